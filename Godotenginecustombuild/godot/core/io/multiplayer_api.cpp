@@ -33,6 +33,7 @@
 #include "core/debugger/engine_debugger.h"
 #include "core/io/marshalls.h"
 #include "scene/main/node.h"
+#include "scene/scene_string_names.h"
 
 #include <stdint.h>
 
@@ -105,6 +106,11 @@ void MultiplayerAPI::poll() {
 
 	network_peer->poll();
 
+	// Send budgets are per poll.
+	for (const int *K = peer_interest.next(nullptr); K; K = peer_interest.next(K)) {
+		peer_interest[*K].sent_bytes = 0;
+	}
+
 	if (!network_peer.is_valid()) { // It's possible that polling might have resulted in a disconnection, so check here.
 		return;
 	}
@@ -136,6 +142,17 @@ void MultiplayerAPI::clear() {
 	path_send_cache.clear();
 	packet_cache.clear();
 	last_send_cache_id = 1;
+	peer_interest.clear();
+	for (const ObjectID *K = node_interest.next(nullptr); K; K = node_interest.next(K)) {
+		Node *node = Object::cast_to<Node>(ObjectDB::get_instance(*K));
+		if (node) {
+			node->disconnect(SceneStringNames::get_singleton()->tree_exited, callable_mp(this, &MultiplayerAPI::_node_interest_exited));
+		}
+	}
+	node_interest.clear();
+	interest_grid.clear();
+	interest_unplaced_peers.clear();
+	interest_grid_dirty = true;
 }
 
 void MultiplayerAPI::set_root_node(Node *p_node) {
@@ -528,14 +545,36 @@ void MultiplayerAPI::_process_confirm_path(int p_from, const uint8_t *p_packet,
 
 	Map<int, bool>::Element *E = psc->confirmed_peers.find(p_from);
 	ERR_FAIL_COND_MSG(!E, "Invalid packet received. Source peer was not found in cache for the given path.");
-	E->get() = true;
+	if (!E->get()) {
+		E->get() = true;
+		psc->confirmed_count++;
+	}
 }
 
-bool MultiplayerAPI::_send_confirm_path(Node *p_node, NodePath p_path, PathSentCache *psc, int p_target) {
+bool MultiplayerAPI::_send_confirm_path(Node *p_node, NodePath p_path, PathSentCache *psc, int p_target, const LocalVector<int> *p_peers) {
+	if (!p_peers && p_target <= 0 && psc->confirmed_count == connected_peers.size()) {
+		// Every connected peer confirmed already, no need to look at them one by one.
+		return true;
+	}
+
 	bool has_all_peers = true;
 	List<int> peers_to_add; // If one is missing, take note to add it.
 
-	for (Set<int>::Element *E = connected_peers.front(); E; E = E->next()) {
+	if (p_peers) {
+		// Interest filtered send, only these peers need the path.
+		for (uint32_t i = 0; i < p_peers->size(); i++) {
+			const int peer = (*p_peers)[i];
+			Map<int, bool>::Element *F = psc->confirmed_peers.find(peer);
+			if (!F || !F->get()) {
+				if (!F) {
+					peers_to_add.push_back(peer);
+				}
+				has_all_peers = false;
+			}
+		}
+	}
+
+	for (Set<int>::Element *E = p_peers ? nullptr : connected_peers.front(); E; E = E->next()) {
 		if (p_target < 0 && E->get() == -p_target) {
 			continue; // Continue, excluded.
 		}
@@ -775,8 +814,21 @@ void MultiplayerAPI::_send_rpc(Node *p_from, int p_to, bool p_unreliable, bool p
 		psc->id = last_send_cache_id++;
 	}
 
+	// Broadcasts from nodes with a declared interest only go to the peers in range.
+	const LocalVector<int> *targets = nullptr;
+	if (p_to <= 0) {
+		const NodeInterest *interest = node_interest.getptr(p_from->get_instance_id());
+		if (interest) {
+			_gather_interested_peers(p_from, *interest, -p_to, interest_targets);
+			if (interest_targets.size() == 0) {
+				return; // Nobody is close enough to care.
+			}
+			targets = &interest_targets;
+		}
+	}
+
 	// See if all peers have cached path (if so, call can be fast).
-	const bool has_all_peers = _send_confirm_path(p_from, from_path, psc, p_to);
+	const bool has_all_peers = _send_confirm_path(p_from, from_path, psc, p_to, targets);
 
 	// Create base packet, lots of hardcode because it must be tight.
 
@@ -925,10 +977,47 @@ void MultiplayerAPI::_send_rpc(Node *p_from, int p_to, bool p_unreliable, bool p
 	// Take chance and set transfer mode, since all send methods will use it.
 	network_peer->set_transfer_mode(p_unreliable ? NetworkedMultiplayerPeer::TRANSFER_MODE_UNRELIABLE : NetworkedMultiplayerPeer::TRANSFER_MODE_RELIABLE);
 
-	if (has_all_peers) {
+	if (has_all_peers && !targets) {
 		// They all have verified paths, so send fast.
 		network_peer->set_target_peer(p_to); // To all of you.
 		network_peer->put_packet(packet_cache.ptr(), ofs); // A message with love.
+	} else if (targets) {
+		// Interest filtered, one by one to the peers in range.
+		int path_len = 0;
+		CharString pname;
+		if (!has_all_peers) {
+			CRASH_COND(node_id_compression != NETWORK_NODE_ID_COMPRESSION_32);
+			pname = String(from_path).utf8();
+			path_len = encode_cstring(pname.get_data(), nullptr);
+			MAKE_ROOM(ofs + path_len);
+			encode_cstring(pname.get_data(), &(packet_cache.write[ofs]));
+		}
+
+		for (uint32_t i = 0; i < targets->size(); i++) {
+			const int peer = (*targets)[i];
+			PeerInterest *pi = peer_interest.getptr(peer);
+			if (pi && p_unreliable && pi->send_budget > 0 && pi->sent_bytes + ofs > pi->send_budget) {
+				continue; // Over budget this poll, unreliable data can be dropped.
+			}
+
+			int size = ofs;
+			if (!has_all_peers) {
+				Map<int, bool>::Element *F = psc->confirmed_peers.find(peer);
+				ERR_CONTINUE(!F); // Should never happen.
+				if (F->get()) {
+					encode_uint32(psc->id, &(packet_cache.write[1]));
+				} else {
+					encode_uint32(0x80000000 | ofs, &(packet_cache.write[1])); // Offset to path and flag.
+					size += path_len;
+				}
+			}
+
+			network_peer->set_target_peer(peer);
+			network_peer->put_packet(packet_cache.ptr(), size);
+			if (pi) {
+				pi->sent_bytes += size;
+			}
+		}
 	} else {
 		// Unreachable because the node ID is never compressed if the peers doesn't know it.
 		CRASH_COND(node_id_compression != NETWORK_NODE_ID_COMPRESSION_32);
@@ -971,11 +1060,15 @@ void MultiplayerAPI::_send_rpc(Node *p_from, int p_to, bool p_unreliable, bool p
 void MultiplayerAPI::_add_peer(int p_id) {
 	connected_peers.insert(p_id);
 	path_get_cache.insert(p_id, PathGetCache());
+	peer_interest.set(p_id, PeerInterest());
+	interest_grid_dirty = true;
 	emit_signal("network_peer_connected", p_id);
 }
 
 void MultiplayerAPI::_del_peer(int p_id) {
 	connected_peers.erase(p_id);
+	peer_interest.erase(p_id);
+	interest_grid_dirty = true;
 	// Cleanup get cache.
 	path_get_cache.erase(p_id);
 	// Cleanup sent cache.
@@ -984,7 +1077,13 @@ void MultiplayerAPI::_del_peer(int p_id) {
 	path_send_cache.get_key_list(&keys);
 	for (List<NodePath>::Element *E = keys.front(); E; E = E->next()) {
 		PathSentCache *psc = path_send_cache.getptr(E->get());
-		psc->confirmed_peers.erase(p_id);
+		Map<int, bool>::Element *F = psc->confirmed_peers.find(p_id);
+		if (F) {
+			if (F->get()) {
+				psc->confirmed_count--;
+			}
+			psc->confirmed_peers.erase(F);
+		}
 	}
 	emit_signal("network_peer_disconnected", p_id);
 }
@@ -1200,6 +1299,170 @@ bool MultiplayerAPI::is_object_decoding_allowed() const {
 	return allow_object_decoding;
 }
 
+#define INTEREST_CELL_BITS 21
+#define INTEREST_CELL_MASK ((1 << INTEREST_CELL_BITS) - 1)
+
+static _FORCE_INLINE_ uint64_t _interest_cell_key(int64_t p_x, int64_t p_y, int64_t p_z) {
+	// Wraps around far away, the distance check below keeps that correct.
+	return (uint64_t(p_x & INTEREST_CELL_MASK) << (INTEREST_CELL_BITS * 2)) | (uint64_t(p_y & INTEREST_CELL_MASK) << INTEREST_CELL_BITS) | uint64_t(p_z & INTEREST_CELL_MASK);
+}
+
+void MultiplayerAPI::_update_interest_grid() {
+	interest_grid.clear();
+	interest_unplaced_peers.clear();
+
+	for (const int *K = peer_interest.next(nullptr); K; K = peer_interest.next(K)) {
+		const PeerInterest &pi = peer_interest[*K];
+		if (!pi.has_position) {
+			interest_unplaced_peers.push_back(*K);
+			continue;
+		}
+		const Vector3 cell = (pi.position / interest_cell_size).floor();
+		interest_grid[_interest_cell_key(cell.x, cell.y, cell.z)].push_back(*K);
+	}
+
+	interest_grid_dirty = false;
+}
+
+void MultiplayerAPI::_gather_interested_peers(Node *p_node, const NodeInterest &p_interest, int p_exclude, LocalVector<int> &r_peers) {
+	if (interest_grid_dirty) {
+		_update_interest_grid();
+	}
+
+	r_peers.clear();
+
+	// Peers that never reported a position can't be filtered, they get everything.
+	for (uint32_t i = 0; i < interest_unplaced_peers.size(); i++) {
+		if (interest_unplaced_peers[i] != p_exclude) {
+			r_peers.push_back(interest_unplaced_peers[i]);
+		}
+	}
+
+	const real_t radius_squared = p_interest.radius * p_interest.radius;
+	const Vector3 from = ((p_interest.position - Vector3(p_interest.radius, p_interest.radius, p_interest.radius)) / interest_cell_size).floor();
+	const Vector3 to = ((p_interest.position + Vector3(p_interest.radius, p_interest.radius, p_interest.radius)) / interest_cell_size).floor();
+	const real_t cells = (to.x - from.x + 1) * (to.y - from.y + 1) * (to.z - from.z + 1);
+
+	if (cells > peer_interest.size()) {
+		// The radius covers more cells than there are peers, just test them all.
+		for (const int *K = peer_interest.next(nullptr); K; K = peer_interest.next(K)) {
+			const PeerInterest &pi = peer_interest[*K];
+			if (pi.has_position && *K != p_exclude && pi.position.distance_squared_to(p_interest.position) <= radius_squared) {
+				r_peers.push_back(*K);
+			}
+		}
+	} else {
+		for (int64_t x = from.x; x <= int64_t(to.x); x++) {
+			for (int64_t y = from.y; y <= int64_t(to.y); y++) {
+				for (int64_t z = from.z; z <= int64_t(to.z); z++) {
+					const LocalVector<int> *cell = interest_grid.getptr(_interest_cell_key(x, y, z));
+					if (!cell) {
+						continue;
+					}
+					for (uint32_t i = 0; i < cell->size(); i++) {
+						const int peer = (*cell)[i];
+						if (peer != p_exclude && peer_interest[peer].position.distance_squared_to(p_interest.position) <= radius_squared) {
+							r_peers.push_back(peer);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (!interest_filter.is_null()) {
+		// Custom relevance gets the last word, it must not send RPCs itself.
+		Variant node = p_node;
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < r_peers.size(); i++) {
+			Variant peer = r_peers[i];
+			const Variant *args[2] = { &node, &peer };
+			Variant ret;
+			Callable::CallError ce;
+			interest_filter.call(args, 2, ret, ce);
+			if (ce.error == Callable::CallError::CALL_OK && ret.operator bool()) {
+				r_peers[kept++] = r_peers[i];
+			}
+		}
+		r_peers.resize(kept);
+	}
+}
+
+void MultiplayerAPI::set_interest_cell_size(real_t p_size) {
+	ERR_FAIL_COND_MSG(p_size <= 0, "Interest cell size must be greater than 0.");
+	interest_cell_size = p_size;
+	interest_grid_dirty = true;
+}
+
+real_t MultiplayerAPI::get_interest_cell_size() const {
+	return interest_cell_size;
+}
+
+void MultiplayerAPI::set_peer_interest_position(int p_peer, const Vector3 &p_position) {
+	PeerInterest *pi = peer_interest.getptr(p_peer);
+	ERR_FAIL_COND_MSG(!pi, "Peer " + itos(p_peer) + " is not connected.");
+	pi->position = p_position;
+	pi->has_position = true;
+	interest_grid_dirty = true;
+}
+
+void MultiplayerAPI::clear_peer_interest_position(int p_peer) {
+	PeerInterest *pi = peer_interest.getptr(p_peer);
+	ERR_FAIL_COND_MSG(!pi, "Peer " + itos(p_peer) + " is not connected.");
+	pi->has_position = false;
+	interest_grid_dirty = true;
+}
+
+void MultiplayerAPI::set_peer_send_budget(int p_peer, int p_bytes) {
+	PeerInterest *pi = peer_interest.getptr(p_peer);
+	ERR_FAIL_COND_MSG(!pi, "Peer " + itos(p_peer) + " is not connected.");
+	pi->send_budget = MAX(p_bytes, 0);
+}
+
+int MultiplayerAPI::get_peer_send_budget(int p_peer) const {
+	const PeerInterest *pi = peer_interest.getptr(p_peer);
+	ERR_FAIL_COND_V_MSG(!pi, 0, "Peer " + itos(p_peer) + " is not connected.");
+	return pi->send_budget;
+}
+
+void MultiplayerAPI::set_node_interest(Node *p_node, const Vector3 &p_position, real_t p_radius) {
+	ERR_FAIL_NULL(p_node);
+	ERR_FAIL_COND_MSG(!p_node->is_inside_tree(), "Node must be inside the tree to declare an interest.");
+	ERR_FAIL_COND_MSG(p_radius < 0, "Interest radius can't be negative.");
+	const ObjectID id = p_node->get_instance_id();
+	if (!node_interest.has(id)) {
+		// The entry goes away with the node, freed nodes must not stay in the map.
+		p_node->connect(SceneStringNames::get_singleton()->tree_exited, callable_mp(this, &MultiplayerAPI::_node_interest_exited), varray(id), CONNECT_ONESHOT);
+	}
+	NodeInterest &ni = node_interest[id];
+	ni.position = p_position;
+	ni.radius = p_radius;
+}
+
+void MultiplayerAPI::clear_node_interest(Node *p_node) {
+	ERR_FAIL_NULL(p_node);
+	if (node_interest.erase(p_node->get_instance_id())) {
+		p_node->disconnect(SceneStringNames::get_singleton()->tree_exited, callable_mp(this, &MultiplayerAPI::_node_interest_exited));
+	}
+}
+
+void MultiplayerAPI::_node_interest_exited(ObjectID p_node) {
+	node_interest.erase(p_node);
+}
+
+bool MultiplayerAPI::has_node_interest(Node *p_node) const {
+	ERR_FAIL_NULL_V(p_node, false);
+	return node_interest.has(p_node->get_instance_id());
+}
+
+void MultiplayerAPI::set_interest_filter(const Callable &p_filter) {
+	interest_filter = p_filter;
+}
+
+Callable MultiplayerAPI::get_interest_filter() const {
+	return interest_filter;
+}
+
 void MultiplayerAPI::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_root_node", "node"), &MultiplayerAPI::set_root_node);
 	ClassDB::bind_method(D_METHOD("send_bytes", "bytes", "id", "mode"), &MultiplayerAPI::send_bytes, DEFVAL(NetworkedMultiplayerPeer::TARGET_PEER_BROADCAST), DEFVAL(NetworkedMultiplayerPeer::TRANSFER_MODE_RELIABLE));
@@ -1217,9 +1480,22 @@ void MultiplayerAPI::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("is_refusing_new_network_connections"), &MultiplayerAPI::is_refusing_new_network_connections);
 	ClassDB::bind_method(D_METHOD("set_allow_object_decoding", "enable"), &MultiplayerAPI::set_allow_object_decoding);
 	ClassDB::bind_method(D_METHOD("is_object_decoding_allowed"), &MultiplayerAPI::is_object_decoding_allowed);
+	ClassDB::bind_method(D_METHOD("set_interest_cell_size", "size"), &MultiplayerAPI::set_interest_cell_size);
+	ClassDB::bind_method(D_METHOD("get_interest_cell_size"), &MultiplayerAPI::get_interest_cell_size);
+	ClassDB::bind_method(D_METHOD("set_peer_interest_position", "id", "position"), &MultiplayerAPI::set_peer_interest_position);
+	ClassDB::bind_method(D_METHOD("clear_peer_interest_position", "id"), &MultiplayerAPI::clear_peer_interest_position);
+	ClassDB::bind_method(D_METHOD("set_peer_send_budget", "id", "bytes"), &MultiplayerAPI::set_peer_send_budget);
+	ClassDB::bind_method(D_METHOD("get_peer_send_budget", "id"), &MultiplayerAPI::get_peer_send_budget);
+	ClassDB::bind_method(D_METHOD("set_node_interest", "node", "position", "radius"), &MultiplayerAPI::set_node_interest);
+	ClassDB::bind_method(D_METHOD("clear_node_interest", "node"), &MultiplayerAPI::clear_node_interest);
+	ClassDB::bind_method(D_METHOD("has_node_interest", "node"), &MultiplayerAPI::has_node_interest);
+	ClassDB::bind_method(D_METHOD("set_interest_filter", "filter"), &MultiplayerAPI::set_interest_filter);
+	ClassDB::bind_method(D_METHOD("get_interest_filter"), &MultiplayerAPI::get_interest_filter);
 
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "allow_object_decoding"), "set_allow_object_decoding", "is_object_decoding_allowed");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "refuse_new_network_connections"), "set_refuse_new_network_connections", "is_refusing_new_network_connections");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "interest_cell_size"), "set_interest_cell_size", "get_interest_cell_size");
+	ADD_PROPERTY(PropertyInfo(Variant::CALLABLE, "interest_filter"), "set_interest_filter", "get_interest_filter");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "network_peer", PROPERTY_HINT_RESOURCE_TYPE, "NetworkedMultiplayerPeer", 0), "set_network_peer", "get_network_peer");
 	ADD_PROPERTY_DEFAULT("refuse_new_network_connections", false);
 
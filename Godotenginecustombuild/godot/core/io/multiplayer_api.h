@@ -33,6 +33,7 @@
 
 #include "core/io/networked_multiplayer_peer.h"
 #include "core/object/reference.h"
+#include "core/templates/local_vector.h"
 
 class MultiplayerAPI : public Reference {
 	GDCLASS(MultiplayerAPI, Reference);
@@ -41,6 +42,7 @@ private:
 	//path sent caches
 	struct PathSentCache {
 		Map<int, bool> confirmed_peers;
+		int confirmed_count = 0; // Entries of confirmed_peers set to true.
 		int id;
 	};
 
@@ -64,6 +66,29 @@ private:
 	Node *root_node = nullptr;
 	bool allow_object_decoding = false;
 
+	// Interest management: broadcasts from nodes with a declared interest
+	// only reach the peers whose position lies inside the node's radius.
+	struct PeerInterest {
+		Vector3 position;
+		bool has_position = false;
+		int send_budget = 0; // Bytes per poll for unreliable filtered sends, 0 is unlimited.
+		int sent_bytes = 0;
+	};
+
+	struct NodeInterest {
+		Vector3 position;
+		real_t radius = 0;
+	};
+
+	HashMap<int, PeerInterest> peer_interest;
+	HashMap<ObjectID, NodeInterest> node_interest;
+	HashMap<uint64_t, LocalVector<int>> interest_grid;
+	LocalVector<int> interest_unplaced_peers;
+	LocalVector<int> interest_targets;
+	real_t interest_cell_size = 1000;
+	bool interest_grid_dirty = true;
+	Callable interest_filter;
+
 protected:
 	static void _bind_methods();
 
@@ -76,7 +101,11 @@ protected:
 	void _process_raw(int p_from, const uint8_t *p_packet, int p_packet_len);
 
 	void _send_rpc(Node *p_from, int p_to, bool p_unreliable, bool p_set, const StringName &p_name, const Variant **p_arg, int p_argcount);
-	bool _send_confirm_path(Node *p_node, NodePath p_path, PathSentCache *psc, int p_target);
+	bool _send_confirm_path(Node *p_node, NodePath p_path, PathSentCache *psc, int p_target, const LocalVector<int> *p_peers = nullptr);
+
+	void _update_interest_grid();
+	void _node_interest_exited(ObjectID p_node);
+	void _gather_interested_peers(Node *p_node, const NodeInterest &p_interest, int p_exclude, LocalVector<int> &r_peers);
 
 	Error _encode_and_compress_variant(const Variant &p_variant, uint8_t *p_buffer, int &r_len);
 	Error _decode_and_decompress_variant(Variant &r_variant, const uint8_t *p_buffer, int p_len, int *r_len);
@@ -140,6 +169,18 @@ public:
 	void set_allow_object_decoding(bool p_enable);
 	bool is_object_decoding_allowed() const;
 
+	void set_interest_cell_size(real_t p_size);
+	real_t get_interest_cell_size() const;
+	void set_peer_interest_position(int p_peer, const Vector3 &p_position);
+	void clear_peer_interest_position(int p_peer);
+	void set_peer_send_budget(int p_peer, int p_bytes);
+	int get_peer_send_budget(int p_peer) const;
+	void set_node_interest(Node *p_node, const Vector3 &p_position, real_t p_radius);
+	void clear_node_interest(Node *p_node);
+	bool has_node_interest(Node *p_node) const;
+	void set_interest_filter(const Callable &p_filter);
+	Callable get_interest_filter() const;
+
 	MultiplayerAPI();
 	~MultiplayerAPI();
 };
@@ -32,17 +32,21 @@
 
 #include "core/math/geometry_3d.h"
 #include "core/object/script_language.h"
+#include "core/os/threaded_array_processor.h"
 #include "scene/scene_string_names.h"
 
+// Below this amount spawning the threads costs more than the queries.
+#define PATH_QUERIES_PARALLEL_MIN 16
+
 int AStar::get_available_point_id() const {
 	if (points.empty()) {
 		return 1;
 	}
 
 	// calculate our new next available point id if bigger than before or next id already contained in set of points.
-	if (points.has(last_free_id)) {
+	if (point_indices.has(last_free_id)) {
 		int cur_new_id = last_free_id;
-		while (points.has(cur_new_id)) {
+		while (point_indices.has(cur_new_id)) {
 			cur_new_id++;
 		}
 		int &non_const = const_cast<int &>(last_free_id);
@@ -56,101 +60,118 @@ void AStar::add_point(int p_id, const Vector3 &p_pos, real_t p_weight_scale) {
 	ERR_FAIL_COND(p_id < 0);
 	ERR_FAIL_COND(p_weight_scale < 1);
 
-	Point *found_pt;
-	bool p_exists = points.lookup(p_id, found_pt);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 
 	if (!p_exists) {
-		Point *pt = memnew(Point);
-		pt->id = p_id;
-		pt->pos = p_pos;
-		pt->weight_scale = p_weight_scale;
-		pt->prev_point = nullptr;
-		pt->open_pass = 0;
-		pt->closed_pass = 0;
-		pt->enabled = true;
-		points.set(p_id, pt);
+		Point pt;
+		pt.id = p_id;
+		pt.pos = p_pos;
+		pt.weight_scale = p_weight_scale;
+		pt.enabled = true;
+		point_indices.set(p_id, points.size());
+		points.push_back(pt);
+		graph_dirty = true;
 	} else {
-		found_pt->pos = p_pos;
-		found_pt->weight_scale = p_weight_scale;
+		points[index].pos = p_pos;
+		points[index].weight_scale = p_weight_scale;
 	}
 }
 
 Vector3 AStar::get_point_position(int p_id) const {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND_V(!p_exists, Vector3());
 
-	return p->pos;
+	return points[index].pos;
 }
 
 void AStar::set_point_position(int p_id, const Vector3 &p_pos) {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND(!p_exists);
 
-	p->pos = p_pos;
+	points[index].pos = p_pos;
 }
 
 real_t AStar::get_point_weight_scale(int p_id) const {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND_V(!p_exists, 0);
 
-	return p->weight_scale;
+	return points[index].weight_scale;
 }
 
 void AStar::set_point_weight_scale(int p_id, real_t p_weight_scale) {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND(!p_exists);
 	ERR_FAIL_COND(p_weight_scale < 1);
 
-	p->weight_scale = p_weight_scale;
+	points[index].weight_scale = p_weight_scale;
 }
 
 void AStar::remove_point(int p_id) {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND(!p_exists);
 
-	for (OAHashMap<int, Point *>::Iterator it = p->neighbours.iter(); it.valid; it = p->neighbours.next_iter(it)) {
-		Segment s(p_id, (*it.key));
+	const Point &p = points[index];
+
+	for (uint32_t i = 0; i < p.neighbours.size(); i++) {
+		Segment s(p_id, p.neighbours[i]);
 		segments.erase(s);
 
-		(*it.value)->neighbours.remove(p->id);
-		(*it.value)->unlinked_neighbours.remove(p->id);
+		Point &n = points[*point_indices.lookup_ptr(p.neighbours[i])];
+		n.neighbours.erase(p_id);
+		n.unlinked_neighbours.erase(p_id);
 	}
 
-	for (OAHashMap<int, Point *>::Iterator it = p->unlinked_neighbours.iter(); it.valid; it = p->unlinked_neighbours.next_iter(it)) {
-		Segment s(p_id, (*it.key));
+	for (uint32_t i = 0; i < p.unlinked_neighbours.size(); i++) {
+		Segment s(p_id, p.unlinked_neighbours[i]);
 		segments.erase(s);
 
-		(*it.value)->neighbours.remove(p->id);
-		(*it.value)->unlinked_neighbours.remove(p->id);
+		Point &n = points[*point_indices.lookup_ptr(p.unlinked_neighbours[i])];
+		n.neighbours.erase(p_id);
+		n.unlinked_neighbours.erase(p_id);
 	}
 
-	memdelete(p);
-	points.remove(p_id);
+	// Keep the points contiguous by moving the last one in the freed slot.
+	const uint32_t last = points.size() - 1;
+	if (index != last) {
+		points[index] = points[last];
+		point_indices.set(points[index].id, index);
+	}
+	points.resize(last);
+	point_indices.remove(p_id);
 	last_free_id = p_id;
+	graph_dirty = true;
 }
 
 void AStar::connect_points(int p_id, int p_with_id, bool bidirectional) {
 	ERR_FAIL_COND(p_id == p_with_id);
 
-	Point *a;
-	bool from_exists = points.lookup(p_id, a);
+	uint32_t a_index;
+	bool from_exists = point_indices.lookup(p_id, a_index);
 	ERR_FAIL_COND(!from_exists);
 
-	Point *b;
-	bool to_exists = points.lookup(p_with_id, b);
+	uint32_t b_index;
+	bool to_exists = point_indices.lookup(p_with_id, b_index);
 	ERR_FAIL_COND(!to_exists);
 
-	a->neighbours.set(b->id, b);
+	Point *a = &points[a_index];
+	Point *b = &points[b_index];
+
+	if (a->neighbours.find(b->id) < 0) {
+		a->neighbours.push_back(b->id);
+	}
 
 	if (bidirectional) {
-		b->neighbours.set(a->id, a);
-	} else {
-		b->unlinked_neighbours.set(a->id, a);
+		if (b->neighbours.find(a->id) < 0) {
+			b->neighbours.push_back(a->id);
+		}
+	} else if (b->unlinked_neighbours.find(a->id) < 0) {
+		b->unlinked_neighbours.push_back(a->id);
 	}
 
 	Segment s(p_id, p_with_id);
@@ -163,24 +184,28 @@ void AStar::connect_points(int p_id, int p_with_id, bool bidirectional) {
 		s.direction |= element->get().direction;
 		if (s.direction == Segment::BIDIRECTIONAL) {
 			// Both are neighbours of each other now
-			a->unlinked_neighbours.remove(b->id);
-			b->unlinked_neighbours.remove(a->id);
+			a->unlinked_neighbours.erase(b->id);
+			b->unlinked_neighbours.erase(a->id);
 		}
 		segments.erase(element);
 	}
 
 	segments.insert(s);
+	graph_dirty = true;
 }
 
 void AStar::disconnect_points(int p_id, int p_with_id, bool bidirectional) {
-	Point *a;
-	bool a_exists = points.lookup(p_id, a);
+	uint32_t a_index;
+	bool a_exists = point_indices.lookup(p_id, a_index);
 	ERR_FAIL_COND(!a_exists);
 
-	Point *b;
-	bool b_exists = points.lookup(p_with_id, b);
+	uint32_t b_index;
+	bool b_exists = point_indices.lookup(p_with_id, b_index);
 	ERR_FAIL_COND(!b_exists);
 
+	Point *a = &points[a_index];
+	Point *b = &points[b_index];
+
 	Segment s(p_id, p_with_id);
 	int remove_direction = bidirectional ? (int)Segment::BIDIRECTIONAL : s.direction;
 
@@ -190,18 +215,18 @@ void AStar::disconnect_points(int p_id, int p_with_id, bool bidirectional) {
 		// Erase the directions to be removed
 		s.direction = (element->get().direction & ~remove_direction);
 
-		a->neighbours.remove(b->id);
+		a->neighbours.erase(b->id);
 		if (bidirectional) {
-			b->neighbours.remove(a->id);
+			b->neighbours.erase(a->id);
 			if (element->get().direction != Segment::BIDIRECTIONAL) {
-				a->unlinked_neighbours.remove(b->id);
-				b->unlinked_neighbours.remove(a->id);
+				a->unlinked_neighbours.erase(b->id);
+				b->unlinked_neighbours.erase(a->id);
 			}
 		} else {
 			if (s.direction == Segment::NONE) {
-				b->unlinked_neighbours.remove(a->id);
-			} else {
-				a->unlinked_neighbours.set(b->id, b);
+				b->unlinked_neighbours.erase(a->id);
+			} else if (a->unlinked_neighbours.find(b->id) < 0) {
+				a->unlinked_neighbours.push_back(b->id);
 			}
 		}
 
@@ -209,32 +234,34 @@ void AStar::disconnect_points(int p_id, int p_with_id, bool bidirectional) {
 		if (s.direction != Segment::NONE) {
 			segments.insert(s);
 		}
+		graph_dirty = true;
 	}
 }
 
 bool AStar::has_point(int p_id) const {
-	return points.has(p_id);
+	return point_indices.has(p_id);
 }
 
 Array AStar::get_points() {
 	Array point_list;
 
-	for (OAHashMap<int, Point *>::Iterator it = points.iter(); it.valid; it = points.next_iter(it)) {
-		point_list.push_back(*(it.key));
+	for (uint32_t i = 0; i < points.size(); i++) {
+		point_list.push_back(points[i].id);
 	}
 
 	return point_list;
 }
 
 Vector<int> AStar::get_point_connections(int p_id) {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND_V(!p_exists, Vector<int>());
 
 	Vector<int> point_list;
 
-	for (OAHashMap<int, Point *>::Iterator it = p->neighbours.iter(); it.valid; it = p->neighbours.next_iter(it)) {
-		point_list.push_back((*it.key));
+	const LocalVector<int> &neighbours = points[index].neighbours;
+	for (uint32_t i = 0; i < neighbours.size(); i++) {
+		point_list.push_back(neighbours[i]);
 	}
 
 	return point_list;
@@ -250,24 +277,24 @@ bool AStar::are_points_connected(int p_id, int p_with_id, bool bidirectional) co
 
 void AStar::clear() {
 	last_free_id = 0;
-	for (OAHashMap<int, Point *>::Iterator it = points.iter(); it.valid; it = points.next_iter(it)) {
-		memdelete(*(it.value));
-	}
 	segments.clear();
 	points.clear();
+	point_indices.clear();
+	graph_dirty = true;
 }
 
 int AStar::get_point_count() const {
-	return points.get_num_elements();
+	return points.size();
 }
 
 int AStar::get_point_capacity() const {
-	return points.get_capacity();
+	return point_indices.get_capacity();
 }
 
 void AStar::reserve_space(int p_num_nodes) {
 	ERR_FAIL_COND_MSG(p_num_nodes <= 0, "New capacity must be greater than 0, was: " + itos(p_num_nodes) + ".");
-	ERR_FAIL_COND_MSG((uint32_t)p_num_nodes < points.get_capacity(), "New capacity must be greater than current capacity: " + itos(points.get_capacity()) + ", new was: " + itos(p_num_nodes) + ".");
+	ERR_FAIL_COND_MSG((uint32_t)p_num_nodes < point_indices.get_capacity(), "New capacity must be greater than current capacity: " + itos(point_indices.get_capacity()) + ", new was: " + itos(p_num_nodes) + ".");
+	point_indices.reserve(p_num_nodes);
 	points.reserve(p_num_nodes);
 }
 
@@ -275,15 +302,15 @@ int AStar::get_closest_point(const Vector3 &p_point, bool p_include_disabled) co
 	int closest_id = -1;
 	real_t closest_dist = 1e20;
 
-	for (OAHashMap<int, Point *>::Iterator it = points.iter(); it.valid; it = points.next_iter(it)) {
-		if (!p_include_disabled && !(*it.value)->enabled) {
+	for (uint32_t i = 0; i < points.size(); i++) {
+		if (!p_include_disabled && !points[i].enabled) {
 			continue; // Disabled points should not be considered.
 		}
 
 		// Keep the closest point's ID, and in case of multiple closest IDs,
 		// the smallest one (makes it deterministic).
-		real_t d = p_point.distance_squared_to((*it.value)->pos);
-		int id = *(it.key);
+		real_t d = p_point.distance_squared_to(points[i].pos);
+		int id = points[i].id;
 		if (d <= closest_dist) {
 			if (d == closest_dist && id > closest_id) { // Keep lowest ID.
 				continue;
@@ -301,17 +328,16 @@ Vector3 AStar::get_closest_position_in_segment(const Vector3 &p_point) const {
 	Vector3 closest_point;
 
 	for (const Set<Segment>::Element *E = segments.front(); E; E = E->next()) {
-		Point *from_point = nullptr, *to_point = nullptr;
-		points.lookup(E->get().u, from_point);
-		points.lookup(E->get().v, to_point);
+		const Point &from_point = points[*point_indices.lookup_ptr(E->get().u)];
+		const Point &to_point = points[*point_indices.lookup_ptr(E->get().v)];
 
-		if (!(from_point->enabled && to_point->enabled)) {
+		if (!(from_point.enabled && to_point.enabled)) {
 			continue;
 		}
 
 		Vector3 segment[2] = {
-			from_point->pos,
-			to_point->pos,
+			from_point.pos,
+			to_point.pos,
 		};
 
 		Vector3 p = Geometry3D::get_closest_point_to_segment(p_point, segment);
@@ -325,66 +351,282 @@ Vector3 AStar::get_closest_position_in_segment(const Vector3 &p_point) const {
 	return closest_point;
 }
 
-bool AStar::_solve(Point *begin_point, Point *end_point) {
-	pass++;
+void AStar::_update_graph() {
+	if (!graph_dirty) {
+		return;
+	}
 
-	if (!end_point->enabled) {
-		return false;
+	graph_offsets.resize(points.size() + 1);
+	graph_neighbours.clear();
+	for (uint32_t i = 0; i < points.size(); i++) {
+		graph_offsets[i] = graph_neighbours.size();
+		const LocalVector<int> &neighbours = points[i].neighbours;
+		for (uint32_t j = 0; j < neighbours.size(); j++) {
+			graph_neighbours.push_back(*point_indices.lookup_ptr(neighbours[j]));
+		}
+	}
+	graph_offsets[points.size()] = graph_neighbours.size();
+
+	graph_dirty = false;
+}
+
+bool AStar::_is_better(const SearchPoint &p_a, const SearchPoint &p_b) {
+	if (p_a.f_score != p_b.f_score) {
+		return p_a.f_score < p_b.f_score;
 	}
+	// If the f_costs are the same then prioritize the points that are further away from the start.
+	return p_a.g_score > p_b.g_score;
+}
 
-	bool found_route = false;
+void AStar::_open_list_sift_up(Search &r_search, uint32_t p_index) {
+	LocalVector<uint32_t> &open_list = r_search.open_list;
+	const uint32_t point = open_list[p_index];
+	const SearchPoint &sp = r_search.points[point];
 
-	Vector<Point *> open_list;
-	SortArray<Point *, SortPoints> sorter;
+	while (p_index > 0) {
+		const uint32_t parent_index = (p_index - 1) / OPEN_LIST_ARITY;
+		const uint32_t parent = open_list[parent_index];
+		if (!_is_better(sp, r_search.points[parent])) {
+			break;
+		}
+		open_list[p_index] = parent;
+		r_search.points[parent].open_index = p_index;
+		p_index = parent_index;
+	}
 
-	begin_point->g_score = 0;
-	begin_point->f_score = _estimate_cost(begin_point->id, end_point->id);
-	open_list.push_back(begin_point);
+	open_list[p_index] = point;
+	r_search.points[point].open_index = p_index;
+}
 
-	while (!open_list.empty()) {
-		Point *p = open_list[0]; // The currently processed point
+uint32_t AStar::_open_list_pop(Search &r_search) {
+	LocalVector<uint32_t> &open_list = r_search.open_list;
+	const uint32_t best = open_list[0];
+	r_search.points[best].open_index = CLOSED;
 
-		if (p == end_point) {
-			found_route = true;
+	const uint32_t last = open_list[open_list.size() - 1];
+	open_list.resize(open_list.size() - 1);
+	const uint32_t size = open_list.size();
+	if (size == 0) {
+		return best;
+	}
+
+	// Sift the last point down from the top.
+	const SearchPoint &sp = r_search.points[last];
+	uint32_t index = 0;
+	while (true) {
+		const uint32_t first_child = index * OPEN_LIST_ARITY + 1;
+		if (first_child >= size) {
+			break;
+		}
+		const uint32_t children_end = MIN(first_child + OPEN_LIST_ARITY, size);
+		uint32_t best_child = first_child;
+		for (uint32_t c = first_child + 1; c < children_end; c++) {
+			if (_is_better(r_search.points[open_list[c]], r_search.points[open_list[best_child]])) {
+				best_child = c;
+			}
+		}
+		if (!_is_better(r_search.points[open_list[best_child]], sp)) {
 			break;
 		}
+		open_list[index] = open_list[best_child];
+		r_search.points[open_list[index]].open_index = index;
+		index = best_child;
+	}
+
+	open_list[index] = last;
+	r_search.points[last].open_index = index;
+	return best;
+}
+
+template <class C>
+bool AStar::_solve(Search &r_search, uint32_t p_begin_point, uint32_t p_end_point, C *p_costs) {
+	if (!points[p_end_point].enabled) {
+		return false;
+	}
+
+	if (r_search.points.size() < points.size()) {
+		r_search.points.resize(points.size());
+	}
+	r_search.pass++;
+	if (r_search.pass == 0) {
+		// Wrapped around, forget the previous searches.
+		for (uint32_t i = 0; i < r_search.points.size(); i++) {
+			r_search.points[i].pass = 0;
+		}
+		r_search.pass = 1;
+	}
+	const uint32_t pass = r_search.pass;
+	const int end_id = points[p_end_point].id;
+
+	SearchPoint &begin_point = r_search.points[p_begin_point];
+	begin_point.pass = pass;
+	begin_point.prev_point = p_begin_point;
+	begin_point.g_score = 0;
+	begin_point.f_score = p_costs->_estimate_cost(points[p_begin_point].id, end_id);
+	r_search.open_list.clear();
+	r_search.open_list.push_back(p_begin_point);
+	begin_point.open_index = 0;
+
+	while (!r_search.open_list.empty()) {
+		const uint32_t p = r_search.open_list[0]; // The currently processed point
+
+		if (p == p_end_point) {
+			return true;
+		}
 
-		sorter.pop_heap(0, open_list.size(), open_list.ptrw()); // Remove the current point from the open list
-		open_list.remove(open_list.size() - 1);
-		p->closed_pass = pass; // Mark the point as closed
+		_open_list_pop(r_search); // Remove the current point from the open list, and mark it as closed.
+		const real_t p_g_score = r_search.points[p].g_score;
+		const int p_id = points[p].id;
 
-		for (OAHashMap<int, Point *>::Iterator it = p->neighbours.iter(); it.valid; it = p->neighbours.next_iter(it)) {
-			Point *e = *(it.value); // The neighbour point
+		for (uint32_t i = graph_offsets[p]; i < graph_offsets[p + 1]; i++) {
+			const uint32_t e = graph_neighbours[i]; // The neighbour point
+			const Point &e_point = points[e];
+			SearchPoint &e_search = r_search.points[e];
 
-			if (!e->enabled || e->closed_pass == pass) {
+			const bool new_point = e_search.pass != pass; // The point wasn't inside the open list.
+			if (!e_point.enabled || (!new_point && e_search.open_index == CLOSED)) {
 				continue;
 			}
 
-			real_t tentative_g_score = p->g_score + _compute_cost(p->id, e->id) * e->weight_scale;
+			real_t tentative_g_score = p_g_score + p_costs->_compute_cost(p_id, e_point.id) * e_point.weight_scale;
 
-			bool new_point = false;
-
-			if (e->open_pass != pass) { // The point wasn't inside the open list.
-				e->open_pass = pass;
-				open_list.push_back(e);
-				new_point = true;
-			} else if (tentative_g_score >= e->g_score) { // The new path is worse than the previous.
+			if (!new_point && tentative_g_score >= e_search.g_score) { // The new path is worse than the previous.
 				continue;
 			}
 
-			e->prev_point = p;
-			e->g_score = tentative_g_score;
-			e->f_score = e->g_score + _estimate_cost(e->id, end_point->id);
+			e_search.pass = pass;
+			e_search.prev_point = p;
+			e_search.g_score = tentative_g_score;
+			e_search.f_score = tentative_g_score + p_costs->_estimate_cost(e_point.id, end_id);
 
-			if (new_point) { // The position of the new points is already known.
-				sorter.push_heap(0, open_list.size() - 1, 0, e, open_list.ptrw());
-			} else {
-				sorter.push_heap(0, open_list.find(e), 0, e, open_list.ptrw());
+			if (new_point) {
+				e_search.open_index = r_search.open_list.size();
+				r_search.open_list.push_back(e);
 			}
+			_open_list_sift_up(r_search, e_search.open_index);
 		}
 	}
 
-	return found_route;
+	return false;
+}
+
+template <class C>
+Vector<int> AStar::_find_id_path(Search &r_search, uint32_t p_begin_point, uint32_t p_end_point, C *p_costs) {
+	if (p_begin_point == p_end_point) {
+		Vector<int> ret;
+		ret.push_back(points[p_begin_point].id);
+		return ret;
+	}
+
+	bool found_route = _solve(r_search, p_begin_point, p_end_point, p_costs);
+	if (!found_route) {
+		return Vector<int>();
+	}
+
+	uint32_t p = p_end_point;
+	int pc = 1; // Begin point
+	while (p != p_begin_point) {
+		pc++;
+		p = r_search.points[p].prev_point;
+	}
+
+	Vector<int> path;
+	path.resize(pc);
+
+	{
+		int *w = path.ptrw();
+
+		p = p_end_point;
+		int idx = pc - 1;
+		while (p != p_begin_point) {
+			w[idx--] = points[p].id;
+			p = r_search.points[p].prev_point;
+		}
+
+		w[0] = points[p].id; // Assign first
+	}
+
+	return path;
+}
+
+template <class C>
+struct AStar::PathQueries {
+	AStar *astar;
+	C *costs;
+	const uint32_t *begin_points;
+	const uint32_t *end_points;
+	uint32_t count;
+	uint32_t job_count;
+	Vector<int> *paths;
+
+	void solve(uint32_t p_job, void *p_userdata) {
+		Search &search = astar->batch_searches[p_job];
+		for (uint32_t i = p_job; i < count; i += job_count) {
+			if (begin_points[i] != CLOSED) {
+				paths[i] = astar->_find_id_path(search, begin_points[i], end_points[i], costs);
+			}
+		}
+	}
+};
+
+template <class C>
+Array AStar::_get_id_paths(const Vector<int> &p_from_ids, const Vector<int> &p_to_ids, C *p_costs) {
+	ERR_FAIL_COND_V(p_from_ids.size() != p_to_ids.size(), Array());
+
+	const uint32_t count = p_from_ids.size();
+	LocalVector<uint32_t> begin_points;
+	LocalVector<uint32_t> end_points;
+	begin_points.resize(count);
+	end_points.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t begin_point;
+		uint32_t end_point;
+		begin_points[i] = CLOSED; // No path.
+		ERR_CONTINUE_MSG(!point_indices.lookup(p_from_ids[i], begin_point) || !point_indices.lookup(p_to_ids[i], end_point), "Can't find the points of the path " + itos(i) + ".");
+		begin_points[i] = begin_point;
+		end_points[i] = end_point;
+	}
+
+	LocalVector<Vector<int>> paths;
+	paths.resize(count);
+
+	_update_graph();
+
+	PathQueries<C> queries;
+	queries.astar = this;
+	queries.costs = p_costs;
+	queries.begin_points = begin_points.ptr();
+	queries.end_points = end_points.ptr();
+	queries.count = count;
+	queries.paths = paths.ptr();
+
+	// The searches only read the graph, so they can run concurrently. The
+	// script calls can't.
+	if (count < PATH_QUERIES_PARALLEL_MIN || p_costs->_has_script_costs()) {
+		queries.job_count = 1;
+		if (batch_searches.empty()) {
+			batch_searches.resize(1);
+		}
+		queries.solve(0, nullptr);
+	} else {
+		queries.job_count = MIN(count, (uint32_t)OS::get_singleton()->get_processor_count() * 4);
+		if (batch_searches.size() < queries.job_count) {
+			batch_searches.resize(queries.job_count);
+		}
+		thread_process_array(queries.job_count, &queries, &PathQueries<C>::solve, (void *)nullptr);
+	}
+
+	Array ret;
+	ret.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		ret[i] = paths[i];
+	}
+	return ret;
+}
+
+bool AStar::_has_script_costs() const {
+	ScriptInstance *script_instance = get_script_instance();
+	return script_instance && (script_instance->has_method(SceneStringNames::get_singleton()->_estimate_cost) || script_instance->has_method(SceneStringNames::get_singleton()->_compute_cost));
 }
 
 real_t AStar::_estimate_cost(int p_from_id, int p_to_id) {
@@ -392,15 +634,15 @@ real_t AStar::_estimate_cost(int p_from_id, int p_to_id) {
 		return get_script_instance()->call(SceneStringNames::get_singleton()->_estimate_cost, p_from_id, p_to_id);
 	}
 
-	Point *from_point;
-	bool from_exists = points.lookup(p_from_id, from_point);
+	uint32_t from_index;
+	bool from_exists = point_indices.lookup(p_from_id, from_index);
 	ERR_FAIL_COND_V(!from_exists, 0);
 
-	Point *to_point;
-	bool to_exists = points.lookup(p_to_id, to_point);
+	uint32_t to_index;
+	bool to_exists = point_indices.lookup(p_to_id, to_index);
 	ERR_FAIL_COND_V(!to_exists, 0);
 
-	return from_point->pos.distance_to(to_point->pos);
+	return points[from_index].pos.distance_to(points[to_index].pos);
 }
 
 real_t AStar::_compute_cost(int p_from_id, int p_to_id) {
@@ -408,45 +650,46 @@ real_t AStar::_compute_cost(int p_from_id, int p_to_id) {
 		return get_script_instance()->call(SceneStringNames::get_singleton()->_compute_cost, p_from_id, p_to_id);
 	}
 
-	Point *from_point;
-	bool from_exists = points.lookup(p_from_id, from_point);
+	uint32_t from_index;
+	bool from_exists = point_indices.lookup(p_from_id, from_index);
 	ERR_FAIL_COND_V(!from_exists, 0);
 
-	Point *to_point;
-	bool to_exists = points.lookup(p_to_id, to_point);
+	uint32_t to_index;
+	bool to_exists = point_indices.lookup(p_to_id, to_index);
 	ERR_FAIL_COND_V(!to_exists, 0);
 
-	return from_point->pos.distance_to(to_point->pos);
+	return points[from_index].pos.distance_to(points[to_index].pos);
 }
 
 Vector<Vector3> AStar::get_point_path(int p_from_id, int p_to_id) {
-	Point *a;
-	bool from_exists = points.lookup(p_from_id, a);
+	uint32_t a;
+	bool from_exists = point_indices.lookup(p_from_id, a);
 	ERR_FAIL_COND_V(!from_exists, Vector<Vector3>());
 
-	Point *b;
-	bool to_exists = points.lookup(p_to_id, b);
+	uint32_t b;
+	bool to_exists = point_indices.lookup(p_to_id, b);
 	ERR_FAIL_COND_V(!to_exists, Vector<Vector3>());
 
 	if (a == b) {
 		Vector<Vector3> ret;
-		ret.push_back(a->pos);
+		ret.push_back(points[a].pos);
 		return ret;
 	}
 
-	Point *begin_point = a;
-	Point *end_point = b;
+	uint32_t begin_point = a;
+	uint32_t end_point = b;
 
-	bool found_route = _solve(begin_point, end_point);
+	_update_graph();
+	bool found_route = _solve(search, begin_point, end_point, this);
 	if (!found_route) {
 		return Vector<Vector3>();
 	}
 
-	Point *p = end_point;
+	uint32_t p = end_point;
 	int pc = 1; // Begin point
 	while (p != begin_point) {
 		pc++;
-		p = p->prev_point;
+		p = search.points[p].prev_point;
 	}
 
 	Vector<Vector3> path;
@@ -455,82 +698,50 @@ Vector<Vector3> AStar::get_point_path(int p_from_id, int p_to_id) {
 	{
 		Vector3 *w = path.ptrw();
 
-		Point *p2 = end_point;
+		uint32_t p2 = end_point;
 		int idx = pc - 1;
 		while (p2 != begin_point) {
-			w[idx--] = p2->pos;
-			p2 = p2->prev_point;
+			w[idx--] = points[p2].pos;
+			p2 = search.points[p2].prev_point;
 		}
 
-		w[0] = p2->pos; // Assign first
+		w[0] = points[p2].pos; // Assign first
 	}
 
 	return path;
 }
 
 Vector<int> AStar::get_id_path(int p_from_id, int p_to_id) {
-	Point *a;
-	bool from_exists = points.lookup(p_from_id, a);
+	uint32_t a;
+	bool from_exists = point_indices.lookup(p_from_id, a);
 	ERR_FAIL_COND_V(!from_exists, Vector<int>());
 
-	Point *b;
-	bool to_exists = points.lookup(p_to_id, b);
+	uint32_t b;
+	bool to_exists = point_indices.lookup(p_to_id, b);
 	ERR_FAIL_COND_V(!to_exists, Vector<int>());
 
-	if (a == b) {
-		Vector<int> ret;
-		ret.push_back(a->id);
-		return ret;
-	}
-
-	Point *begin_point = a;
-	Point *end_point = b;
-
-	bool found_route = _solve(begin_point, end_point);
-	if (!found_route) {
-		return Vector<int>();
-	}
-
-	Point *p = end_point;
-	int pc = 1; // Begin point
-	while (p != begin_point) {
-		pc++;
-		p = p->prev_point;
-	}
-
-	Vector<int> path;
-	path.resize(pc);
-
-	{
-		int *w = path.ptrw();
-
-		p = end_point;
-		int idx = pc - 1;
-		while (p != begin_point) {
-			w[idx--] = p->id;
-			p = p->prev_point;
-		}
-
-		w[0] = p->id; // Assign first
-	}
+	_update_graph();
+	return _find_id_path(search, a, b, this);
+}
 
-	return path;
+Array AStar::get_id_paths(const Vector<int> &p_from_ids, const Vector<int> &p_to_ids) {
+	return _get_id_paths(p_from_ids, p_to_ids, this);
 }
 
 void AStar::set_point_disabled(int p_id, bool p_disabled) {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND(!p_exists);
 
-	p->enabled = !p_disabled;
+	points[index].enabled = !p_disabled;
 }
 
 bool AStar::is_point_disabled(int p_id) const {
-	Point *p;
-	bool p_exists = points.lookup(p_id, p);
+	uint32_t index;
+	bool p_exists = point_indices.lookup(p_id, index);
 	ERR_FAIL_COND_V(!p_exists, false);
 
-	return !p->enabled;
+	return !points[index].enabled;
 }
 
 void AStar::_bind_methods() {
@@ -562,6 +773,7 @@ void AStar::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("get_point_path", "from_id", "to_id"), &AStar::get_point_path);
 	ClassDB::bind_method(D_METHOD("get_id_path", "from_id", "to_id"), &AStar::get_id_path);
+	ClassDB::bind_method(D_METHOD("get_id_paths", "from_ids", "to_ids"), &AStar::get_id_paths);
 
 	BIND_VMETHOD(MethodInfo(Variant::FLOAT, "_estimate_cost", PropertyInfo(Variant::INT, "from_id"), PropertyInfo(Variant::INT, "to_id")));
 	BIND_VMETHOD(MethodInfo(Variant::FLOAT, "_compute_cost", PropertyInfo(Variant::INT, "from_id"), PropertyInfo(Variant::INT, "to_id")));
@@ -659,20 +871,25 @@ Vector2 AStar2D::get_closest_position_in_segment(const Vector2 &p_point) const {
 	return Vector2(p.x, p.y);
 }
 
+bool AStar2D::_has_script_costs() const {
+	ScriptInstance *script_instance = get_script_instance();
+	return script_instance && (script_instance->has_method(SceneStringNames::get_singleton()->_estimate_cost) || script_instance->has_method(SceneStringNames::get_singleton()->_compute_cost));
+}
+
 real_t AStar2D::_estimate_cost(int p_from_id, int p_to_id) {
 	if (get_script_instance() && get_script_instance()->has_method(SceneStringNames::get_singleton()->_estimate_cost)) {
 		return get_script_instance()->call(SceneStringNames::get_singleton()->_estimate_cost, p_from_id, p_to_id);
 	}
 
-	AStar::Point *from_point;
-	bool from_exists = astar.points.lookup(p_from_id, from_point);
+	uint32_t from_index;
+	bool from_exists = astar.point_indices.lookup(p_from_id, from_index);
 	ERR_FAIL_COND_V(!from_exists, 0);
 
-	AStar::Point *to_point;
-	bool to_exists = astar.points.lookup(p_to_id, to_point);
+	uint32_t to_index;
+	bool to_exists = astar.point_indices.lookup(p_to_id, to_index);
 	ERR_FAIL_COND_V(!to_exists, 0);
 
-	return from_point->pos.distance_to(to_point->pos);
+	return astar.points[from_index].pos.distance_to(astar.points[to_index].pos);
 }
 
 real_t AStar2D::_compute_cost(int p_from_id, int p_to_id) {
@@ -680,45 +897,46 @@ real_t AStar2D::_compute_cost(int p_from_id, int p_to_id) {
 		return get_script_instance()->call(SceneStringNames::get_singleton()->_compute_cost, p_from_id, p_to_id);
 	}
 
-	AStar::Point *from_point;
-	bool from_exists = astar.points.lookup(p_from_id, from_point);
+	uint32_t from_index;
+	bool from_exists = astar.point_indices.lookup(p_from_id, from_index);
 	ERR_FAIL_COND_V(!from_exists, 0);
 
-	AStar::Point *to_point;
-	bool to_exists = astar.points.lookup(p_to_id, to_point);
+	uint32_t to_index;
+	bool to_exists = astar.point_indices.lookup(p_to_id, to_index);
 	ERR_FAIL_COND_V(!to_exists, 0);
 
-	return from_point->pos.distance_to(to_point->pos);
+	return astar.points[from_index].pos.distance_to(astar.points[to_index].pos);
 }
 
 Vector<Vector2> AStar2D::get_point_path(int p_from_id, int p_to_id) {
-	AStar::Point *a;
-	bool from_exists = astar.points.lookup(p_from_id, a);
+	uint32_t a;
+	bool from_exists = astar.point_indices.lookup(p_from_id, a);
 	ERR_FAIL_COND_V(!from_exists, Vector<Vector2>());
 
-	AStar::Point *b;
-	bool to_exists = astar.points.lookup(p_to_id, b);
+	uint32_t b;
+	bool to_exists = astar.point_indices.lookup(p_to_id, b);
 	ERR_FAIL_COND_V(!to_exists, Vector<Vector2>());
 
 	if (a == b) {
 		Vector<Vector2> ret;
-		ret.push_back(Vector2(a->pos.x, a->pos.y));
+		ret.push_back(Vector2(astar.points[a].pos.x, astar.points[a].pos.y));
 		return ret;
 	}
 
-	AStar::Point *begin_point = a;
-	AStar::Point *end_point = b;
+	uint32_t begin_point = a;
+	uint32_t end_point = b;
 
-	bool found_route = _solve(begin_point, end_point);
+	astar._update_graph();
+	bool found_route = astar._solve(astar.search, begin_point, end_point, this);
 	if (!found_route) {
 		return Vector<Vector2>();
 	}
 
-	AStar::Point *p = end_point;
+	uint32_t p = end_point;
 	int pc = 1; // Begin point
 	while (p != begin_point) {
 		pc++;
-		p = p->prev_point;
+		p = astar.search.points[p].prev_point;
 	}
 
 	Vector<Vector2> path;
@@ -727,128 +945,34 @@ Vector<Vector2> AStar2D::get_point_path(int p_from_id, int p_to_id) {
 	{
 		Vector2 *w = path.ptrw();
 
-		AStar::Point *p2 = end_point;
+		uint32_t p2 = end_point;
 		int idx = pc - 1;
 		while (p2 != begin_point) {
-			w[idx--] = Vector2(p2->pos.x, p2->pos.y);
-			p2 = p2->prev_point;
+			w[idx--] = Vector2(astar.points[p2].pos.x, astar.points[p2].pos.y);
+			p2 = astar.search.points[p2].prev_point;
 		}
 
-		w[0] = Vector2(p2->pos.x, p2->pos.y); // Assign first
+		w[0] = Vector2(astar.points[p2].pos.x, astar.points[p2].pos.y); // Assign first
 	}
 
 	return path;
 }
 
 Vector<int> AStar2D::get_id_path(int p_from_id, int p_to_id) {
-	AStar::Point *a;
-	bool from_exists = astar.points.lookup(p_from_id, a);
+	uint32_t a;
+	bool from_exists = astar.point_indices.lookup(p_from_id, a);
 	ERR_FAIL_COND_V(!from_exists, Vector<int>());
 
-	AStar::Point *b;
-	bool to_exists = astar.points.lookup(p_to_id, b);
+	uint32_t b;
+	bool to_exists = astar.point_indices.lookup(p_to_id, b);
 	ERR_FAIL_COND_V(!to_exists, Vector<int>());
 
-	if (a == b) {
-		Vector<int> ret;
-		ret.push_back(a->id);
-		return ret;
-	}
-
-	AStar::Point *begin_point = a;
-	AStar::Point *end_point = b;
-
-	bool found_route = _solve(begin_point, end_point);
-	if (!found_route) {
-		return Vector<int>();
-	}
-
-	AStar::Point *p = end_point;
-	int pc = 1; // Begin point
-	while (p != begin_point) {
-		pc++;
-		p = p->prev_point;
-	}
-
-	Vector<int> path;
-	path.resize(pc);
-
-	{
-		int *w = path.ptrw();
-
-		p = end_point;
-		int idx = pc - 1;
-		while (p != begin_point) {
-			w[idx--] = p->id;
-			p = p->prev_point;
-		}
-
-		w[0] = p->id; // Assign first
-	}
-
-	return path;
+	astar._update_graph();
+	return astar._find_id_path(astar.search, a, b, this);
 }
 
-bool AStar2D::_solve(AStar::Point *begin_point, AStar::Point *end_point) {
-	astar.pass++;
-
-	if (!end_point->enabled) {
-		return false;
-	}
-
-	bool found_route = false;
-
-	Vector<AStar::Point *> open_list;
-	SortArray<AStar::Point *, AStar::SortPoints> sorter;
-
-	begin_point->g_score = 0;
-	begin_point->f_score = _estimate_cost(begin_point->id, end_point->id);
-	open_list.push_back(begin_point);
-
-	while (!open_list.empty()) {
-		AStar::Point *p = open_list[0]; // The currently processed point
-
-		if (p == end_point) {
-			found_route = true;
-			break;
-		}
-
-		sorter.pop_heap(0, open_list.size(), open_list.ptrw()); // Remove the current point from the open list
-		open_list.remove(open_list.size() - 1);
-		p->closed_pass = astar.pass; // Mark the point as closed
-
-		for (OAHashMap<int, AStar::Point *>::Iterator it = p->neighbours.iter(); it.valid; it = p->neighbours.next_iter(it)) {
-			AStar::Point *e = *(it.value); // The neighbour point
-
-			if (!e->enabled || e->closed_pass == astar.pass) {
-				continue;
-			}
-
-			real_t tentative_g_score = p->g_score + _compute_cost(p->id, e->id) * e->weight_scale;
-
-			bool new_point = false;
-
-			if (e->open_pass != astar.pass) { // The point wasn't inside the open list.
-				e->open_pass = astar.pass;
-				open_list.push_back(e);
-				new_point = true;
-			} else if (tentative_g_score >= e->g_score) { // The new path is worse than the previous.
-				continue;
-			}
-
-			e->prev_point = p;
-			e->g_score = tentative_g_score;
-			e->f_score = e->g_score + _estimate_cost(e->id, end_point->id);
-
-			if (new_point) { // The position of the new points is already known.
-				sorter.push_heap(0, open_list.size() - 1, 0, e, open_list.ptrw());
-			} else {
-				sorter.push_heap(0, open_list.find(e), 0, e, open_list.ptrw());
-			}
-		}
-	}
-
-	return found_route;
+Array AStar2D::get_id_paths(const Vector<int> &p_from_ids, const Vector<int> &p_to_ids) {
+	return astar._get_id_paths(p_from_ids, p_to_ids, this);
 }
 
 void AStar2D::_bind_methods() {
@@ -880,6 +1004,7 @@ void AStar2D::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("get_point_path", "from_id", "to_id"), &AStar2D::get_point_path);
 	ClassDB::bind_method(D_METHOD("get_id_path", "from_id", "to_id"), &AStar2D::get_id_path);
+	ClassDB::bind_method(D_METHOD("get_id_paths", "from_ids", "to_ids"), &AStar2D::get_id_paths);
 
 	BIND_VMETHOD(MethodInfo(Variant::FLOAT, "_estimate_cost", PropertyInfo(Variant::INT, "from_id"), PropertyInfo(Variant::INT, "to_id")));
 	BIND_VMETHOD(MethodInfo(Variant::FLOAT, "_compute_cost", PropertyInfo(Variant::INT, "from_id"), PropertyInfo(Variant::INT, "to_id")));
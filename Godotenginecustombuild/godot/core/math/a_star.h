@@ -32,6 +32,7 @@
 #define A_STAR_H
 
 #include "core/object/reference.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/oa_hash_map.h"
 
 /**
@@ -47,32 +48,32 @@ class AStar : public Reference {
 	struct Point {
 		Point() {}
 
-		int id;
+		int id = 0;
 		Vector3 pos;
-		real_t weight_scale;
-		bool enabled;
-
-		OAHashMap<int, Point *> neighbours = 4u;
-		OAHashMap<int, Point *> unlinked_neighbours = 4u;
-
-		// Used for pathfinding.
-		Point *prev_point;
-		real_t g_score;
-		real_t f_score;
-		uint64_t open_pass;
-		uint64_t closed_pass;
+		real_t weight_scale = 1;
+		bool enabled = true;
+
+		LocalVector<int> neighbours;
+		LocalVector<int> unlinked_neighbours;
 	};
 
-	struct SortPoints {
-		_FORCE_INLINE_ bool operator()(const Point *A, const Point *B) const { // Returns true when the Point A is worse than Point B.
-			if (A->f_score > B->f_score) {
-				return true;
-			} else if (A->f_score < B->f_score) {
-				return false;
-			} else {
-				return A->g_score < B->g_score; // If the f_costs are the same then prioritize the points that are further away from the start.
-			}
-		}
+	// Used for pathfinding, indexed like `points`.
+	struct SearchPoint {
+		// The point belongs to the current search only when this matches `Search::pass`.
+		uint32_t pass = 0;
+		// Position in `Search::open_list`, or `CLOSED`.
+		uint32_t open_index = 0;
+		uint32_t prev_point = 0;
+		real_t g_score = 0;
+		real_t f_score = 0;
+	};
+
+	// The state of one search, so that several can run at once.
+	struct Search {
+		LocalVector<SearchPoint> points;
+		// Indexed d-ary heap, the best point first.
+		LocalVector<uint32_t> open_list;
+		uint32_t pass = 0;
 	};
 
 	struct Segment {
@@ -108,13 +109,46 @@ class AStar : public Reference {
 		}
 	};
 
+	enum {
+		OPEN_LIST_ARITY = 4,
+	};
+	static const uint32_t CLOSED = UINT32_MAX;
+
+	template <class C>
+	struct PathQueries;
+
 	int last_free_id = 0;
-	uint64_t pass = 1;
 
-	OAHashMap<int, Point *> points;
+	// Points are stored contiguously, `point_indices` maps the ids to their index.
+	LocalVector<Point> points;
+	OAHashMap<int, uint32_t> point_indices;
 	Set<Segment> segments;
 
-	bool _solve(Point *begin_point, Point *end_point);
+	// The connections in compressed sparse row form, rebuilt before solving
+	// when they changed: the neighbours of the point `i` are the entries of
+	// `graph_neighbours` from `graph_offsets[i]` to `graph_offsets[i + 1]`.
+	bool graph_dirty = true;
+	LocalVector<uint32_t> graph_offsets;
+	LocalVector<uint32_t> graph_neighbours;
+
+	Search search;
+	// One per job of the batched searches.
+	LocalVector<Search> batch_searches;
+
+	void _update_graph();
+
+	static _FORCE_INLINE_ bool _is_better(const SearchPoint &p_a, const SearchPoint &p_b);
+	static void _open_list_sift_up(Search &r_search, uint32_t p_index);
+	static uint32_t _open_list_pop(Search &r_search);
+
+	template <class C>
+	bool _solve(Search &r_search, uint32_t p_begin_point, uint32_t p_end_point, C *p_costs);
+	template <class C>
+	Vector<int> _find_id_path(Search &r_search, uint32_t p_begin_point, uint32_t p_end_point, C *p_costs);
+	template <class C>
+	Array _get_id_paths(const Vector<int> &p_from_ids, const Vector<int> &p_to_ids, C *p_costs);
+
+	bool _has_script_costs() const;
 
 protected:
 	static void _bind_methods();
@@ -152,6 +186,9 @@ public:
 
 	Vector<Vector3> get_point_path(int p_from_id, int p_to_id);
 	Vector<int> get_id_path(int p_from_id, int p_to_id);
+	// Solves the path from `p_from_ids[i]` to `p_to_ids[i]` for each `i`, in
+	// parallel unless a script overrides the costs. C++ overrides must be thread safe.
+	Array get_id_paths(const Vector<int> &p_from_ids, const Vector<int> &p_to_ids);
 
 	AStar() {}
 	~AStar();
@@ -159,9 +196,10 @@ public:
 
 class AStar2D : public Reference {
 	GDCLASS(AStar2D, Reference);
+	friend class AStar;
 	AStar astar;
 
-	bool _solve(AStar::Point *begin_point, AStar::Point *end_point);
+	bool _has_script_costs() const;
 
 protected:
 	static void _bind_methods();
@@ -199,6 +237,7 @@ public:
 
 	Vector<Vector2> get_point_path(int p_from_id, int p_to_id);
 	Vector<int> get_id_path(int p_from_id, int p_to_id);
+	Array get_id_paths(const Vector<int> &p_from_ids, const Vector<int> &p_to_ids);
 
 	AStar2D() {}
 	~AStar2D() {}
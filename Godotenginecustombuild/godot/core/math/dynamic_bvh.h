@@ -0,0 +1,1155 @@
+/*************************************************************************/
+/*  dynamic_bvh.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef DYNAMIC_BVH_H
+#define DYNAMIC_BVH_H
+
+#include "core/math/aabb.h"
+#include "core/math/geometry_3d.h"
+#include "core/math/vector3.h"
+#include "core/templates/local_vector.h"
+
+#if !defined(REAL_T_IS_DOUBLE) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define DYNAMIC_BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+typedef uint32_t DynamicBVHElementID;
+
+#define DYNAMIC_BVH_ELEMENT_INVALID_ID 0
+#define DYNAMIC_BVH_SIZE_LIMIT 1e15
+
+/**
+ * Incrementally balanced AABB tree for objects that move a lot.
+ *
+ * Each element owns a leaf whose bounds are a "fat" copy of its AABB,
+ * grown by a margin and stretched along the last displacement. Moves that
+ * stay inside the fat bounds do not touch the tree. Leaves that are left
+ * behind are reinserted where they add the least surface area, and the
+ * branch is rebalanced with rotations on the way back up.
+ *
+ * Nodes, elements and pairs live in pooled arrays and refer to each other
+ * by index. The interface matches Octree, so either can be used.
+ */
+template <class T, bool use_pairs = false>
+class DynamicBVH {
+public:
+	typedef void *(*PairCallback)(void *, DynamicBVHElementID, T *, int, DynamicBVHElementID, T *, int);
+	typedef void (*UnpairCallback)(void *, DynamicBVHElementID, T *, int, DynamicBVHElementID, T *, int, void *);
+
+private:
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+	static const uint32_t INSIDE_BIT = 0x80000000;
+	// Siblings whose heights differ by more than this are rebalanced by
+	// height, which bounds the depth to about 4.5 * log2(n). Below
+	// that, rotations only look at surface area.
+	static const int MAX_IMBALANCE = 4;
+	static const int STACK_SIZE = 256;
+
+	struct Bounds {
+		// Padded to four lanes so SSE can load them directly.
+		real_t min[4];
+		real_t max[4];
+
+		_FORCE_INLINE_ void set_aabb(const AABB &p_aabb) {
+			min[0] = p_aabb.position.x;
+			min[1] = p_aabb.position.y;
+			min[2] = p_aabb.position.z;
+			min[3] = 0;
+			max[0] = p_aabb.position.x + p_aabb.size.x;
+			max[1] = p_aabb.position.y + p_aabb.size.y;
+			max[2] = p_aabb.position.z + p_aabb.size.z;
+			max[3] = 0;
+		}
+
+		_FORCE_INLINE_ AABB get_aabb() const {
+			return AABB(Vector3(min[0], min[1], min[2]), Vector3(max[0] - min[0], max[1] - min[1], max[2] - min[2]));
+		}
+
+		// Inclusive, like AABB::intersects_inclusive().
+		_FORCE_INLINE_ bool intersects(const Bounds &p_bounds) const {
+#ifdef DYNAMIC_BVH_USE_SSE
+			__m128 overlap = _mm_and_ps(
+					_mm_cmple_ps(_mm_loadu_ps(min), _mm_loadu_ps(p_bounds.max)),
+					_mm_cmple_ps(_mm_loadu_ps(p_bounds.min), _mm_loadu_ps(max)));
+			return (_mm_movemask_ps(overlap) & 7) == 7;
+#else
+			return min[0] <= p_bounds.max[0] && p_bounds.min[0] <= max[0] &&
+					min[1] <= p_bounds.max[1] && p_bounds.min[1] <= max[1] &&
+					min[2] <= p_bounds.max[2] && p_bounds.min[2] <= max[2];
+#endif
+		}
+
+		_FORCE_INLINE_ bool encloses(const Bounds &p_bounds) const {
+#ifdef DYNAMIC_BVH_USE_SSE
+			__m128 inside = _mm_and_ps(
+					_mm_cmple_ps(_mm_loadu_ps(min), _mm_loadu_ps(p_bounds.min)),
+					_mm_cmple_ps(_mm_loadu_ps(p_bounds.max), _mm_loadu_ps(max)));
+			return (_mm_movemask_ps(inside) & 7) == 7;
+#else
+			return min[0] <= p_bounds.min[0] && p_bounds.max[0] <= max[0] &&
+					min[1] <= p_bounds.min[1] && p_bounds.max[1] <= max[1] &&
+					min[2] <= p_bounds.min[2] && p_bounds.max[2] <= max[2];
+#endif
+		}
+
+		_FORCE_INLINE_ bool has_point(const Vector3 &p_point) const {
+			return min[0] <= p_point.x && p_point.x <= max[0] &&
+					min[1] <= p_point.y && p_point.y <= max[1] &&
+					min[2] <= p_point.z && p_point.z <= max[2];
+		}
+
+		_FORCE_INLINE_ bool operator==(const Bounds &p_bounds) const {
+			return min[0] == p_bounds.min[0] && min[1] == p_bounds.min[1] && min[2] == p_bounds.min[2] &&
+					max[0] == p_bounds.max[0] && max[1] == p_bounds.max[1] && max[2] == p_bounds.max[2];
+		}
+
+		// Half the surface area, the cost used to pick insertion points.
+		_FORCE_INLINE_ real_t get_cost() const {
+			real_t x = max[0] - min[0];
+			real_t y = max[1] - min[1];
+			real_t z = max[2] - min[2];
+			return x * y + y * z + z * x;
+		}
+
+		static _FORCE_INLINE_ Bounds merge(const Bounds &p_a, const Bounds &p_b) {
+			Bounds r;
+#ifdef DYNAMIC_BVH_USE_SSE
+			_mm_storeu_ps(r.min, _mm_min_ps(_mm_loadu_ps(p_a.min), _mm_loadu_ps(p_b.min)));
+			_mm_storeu_ps(r.max, _mm_max_ps(_mm_loadu_ps(p_a.max), _mm_loadu_ps(p_b.max)));
+#else
+			for (int i = 0; i < 4; i++) {
+				r.min[i] = MIN(p_a.min[i], p_b.min[i]);
+				r.max[i] = MAX(p_a.max[i], p_b.max[i]);
+			}
+#endif
+			return r;
+		}
+	};
+
+	struct Node {
+		Bounds bounds;
+		uint32_t parent = INVALID_INDEX;
+		uint32_t children[2] = { INVALID_INDEX, INVALID_INDEX };
+		uint32_t element = INVALID_INDEX; // Only set on leaves.
+		int height = 0; // Leaves are 0.
+
+		_FORCE_INLINE_ bool is_leaf() const { return children[0] == INVALID_INDEX; }
+	};
+
+	struct Element {
+		T *userdata = nullptr;
+		int subindex = 0;
+		bool used = false;
+		bool pairable = false;
+		uint32_t pairable_type = 0;
+		uint32_t pairable_mask = 0;
+		uint32_t leaf = INVALID_INDEX; // Not in the tree while the AABB has no surface.
+
+		AABB aabb;
+		Bounds bounds;
+
+		LocalVector<uint32_t> pairs;
+	};
+
+	// A pair exists while the fat bounds of A and B overlap, so it only has
+	// to be looked for again when either of them is reinserted. Callbacks
+	// follow the exact AABBs, tracked by intersect.
+	struct Pair {
+		uint32_t A = INVALID_INDEX;
+		uint32_t B = INVALID_INDEX;
+		bool intersect = false;
+		void *ud = nullptr;
+	};
+
+	LocalVector<Node> nodes;
+	LocalVector<uint32_t> free_nodes;
+	LocalVector<Element> elements;
+	LocalVector<uint32_t> free_elements;
+	LocalVector<Pair> pairs;
+	LocalVector<uint32_t> free_pairs;
+
+	uint32_t root = INVALID_INDEX;
+	int element_count = 0;
+	int pair_count = 0;
+	real_t margin;
+
+	PairCallback pair_callback = nullptr;
+	UnpairCallback unpair_callback = nullptr;
+	void *pair_callback_userdata = nullptr;
+	void *unpair_callback_userdata = nullptr;
+
+	uint32_t _alloc_node();
+	void _free_node(uint32_t p_node);
+
+	Bounds _make_fat(const AABB &p_aabb, const Vector3 &p_displacement) const;
+	bool _refit_node(uint32_t p_node);
+	uint32_t _balance(uint32_t p_node);
+	void _swap_children(uint32_t p_parent_a, int p_slot_a, uint32_t p_parent_b, int p_slot_b);
+	bool _rotate(uint32_t p_node);
+	void _refit_from(uint32_t p_node);
+	void _insert_leaf(uint32_t p_leaf);
+	void _remove_leaf(uint32_t p_leaf);
+
+	_FORCE_INLINE_ bool _can_pair(const Element &p_A, const Element &p_B) const {
+		if (!p_A.pairable && !p_B.pairable) {
+			return false; // Static elements never pair with each other.
+		}
+		if (p_A.userdata == p_B.userdata && p_A.userdata) {
+			return false;
+		}
+		return (p_A.pairable_type & p_B.pairable_mask) || (p_B.pairable_type & p_A.pairable_mask);
+	}
+
+	_FORCE_INLINE_ void _check_pair(uint32_t p_pair) {
+		Pair &p = pairs[p_pair];
+		const Element &A = elements[p.A];
+		const Element &B = elements[p.B];
+		bool intersect = A.bounds.intersects(B.bounds);
+
+		if (intersect != p.intersect) {
+			if (intersect) {
+				if (pair_callback) {
+					p.ud = pair_callback(pair_callback_userdata, p.A + 1, A.userdata, A.subindex, p.B + 1, B.userdata, B.subindex);
+				}
+				pair_count++;
+			} else {
+				if (unpair_callback) {
+					unpair_callback(unpair_callback_userdata, p.A + 1, A.userdata, A.subindex, p.B + 1, B.userdata, B.subindex, p.ud);
+				}
+				p.ud = nullptr;
+				pair_count--;
+			}
+
+			p.intersect = intersect;
+		}
+	}
+
+	_FORCE_INLINE_ void _check_pairs(uint32_t p_element) {
+		const LocalVector<uint32_t> &list = elements[p_element].pairs;
+		for (uint32_t i = 0; i < list.size(); i++) {
+			_check_pair(list[i]);
+		}
+	}
+
+	uint32_t _find_pair(uint32_t p_A, uint32_t p_B) const;
+	void _add_pair(uint32_t p_A, uint32_t p_B);
+	void _remove_pair(uint32_t p_pair);
+	void _clear_pairs(uint32_t p_element);
+	void _update_pairs(uint32_t p_element);
+
+	enum CullResult {
+		CULL_OUTSIDE,
+		CULL_INTERSECT,
+		CULL_INSIDE, // Everything below passes without further tests.
+	};
+
+	struct _CullAABB {
+		Bounds bounds;
+
+		_FORCE_INLINE_ CullResult test_node(const Bounds &p_bounds) const {
+			if (!bounds.intersects(p_bounds)) {
+				return CULL_OUTSIDE;
+			}
+			return bounds.encloses(p_bounds) ? CULL_INSIDE : CULL_INTERSECT;
+		}
+		_FORCE_INLINE_ bool test_element(const Element &p_element) const {
+			return bounds.intersects(p_element.bounds);
+		}
+	};
+
+	struct _CullSegment {
+		Vector3 from;
+		Vector3 to;
+
+		_FORCE_INLINE_ CullResult test_node(const Bounds &p_bounds) const {
+			return p_bounds.get_aabb().intersects_segment(from, to) ? CULL_INTERSECT : CULL_OUTSIDE;
+		}
+		_FORCE_INLINE_ bool test_element(const Element &p_element) const {
+			return p_element.aabb.intersects_segment(from, to);
+		}
+	};
+
+	struct _CullPoint {
+		Vector3 point;
+
+		_FORCE_INLINE_ CullResult test_node(const Bounds &p_bounds) const {
+			return p_bounds.has_point(point) ? CULL_INTERSECT : CULL_OUTSIDE;
+		}
+		_FORCE_INLINE_ bool test_element(const Element &p_element) const {
+			return p_element.aabb.has_point(point);
+		}
+	};
+
+	struct _CullConvex {
+		const Plane *planes;
+		int plane_count;
+		const Vector3 *points;
+		int point_count;
+
+		_FORCE_INLINE_ CullResult test_node(const Bounds &p_bounds) const {
+			AABB aabb = p_bounds.get_aabb();
+			if (!aabb.intersects_convex_shape(planes, plane_count, points, point_count)) {
+				return CULL_OUTSIDE;
+			}
+			return aabb.inside_convex_shape(planes, plane_count) ? CULL_INSIDE : CULL_INTERSECT;
+		}
+		_FORCE_INLINE_ bool test_element(const Element &p_element) const {
+			return p_element.aabb.intersects_convex_shape(planes, plane_count, points, point_count);
+		}
+	};
+
+	template <class Q>
+	int _cull(const Q &p_query, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const;
+
+	_FORCE_INLINE_ Element *_get_element(DynamicBVHElementID p_id) {
+		uint32_t index = p_id - 1;
+		if (index >= elements.size() || !elements[index].used) {
+			return nullptr;
+		}
+		return &elements[index];
+	}
+
+	_FORCE_INLINE_ const Element *_get_element(DynamicBVHElementID p_id) const {
+		uint32_t index = p_id - 1;
+		if (index >= elements.size() || !elements[index].used) {
+			return nullptr;
+		}
+		return &elements[index];
+	}
+
+public:
+	DynamicBVHElementID create(T *p_userdata, const AABB &p_aabb = AABB(), int p_subindex = 0, bool p_pairable = false, uint32_t p_pairable_type = 0, uint32_t pairable_mask = 1);
+	void move(DynamicBVHElementID p_id, const AABB &p_aabb);
+	void set_pairable(DynamicBVHElementID p_id, bool p_pairable = false, uint32_t p_pairable_type = 0, uint32_t pairable_mask = 1);
+	void erase(DynamicBVHElementID p_id);
+
+	bool is_pairable(DynamicBVHElementID p_id) const;
+	T *get(DynamicBVHElementID p_id) const;
+	int get_subindex(DynamicBVHElementID p_id) const;
+
+	int cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+	int cull_aabb(const AABB &p_aabb, T **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
+	int cull_segment(const Vector3 &p_from, const Vector3 &p_to, T **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
+
+	int cull_point(const Vector3 &p_point, T **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF);
+
+	void set_pair_callback(PairCallback p_callback, void *p_userdata);
+	void set_unpair_callback(UnpairCallback p_callback, void *p_userdata);
+
+	int get_element_count() const { return element_count; }
+	int get_node_count() const { return nodes.size() - free_nodes.size(); }
+	int get_pair_count() const { return pair_count; }
+	int get_height() const { return root == INVALID_INDEX ? 0 : nodes[root].height; }
+
+	// p_margin is how far an element can move before its leaf is reinserted.
+	DynamicBVH(real_t p_margin = 0.1);
+};
+
+template <class T, bool use_pairs>
+uint32_t DynamicBVH<T, use_pairs>::_alloc_node() {
+	uint32_t index;
+	if (free_nodes.size()) {
+		index = free_nodes[free_nodes.size() - 1];
+		free_nodes.resize(free_nodes.size() - 1);
+		nodes[index] = Node();
+	} else {
+		index = nodes.size();
+		nodes.push_back(Node());
+	}
+	return index;
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_free_node(uint32_t p_node) {
+	free_nodes.push_back(p_node);
+}
+
+template <class T, bool use_pairs>
+typename DynamicBVH<T, use_pairs>::Bounds DynamicBVH<T, use_pairs>::_make_fat(const AABB &p_aabb, const Vector3 &p_displacement) const {
+	Bounds fat;
+	fat.set_aabb(p_aabb);
+	for (int i = 0; i < 3; i++) {
+		fat.min[i] -= margin;
+		fat.max[i] += margin;
+
+		// Stretch towards where the element is heading, but not so far that
+		// a teleport (or a floating origin shift) covers half the world.
+		real_t limit = (fat.max[i] - fat.min[i]) * 8;
+		real_t ahead = CLAMP(p_displacement[i] * 4, -limit, limit);
+		if (ahead < 0) {
+			fat.min[i] += ahead;
+		} else {
+			fat.max[i] += ahead;
+		}
+	}
+	return fat;
+}
+
+template <class T, bool use_pairs>
+bool DynamicBVH<T, use_pairs>::_refit_node(uint32_t p_node) {
+	Node &node = nodes[p_node];
+	const Node &child0 = nodes[node.children[0]];
+	const Node &child1 = nodes[node.children[1]];
+	int height = 1 + MAX(child0.height, child1.height);
+	Bounds bounds = Bounds::merge(child0.bounds, child1.bounds);
+	if (height == node.height && bounds == node.bounds) {
+		return false;
+	}
+	node.height = height;
+	node.bounds = bounds;
+	return true;
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_swap_children(uint32_t p_parent_a, int p_slot_a, uint32_t p_parent_b, int p_slot_b) {
+	uint32_t a = nodes[p_parent_a].children[p_slot_a];
+	uint32_t b = nodes[p_parent_b].children[p_slot_b];
+	nodes[p_parent_a].children[p_slot_a] = b;
+	nodes[b].parent = p_parent_a;
+	nodes[p_parent_b].children[p_slot_b] = a;
+	nodes[a].parent = p_parent_b;
+}
+
+template <class T, bool use_pairs>
+bool DynamicBVH<T, use_pairs>::_rotate(uint32_t p_node) {
+	// Swaps a child of p_node with a grandchild, or two grandchildren, when
+	// that shrinks the children. Unlike rotating by height, this keeps
+	// nearby objects together, which is what queries care about.
+	const Node &a = nodes[p_node];
+	if (a.height < 2) {
+		return false; // Only leaves below, nothing to rotate.
+	}
+
+	enum {
+		ROTATE_NONE,
+		ROTATE_B_F,
+		ROTATE_B_G,
+		ROTATE_C_D,
+		ROTATE_C_E,
+		ROTATE_D_F,
+		ROTATE_D_G,
+	};
+
+	uint32_t b_index = a.children[0];
+	uint32_t c_index = a.children[1];
+	const Node &b = nodes[b_index];
+	const Node &c = nodes[c_index];
+	real_t b_cost = b.bounds.get_cost();
+	real_t c_cost = c.bounds.get_cost();
+
+	int best = ROTATE_NONE;
+	real_t best_gain = 0;
+
+	if (!c.is_leaf()) {
+		const Bounds &f = nodes[c.children[0]].bounds;
+		const Bounds &g = nodes[c.children[1]].bounds;
+
+		real_t gain = c_cost - Bounds::merge(b.bounds, g).get_cost();
+		if (gain > best_gain) {
+			best = ROTATE_B_F;
+			best_gain = gain;
+		}
+		gain = c_cost - Bounds::merge(f, b.bounds).get_cost();
+		if (gain > best_gain) {
+			best = ROTATE_B_G;
+			best_gain = gain;
+		}
+	}
+
+	if (!b.is_leaf()) {
+		const Bounds &d = nodes[b.children[0]].bounds;
+		const Bounds &e = nodes[b.children[1]].bounds;
+
+		real_t gain = b_cost - Bounds::merge(c.bounds, e).get_cost();
+		if (gain > best_gain) {
+			best = ROTATE_C_D;
+			best_gain = gain;
+		}
+		gain = b_cost - Bounds::merge(d, c.bounds).get_cost();
+		if (gain > best_gain) {
+			best = ROTATE_C_E;
+			best_gain = gain;
+		}
+
+		if (!c.is_leaf()) {
+			const Bounds &f = nodes[c.children[0]].bounds;
+			const Bounds &g = nodes[c.children[1]].bounds;
+
+			gain = b_cost + c_cost - Bounds::merge(f, e).get_cost() - Bounds::merge(d, g).get_cost();
+			if (gain > best_gain) {
+				best = ROTATE_D_F;
+				best_gain = gain;
+			}
+			gain = b_cost + c_cost - Bounds::merge(g, e).get_cost() - Bounds::merge(f, d).get_cost();
+			if (gain > best_gain) {
+				best = ROTATE_D_G;
+				best_gain = gain;
+			}
+		}
+	}
+
+	switch (best) {
+		case ROTATE_NONE: {
+			return false;
+		} break;
+		case ROTATE_B_F: {
+			_swap_children(p_node, 0, c_index, 0);
+			_refit_node(c_index);
+		} break;
+		case ROTATE_B_G: {
+			_swap_children(p_node, 0, c_index, 1);
+			_refit_node(c_index);
+		} break;
+		case ROTATE_C_D: {
+			_swap_children(p_node, 1, b_index, 0);
+			_refit_node(b_index);
+		} break;
+		case ROTATE_C_E: {
+			_swap_children(p_node, 1, b_index, 1);
+			_refit_node(b_index);
+		} break;
+		case ROTATE_D_F: {
+			_swap_children(b_index, 0, c_index, 0);
+			_refit_node(b_index);
+			_refit_node(c_index);
+		} break;
+		case ROTATE_D_G: {
+			_swap_children(b_index, 0, c_index, 1);
+			_refit_node(b_index);
+			_refit_node(c_index);
+		} break;
+	}
+
+	// The bounds stay the same, but the height can change.
+	return _refit_node(p_node);
+}
+
+template <class T, bool use_pairs>
+uint32_t DynamicBVH<T, use_pairs>::_balance(uint32_t p_node) {
+	Node &a = nodes[p_node];
+	if (a.is_leaf() || a.height < 2) {
+		return p_node;
+	}
+
+	uint32_t b_index = a.children[0];
+	uint32_t c_index = a.children[1];
+	Node &b = nodes[b_index];
+	Node &c = nodes[c_index];
+
+	int balance = c.height - b.height;
+
+	if (balance > 1) {
+		// Rotate C up.
+		uint32_t f_index = c.children[0];
+		uint32_t g_index = c.children[1];
+		Node &f = nodes[f_index];
+		Node &g = nodes[g_index];
+
+		c.children[0] = p_node;
+		c.parent = a.parent;
+		a.parent = c_index;
+
+		if (c.parent != INVALID_INDEX) {
+			Node &parent = nodes[c.parent];
+			parent.children[parent.children[0] == p_node ? 0 : 1] = c_index;
+		} else {
+			root = c_index;
+		}
+
+		if (f.height > g.height) {
+			c.children[1] = f_index;
+			a.children[1] = g_index;
+			g.parent = p_node;
+			a.bounds = Bounds::merge(b.bounds, g.bounds);
+			c.bounds = Bounds::merge(a.bounds, f.bounds);
+			a.height = 1 + MAX(b.height, g.height);
+			c.height = 1 + MAX(a.height, f.height);
+		} else {
+			c.children[1] = g_index;
+			a.children[1] = f_index;
+			f.parent = p_node;
+			a.bounds = Bounds::merge(b.bounds, f.bounds);
+			c.bounds = Bounds::merge(a.bounds, g.bounds);
+			a.height = 1 + MAX(b.height, f.height);
+			c.height = 1 + MAX(a.height, g.height);
+		}
+
+		return c_index;
+	}
+
+	if (balance < -1) {
+		// Rotate B up.
+		uint32_t d_index = b.children[0];
+		uint32_t e_index = b.children[1];
+		Node &d = nodes[d_index];
+		Node &e = nodes[e_index];
+
+		b.children[0] = p_node;
+		b.parent = a.parent;
+		a.parent = b_index;
+
+		if (b.parent != INVALID_INDEX) {
+			Node &parent = nodes[b.parent];
+			parent.children[parent.children[0] == p_node ? 0 : 1] = b_index;
+		} else {
+			root = b_index;
+		}
+
+		if (d.height > e.height) {
+			b.children[1] = d_index;
+			a.children[0] = e_index;
+			e.parent = p_node;
+			a.bounds = Bounds::merge(c.bounds, e.bounds);
+			b.bounds = Bounds::merge(a.bounds, d.bounds);
+			a.height = 1 + MAX(c.height, e.height);
+			b.height = 1 + MAX(a.height, d.height);
+		} else {
+			b.children[1] = e_index;
+			a.children[0] = d_index;
+			d.parent = p_node;
+			a.bounds = Bounds::merge(c.bounds, d.bounds);
+			b.bounds = Bounds::merge(a.bounds, e.bounds);
+			a.height = 1 + MAX(c.height, d.height);
+			b.height = 1 + MAX(a.height, e.height);
+		}
+
+		return b_index;
+	}
+
+	return p_node;
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_refit_from(uint32_t p_node) {
+	uint32_t index = p_node;
+	while (index != INVALID_INDEX) {
+		bool changed = _refit_node(index);
+		const Node &node = nodes[index];
+		if (ABS(nodes[node.children[0]].height - nodes[node.children[1]].height) > MAX_IMBALANCE) {
+			index = _balance(index);
+			changed = true;
+		} else {
+			changed = _rotate(index) || changed;
+		}
+		if (!changed && index != p_node) {
+			break; // Nothing above can change either.
+		}
+		index = nodes[index].parent;
+	}
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_insert_leaf(uint32_t p_leaf) {
+	if (root == INVALID_INDEX) {
+		root = p_leaf;
+		nodes[p_leaf].parent = INVALID_INDEX;
+		return;
+	}
+
+	// Walk down to the sibling that grows the tree the least.
+	const Bounds leaf_bounds = nodes[p_leaf].bounds;
+	uint32_t index = root;
+	while (!nodes[index].is_leaf()) {
+		const Node &node = nodes[index];
+
+		real_t cost = node.bounds.get_cost();
+		real_t combined_cost = Bounds::merge(node.bounds, leaf_bounds).get_cost();
+
+		// Cost of making a new parent for this node and the leaf.
+		real_t sibling_cost = 2 * combined_cost;
+		// Cost that every node below pays for growing this one.
+		real_t inheritance_cost = 2 * (combined_cost - cost);
+
+		real_t child_cost[2];
+		for (int i = 0; i < 2; i++) {
+			const Node &child = nodes[node.children[i]];
+			real_t grown = Bounds::merge(child.bounds, leaf_bounds).get_cost();
+			child_cost[i] = (child.is_leaf() ? grown : grown - child.bounds.get_cost()) + inheritance_cost;
+		}
+
+		if (sibling_cost < child_cost[0] && sibling_cost < child_cost[1]) {
+			break;
+		}
+
+		index = node.children[child_cost[0] < child_cost[1] ? 0 : 1];
+	}
+
+	uint32_t sibling = index;
+	uint32_t new_parent = _alloc_node();
+	uint32_t old_parent = nodes[sibling].parent;
+
+	Node &parent = nodes[new_parent];
+	parent.parent = old_parent;
+	parent.bounds = Bounds::merge(leaf_bounds, nodes[sibling].bounds);
+	parent.height = nodes[sibling].height + 1;
+	parent.children[0] = sibling;
+	parent.children[1] = p_leaf;
+
+	if (old_parent != INVALID_INDEX) {
+		Node &old = nodes[old_parent];
+		old.children[old.children[0] == sibling ? 0 : 1] = new_parent;
+	} else {
+		root = new_parent;
+	}
+
+	nodes[sibling].parent = new_parent;
+	nodes[p_leaf].parent = new_parent;
+
+	_refit_from(new_parent);
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_remove_leaf(uint32_t p_leaf) {
+	if (p_leaf == root) {
+		root = INVALID_INDEX;
+		return;
+	}
+
+	uint32_t parent = nodes[p_leaf].parent;
+	uint32_t grand_parent = nodes[parent].parent;
+	uint32_t sibling = nodes[parent].children[nodes[parent].children[0] == p_leaf ? 1 : 0];
+
+	if (grand_parent != INVALID_INDEX) {
+		Node &grand = nodes[grand_parent];
+		grand.children[grand.children[0] == parent ? 0 : 1] = sibling;
+		nodes[sibling].parent = grand_parent;
+		_free_node(parent);
+		_refit_from(grand_parent);
+	} else {
+		root = sibling;
+		nodes[sibling].parent = INVALID_INDEX;
+		_free_node(parent);
+	}
+
+	nodes[p_leaf].parent = INVALID_INDEX;
+}
+
+template <class T, bool use_pairs>
+uint32_t DynamicBVH<T, use_pairs>::_find_pair(uint32_t p_A, uint32_t p_B) const {
+	// Look through the shorter list, big areas can have long ones.
+	const LocalVector<uint32_t> &list_A = elements[p_A].pairs;
+	const LocalVector<uint32_t> &list_B = elements[p_B].pairs;
+	const LocalVector<uint32_t> &list = list_A.size() < list_B.size() ? list_A : list_B;
+	for (uint32_t i = 0; i < list.size(); i++) {
+		const Pair &p = pairs[list[i]];
+		if ((p.A == p_A && p.B == p_B) || (p.A == p_B && p.B == p_A)) {
+			return list[i];
+		}
+	}
+	return INVALID_INDEX;
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_add_pair(uint32_t p_A, uint32_t p_B) {
+	uint32_t index;
+	if (free_pairs.size()) {
+		index = free_pairs[free_pairs.size() - 1];
+		free_pairs.resize(free_pairs.size() - 1);
+	} else {
+		index = pairs.size();
+		pairs.push_back(Pair());
+	}
+
+	Pair &p = pairs[index];
+	p.A = p_A;
+	p.B = p_B;
+	p.intersect = false;
+	p.ud = nullptr;
+
+	elements[p_A].pairs.push_back(index);
+	elements[p_B].pairs.push_back(index);
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_remove_pair(uint32_t p_pair) {
+	Pair &p = pairs[p_pair];
+
+	if (p.intersect) {
+		const Element &A = elements[p.A];
+		const Element &B = elements[p.B];
+		if (unpair_callback) {
+			unpair_callback(unpair_callback_userdata, p.A + 1, A.userdata, A.subindex, p.B + 1, B.userdata, B.subindex, p.ud);
+		}
+		pair_count--;
+	}
+
+	uint32_t owners[2] = { p.A, p.B };
+	for (int i = 0; i < 2; i++) {
+		// Order does not matter, so swap the last one in.
+		LocalVector<uint32_t> &list = elements[owners[i]].pairs;
+		int64_t pos = list.find(p_pair);
+		ERR_CONTINUE(pos < 0);
+		list[pos] = list[list.size() - 1];
+		list.resize(list.size() - 1);
+	}
+
+	p.A = INVALID_INDEX;
+	p.B = INVALID_INDEX;
+	p.intersect = false;
+	p.ud = nullptr;
+	free_pairs.push_back(p_pair);
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_clear_pairs(uint32_t p_element) {
+	LocalVector<uint32_t> &list = elements[p_element].pairs;
+	while (list.size()) {
+		_remove_pair(list[list.size() - 1]);
+	}
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::_update_pairs(uint32_t p_element) {
+	Element &e = elements[p_element];
+	const Bounds &fat = nodes[e.leaf].bounds;
+
+	// Drop the pairs whose leaves no longer overlap...
+	for (uint32_t i = 0; i < e.pairs.size();) {
+		const Pair &p = pairs[e.pairs[i]];
+		uint32_t other = p.A == p_element ? p.B : p.A;
+		if (fat.intersects(nodes[elements[other].leaf].bounds)) {
+			i++;
+		} else {
+			_remove_pair(e.pairs[i]); // Moves the last pair to i.
+		}
+	}
+
+	// ...and add the ones that started to.
+	uint32_t stack[STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = root;
+
+	while (stack_size) {
+		const Node &node = nodes[stack[--stack_size]];
+		if (!node.bounds.intersects(fat)) {
+			continue;
+		}
+
+		if (node.is_leaf()) {
+			if (node.element != p_element && _can_pair(e, elements[node.element]) && _find_pair(p_element, node.element) == INVALID_INDEX) {
+				_add_pair(p_element, node.element);
+			}
+		} else {
+			ERR_FAIL_COND(stack_size + 2 > STACK_SIZE);
+			stack[stack_size++] = node.children[0];
+			stack[stack_size++] = node.children[1];
+		}
+	}
+
+	_check_pairs(p_element);
+}
+
+template <class T, bool use_pairs>
+template <class Q>
+int DynamicBVH<T, use_pairs>::_cull(const Q &p_query, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+	if (root == INVALID_INDEX || p_result_max <= 0) {
+		return 0;
+	}
+
+	int result_count = 0;
+	uint32_t stack[STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = root;
+
+	while (stack_size) {
+		uint32_t index = stack[--stack_size];
+		bool inside = index & INSIDE_BIT;
+		const Node &node = nodes[index & ~INSIDE_BIT];
+
+		if (!inside) {
+			CullResult result = p_query.test_node(node.bounds);
+			if (result == CULL_OUTSIDE) {
+				continue;
+			}
+			inside = result == CULL_INSIDE;
+		}
+
+		if (node.is_leaf()) {
+			const Element &e = elements[node.element];
+			if (use_pairs && !(e.pairable_type & p_mask)) {
+				continue;
+			}
+			if (!inside && !p_query.test_element(e)) {
+				continue;
+			}
+
+			p_result_array[result_count] = e.userdata;
+			if (p_subindex_array) {
+				p_subindex_array[result_count] = e.subindex;
+			}
+			result_count++;
+			if (result_count == p_result_max) {
+				break;
+			}
+		} else {
+			ERR_FAIL_COND_V(stack_size + 2 > STACK_SIZE, result_count);
+			uint32_t flag = inside ? INSIDE_BIT : 0;
+			stack[stack_size++] = node.children[1] | flag;
+			stack[stack_size++] = node.children[0] | flag;
+		}
+	}
+
+	return result_count;
+}
+
+template <class T, bool use_pairs>
+DynamicBVHElementID DynamicBVH<T, use_pairs>::create(T *p_userdata, const AABB &p_aabb, int p_subindex, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+// check for AABB validity
+#ifdef DEBUG_ENABLED
+	ERR_FAIL_COND_V(p_aabb.position.x > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.position.x < -DYNAMIC_BVH_SIZE_LIMIT, DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(p_aabb.position.y > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.position.y < -DYNAMIC_BVH_SIZE_LIMIT, DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(p_aabb.position.z > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.position.z < -DYNAMIC_BVH_SIZE_LIMIT, DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(p_aabb.size.x > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.size.x < 0.0, DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(p_aabb.size.y > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.size.y < 0.0, DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(p_aabb.size.z > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.size.z < 0.0, DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(Math::is_nan(p_aabb.size.x), DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(Math::is_nan(p_aabb.size.y), DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	ERR_FAIL_COND_V(Math::is_nan(p_aabb.size.z), DYNAMIC_BVH_ELEMENT_INVALID_ID);
+#endif
+	uint32_t index;
+	if (free_elements.size()) {
+		index = free_elements[free_elements.size() - 1];
+		free_elements.resize(free_elements.size() - 1);
+	} else {
+		index = elements.size();
+		elements.push_back(Element());
+	}
+
+	Element &e = elements[index];
+	e.userdata = p_userdata;
+	e.subindex = p_subindex;
+	e.used = true;
+	e.pairable = p_pairable;
+	e.pairable_type = p_pairable_type;
+	e.pairable_mask = p_pairable_mask;
+	e.aabb = p_aabb;
+	e.bounds.set_aabb(p_aabb);
+	element_count++;
+
+	if (!p_aabb.has_no_surface()) {
+		uint32_t leaf = _alloc_node();
+		nodes[leaf].element = index;
+		nodes[leaf].bounds = _make_fat(p_aabb, Vector3());
+		e.leaf = leaf;
+		_insert_leaf(leaf);
+		if (use_pairs) {
+			_update_pairs(index);
+		}
+	}
+
+	return index + 1;
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::move(DynamicBVHElementID p_id, const AABB &p_aabb) {
+#ifdef DEBUG_ENABLED
+	// check for AABB validity
+	ERR_FAIL_COND(p_aabb.position.x > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.position.x < -DYNAMIC_BVH_SIZE_LIMIT);
+	ERR_FAIL_COND(p_aabb.position.y > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.position.y < -DYNAMIC_BVH_SIZE_LIMIT);
+	ERR_FAIL_COND(p_aabb.position.z > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.position.z < -DYNAMIC_BVH_SIZE_LIMIT);
+	ERR_FAIL_COND(p_aabb.size.x > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.size.x < 0.0);
+	ERR_FAIL_COND(p_aabb.size.y > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.size.y < 0.0);
+	ERR_FAIL_COND(p_aabb.size.z > DYNAMIC_BVH_SIZE_LIMIT || p_aabb.size.z < 0.0);
+	ERR_FAIL_COND(Math::is_nan(p_aabb.size.x));
+	ERR_FAIL_COND(Math::is_nan(p_aabb.size.y));
+	ERR_FAIL_COND(Math::is_nan(p_aabb.size.z));
+#endif
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+	uint32_t index = p_id - 1;
+
+	Vector3 displacement = p_aabb.position - e->aabb.position;
+	e->aabb = p_aabb;
+	e->bounds.set_aabb(p_aabb);
+
+	if (p_aabb.has_no_surface()) {
+		if (e->leaf != INVALID_INDEX) {
+			if (use_pairs) {
+				_clear_pairs(index);
+			}
+			_remove_leaf(e->leaf);
+			_free_node(e->leaf);
+			e->leaf = INVALID_INDEX;
+		}
+		return;
+	}
+
+	if (e->leaf == INVALID_INDEX) {
+		uint32_t leaf = _alloc_node();
+		nodes[leaf].element = index;
+		nodes[leaf].bounds = _make_fat(p_aabb, Vector3());
+		e->leaf = leaf;
+		_insert_leaf(leaf);
+		if (use_pairs) {
+			_update_pairs(index);
+		}
+		return;
+	}
+
+	if (nodes[e->leaf].bounds.encloses(e->bounds)) {
+		// Still inside the fat bounds, the tree and the pair list stay valid.
+		if (use_pairs) {
+			_check_pairs(index);
+		}
+		return;
+	}
+
+	_remove_leaf(e->leaf);
+	nodes[e->leaf].bounds = _make_fat(p_aabb, displacement);
+	_insert_leaf(e->leaf);
+	if (use_pairs) {
+		_update_pairs(index);
+	}
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::set_pairable(DynamicBVHElementID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (p_pairable == e->pairable && e->pairable_type == p_pairable_type && e->pairable_mask == p_pairable_mask) {
+		return; // no changes, return
+	}
+
+	// Like Octree, every pair is dropped and found again.
+	bool in_tree = e->leaf != INVALID_INDEX;
+	if (use_pairs && in_tree) {
+		_clear_pairs(p_id - 1);
+	}
+
+	e->pairable = p_pairable;
+	e->pairable_type = p_pairable_type;
+	e->pairable_mask = p_pairable_mask;
+
+	if (use_pairs && in_tree) {
+		_update_pairs(p_id - 1);
+	}
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::erase(DynamicBVHElementID p_id) {
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (e->leaf != INVALID_INDEX) {
+		if (use_pairs) {
+			_clear_pairs(p_id - 1);
+		}
+		_remove_leaf(e->leaf);
+		_free_node(e->leaf);
+	}
+
+	e->pairs.reset();
+	*e = Element();
+	free_elements.push_back(p_id - 1);
+	element_count--;
+}
+
+template <class T, bool use_pairs>
+bool DynamicBVH<T, use_pairs>::is_pairable(DynamicBVHElementID p_id) const {
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, false);
+	return e->pairable;
+}
+
+template <class T, bool use_pairs>
+T *DynamicBVH<T, use_pairs>::get(DynamicBVHElementID p_id) const {
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, nullptr);
+	return e->userdata;
+}
+
+template <class T, bool use_pairs>
+int DynamicBVH<T, use_pairs>::get_subindex(DynamicBVHElementID p_id) const {
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, -1);
+	return e->subindex;
+}
+
+template <class T, bool use_pairs>
+int DynamicBVH<T, use_pairs>::cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask) {
+	if (root == INVALID_INDEX || p_convex.size() == 0) {
+		return 0;
+	}
+
+	Vector<Vector3> convex_points = Geometry3D::compute_convex_mesh_points(&p_convex[0], p_convex.size());
+	if (convex_points.size() == 0) {
+		return 0;
+	}
+
+	_CullConvex query;
+	query.planes = &p_convex[0];
+	query.plane_count = p_convex.size();
+	query.points = &convex_points[0];
+	query.point_count = convex_points.size();
+	return _cull(query, p_result_array, p_result_max, nullptr, p_mask);
+}
+
+template <class T, bool use_pairs>
+int DynamicBVH<T, use_pairs>::cull_aabb(const AABB &p_aabb, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) {
+	_CullAABB query;
+	query.bounds.set_aabb(p_aabb);
+	return _cull(query, p_result_array, p_result_max, p_subindex_array, p_mask);
+}
+
+template <class T, bool use_pairs>
+int DynamicBVH<T, use_pairs>::cull_segment(const Vector3 &p_from, const Vector3 &p_to, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) {
+	_CullSegment query;
+	query.from = p_from;
+	query.to = p_to;
+	return _cull(query, p_result_array, p_result_max, p_subindex_array, p_mask);
+}
+
+template <class T, bool use_pairs>
+int DynamicBVH<T, use_pairs>::cull_point(const Vector3 &p_point, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) {
+	_CullPoint query;
+	query.point = p_point;
+	return _cull(query, p_result_array, p_result_max, p_subindex_array, p_mask);
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::set_pair_callback(PairCallback p_callback, void *p_userdata) {
+	pair_callback = p_callback;
+	pair_callback_userdata = p_userdata;
+}
+
+template <class T, bool use_pairs>
+void DynamicBVH<T, use_pairs>::set_unpair_callback(UnpairCallback p_callback, void *p_userdata) {
+	unpair_callback = p_callback;
+	unpair_callback_userdata = p_userdata;
+}
+
+template <class T, bool use_pairs>
+DynamicBVH<T, use_pairs>::DynamicBVH(real_t p_margin) {
+	margin = p_margin;
+}
+
+#endif // DYNAMIC_BVH_H
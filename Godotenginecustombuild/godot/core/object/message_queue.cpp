@@ -35,11 +35,177 @@
 #include "core/object/script_language.h"
 
 MessageQueue *MessageQueue::singleton = nullptr;
+thread_local MessageQueue::ThreadProducer MessageQueue::thread_producer;
+std::atomic<uint64_t> MessageQueue::last_queue_id(0);
+
+MessageQueue::ThreadProducer::~ThreadProducer() {
+	// flush() frees the producer once it is drained. At exit the queue may already be gone.
+	if (producer && singleton && singleton->queue_id == queue_id) {
+		producer->abandoned.store(true, std::memory_order_release);
+	}
+}
 
 MessageQueue *MessageQueue::get_singleton() {
 	return singleton;
 }
 
+MessageQueue::Segment *MessageQueue::_alloc_segment(uint32_t p_min_size) {
+	uint32_t size = MAX((uint32_t)SEGMENT_SIZE, p_min_size);
+	Segment *segment = (Segment *)memalloc(sizeof(Segment) + size);
+	memnew_placement(segment, Segment);
+	segment->committed.store(0, std::memory_order_relaxed);
+	segment->next.store(nullptr, std::memory_order_relaxed);
+	segment->size = size;
+	return segment;
+}
+
+uint32_t MessageQueue::_get_message_size(const Message *p_message) {
+	uint32_t size = sizeof(Message);
+	if ((p_message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+		size += sizeof(Variant) * p_message->args;
+	}
+	return size;
+}
+
+void MessageQueue::_destroy_message(Message *p_message) {
+	if ((p_message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+		Variant *args = (Variant *)(p_message + 1);
+		for (int i = 0; i < p_message->args; i++) {
+			args[i].~Variant();
+		}
+	}
+	p_message->~Message();
+}
+
+void MessageQueue::_free_segments(Segment *p_segment) {
+	while (p_segment) {
+		Segment *next = p_segment->next.load(std::memory_order_acquire);
+		memfree(p_segment);
+		p_segment = next;
+	}
+}
+
+void MessageQueue::_free_producer(Producer *p_producer) {
+	_free_segments(p_producer->read_segment);
+	_free_segments(p_producer->reusable_segments);
+	_free_segments(p_producer->free_segments.load(std::memory_order_acquire));
+	memdelete(p_producer);
+}
+
+MessageQueue::Producer *MessageQueue::_get_producer() {
+	if (likely(thread_producer.queue_id == queue_id)) {
+		return thread_producer.producer;
+	}
+
+	Producer *producer = memnew(Producer);
+	producer->write_segment = _alloc_segment(0);
+	producer->write_pos = 0;
+	producer->reusable_segments = nullptr;
+	producer->read_segment = producer->write_segment;
+	producer->read_pos = 0;
+	producer->free_segments.store(nullptr, std::memory_order_relaxed);
+	producer->abandoned.store(false, std::memory_order_relaxed);
+
+	_THREAD_SAFE_LOCK_
+	producers.push_back(producer);
+	producers_version.fetch_add(1, std::memory_order_release);
+	_THREAD_SAFE_UNLOCK_
+
+	thread_producer.queue_id = queue_id;
+	thread_producer.producer = producer;
+	return producer;
+}
+
+MessageQueue::Message *MessageQueue::_alloc_message(Producer *p_producer, uint32_t p_size) {
+	Segment *segment = p_producer->write_segment;
+	if (unlikely(p_producer->write_pos + p_size > segment->size)) {
+		// Reuse drained segments, so a steady stream of messages does not allocate.
+		if (!p_producer->reusable_segments && p_size <= SEGMENT_SIZE) {
+			p_producer->reusable_segments = p_producer->free_segments.exchange(nullptr, std::memory_order_acquire);
+		}
+		Segment *next = nullptr;
+		if (p_producer->reusable_segments && p_size <= SEGMENT_SIZE) {
+			next = p_producer->reusable_segments;
+			p_producer->reusable_segments = next->next.load(std::memory_order_relaxed);
+			next->committed.store(0, std::memory_order_relaxed);
+			next->next.store(nullptr, std::memory_order_relaxed);
+		} else {
+			next = _alloc_segment(p_size);
+		}
+
+		// Everything in the old segment is committed, flush() moves on once it sees this.
+		segment->next.store(next, std::memory_order_release);
+		p_producer->write_segment = next;
+		p_producer->write_pos = 0;
+		segment = next;
+	}
+
+	return (Message *)(segment->get_data() + p_producer->write_pos);
+}
+
+void MessageQueue::_commit_message(Producer *p_producer, Message *p_message, uint32_t p_size) {
+	p_message->order = next_order.fetch_add(1, std::memory_order_relaxed);
+	p_producer->write_pos += p_size;
+	p_producer->write_segment->committed.store(p_producer->write_pos, std::memory_order_release);
+}
+
+MessageQueue::Message *MessageQueue::_peek_message(Producer *p_producer) {
+	while (true) {
+		Segment *segment = p_producer->read_segment;
+		if (p_producer->read_pos < segment->committed.load(std::memory_order_acquire)) {
+			return (Message *)(segment->get_data() + p_producer->read_pos);
+		}
+
+		Segment *next = segment->next.load(std::memory_order_acquire);
+		if (!next) {
+			return nullptr;
+		}
+		// Messages committed right before the owner moved on are visible now.
+		if (p_producer->read_pos < segment->committed.load(std::memory_order_acquire)) {
+			continue;
+		}
+
+		p_producer->read_segment = next;
+		p_producer->read_pos = 0;
+
+		if (segment->size > SEGMENT_SIZE) {
+			memfree(segment); // made for one big message
+			continue;
+		}
+		Segment *free_segments = p_producer->free_segments.load(std::memory_order_relaxed);
+		do {
+			segment->next.store(free_segments, std::memory_order_relaxed);
+		} while (!p_producer->free_segments.compare_exchange_weak(free_segments, segment, std::memory_order_release, std::memory_order_relaxed));
+	}
+}
+
+void MessageQueue::_load_cursor(FlushCursor &r_cursor) {
+	r_cursor.head = _peek_message(r_cursor.producer);
+	if (r_cursor.head) {
+		r_cursor.order = r_cursor.head->order;
+	}
+}
+
+template <class F>
+void MessageQueue::_for_each_pending(F p_function) {
+	_THREAD_SAFE_METHOD_
+
+	for (uint32_t i = 0; i < producers.size(); i++) {
+		Segment *segment = producers[i]->read_segment;
+		uint32_t pos = producers[i]->read_pos;
+		while (segment) {
+			uint32_t end = segment->committed.load(std::memory_order_acquire);
+			while (pos < end) {
+				Message *message = (Message *)(segment->get_data() + pos);
+				pos += _get_message_size(message);
+				p_function(message);
+			}
+			segment = segment->next.load(std::memory_order_acquire);
+			pos = 0;
+		}
+	}
+}
+
 Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
 	return push_callable(Callable(p_id, p_method), p_args, p_argcount, p_show_error);
 }
@@ -60,55 +226,36 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, VARIANT
 }
 
 Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
-	_THREAD_SAFE_METHOD_
-
-	uint8_t room_needed = sizeof(Message) + sizeof(Variant);
+	uint32_t room_needed = sizeof(Message) + sizeof(Variant);
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id)) {
-			type = ObjectDB::get_instance(p_id)->get_class();
-		}
-		print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
-
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Producer *producer = _get_producer();
+	Message *msg = memnew_placement(_alloc_message(producer, room_needed), Message);
 	msg->args = 1;
 	msg->callable = Callable(p_id, p_prop);
 	msg->type = TYPE_SET;
 
-	buffer_end += sizeof(Message);
-
-	Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-	buffer_end += sizeof(Variant);
+	Variant *v = memnew_placement(msg + 1, Variant);
 	*v = p_value;
 
+	_commit_message(producer, msg, room_needed);
+
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification < 0, ERR_INVALID_PARAMETER);
 
-	uint8_t room_needed = sizeof(Message);
+	uint32_t room_needed = sizeof(Message);
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
-
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Producer *producer = _get_producer();
+	Message *msg = memnew_placement(_alloc_message(producer, room_needed), Message);
 
 	msg->type = TYPE_NOTIFICATION;
 	msg->callable = Callable(p_id, CoreStringNames::get_singleton()->notification); //name is meaningless but callable needs it
 	//msg->target;
 	msg->notification = p_notification;
 
-	buffer_end += sizeof(Message);
+	_commit_message(producer, msg, room_needed);
 
 	return OK;
 }
@@ -126,17 +273,10 @@ Error MessageQueue::push_set(Object *p_object, const StringName &p_prop, const V
 }
 
 Error MessageQueue::push_callable(const Callable &p_callable, const Variant **p_args, int p_argcount, bool p_show_error) {
-	_THREAD_SAFE_METHOD_
-
-	int room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
-
-	if ((buffer_end + room_needed) >= buffer_size) {
-		print_line("Failed method: " + p_callable);
-		statistics();
-		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_kb' in project settings.");
-	}
+	uint32_t room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Producer *producer = _get_producer();
+	Message *msg = memnew_placement(_alloc_message(producer, room_needed), Message);
 	msg->args = p_argcount;
 	msg->callable = p_callable;
 	msg->type = TYPE_CALL;
@@ -144,14 +284,14 @@ Error MessageQueue::push_callable(const Callable &p_callable, const Variant **p_
 		msg->type |= FLAG_SHOW_ERROR;
 	}
 
-	buffer_end += sizeof(Message);
-
+	Variant *args = (Variant *)(msg + 1);
 	for (int i = 0; i < p_argcount; i++) {
-		Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-		buffer_end += sizeof(Variant);
+		Variant *v = memnew_placement(&args[i], Variant);
 		*v = *p_args[i];
 	}
 
+	_commit_message(producer, msg, room_needed);
+
 	return OK;
 }
 
@@ -175,10 +315,10 @@ void MessageQueue::statistics() {
 	Map<int, int> notify_count;
 	Map<Callable, int> call_count;
 	int null_count = 0;
+	uint64_t total_bytes = 0;
 
-	uint32_t read_pos = 0;
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
+	_for_each_pending([&](Message *message) {
+		total_bytes += _get_message_size(message);
 
 		Object *target = message->callable.get_object();
 
@@ -217,14 +357,9 @@ void MessageQueue::statistics() {
 
 			null_count++;
 		}
+	});
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
-		}
-	}
-
-	print_line("TOTAL BYTES: " + itos(buffer_end));
+	print_line("TOTAL BYTES: " + itos(total_bytes));
 	print_line("NULL count: " + itos(null_count));
 
 	for (Map<StringName, int>::Element *E = set_count.front(); E; E = E->next()) {
@@ -262,35 +397,57 @@ void MessageQueue::_call_function(const Callable &p_callable, const Variant *p_a
 }
 
 void MessageQueue::flush() {
-	if (buffer_end > buffer_max_used) {
-		buffer_max_used = buffer_end;
-	}
-
-	uint32_t read_pos = 0;
-
-	//using reverse locking strategy
-	_THREAD_SAFE_LOCK_
-
-	if (flushing) {
-		_THREAD_SAFE_UNLOCK_
-		ERR_FAIL_COND(flushing); //already flushing, you did something odd
-	}
-	flushing = true;
-
-	while (read_pos < buffer_end) {
-		//lock on each iteration, so a call can re-add itself to the message queue
+	ERR_FAIL_COND(flushing.exchange(true, std::memory_order_acquire)); //already flushing, you did something odd
+
+	uint32_t flushed = 0;
+	uint32_t until_refresh = 0;
+
+	while (true) {
+		if (flush_cursors_version != producers_version.load(std::memory_order_acquire)) {
+			_THREAD_SAFE_LOCK_
+			flush_cursors_version = producers_version.load(std::memory_order_relaxed);
+			flush_cursors.resize(producers.size());
+			for (uint32_t i = 0; i < producers.size(); i++) {
+				flush_cursors[i].producer = producers[i];
+				flush_cursors[i].head = nullptr;
+			}
+			_THREAD_SAFE_UNLOCK_
+			until_refresh = 0;
+		}
 
-		Message *message = (Message *)&buffer[read_pos];
+		bool refreshed = until_refresh == 0;
+		if (refreshed) {
+			for (uint32_t i = 0; i < flush_cursors.size(); i++) {
+				if (!flush_cursors[i].head) {
+					_load_cursor(flush_cursors[i]);
+				}
+			}
+			until_refresh = FLUSH_REFRESH_INTERVAL;
+		}
 
-		uint32_t advance = sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			advance += sizeof(Variant) * message->args;
+		// Every thread's messages are already in order, take the oldest of their first ones.
+		// Messages pushed by the calls below are picked up in this same flush.
+		FlushCursor *cursor = nullptr;
+		for (uint32_t i = 0; i < flush_cursors.size(); i++) {
+			if (flush_cursors[i].head && (!cursor || flush_cursors[i].order < cursor->order)) {
+				cursor = &flush_cursors[i];
+			}
 		}
 
-		//pre-advance so this function is reentrant
-		read_pos += advance;
+		if (!cursor) {
+			if (refreshed) {
+				break;
+			}
+			until_refresh = 0;
+			continue;
+		}
+		until_refresh--;
 
-		_THREAD_SAFE_UNLOCK_
+		Message *message = cursor->head;
+		Producer *producer = cursor->producer;
+		uint32_t advance = _get_message_size(message);
+		producer->read_pos += advance;
+		flushed += advance;
 
 		Object *target = message->callable.get_object();
 
@@ -318,57 +475,61 @@ void MessageQueue::flush() {
 			}
 		}
 
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			Variant *args = (Variant *)(message + 1);
-			for (int i = 0; i < message->args; i++) {
-				args[i].~Variant();
-			}
-		}
+		_destroy_message(message);
 
-		message->~Message();
+		// Nothing else touches the cursors while a message runs, a new producer only bumps the version.
+		_load_cursor(*cursor);
+	}
 
-		_THREAD_SAFE_LOCK_
+	if (flushed > buffer_max_used) {
+		buffer_max_used = flushed;
+	}
+	if (flushed > buffer_warn_size) {
+		WARN_PRINT_ONCE("Message queue flushed more than 'memory/limits/message_queue/max_size_kb' at once, check for deferred calls that keep queueing themselves.");
 	}
 
-	buffer_end = 0; // reset buffer
-	flushing = false;
+	// Drop producers of threads that exited, once nothing of theirs is left.
+	_THREAD_SAFE_LOCK_
+	for (uint32_t i = 0; i < producers.size(); i++) {
+		Producer *p = producers[i];
+		if (p->abandoned.load(std::memory_order_acquire) && !_peek_message(p)) {
+			producers.remove(i);
+			producers_version.fetch_add(1, std::memory_order_release);
+			_free_producer(p);
+			i--;
+		}
+	}
 	_THREAD_SAFE_UNLOCK_
+
+	flushing.store(false, std::memory_order_release);
 }
 
 bool MessageQueue::is_flushing() const {
-	return flushing;
+	return flushing.load(std::memory_order_relaxed);
 }
 
 MessageQueue::MessageQueue() {
 	ERR_FAIL_COND_MSG(singleton != nullptr, "A MessageQueue singleton already exists.");
 	singleton = this;
 
-	buffer_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
+	queue_id = last_queue_id.fetch_add(1) + 1;
+	next_order.store(0);
+	producers_version.store(0);
+	flushing.store(false);
+
+	buffer_warn_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/max_size_kb", PropertyInfo(Variant::INT, "memory/limits/message_queue/max_size_kb", PROPERTY_HINT_RANGE, "1024,4096,1,or_greater"));
-	buffer_size *= 1024;
-	buffer = memnew_arr(uint8_t, buffer_size);
+	buffer_warn_size *= 1024;
 }
 
 MessageQueue::~MessageQueue() {
-	uint32_t read_pos = 0;
-
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
-		Variant *args = (Variant *)(message + 1);
-		int argc = message->args;
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			for (int i = 0; i < argc; i++) {
-				args[i].~Variant();
-			}
-		}
-		message->~Message();
+	_for_each_pending([](Message *message) {
+		_destroy_message(message);
+	});
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			read_pos += sizeof(Variant) * message->args;
-		}
+	for (uint32_t i = 0; i < producers.size(); i++) {
+		_free_producer(producers[i]);
 	}
 
 	singleton = nullptr;
-	memdelete_arr(buffer);
 }
@@ -33,12 +33,19 @@
 
 #include "core/object/class_db.h"
 #include "core/os/thread_safe.h"
+#include "core/templates/local_vector.h"
 
+#include <atomic>
+
+// Each thread appends its messages to its own chain of segments, so pushing
+// never takes a lock. flush() merges the chains back in submission order.
 class MessageQueue {
-	_THREAD_SAFE_CLASS_
+	_THREAD_SAFE_CLASS_ // guards the producer list only
 
 	enum {
-		DEFAULT_QUEUE_SIZE_KB = 4096
+		DEFAULT_QUEUE_SIZE_KB = 4096,
+		SEGMENT_SIZE = 64 * 1024,
+		FLUSH_REFRESH_INTERVAL = 64 // messages between looks at threads that had nothing queued
 	};
 
 	enum {
@@ -52,6 +59,7 @@ class MessageQueue {
 
 	struct Message {
 		Callable callable;
+		uint64_t order; // submission order across all threads
 		int16_t type;
 		union {
 			int16_t notification;
@@ -59,16 +67,72 @@ class MessageQueue {
 		};
 	};
 
-	uint8_t *buffer;
-	uint32_t buffer_end = 0;
+	// Only the owning thread writes a segment, and only flush() reads it.
+	struct Segment {
+		std::atomic<uint32_t> committed; // bytes holding complete messages
+		std::atomic<Segment *> next; // set once the owner moved on, nothing is added after that
+		uint32_t size;
+		uint8_t *get_data() { return (uint8_t *)(this + 1); }
+	};
+
+	struct Producer {
+		// Owning thread.
+		Segment *write_segment;
+		uint32_t write_pos;
+		Segment *reusable_segments; // taken from free_segments all at once
+		// flush().
+		Segment *read_segment;
+		uint32_t read_pos;
+		// Drained segments handed back by flush(), linked through next.
+		std::atomic<Segment *> free_segments;
+		std::atomic<bool> abandoned; // owning thread exited
+	};
+
+	struct ThreadProducer {
+		uint64_t queue_id = 0;
+		Producer *producer = nullptr;
+		~ThreadProducer();
+	};
+
+	static thread_local ThreadProducer thread_producer;
+	static std::atomic<uint64_t> last_queue_id;
+
+	uint64_t queue_id;
+	std::atomic<uint64_t> next_order;
+	LocalVector<Producer *> producers;
+	std::atomic<uint32_t> producers_version;
+
+	// Next message of each producer, so flush() only looks at the one it consumed from.
+	struct FlushCursor {
+		Producer *producer;
+		Message *head;
+		uint64_t order;
+	};
+	LocalVector<FlushCursor> flush_cursors;
+	uint32_t flush_cursors_version = 0;
+
 	uint32_t buffer_max_used = 0;
-	uint32_t buffer_size;
+	uint32_t buffer_warn_size;
+
+	static Segment *_alloc_segment(uint32_t p_min_size);
+	static uint32_t _get_message_size(const Message *p_message);
+	static void _destroy_message(Message *p_message);
+	static void _free_segments(Segment *p_segment);
+	static void _free_producer(Producer *p_producer);
+
+	Producer *_get_producer();
+	Message *_alloc_message(Producer *p_producer, uint32_t p_size);
+	void _commit_message(Producer *p_producer, Message *p_message, uint32_t p_size);
+	Message *_peek_message(Producer *p_producer);
+	void _load_cursor(FlushCursor &r_cursor);
+	template <class F>
+	void _for_each_pending(F p_function);
 
 	void _call_function(const Callable &p_callable, const Variant *p_args, int p_argcount, bool p_show_error);
 
 	static MessageQueue *singleton;
 
-	bool flushing = false;
+	std::atomic<bool> flushing;
 
 public:
 	static MessageQueue *get_singleton();
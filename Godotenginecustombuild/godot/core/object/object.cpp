@@ -38,6 +38,7 @@
 #include "core/os/os.h"
 #include "core/string/print_string.h"
 #include "core/string/translation.h"
+#include "core/variant/variant_internal.h"
 
 #ifdef DEBUG_ENABLED
 
@@ -996,6 +997,45 @@ Variant Object::_emit_signal(const Variant **p_args, int p_argcount, Callable::C
 	return Variant();
 }
 
+// calls a native method directly, skipping the script and method lookups of Object::call.
+// when the arguments already hold the exact types the method takes, they are passed by pointer.
+static void _call_signal_method(Object *p_target, MethodBind *p_method, const Variant **p_args, int p_argcount, Callable::CallError &r_error) {
+	r_error.error = Callable::CallError::CALL_OK;
+
+#if defined(PTRCALL_ENABLED) && defined(DEBUG_METHODS_ENABLED)
+	//argument types are only known to debug builds, release builds take the validated call below
+	if (!p_method->has_return() && !p_method->is_vararg() && p_argcount == p_method->get_argument_count()) {
+		const void **argptrs = (const void **)alloca(sizeof(void *) * MAX(p_argcount, 1));
+		bool exact = true;
+
+		for (int i = 0; i < p_argcount; i++) {
+			Variant::Type type = p_method->get_argument_type(i);
+			if (type == Variant::NIL) {
+				argptrs[i] = p_args[i]; //takes a Variant
+			} else if (type == p_args[i]->get_type() && type != Variant::OBJECT) {
+				argptrs[i] = VariantInternal::get_opaque_pointer(p_args[i]);
+			} else {
+				exact = false;
+				break;
+			}
+		}
+
+		if (exact) {
+#ifdef DEBUG_ENABLED
+			_ObjectDebugLock debug_lock(p_target);
+#endif
+			p_method->ptrcall(p_target, argptrs, nullptr);
+			return;
+		}
+	}
+#endif
+
+#ifdef DEBUG_ENABLED
+	_ObjectDebugLock debug_lock(p_target);
+#endif
+	p_method->call(p_target, p_args, p_argcount, r_error);
+}
+
 Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int p_argcount) {
 	if (_block_signals) {
 		return ERR_CANT_ACQUIRE_RESOURCE; //no emit, signals blocked
@@ -1014,12 +1054,12 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 
 	List<_ObjectSignalDisconnectData> disconnect_data;
 
-	//copy on write will ensure that disconnecting the signal or even deleting the object will not affect the signal calling.
-	//this happens automatically and will not change the performance of calling.
-	//awesome, isn't it?
-	VMap<Callable, SignalData::Slot> slot_map = s->slot_map;
+	//holding a reference to the targets ensures that disconnecting the signal or even deleting the object
+	//will not affect the signal calling, as those make their own copy. nothing is copied otherwise.
+	const Vector<SignalData::Target> targets = s->targets;
 
-	int ssize = slot_map.size();
+	const SignalData::Target *tptr = targets.ptr();
+	int tsize = targets.size();
 
 	OBJ_DEBUG_LOCK
 
@@ -1027,10 +1067,10 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 
 	Error err = OK;
 
-	for (int i = 0; i < ssize; i++) {
-		const Connection &c = slot_map.getv(i).conn;
+	for (int i = 0; i < tsize; i++) {
+		const SignalData::Target &t = tptr[i];
 
-		Object *target = c.callable.get_object();
+		Object *target = t.callable.get_object();
 		if (!target) {
 			// Target might have been deleted during signal callback, this is expected and OK.
 			continue;
@@ -1039,48 +1079,53 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 		const Variant **args = p_args;
 		int argc = p_argcount;
 
-		if (c.binds.size()) {
+		if (t.binds.size()) {
 			//handle binds
-			bind_mem.resize(p_argcount + c.binds.size());
+			bind_mem.resize(p_argcount + t.binds.size());
 
 			for (int j = 0; j < p_argcount; j++) {
 				bind_mem.write[j] = p_args[j];
 			}
-			for (int j = 0; j < c.binds.size(); j++) {
-				bind_mem.write[p_argcount + j] = &c.binds[j];
+			for (int j = 0; j < t.binds.size(); j++) {
+				bind_mem.write[p_argcount + j] = &t.binds[j];
 			}
 
 			args = (const Variant **)bind_mem.ptr();
 			argc = bind_mem.size();
 		}
 
-		if (c.flags & CONNECT_DEFERRED) {
-			MessageQueue::get_singleton()->push_callable(c.callable, args, argc, true);
+		if (t.flags & CONNECT_DEFERRED) {
+			MessageQueue::get_singleton()->push_callable(t.callable, args, argc, true);
 		} else {
 			Callable::CallError ce;
 			_emitting = true;
-			Variant ret;
-			c.callable.call(args, argc, ret, ce);
+			if (t.method && !target->script_instance) {
+				//a script attached after connecting may override the method, so it is checked each time
+				_call_signal_method(target, t.method, args, argc, ce);
+			} else {
+				Variant ret;
+				t.callable.call(args, argc, ret, ce);
+			}
 			_emitting = false;
 
 			if (ce.error != Callable::CallError::CALL_OK) {
 #ifdef DEBUG_ENABLED
-				if (c.flags & CONNECT_PERSIST && Engine::get_singleton()->is_editor_hint() && (script.is_null() || !Ref<Script>(script)->is_tool())) {
+				if (t.flags & CONNECT_PERSIST && Engine::get_singleton()->is_editor_hint() && (script.is_null() || !Ref<Script>(script)->is_tool())) {
 					continue;
 				}
 #endif
 				if (ce.error == Callable::CallError::CALL_ERROR_INVALID_METHOD && !ClassDB::class_exists(target->get_class_name())) {
 					//most likely object is not initialized yet, do not throw error.
 				} else {
-					ERR_PRINT("Error calling from signal '" + String(p_name) + "' to callable: " + Variant::get_callable_error_text(c.callable, args, argc, ce) + ".");
+					ERR_PRINT("Error calling from signal '" + String(p_name) + "' to callable: " + Variant::get_callable_error_text(t.callable, args, argc, ce) + ".");
 					err = ERR_METHOD_NOT_FOUND;
 				}
 			}
 		}
 
-		bool disconnect = c.flags & CONNECT_ONESHOT;
+		bool disconnect = t.flags & CONNECT_ONESHOT;
 #ifdef TOOLS_ENABLED
-		if (disconnect && (c.flags & CONNECT_PERSIST) && Engine::get_singleton()->is_editor_hint()) {
+		if (disconnect && (t.flags & CONNECT_PERSIST) && Engine::get_singleton()->is_editor_hint()) {
 			//this signal was connected from the editor, and is being edited. just don't disconnect for now
 			disconnect = false;
 		}
@@ -1088,7 +1133,7 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 		if (disconnect) {
 			_ObjectSignalDisconnectData dd;
 			dd.signal = p_name;
-			dd.callable = c.callable;
+			dd.callable = t.callable;
 			disconnect_data.push_back(dd);
 		}
 	}
@@ -1325,8 +1370,17 @@ Error Object::connect(const StringName &p_signal, const Callable &p_callable, co
 		slot.reference_count = 1;
 	}
 
+	SignalData::Target t;
+	t.callable = target;
+	t.binds = p_binds;
+	t.flags = p_flags;
+	if (!target.is_custom()) {
+		t.method = ClassDB::get_method(target_object->get_class_name(), target.get_method());
+	}
+
 	//use callable version as key, so binds can be ignored
-	s->slot_map[*target.get_base_comparator()] = slot;
+	int pos = s->slot_map.insert(*target.get_base_comparator(), slot);
+	s->targets.insert(pos, t);
 
 	return OK;
 }
@@ -1387,7 +1441,9 @@ void Object::_disconnect(const StringName &p_signal, const Callable &p_callable,
 	}
 
 	target_object->connections.erase(slot->cE);
+	int pos = s->slot_map.find(*p_callable.get_base_comparator());
 	s->slot_map.erase(*p_callable.get_base_comparator());
+	s->targets.remove(pos);
 
 	if (s->slot_map.empty() && ClassDB::has_signal(get_class_name(), p_signal)) {
 		//not user signal, delete
@@ -400,6 +400,7 @@ public:                                                                 \
                                                                         \
 private:
 
+class MethodBind;
 class ScriptInstance;
 
 class Object {
@@ -443,8 +444,19 @@ private:
 			List<Connection>::Element *cE = nullptr;
 		};
 
+		//flat copy of slot_map in the same order, which is what emission walks.
+		//emitting keeps a reference to it, so connecting or disconnecting from a
+		//callback copies the array instead of changing the one being walked.
+		struct Target {
+			Callable callable;
+			Vector<Variant> binds;
+			uint32_t flags = 0;
+			MethodBind *method = nullptr; //native method of a plain object callable, resolved on connect
+		};
+
 		MethodInfo user;
 		VMap<Callable, Slot> slot_map;
+		Vector<Target> targets;
 	};
 
 	HashMap<StringName, SignalData> signal_map;
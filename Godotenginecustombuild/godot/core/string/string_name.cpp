@@ -39,30 +39,241 @@ StaticCString StaticCString::create(const char *p_ptr) {
 	return scs;
 }
 
-StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+std::atomic<StringName::_Table *> StringName::table(nullptr);
+StringName::_Stripe StringName::stripes[STRING_TABLE_STRIPES];
+std::atomic<uint32_t> StringName::entry_count(0);
+std::atomic<uint32_t> StringName::grow_sequence(0);
+std::atomic<uint64_t> StringName::epoch(1);
+std::atomic<StringName::_Reader *> StringName::readers(nullptr);
+BinaryMutex StringName::readers_mutex;
+uint32_t StringName::generation = 0;
+thread_local StringName::ThreadReader StringName::thread_reader;
 
 StringName _scs_create(const char *p_chr) {
 	return (p_chr[0] ? StringName(StaticCString::create(p_chr)) : StringName());
 }
 
 bool StringName::configured = false;
-Mutex StringName::mutex;
+
+StringName::ThreadReader::~ThreadReader() {
+	// Another thread starting later takes it over. After cleanup it is already gone.
+	if (reader && generation == StringName::generation) {
+		reader->in_use.store(false, std::memory_order_release);
+	}
+}
+
+StringName::_Table *StringName::_alloc_table(uint32_t p_buckets) {
+	_Table *t = memnew(_Table);
+	t->mask = p_buckets - 1;
+	t->buckets = memnew_arr(std::atomic<_Data *>, p_buckets);
+	for (uint32_t i = 0; i < p_buckets; i++) {
+		t->buckets[i].store(nullptr, std::memory_order_relaxed);
+	}
+	return t;
+}
+
+StringName::_Reader *StringName::_get_reader() {
+	if (likely(thread_reader.generation == generation)) {
+		return thread_reader.reader;
+	}
+
+	MutexLock lock(readers_mutex);
+
+	_Reader *reader = readers.load(std::memory_order_relaxed);
+	while (reader && reader->in_use.load(std::memory_order_acquire)) {
+		reader = reader->next;
+	}
+	if (reader) {
+		reader->in_use.store(true, std::memory_order_relaxed);
+	} else {
+		reader = memnew(_Reader);
+		reader->next = readers.load(std::memory_order_relaxed);
+		readers.store(reader, std::memory_order_release);
+	}
+
+	thread_reader.generation = generation;
+	thread_reader.reader = reader;
+	return reader;
+}
+
+template <class T>
+StringName::_Data *StringName::_find(const std::atomic<_Data *> &p_bucket, uint32_t p_hash, const T &p_name) {
+	for (_Data *data = p_bucket.load(std::memory_order_acquire); data; data = data->next.load(std::memory_order_acquire)) {
+		// compare hash first, and skip names that are being removed
+		if (data->hash == p_hash && data->get_name() == p_name && data->refcount.ref()) {
+			return data;
+		}
+	}
+	return nullptr;
+}
+
+template <class T>
+StringName::_Data *StringName::_lookup(uint32_t p_hash, const T &p_name) {
+	_Reader *reader = _get_reader();
+	reader->epoch.store(epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+	// Pairs with the fence in _reclaim(), either it sees this lookup or this lookup sees the removal.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	uint32_t sequence = grow_sequence.load(std::memory_order_acquire);
+	bool certain = !(sequence & 1);
+	_Data *data = nullptr;
+
+	if (certain) {
+		_Table *t = table.load(std::memory_order_acquire);
+		data = _find(t->buckets[p_hash & t->mask], p_hash, p_name);
+		if (!data) {
+			// The chains may have been relinked under this lookup, then a miss means nothing.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			certain = grow_sequence.load(std::memory_order_relaxed) == sequence;
+		}
+	}
+
+	reader->epoch.store(0, std::memory_order_release);
+
+	if (data || certain) {
+		return data;
+	}
+	return _find_locked(p_hash, p_name);
+}
+
+template <class T>
+StringName::_Data *StringName::_find_locked(uint32_t p_hash, const T &p_name) {
+	MutexLock lock(stripes[p_hash & (STRING_TABLE_STRIPES - 1)].mutex);
+	_Table *t = table.load(std::memory_order_relaxed);
+	return _find(t->buckets[p_hash & t->mask], p_hash, p_name);
+}
+
+template <class T>
+StringName::_Data *StringName::_intern(uint32_t p_hash, const T &p_name, const char *p_cname) {
+	_Stripe &stripe = stripes[p_hash & (STRING_TABLE_STRIPES - 1)];
+	_Data *data = nullptr;
+	uint32_t buckets = 0;
+
+	{
+		MutexLock lock(stripe.mutex);
+
+		// another thread may have added it since the lookup
+		_Table *t = table.load(std::memory_order_relaxed);
+		std::atomic<_Data *> &bucket = t->buckets[p_hash & t->mask];
+		data = _find(bucket, p_hash, p_name);
+		if (data) {
+			return data;
+		}
+
+		data = memnew(_Data);
+		if (p_cname) {
+			data->cname = p_cname;
+		} else {
+			data->name = p_name;
+		}
+		data->refcount.init();
+		data->hash = p_hash;
+
+		_Data *head = bucket.load(std::memory_order_relaxed);
+		data->next.store(head, std::memory_order_relaxed);
+		if (head) {
+			head->prev = data;
+		}
+		bucket.store(data, std::memory_order_release);
+
+		buckets = t->mask + 1;
+		if (entry_count.fetch_add(1, std::memory_order_relaxed) < buckets) {
+			return data;
+		}
+	}
+
+	_grow(buckets * 2);
+	return data;
+}
+
+void StringName::_grow(uint32_t p_buckets) {
+	for (int i = 0; i < STRING_TABLE_STRIPES; i++) {
+		stripes[i].mutex.lock();
+	}
+
+	_Table *t = table.load(std::memory_order_relaxed);
+	if (t->mask + 1 < p_buckets) {
+		_Table *grown = _alloc_table(p_buckets);
+
+		grow_sequence.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (uint32_t i = 0; i <= t->mask; i++) {
+			_Data *data = t->buckets[i].load(std::memory_order_relaxed);
+			while (data) {
+				_Data *next = data->next.load(std::memory_order_relaxed);
+				std::atomic<_Data *> &bucket = grown->buckets[data->hash & grown->mask];
+				_Data *head = bucket.load(std::memory_order_relaxed);
+				data->prev = nullptr;
+				data->next.store(head, std::memory_order_release);
+				if (head) {
+					head->prev = data;
+				}
+				bucket.store(data, std::memory_order_release);
+				data = next;
+			}
+		}
+
+		// lookups that started before may still be walking the old buckets
+		grown->previous = t;
+		table.store(grown, std::memory_order_release);
+		grow_sequence.fetch_add(1, std::memory_order_release);
+	}
+
+	for (int i = STRING_TABLE_STRIPES - 1; i >= 0; i--) {
+		stripes[i].mutex.unlock();
+	}
+}
+
+void StringName::_reclaim(_Stripe &p_stripe) {
+	// Pairs with the fence in _lookup(), see there.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	uint64_t oldest = UINT64_MAX;
+	for (_Reader *reader = readers.load(std::memory_order_acquire); reader; reader = reader->next) {
+		uint64_t reader_epoch = reader->epoch.load(std::memory_order_acquire);
+		if (reader_epoch && reader_epoch < oldest) {
+			oldest = reader_epoch;
+		}
+	}
+
+	// lookups that started after a name was removed can't reach it
+	_Data **link = &p_stripe.retired;
+	while (*link) {
+		_Data *data = *link;
+		if (data->retired_epoch < oldest) {
+			*link = data->prev;
+			memdelete(data);
+			p_stripe.retired_count--;
+		} else {
+			link = &data->prev;
+		}
+	}
+}
 
 void StringName::setup() {
 	ERR_FAIL_COND(configured);
-	for (int i = 0; i < STRING_TABLE_LEN; i++) {
-		_table[i] = nullptr;
-	}
+	generation++;
+	table.store(_alloc_table(STRING_TABLE_LEN), std::memory_order_release);
 	configured = true;
 }
 
+void StringName::reserve(uint32_t p_buckets) {
+	ERR_FAIL_COND(!configured);
+	_grow(next_power_of_2(MAX(p_buckets, (uint32_t)STRING_TABLE_LEN)));
+}
+
 void StringName::cleanup() {
-	MutexLock lock(mutex);
+	for (int i = 0; i < STRING_TABLE_STRIPES; i++) {
+		stripes[i].mutex.lock();
+	}
+
+	_Table *t = table.load(std::memory_order_relaxed);
 
 	int lost_strings = 0;
-	for (int i = 0; i < STRING_TABLE_LEN; i++) {
-		while (_table[i]) {
-			_Data *d = _table[i];
+	for (uint32_t i = 0; i <= t->mask; i++) {
+		_Data *d = t->buckets[i].load(std::memory_order_relaxed);
+		while (d) {
 			lost_strings++;
 			if (OS::get_singleton()->is_stdout_verbose()) {
 				if (d->cname) {
@@ -72,34 +283,87 @@ void StringName::cleanup() {
 				}
 			}
 
-			_table[i] = _table[i]->next;
+			_Data *next = d->next.load(std::memory_order_relaxed);
 			memdelete(d);
+			d = next;
 		}
 	}
 	if (lost_strings) {
 		print_verbose("StringName: " + itos(lost_strings) + " unclaimed string names at exit.");
 	}
+
+	while (t) {
+		_Table *previous = t->previous;
+		memdelete_arr(t->buckets);
+		memdelete(t);
+		t = previous;
+	}
+	table.store(nullptr, std::memory_order_relaxed);
+	entry_count.store(0, std::memory_order_relaxed);
+
+	for (int i = 0; i < STRING_TABLE_STRIPES; i++) {
+		while (stripes[i].retired) {
+			_Data *d = stripes[i].retired;
+			stripes[i].retired = d->prev;
+			memdelete(d);
+		}
+		stripes[i].retired_count = 0;
+	}
+
+	for (int i = STRING_TABLE_STRIPES - 1; i >= 0; i--) {
+		stripes[i].mutex.unlock();
+	}
+
+	{
+		MutexLock lock(readers_mutex);
+		_Reader *reader = readers.exchange(nullptr, std::memory_order_relaxed);
+		while (reader) {
+			_Reader *next = reader->next;
+			memdelete(reader);
+			reader = next;
+		}
+		// threads still holding one must not touch it
+		generation++;
+	}
 }
 
 void StringName::unref() {
 	ERR_FAIL_COND(!configured);
 
 	if (_data && _data->refcount.unref()) {
-		MutexLock lock(mutex);
+		_Stripe &stripe = stripes[_data->hash & (STRING_TABLE_STRIPES - 1)];
+		MutexLock lock(stripe.mutex);
 
+		_Table *t = table.load(std::memory_order_relaxed);
+		if (!t) {
+			// names held past cleanup were freed with the table
+			_data = nullptr;
+			return;
+		}
+
+		// lookups walking past it still find the rest of the chain
+		_Data *next = _data->next.load(std::memory_order_relaxed);
 		if (_data->prev) {
-			_data->prev->next = _data->next;
+			_data->prev->next.store(next, std::memory_order_release);
 		} else {
-			if (_table[_data->idx] != _data) {
+			std::atomic<_Data *> &bucket = t->buckets[_data->hash & t->mask];
+			if (bucket.load(std::memory_order_relaxed) != _data) {
 				ERR_PRINT("BUG!");
 			}
-			_table[_data->idx] = _data->next;
+			bucket.store(next, std::memory_order_release);
+		}
+
+		if (next) {
+			next->prev = _data->prev;
 		}
+		entry_count.fetch_sub(1, std::memory_order_relaxed);
 
-		if (_data->next) {
-			_data->next->prev = _data->prev;
+		_data->retired_epoch = epoch.fetch_add(1, std::memory_order_seq_cst);
+		_data->prev = stripe.retired;
+		stripe.retired = _data;
+		if (++stripe.retired_count >= STRING_TABLE_MAX_RETIRED) {
+			_reclaim(stripe);
 		}
-		memdelete(_data);
 	}
 
 	_data = nullptr;
@@ -162,41 +426,12 @@ StringName::StringName(const char *p_name) {
 		return; //empty, ignore
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_name);
 
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			return;
-		}
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
+	_data = _lookup(hash, p_name);
+	if (!_data) {
+		_data = _intern(hash, p_name, nullptr);
 	}
-	_table[idx] = _data;
 }
 
 StringName::StringName(const StaticCString &p_static_string) {
@@ -206,41 +441,12 @@ StringName::StringName(const StaticCString &p_static_string) {
 
 	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = String::hash(p_static_string.ptr);
 
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_static_string.ptr) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			return;
-		}
-	}
-
-	_data = memnew(_Data);
-
-	_data->refcount.init();
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = p_static_string.ptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
+	_data = _lookup(hash, p_static_string.ptr);
+	if (!_data) {
+		_data = _intern(hash, p_static_string.ptr, p_static_string.ptr);
 	}
-	_table[idx] = _data;
 }
 
 StringName::StringName(const String &p_name) {
@@ -252,39 +458,12 @@ StringName::StringName(const String &p_name) {
 		return;
 	}
 
-	MutexLock lock(mutex);
-
 	uint32_t hash = p_name.hash();
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
 
-	while (_data) {
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			return;
-		}
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = nullptr;
-	_data->next = _table[idx];
-	_data->prev = nullptr;
-	if (_table[idx]) {
-		_table[idx]->prev = _data;
+	_data = _lookup(hash, p_name);
+	if (!_data) {
+		_data = _intern(hash, p_name, nullptr);
 	}
-	_table[idx] = _data;
 }
 
 StringName StringName::search(const char *p_name) {
@@ -295,23 +474,9 @@ StringName StringName::search(const char *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = String::hash(p_name);
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		return StringName(_data);
+	_Data *data = _lookup(String::hash(p_name), p_name);
+	if (data) {
+		return StringName(data);
 	}
 
 	return StringName(); //does not exist
@@ -325,24 +490,9 @@ StringName StringName::search(const char32_t *p_name) {
 		return StringName();
 	}
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		return StringName(_data);
+	_Data *data = _lookup(String::hash(p_name), p_name);
+	if (data) {
+		return StringName(data);
 	}
 
 	return StringName(); //does not exist
@@ -351,24 +501,9 @@ StringName StringName::search(const char32_t *p_name) {
 StringName StringName::search(const String &p_name) {
 	ERR_FAIL_COND_V(p_name == "", StringName());
 
-	MutexLock lock(mutex);
-
-	uint32_t hash = p_name.hash();
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-		// compare hash first
-		if (_data->hash == hash && p_name == _data->get_name()) {
-			break;
-		}
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		return StringName(_data);
+	_Data *data = _lookup(p_name.hash(), p_name);
+	if (data) {
+		return StringName(data);
 	}
 
 	return StringName(); //does not exist
@@ -35,6 +35,8 @@
 #include "core/string/ustring.h"
 #include "core/templates/safe_refcount.h"
 
+#include <atomic>
+
 class Main;
 
 struct StaticCString {
@@ -45,8 +47,9 @@ struct StaticCString {
 class StringName {
 	enum {
 		STRING_TABLE_BITS = 12,
-		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS,
-		STRING_TABLE_MASK = STRING_TABLE_LEN - 1
+		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS, // buckets the table starts with, it grows as names are added
+		STRING_TABLE_STRIPES = 64, // insert and remove locks, picked by the low bits of the hash
+		STRING_TABLE_MAX_RETIRED = 64, // removed names a stripe keeps before trying to free them
 	};
 
 	struct _Data {
@@ -55,14 +58,50 @@ class StringName {
 		String name;
 
 		String get_name() const { return cname ? String(cname) : name; }
-		int idx = 0;
 		uint32_t hash = 0;
-		_Data *prev = nullptr;
-		_Data *next = nullptr;
+		uint64_t retired_epoch = 0;
+		_Data *prev = nullptr; // only used with the stripe locked, links the retired list once removed
+		std::atomic<_Data *> next{ nullptr };
 		_Data() {}
 	};
 
-	static _Data *_table[STRING_TABLE_LEN];
+	// Lookups walk the chains without locking. Adding and removing names locks the
+	// stripe of their hash, growing locks all of them. Removed names are only freed
+	// once no lookup that could still reach them is running, replaced tables at cleanup.
+	struct _Table {
+		uint32_t mask = 0;
+		std::atomic<_Data *> *buckets = nullptr;
+		_Table *previous = nullptr;
+	};
+
+	struct _Stripe {
+		BinaryMutex mutex;
+		_Data *retired = nullptr;
+		uint32_t retired_count = 0;
+	};
+
+	// The epoch a thread's lookup started in, 0 while it is not looking up.
+	struct _Reader {
+		std::atomic<uint64_t> epoch{ 0 };
+		std::atomic<bool> in_use{ true };
+		_Reader *next = nullptr;
+	};
+
+	struct ThreadReader {
+		uint32_t generation = 0;
+		_Reader *reader = nullptr;
+		~ThreadReader();
+	};
+
+	static std::atomic<_Table *> table;
+	static _Stripe stripes[STRING_TABLE_STRIPES];
+	static std::atomic<uint32_t> entry_count;
+	static std::atomic<uint32_t> grow_sequence; // odd while the chains are being relinked
+	static std::atomic<uint64_t> epoch;
+	static std::atomic<_Reader *> readers;
+	static BinaryMutex readers_mutex;
+	static uint32_t generation;
+	static thread_local ThreadReader thread_reader;
 
 	_Data *_data = nullptr;
 
@@ -71,13 +110,26 @@ class StringName {
 		uint32_t hash;
 	};
 
+	static _Table *_alloc_table(uint32_t p_buckets);
+	static _Reader *_get_reader();
+	template <class T>
+	static _Data *_find(const std::atomic<_Data *> &p_bucket, uint32_t p_hash, const T &p_name);
+	template <class T>
+	static _Data *_lookup(uint32_t p_hash, const T &p_name);
+	template <class T>
+	static _Data *_find_locked(uint32_t p_hash, const T &p_name);
+	template <class T>
+	static _Data *_intern(uint32_t p_hash, const T &p_name, const char *p_cname);
+	static void _grow(uint32_t p_buckets);
+	static void _reclaim(_Stripe &p_stripe);
+
 	void unref();
 	friend void register_core_types();
 	friend void unregister_core_types();
 	friend class Main;
-	static Mutex mutex;
 	static void setup();
 	static void cleanup();
+	static void reserve(uint32_t p_buckets);
 	static bool configured;
 
 	StringName(_Data *p_data) { _data = p_data; }
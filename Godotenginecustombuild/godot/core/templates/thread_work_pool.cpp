@@ -32,7 +32,10 @@
 
 #include "core/os/os.h"
 
+thread_local int32_t ThreadWorkPool::current_thread_index = -1;
+
 void ThreadWorkPool::_thread_function(ThreadData *p_thread) {
+	current_thread_index = p_thread->index;
 	while (true) {
 		p_thread->start.wait();
 		if (p_thread->exit.load()) {
@@ -54,6 +57,7 @@ void ThreadWorkPool::init(int p_thread_count) {
 
 	for (uint32_t i = 0; i < thread_count; i++) {
 		threads[i].exit.store(false);
+		threads[i].index = i;
 		threads[i].thread = memnew(std::thread(ThreadWorkPool::_thread_function, &threads[i]));
 	}
 }
@@ -69,12 +69,15 @@ class ThreadWorkPool {
 		Semaphore completed;
 		std::atomic<bool> exit;
 		BaseWork *work;
+		uint32_t index;
 	};
 
 	ThreadData *threads = nullptr;
 	uint32_t thread_count = 0;
 	BaseWork *current_work = nullptr;
 
+	static thread_local int32_t current_thread_index;
+
 	static void _thread_function(ThreadData *p_thread);
 
 public:
@@ -108,6 +111,15 @@ public:
 		return index;
 	}
 
+	uint32_t get_thread_count() const {
+		return thread_count;
+	}
+
+	// Index of the pool thread running the caller, -1 outside of pool threads.
+	static int32_t get_thread_index() {
+		return current_thread_index;
+	}
+
 	void end_work() {
 		ERR_FAIL_COND(current_work == nullptr);
 		for (uint32_t i = 0; i < thread_count; i++) {
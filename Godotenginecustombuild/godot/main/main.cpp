@@ -1049,6 +1049,12 @@ Error Main::setup(const char *execpath, int argc, char *argv[], bool p_second_ph
 	// Initialize user data dir.
 	OS::get_singleton()->ensure_user_data_dir();
 
+	StringName::reserve(GLOBAL_DEF_RST("memory/limits/string_name/initial_table_size", 4096));
+	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/string_name/initial_table_size",
+			PropertyInfo(Variant::INT,
+					"memory/limits/string_name/initial_table_size",
+					PROPERTY_HINT_RANGE,
+					"4096,1048576,1,or_greater"));
 	GLOBAL_DEF("memory/limits/multithreaded_server/rid_pool_prealloc", 60);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/multithreaded_server/rid_pool_prealloc",
 			PropertyInfo(Variant::INT,
@@ -2388,6 +2394,7 @@ bool Main::iteration() {
 	for (int iters = 0; iters < advance.physics_steps; ++iters) {
 		uint64_t physics_begin = OS::get_singleton()->get_ticks_usec();
 
+		PhysicsServer3D::get_singleton()->sync();
 		PhysicsServer3D::get_singleton()->flush_queries();
 
 		PhysicsServer2D::get_singleton()->sync();
@@ -2402,6 +2409,7 @@ bool Main::iteration() {
 
 		message_queue->flush();
 
+		PhysicsServer3D::get_singleton()->end_sync();
 		PhysicsServer3D::get_singleton()->step(frame_slice * time_scale);
 
 		PhysicsServer2D::get_singleton()->end_sync();
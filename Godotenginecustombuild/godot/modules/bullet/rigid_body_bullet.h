@@ -89,13 +89,13 @@ private:
 
 public:
 	virtual Vector3 get_total_gravity() const override;
-	virtual float get_total_angular_damp() const override;
-	virtual float get_total_linear_damp() const override;
+	virtual real_t get_total_angular_damp() const override;
+	virtual real_t get_total_linear_damp() const override;
 
 	virtual Vector3 get_center_of_mass() const override;
 	virtual Basis get_principal_inertia_axes() const override;
 	// get the mass
-	virtual float get_inverse_mass() const override;
+	virtual real_t get_inverse_mass() const override;
 	// get density of this body space
 	virtual Vector3 get_inverse_inertia() const override;
 	// get density of this body space
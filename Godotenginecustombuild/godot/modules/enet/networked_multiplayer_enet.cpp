@@ -568,8 +568,7 @@ Error NetworkedMultiplayerENet::put_packet(const uint8_t *p_buffer, int p_buffer
 		if (target_peer == 0) {
 			enet_host_broadcast(host, channel, packet);
 		} else if (target_peer < 0) {
-			// Send to all but one
-			// and make copies for sending
+			// Send to all but one, sharing the same packet like enet_host_broadcast does.
 
 			int exclude = -target_peer;
 
@@ -578,12 +577,12 @@ Error NetworkedMultiplayerENet::put_packet(const uint8_t *p_buffer, int p_buffer
 					continue;
 				}
 
-				ENetPacket *packet2 = enet_packet_create(packet->data, packet->dataLength, packet_flags);
-
-				enet_peer_send(F->get(), channel, packet2);
+				enet_peer_send(F->get(), channel, packet);
 			}
 
-			enet_packet_destroy(packet); // Original packet no longer needed
+			if (packet->referenceCount == 0) {
+				enet_packet_destroy(packet); // Nobody took it.
+			}
 		} else {
 			enet_peer_send(E->get(), channel, packet);
 		}
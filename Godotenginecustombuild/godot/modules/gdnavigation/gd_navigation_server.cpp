@@ -115,10 +115,12 @@
 
 GdNavigationServer::GdNavigationServer() :
 		NavigationServer3D() {
+	work_pool.init();
 }
 
 GdNavigationServer::~GdNavigationServer() {
 	flush_queries();
+	work_pool.finish();
 }
 
 void GdNavigationServer::add_command(SetCommand *command) const {
@@ -207,6 +209,18 @@ Vector<Vector3> GdNavigationServer::map_get_path(RID p_map, Vector3 p_origin, Ve
 	return map->get_path(p_origin, p_destination, p_optimize);
 }
 
+void GdNavigationServer::map_get_paths(RID p_map, const Vector3 *p_origins, const Vector3 *p_destinations, int p_count, bool p_optimize, Vector<Vector3> *r_paths) const {
+	auto mut_this = const_cast<GdNavigationServer *>(this);
+	// The work pool runs one batch at a time, and it steps the maps too.
+	MutexLock lock(mut_this->operations_mutex);
+
+	const NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND(map == nullptr);
+	ERR_FAIL_COND(p_count < 0);
+
+	map->get_paths(p_origins, p_destinations, p_count, p_optimize, r_paths, mut_this->work_pool);
+}
+
 Vector3 GdNavigationServer::map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
 	const NavMap *map = map_owner.getornull(p_map);
 	ERR_FAIL_COND_V(map == nullptr, Vector3());
@@ -492,7 +506,12 @@ void GdNavigationServer::process(real_t p_delta_time) {
 	MutexLock lock(operations_mutex);
 	for (int i(0); i < active_maps.size(); i++) {
 		active_maps[i]->sync();
-		active_maps[i]->step(p_delta_time);
+		active_maps[i]->step(p_delta_time, work_pool);
+	}
+
+	// The callbacks run once all the maps are stepped, so the scripts always
+	// see the results of the whole frame.
+	for (int i(0); i < active_maps.size(); i++) {
 		active_maps[i]->dispatch_callbacks();
 	}
 }
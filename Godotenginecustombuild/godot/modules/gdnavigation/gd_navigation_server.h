@@ -81,6 +81,10 @@ class GdNavigationServer : public NavigationServer3D {
 	bool active = true;
 	Vector<NavMap *> active_maps;
 
+	/// Steps the avoidance of the maps agents, and solves the batched path
+	/// queries.
+	ThreadWorkPool work_pool;
+
 public:
 	GdNavigationServer();
 	virtual ~GdNavigationServer();
@@ -101,6 +105,7 @@ public:
 	virtual real_t map_get_edge_connection_margin(RID p_map) const;
 
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize) const;
+	virtual void map_get_paths(RID p_map, const Vector3 *p_origins, const Vector3 *p_destinations, int p_count, bool p_optimize, Vector<Vector3> *r_paths) const;
 
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const;
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const;
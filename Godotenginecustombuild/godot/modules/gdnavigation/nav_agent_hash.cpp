@@ -0,0 +1,119 @@
+/*************************************************************************/
+/*  nav_agent_hash.cpp                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_agent_hash.h"
+
+gd::PointKey NavAgentHash::get_key(const Vector3 &p_position) const {
+	// Clamped to the key range, so far away agents share the border cells
+	// instead of wrapping around.
+	const int64_t x = CLAMP(int64_t(Math::floor(p_position.x * inv_cell_size)), -(1 << 20), (1 << 20) - 1);
+	const int64_t y = CLAMP(int64_t(Math::floor(p_position.y * inv_cell_size)), -(1 << 21), (1 << 21) - 1);
+	const int64_t z = CLAMP(int64_t(Math::floor(p_position.z * inv_cell_size)), -(1 << 20), (1 << 20) - 1);
+
+	gd::PointKey key;
+	key.key = 0;
+	key.x = x;
+	key.y = y;
+	key.z = z;
+	return key;
+}
+
+void NavAgentHash::insert(uint32_t p_agent, const gd::PointKey &p_key, const Vector3 &p_position) {
+	uint32_t cell_id;
+	const uint32_t *existing = cell_ids.getptr(p_key.key);
+	if (existing) {
+		cell_id = *existing;
+	} else {
+		if (free_cells.empty()) {
+			cell_id = cells.size();
+			cells.push_back(Cell());
+		} else {
+			cell_id = free_cells.back();
+			free_cells.pop_back();
+		}
+		cells[cell_id].key = p_key;
+		cell_ids.set(p_key.key, cell_id);
+	}
+
+	Cell &cell = cells[cell_id];
+	agents[p_agent].cell = cell_id;
+	agents[p_agent].slot = cell.items.size();
+
+	Item item;
+	item.position = p_position;
+	item.agent = p_agent;
+	cell.items.push_back(item);
+}
+
+void NavAgentHash::erase(uint32_t p_agent) {
+	Agent &agent = agents[p_agent];
+	Cell &cell = cells[agent.cell];
+
+	const Item &last = cell.items.back();
+	agents[last.agent].slot = agent.slot;
+	cell.items[agent.slot] = last;
+	cell.items.pop_back();
+
+	if (cell.items.empty()) {
+		cell_ids.erase(cell.key.key);
+		free_cells.push_back(agent.cell);
+	}
+	agent.cell = INVALID_CELL;
+}
+
+void NavAgentHash::reset(uint32_t p_agent_count) {
+	cells.clear();
+	free_cells.clear();
+	cell_ids.clear();
+	agents.clear();
+	agents.resize(p_agent_count);
+}
+
+void NavAgentHash::set_cell_size(real_t p_cell_size) {
+	ERR_FAIL_COND(p_cell_size <= 0.0);
+	cell_size = p_cell_size;
+	inv_cell_size = 1.0 / p_cell_size;
+	reset(agents.size());
+}
+
+bool NavAgentHash::update(uint32_t p_agent, const Vector3 &p_position) {
+	const gd::PointKey key = get_key(p_position);
+	const Agent &agent = agents[p_agent];
+	if (agent.cell != INVALID_CELL) {
+		Cell &cell = cells[agent.cell];
+		if (cell.key.key == key.key) {
+			cell.items[agent.slot].position = p_position;
+			return false;
+		}
+		erase(p_agent);
+	}
+	insert(p_agent, key, p_position);
+	return true;
+}
@@ -0,0 +1,156 @@
+/*************************************************************************/
+/*  nav_agent_hash.h                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef NAV_AGENT_HASH_H
+#define NAV_AGENT_HASH_H
+
+#include "core/math/vector3.h"
+#include "core/templates/hash_map.h"
+#include "nav_utils.h"
+
+#include <vector>
+
+/// Uniform grid over the avoidance agents, used to find their neighbors.
+///
+/// Unlike a tree it's updated incrementally: each step only the agents that
+/// crossed a cell border are moved from a cell to the other. Agents are
+/// referred by their index in the map agents array, so the map resets the
+/// hash each time that array changes.
+///
+/// The cells are visited in a fixed order and the agents are moved in index
+/// order, so the same simulation always yields the same neighbors.
+class NavAgentHash {
+	enum {
+		INVALID_CELL = UINT32_MAX,
+	};
+
+	struct Item {
+		/// Copy of the agent position, so the far agents are discarded
+		/// without touching them.
+		Vector3 position;
+		uint32_t agent;
+	};
+
+	struct Cell {
+		gd::PointKey key;
+		std::vector<Item> items;
+	};
+
+	struct Agent {
+		uint32_t cell = INVALID_CELL;
+		/// Index of the agent in `Cell::items`.
+		uint32_t slot = 0;
+	};
+
+	real_t cell_size = 1.0;
+	real_t inv_cell_size = 1.0;
+
+	std::vector<Cell> cells;
+	/// Empty cells, ready to be reused.
+	std::vector<uint32_t> free_cells;
+	HashMap<uint64_t, uint32_t> cell_ids;
+
+	std::vector<Agent> agents;
+
+	gd::PointKey get_key(const Vector3 &p_position) const;
+	void insert(uint32_t p_agent, const gd::PointKey &p_key, const Vector3 &p_position);
+	void erase(uint32_t p_agent);
+
+	template <class F>
+	void query_cell(const gd::PointKey &p_key, const Vector3 &p_position, real_t &r_range_sq, F &p_visitor) const;
+
+public:
+	/// Removes all the agents, and sizes the hash for `p_agent_count` of them.
+	void reset(uint32_t p_agent_count);
+
+	/// Changing the cell size resets the hash.
+	void set_cell_size(real_t p_cell_size);
+	real_t get_cell_size() const {
+		return cell_size;
+	}
+
+	/// Moves the agent into the cell containing `p_position`, if it isn't
+	/// there already. Returns true if the agent changed cell.
+	bool update(uint32_t p_agent, const Vector3 &p_position);
+
+	/// Calls `p_visitor(agent_index)` for each agent closer than
+	/// `sqrt(r_range_sq)` to `p_position`, the agents of its own cell first.
+	/// The visitor can shrink `r_range_sq`, the cells out of range are skipped.
+	template <class F>
+	void query(const Vector3 &p_position, real_t &r_range_sq, F &p_visitor) const;
+};
+
+template <class F>
+void NavAgentHash::query_cell(const gd::PointKey &p_key, const Vector3 &p_position, real_t &r_range_sq, F &p_visitor) const {
+	const uint32_t *cell_id = cell_ids.getptr(p_key.key);
+	if (cell_id == nullptr) {
+		return;
+	}
+	const std::vector<Item> &items = cells[*cell_id].items;
+	for (size_t i(0); i < items.size(); i++) {
+		if (p_position.distance_squared_to(items[i].position) < r_range_sq) {
+			p_visitor(items[i].agent);
+		}
+	}
+}
+
+template <class F>
+void NavAgentHash::query(const Vector3 &p_position, real_t &r_range_sq, F &p_visitor) const {
+	const gd::PointKey center = get_key(p_position);
+	query_cell(center, p_position, r_range_sq, p_visitor);
+
+	const real_t range = Math::sqrt(r_range_sq);
+	const gd::PointKey from = get_key(p_position - Vector3(range, range, range));
+	const gd::PointKey to = get_key(p_position + Vector3(range, range, range));
+
+	gd::PointKey key;
+	key.key = 0;
+	for (int64_t x = from.x; x <= to.x; x++) {
+		key.x = x;
+		const real_t dx = MAX(MAX(x * cell_size - p_position.x, p_position.x - (x + 1) * cell_size), 0.0);
+		for (int64_t y = from.y; y <= to.y; y++) {
+			key.y = y;
+			const real_t dy = MAX(MAX(y * cell_size - p_position.y, p_position.y - (y + 1) * cell_size), 0.0);
+			for (int64_t z = from.z; z <= to.z; z++) {
+				key.z = z;
+				if (key.key == center.key) {
+					continue;
+				}
+				const real_t dz = MAX(MAX(z * cell_size - p_position.z, p_position.z - (z + 1) * cell_size), 0.0);
+				if (dx * dx + dy * dy + dz * dz >= r_range_sq) {
+					continue;
+				}
+				query_cell(key, p_position, r_range_sq, p_visitor);
+			}
+		}
+	}
+}
+
+#endif // NAV_AGENT_HASH_H
@@ -0,0 +1,300 @@
+/*************************************************************************/
+/*  nav_bvh.cpp                                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_bvh.h"
+
+#include "core/math/face3.h"
+#include "core/math/geometry_3d.h"
+
+#include <algorithm>
+
+static _FORCE_INLINE_ real_t get_aabb_distance_squared(const AABB &p_a, const AABB &p_b) {
+	Vector3 gap;
+	for (int i = 0; i < 3; i++) {
+		const real_t a_end = p_a.position[i] + p_a.size[i];
+		const real_t b_end = p_b.position[i] + p_b.size[i];
+		if (a_end < p_b.position[i]) {
+			gap[i] = p_b.position[i] - a_end;
+		} else if (b_end < p_a.position[i]) {
+			gap[i] = p_a.position[i] - b_end;
+		}
+	}
+	return gap.length_squared();
+}
+
+/// Closest point of the polygon faces to a point.
+struct NavBVHPointQuery {
+	Vector3 point;
+	AABB point_aabb;
+
+	_FORCE_INLINE_ real_t get_node_distance_squared(const AABB &p_aabb) const {
+		return get_aabb_distance_squared(p_aabb, point_aabb);
+	}
+
+	_FORCE_INLINE_ void test_polygon(const gd::Polygon *p_polygon, real_t &r_distance_squared, NavBVH::ClosestPoint &r_result) const {
+		// For each point cast a face and check the distance to the point
+		for (size_t point_id = 2; point_id < p_polygon->points.size(); point_id++) {
+			const Face3 f(p_polygon->points[point_id - 2].pos, p_polygon->points[point_id - 1].pos, p_polygon->points[point_id].pos);
+			const Vector3 spoint = f.get_closest_point_to(point);
+			const real_t d = spoint.distance_squared_to(point);
+			if (d < r_distance_squared) {
+				r_distance_squared = d;
+				r_result.polygon = p_polygon;
+				r_result.point_id = point_id;
+				r_result.point = spoint;
+			}
+		}
+	}
+
+	NavBVHPointQuery(const Vector3 &p_point) :
+			point(p_point),
+			point_aabb(p_point, Vector3()) {}
+};
+
+/// Intersection of the polygon faces with a segment, closest to its start.
+struct NavBVHSegmentQuery {
+	Vector3 from;
+	Vector3 to;
+	AABB from_aabb;
+
+	_FORCE_INLINE_ real_t get_node_distance_squared(const AABB &p_aabb) const {
+		if (!p_aabb.intersects_segment(from, to)) {
+			return Math_INF;
+		}
+		return get_aabb_distance_squared(p_aabb, from_aabb);
+	}
+
+	_FORCE_INLINE_ void test_polygon(const gd::Polygon *p_polygon, real_t &r_distance_squared, NavBVH::ClosestPoint &r_result) const {
+		// For each point cast a face and check the intersection with the segment
+		for (size_t point_id = 2; point_id < p_polygon->points.size(); point_id++) {
+			const Face3 f(p_polygon->points[point_id - 2].pos, p_polygon->points[point_id - 1].pos, p_polygon->points[point_id].pos);
+			Vector3 inters;
+			if (f.intersects_segment(from, to, &inters)) {
+				const real_t d = inters.distance_squared_to(from);
+				if (d < r_distance_squared) {
+					r_distance_squared = d;
+					r_result.polygon = p_polygon;
+					r_result.point_id = point_id;
+					r_result.point = inters;
+				}
+			}
+		}
+	}
+
+	NavBVHSegmentQuery(const Vector3 &p_from, const Vector3 &p_to) :
+			from(p_from),
+			to(p_to),
+			from_aabb(p_from, Vector3()) {}
+};
+
+/// Closest point of the polygon edges to a segment.
+struct NavBVHSegmentEdgeQuery {
+	Vector3 from;
+	Vector3 to;
+	AABB segment_aabb;
+
+	_FORCE_INLINE_ real_t get_node_distance_squared(const AABB &p_aabb) const {
+		// The segment lies in its own box, so the distance between the boxes never exceeds the real one.
+		return get_aabb_distance_squared(p_aabb, segment_aabb);
+	}
+
+	_FORCE_INLINE_ void test_polygon(const gd::Polygon *p_polygon, real_t &r_distance_squared, NavBVH::ClosestPoint &r_result) const {
+		for (size_t point_id = 0; point_id < p_polygon->points.size(); point_id++) {
+			Vector3 a, b;
+			Geometry3D::get_closest_points_between_segments(
+					from,
+					to,
+					p_polygon->points[point_id].pos,
+					p_polygon->points[(point_id + 1) % p_polygon->points.size()].pos,
+					a,
+					b);
+
+			const real_t d = a.distance_squared_to(b);
+			if (d < r_distance_squared) {
+				r_distance_squared = d;
+				r_result.polygon = p_polygon;
+				r_result.point_id = point_id;
+				r_result.point = b;
+			}
+		}
+	}
+
+	NavBVHSegmentEdgeQuery(const Vector3 &p_from, const Vector3 &p_to) :
+			from(p_from),
+			to(p_to),
+			segment_aabb(p_from, Vector3()) {
+		segment_aabb.expand_to(p_to);
+	}
+};
+
+uint32_t NavBVH::_build(std::vector<BuildPolygon> &p_polygons, uint32_t p_from, uint32_t p_to, uint32_t p_depth) {
+	const uint32_t node_id = nodes.size();
+	nodes.push_back(Node());
+
+	AABB aabb = p_polygons[p_from].aabb;
+	AABB centers(p_polygons[p_from].center, Vector3());
+	for (uint32_t i = p_from + 1; i < p_to; i++) {
+		aabb.merge_with(p_polygons[i].aabb);
+		centers.expand_to(p_polygons[i].center);
+	}
+	nodes[node_id].aabb = aabb;
+
+	if (p_to - p_from <= MAX_LEAF_POLYGONS || p_depth + 1 >= MAX_DEPTH) {
+		nodes[node_id].index = leaf_polygons.size();
+		nodes[node_id].count = p_to - p_from;
+		for (uint32_t i = p_from; i < p_to; i++) {
+			leaf_polygons.push_back(p_polygons[i].polygon);
+		}
+		return node_id;
+	}
+
+	// Splitting at the median keeps the tree balanced, whatever the polygons layout.
+	const int axis = centers.get_longest_axis_index();
+	const uint32_t middle = (p_from + p_to) / 2;
+	std::nth_element(
+			p_polygons.begin() + p_from,
+			p_polygons.begin() + middle,
+			p_polygons.begin() + p_to,
+			[axis](const BuildPolygon &p_a, const BuildPolygon &p_b) {
+				return p_a.center[axis] < p_b.center[axis];
+			});
+
+	_build(p_polygons, p_from, middle, p_depth + 1);
+	const uint32_t second = _build(p_polygons, middle, p_to, p_depth + 1);
+	nodes[node_id].index = second;
+	return node_id;
+}
+
+template <class Q>
+bool NavBVH::_query(const Q &p_query, ClosestPoint &r_result) const {
+	r_result = ClosestPoint();
+	if (nodes.empty()) {
+		return false;
+	}
+
+	real_t closest_d = Math_INF;
+
+	// Depth first with the nearest child on top, so far branches get
+	// culled by the closest distance found so far.
+	uint32_t stack[MAX_DEPTH + 1];
+	real_t stack_d[MAX_DEPTH + 1];
+	stack[0] = 0;
+	stack_d[0] = p_query.get_node_distance_squared(nodes[0].aabb);
+	int stack_size = 1;
+
+	while (stack_size > 0) {
+		stack_size--;
+		const uint32_t node_id = stack[stack_size];
+		if (stack_d[stack_size] >= closest_d) {
+			continue;
+		}
+
+		const Node &node = nodes[node_id];
+		if (node.count > 0) {
+			for (uint32_t i = 0; i < node.count; i++) {
+				p_query.test_polygon(leaf_polygons[node.index + i], closest_d, r_result);
+			}
+			continue;
+		}
+
+		uint32_t nearest = node_id + 1;
+		uint32_t farthest = node.index;
+		real_t nearest_d = p_query.get_node_distance_squared(nodes[nearest].aabb);
+		real_t farthest_d = p_query.get_node_distance_squared(nodes[farthest].aabb);
+		if (farthest_d < nearest_d) {
+			SWAP(nearest, farthest);
+			SWAP(nearest_d, farthest_d);
+		}
+
+		if (farthest_d < closest_d) {
+			stack[stack_size] = farthest;
+			stack_d[stack_size] = farthest_d;
+			stack_size++;
+		}
+		if (nearest_d < closest_d) {
+			stack[stack_size] = nearest;
+			stack_d[stack_size] = nearest_d;
+			stack_size++;
+		}
+	}
+
+	return r_result.polygon != nullptr;
+}
+
+void NavBVH::build(const std::vector<gd::Polygon> &p_polygons) {
+	clear();
+
+	std::vector<BuildPolygon> build_polygons;
+	build_polygons.reserve(p_polygons.size());
+
+	for (size_t i(0); i < p_polygons.size(); i++) {
+		const gd::Polygon &p = p_polygons[i];
+		if (p.points.empty()) {
+			continue;
+		}
+
+		BuildPolygon bp;
+		bp.polygon = &p;
+		bp.aabb = AABB(p.points[0].pos, Vector3());
+		for (size_t point_id = 1; point_id < p.points.size(); point_id++) {
+			bp.aabb.expand_to(p.points[point_id].pos);
+		}
+		// Navigation meshes are mostly flat, don't let the boxes collapse to planes.
+		bp.aabb.grow_by(CMP_EPSILON);
+		bp.center = bp.aabb.position + bp.aabb.size * 0.5;
+		build_polygons.push_back(bp);
+	}
+
+	if (build_polygons.empty()) {
+		return;
+	}
+
+	// Median splits leave at least two polygons per leaf.
+	nodes.reserve(build_polygons.size());
+	leaf_polygons.reserve(build_polygons.size());
+	_build(build_polygons, 0, build_polygons.size(), 0);
+}
+
+void NavBVH::clear() {
+	nodes.clear();
+	leaf_polygons.clear();
+}
+
+bool NavBVH::get_closest_point(const Vector3 &p_point, ClosestPoint &r_result) const {
+	return _query(NavBVHPointQuery(p_point), r_result);
+}
+
+bool NavBVH::intersect_segment(const Vector3 &p_from, const Vector3 &p_to, ClosestPoint &r_result) const {
+	return _query(NavBVHSegmentQuery(p_from, p_to), r_result);
+}
+
+bool NavBVH::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, ClosestPoint &r_result) const {
+	return _query(NavBVHSegmentEdgeQuery(p_from, p_to), r_result);
+}
@@ -0,0 +1,104 @@
+/*************************************************************************/
+/*  nav_bvh.h                                                            */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef NAV_BVH_H
+#define NAV_BVH_H
+
+#include "core/math/aabb.h"
+#include "nav_utils.h"
+
+#include <vector>
+
+/// Static bounding volume hierarchy over the map polygons.
+///
+/// The map rebuilds it during `sync` each time the polygons change, so it
+/// favors query speed: nodes are stored depth first in a flat array and the
+/// tree is split at the median of the polygon centers.
+///
+/// It holds pointers into the polygon array it was built from, so it must be
+/// rebuilt (or cleared) whenever that array is reallocated.
+class NavBVH {
+public:
+	struct ClosestPoint {
+		const gd::Polygon *polygon = nullptr;
+		/// The polygon point identifying the face (its last point) or the
+		/// edge (its first point) where `point` lies.
+		uint32_t point_id = 0;
+		Vector3 point;
+	};
+
+private:
+	enum {
+		MAX_LEAF_POLYGONS = 4,
+		MAX_DEPTH = 64,
+	};
+
+	struct Node {
+		AABB aabb;
+		/// Leaves: first polygon in `leaf_polygons`.
+		/// Internal nodes: index of the second child, the first one being the next node.
+		uint32_t index = 0;
+		/// Polygons of a leaf, zero for internal nodes.
+		uint32_t count = 0;
+	};
+
+	struct BuildPolygon {
+		const gd::Polygon *polygon;
+		AABB aabb;
+		Vector3 center;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<const gd::Polygon *> leaf_polygons;
+
+	uint32_t _build(std::vector<BuildPolygon> &p_polygons, uint32_t p_from, uint32_t p_to, uint32_t p_depth);
+
+	template <class Q>
+	bool _query(const Q &p_query, ClosestPoint &r_result) const;
+
+public:
+	void build(const std::vector<gd::Polygon> &p_polygons);
+	void clear();
+
+	bool is_empty() const {
+		return nodes.empty();
+	}
+
+	/// Finds the point on the polygons surface closest to `p_point`.
+	bool get_closest_point(const Vector3 &p_point, ClosestPoint &r_result) const;
+
+	/// Finds the intersection between the segment and the polygons surface closest to `p_from`.
+	bool intersect_segment(const Vector3 &p_from, const Vector3 &p_to, ClosestPoint &r_result) const;
+
+	/// Finds the point on the polygons edges closest to the segment.
+	bool get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, ClosestPoint &r_result) const;
+};
+
+#endif // NAV_BVH_H
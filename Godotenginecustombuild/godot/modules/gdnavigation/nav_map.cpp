@@ -30,7 +30,6 @@
 
 #include "nav_map.h"
 
-#include "core/os/threaded_array_processor.h"
 #include "nav_region.h"
 #include "rvo_agent.h"
 
@@ -42,6 +41,47 @@
 
 #define USE_ENTRY_POINT
 
+#define PATH_QUERIES_PARALLEL_MIN 8
+#define AGENTS_PARALLEL_MIN 64
+
+/// The open lists are binary heaps. Rather than updating an entry when its
+/// cost drops, a new one is pushed and the outdated one is skipped once popped.
+struct NavMapOpenEntry {
+	float cost;
+	/// Traveled distance when pushed, to detect the outdated entries.
+	float distance;
+	uint32_t id;
+
+	bool operator<(const NavMapOpenEntry &p_other) const {
+		// Reversed, so the least cost is on top of the heap.
+		return cost > p_other.cost;
+	}
+};
+
+static _FORCE_INLINE_ void open_list_push(std::vector<NavMapOpenEntry> &r_open_list, float p_cost, float p_distance, uint32_t p_id) {
+	NavMapOpenEntry e;
+	e.cost = p_cost;
+	e.distance = p_distance;
+	e.id = p_id;
+	r_open_list.push_back(e);
+	std::push_heap(r_open_list.begin(), r_open_list.end());
+}
+
+static _FORCE_INLINE_ NavMapOpenEntry open_list_pop(std::vector<NavMapOpenEntry> &r_open_list) {
+	std::pop_heap(r_open_list.begin(), r_open_list.end());
+	const NavMapOpenEntry e = r_open_list.back();
+	r_open_list.pop_back();
+	return e;
+}
+
+static _FORCE_INLINE_ float get_navigation_poly_cost(const gd::NavigationPoly &p_poly, const Vector3 &p_end_point) {
+#ifdef USE_ENTRY_POINT
+	return p_poly.traveled_distance + p_poly.entry.distance_to(p_end_point);
+#else
+	return p_poly.traveled_distance + p_poly.poly->center.distance_to(p_end_point);
+#endif
+}
+
 void NavMap::set_up(Vector3 p_up) {
 	up = p_up;
 	regenerate_polygons = true;
@@ -55,6 +95,8 @@ void NavMap::set_cell_size(float p_cell_size) {
 void NavMap::set_edge_connection_margin(float p_edge_connection_margin) {
 	edge_connection_margin = p_edge_connection_margin;
 	regenerate_links = true;
+	// Any region may get new links.
+	path_cache.clear();
 }
 
 gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
@@ -71,43 +113,19 @@ gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 }
 
 Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize) const {
-	const gd::Polygon *begin_poly = nullptr;
-	const gd::Polygon *end_poly = nullptr;
-	Vector3 begin_point;
-	Vector3 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
-
 	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each point cast a face and check the distance between the origin/destination
-		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
-			Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			Vector3 spoint = f.get_closest_point_to(p_origin);
-			float dpoint = spoint.distance_to(p_origin);
-			if (dpoint < begin_d) {
-				begin_d = dpoint;
-				begin_poly = &p;
-				begin_point = spoint;
-			}
-
-			spoint = f.get_closest_point_to(p_destination);
-			dpoint = spoint.distance_to(p_destination);
-			if (dpoint < end_d) {
-				end_d = dpoint;
-				end_poly = &p;
-				end_point = spoint;
-			}
-		}
-	}
-
-	if (!begin_poly || !end_poly) {
+	NavBVH::ClosestPoint begin;
+	NavBVH::ClosestPoint end;
+	if (!polygons_bvh.get_closest_point(p_origin, begin) || !polygons_bvh.get_closest_point(p_destination, end)) {
 		// No path
 		return Vector<Vector3>();
 	}
 
+	const gd::Polygon *begin_poly = begin.polygon;
+	const gd::Polygon *end_poly = end.polygon;
+	const Vector3 begin_point = begin.point;
+	Vector3 end_point = end.point;
+
 	if (begin_poly == end_poly) {
 		Vector<Vector3> path;
 		path.resize(2);
@@ -117,28 +135,160 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	}
 
 	std::vector<gd::NavigationPoly> navigation_polys;
-	navigation_polys.reserve(polygons.size() * 0.75);
+	int least_cost_id = -1;
+
+	NavPathCache::Key cache_key;
+	cache_key.begin.region = begin_poly->owner;
+	cache_key.begin.id = begin_poly->region_polygon_id;
+	cache_key.end.region = end_poly->owner;
+	cache_key.end.id = end_poly->region_polygon_id;
+
+	if (load_cached_route(cache_key, begin_poly, begin_point, navigation_polys)) {
+		least_cost_id = navigation_polys.size() - 1;
+	} else {
+		const gd::Polygon *destination_poly = end_poly;
+		bool found_route = false;
+
+		// Find the clusters to go through first, so only their polygons are searched.
+		std::vector<uint8_t> route_clusters;
+		if (find_cluster_route(begin_poly, begin_point, end_poly, end_point, route_clusters)) {
+			found_route = find_polygon_route(begin_poly, begin_point, end_poly, end_point, p_destination, route_clusters.data(), navigation_polys, least_cost_id);
+		}
+
+		if (!found_route) {
+			// Search the whole map, this falls back to the nearest reachable polygon.
+			found_route = find_polygon_route(begin_poly, begin_point, end_poly, end_point, p_destination, nullptr, navigation_polys, least_cost_id);
+		}
+
+		if (!found_route) {
+			return Vector<Vector3>();
+		}
+
+		if (end_poly == destination_poly) {
+			store_cached_route(cache_key, navigation_polys, least_cost_id);
+		}
+	}
+
+	return build_path(navigation_polys, least_cost_id, begin_poly, begin_point, end_point, p_optimize);
+}
+
+bool NavMap::find_cluster_route(const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, const gd::Polygon *p_end_poly, const Vector3 &p_end_point, std::vector<uint8_t> &r_route_clusters) const {
+	const uint32_t begin_cluster = p_begin_poly->cluster_id;
+	const uint32_t end_cluster = p_end_poly->cluster_id;
+
+	r_route_clusters.assign(clusters.size(), 0);
+	r_route_clusters[begin_cluster] = 1;
+	r_route_clusters[end_cluster] = 1;
+
+	if (begin_cluster == end_cluster) {
+		return true;
+	}
+
+	// A* on the portals graph. The begin and end points are linked to the
+	// portals of their clusters in straight line, the end point is the
+	// node `portals.size()`.
+	const uint32_t goal = portals.size();
+	std::vector<float> distances(portals.size() + 1, Math_INF);
+	std::vector<uint32_t> previous(portals.size() + 1, UINT32_MAX);
+	std::vector<uint8_t> closed(portals.size() + 1, 0);
+	std::vector<NavMapOpenEntry> open_list;
+
+	const std::vector<uint32_t> &begin_portals = clusters[begin_cluster].portals;
+	for (size_t i(0); i < begin_portals.size(); i++) {
+		const uint32_t portal_id = begin_portals[i];
+		distances[portal_id] = p_begin_point.distance_to(portals[portal_id].position);
+		open_list_push(open_list, distances[portal_id] + portals[portal_id].position.distance_to(p_end_point), distances[portal_id], portal_id);
+	}
+
+	while (open_list.size()) {
+		const NavMapOpenEntry current = open_list_pop(open_list);
+		if (closed[current.id] || current.distance > distances[current.id]) {
+			// Outdated entry.
+			continue;
+		}
+		closed[current.id] = 1;
+
+		if (current.id == goal) {
+			std::vector<uint32_t> route;
+			route.push_back(begin_cluster);
+			route.push_back(end_cluster);
+			for (uint32_t portal_id = previous[goal]; portal_id != UINT32_MAX; portal_id = previous[portal_id]) {
+				route.push_back(portals[portal_id].clusters[0]);
+				route.push_back(portals[portal_id].clusters[1]);
+			}
+
+			// The portals are crude summaries of the cluster borders, so also
+			// search the clusters next to the route in case they hold a shortcut.
+			for (size_t r(0); r < route.size(); r++) {
+				const std::vector<uint32_t> &route_portals = clusters[route[r]].portals;
+				for (size_t i(0); i < route_portals.size(); i++) {
+					r_route_clusters[portals[route_portals[i]].clusters[0]] = 1;
+					r_route_clusters[portals[route_portals[i]].clusters[1]] = 1;
+				}
+			}
+			return true;
+		}
+
+		const gd::Portal &portal = portals[current.id];
+		for (int side = 0; side < 2; side++) {
+			const gd::Cluster &cluster = clusters[portal.clusters[side]];
+			const uint32_t portal_count = cluster.portals.size();
+			const float *portal_distances = &cluster.portal_distances[portal.cluster_portals[side] * portal_count];
+
+			for (uint32_t i = 0; i < portal_count; i++) {
+				const uint32_t next_id = cluster.portals[i];
+				const float distance = current.distance + portal_distances[i];
+				if (next_id != current.id && !closed[next_id] && distance < distances[next_id]) {
+					distances[next_id] = distance;
+					previous[next_id] = current.id;
+					open_list_push(open_list, distance + portals[next_id].position.distance_to(p_end_point), distance, next_id);
+				}
+			}
+
+			if (portal.clusters[side] == end_cluster) {
+				const float distance = current.distance + portal.position.distance_to(p_end_point);
+				if (distance < distances[goal]) {
+					distances[goal] = distance;
+					previous[goal] = current.id;
+					open_list_push(open_list, distance, distance, goal);
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+bool NavMap::find_polygon_route(const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, const gd::Polygon *&r_end_poly, Vector3 &r_end_point, const Vector3 &p_destination, const uint8_t *p_route_clusters, std::vector<gd::NavigationPoly> &r_navigation_polys, int &r_least_cost_id) const {
+	std::vector<gd::NavigationPoly> &navigation_polys = r_navigation_polys;
+	navigation_polys.clear();
+	if (!p_route_clusters) {
+		navigation_polys.reserve(polygons.size() * 0.75);
+	}
+
+	// The `navigation_polys` index of each map polygon, -1 when not visited.
+	std::vector<int> polygon_navigation_ids(polygons.size(), -1);
 
 	// The elements indices in the `navigation_polys`.
 	int least_cost_id(-1);
-	List<uint32_t> open_list;
-	bool found_route = false;
+	std::vector<NavMapOpenEntry> open_list;
 
-	navigation_polys.push_back(gd::NavigationPoly(begin_poly));
+	navigation_polys.push_back(gd::NavigationPoly(p_begin_poly));
 	{
 		least_cost_id = 0;
 		gd::NavigationPoly *least_cost_poly = &navigation_polys[least_cost_id];
 		least_cost_poly->self_id = least_cost_id;
-		least_cost_poly->entry = begin_point;
+		least_cost_poly->entry = p_begin_point;
+		polygon_navigation_ids[p_begin_poly->id] = least_cost_id;
 	}
 
-	open_list.push_back(0);
-
 	const gd::Polygon *reachable_end = nullptr;
 	float reachable_d = 1e30;
 	bool is_reachable = true;
 
-	while (found_route == false) {
+	while (true) {
+		navigation_polys[least_cost_id].closed = true;
+
 		{
 			// Takes the current least_cost_poly neighbors and compute the traveled_distance of each
 			for (size_t i = 0; i < navigation_polys[least_cost_id].poly->edges.size(); i++) {
@@ -149,6 +299,10 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					continue;
 				}
 
+				if (p_route_clusters && !p_route_clusters[edge.other_polygon->cluster_id]) {
+					continue;
+				}
+
 #ifdef USE_ENTRY_POINT
 				Vector3 edge_line[2] = {
 					least_cost_poly->poly->points[i].pos,
@@ -161,20 +315,20 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				const float new_distance = least_cost_poly->poly->center.distance_to(edge.other_polygon->center) + least_cost_poly->traveled_distance;
 #endif
 
-				auto it = std::find(
-						navigation_polys.begin(),
-						navigation_polys.end(),
-						gd::NavigationPoly(edge.other_polygon));
-
-				if (it != navigation_polys.end()) {
+				const int navigation_id = polygon_navigation_ids[edge.other_polygon->id];
+				if (navigation_id != -1) {
+					gd::NavigationPoly *np = &navigation_polys[navigation_id];
 					// Oh this was visited already, can we win the cost?
-					if (it->traveled_distance > new_distance) {
-						it->prev_navigation_poly_id = least_cost_id;
-						it->back_navigation_edge = edge.other_edge;
-						it->traveled_distance = new_distance;
+					if (np->traveled_distance > new_distance) {
+						np->prev_navigation_poly_id = least_cost_id;
+						np->back_navigation_edge = edge.other_edge;
+						np->traveled_distance = new_distance;
 #ifdef USE_ENTRY_POINT
-						it->entry = new_entry;
+						np->entry = new_entry;
 #endif
+						if (!np->closed) {
+							open_list_push(open_list, get_navigation_poly_cost(*np, r_end_point), np->traveled_distance, navigation_id);
+						}
 					}
 				} else {
 					// Add to open neighbours
@@ -189,67 +343,69 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 #ifdef USE_ENTRY_POINT
 					np->entry = new_entry;
 #endif
-					open_list.push_back(navigation_polys.size() - 1);
+					polygon_navigation_ids[edge.other_polygon->id] = np->self_id;
+					open_list_push(open_list, get_navigation_poly_cost(*np, r_end_point), np->traveled_distance, np->self_id);
 				}
 			}
 		}
 
-		// Removes the least cost polygon from the open list so we can advance.
-		open_list.erase(least_cost_id);
+		// Now take the new least_cost_poly from the open list.
+		least_cost_id = -1;
+		while (open_list.size()) {
+			const NavMapOpenEntry least_cost = open_list_pop(open_list);
+			const gd::NavigationPoly &np = navigation_polys[least_cost.id];
+			// Skip the entries outdated by a cheaper one.
+			if (!np.closed && np.traveled_distance == least_cost.distance) {
+				least_cost_id = least_cost.id;
+				break;
+			}
+		}
+
+		if (least_cost_id == -1) {
+			if (p_route_clusters) {
+				// Let the caller search the whole map instead.
+				return false;
+			}
 
-		if (open_list.size() == 0) {
 			// When the open list is empty at this point the End Polygon is not reachable
 			// so use the further reachable polygon
-			ERR_BREAK_MSG(is_reachable == false, "It's not expect to not find the most reachable polygons");
+			ERR_FAIL_COND_V_MSG(is_reachable == false, false, "It's not expect to not find the most reachable polygons");
 			is_reachable = false;
 			if (reachable_end == nullptr) {
 				// The path is not found and there is not a way out.
-				break;
+				return false;
 			}
 
 			// Set as end point the furthest reachable point.
-			end_poly = reachable_end;
-			end_d = 1e20;
-			for (size_t point_id = 2; point_id < end_poly->points.size(); point_id++) {
-				Face3 f(end_poly->points[point_id - 2].pos, end_poly->points[point_id - 1].pos, end_poly->points[point_id].pos);
+			r_end_poly = reachable_end;
+			float end_d = 1e20;
+			for (size_t point_id = 2; point_id < r_end_poly->points.size(); point_id++) {
+				Face3 f(r_end_poly->points[point_id - 2].pos, r_end_poly->points[point_id - 1].pos, r_end_poly->points[point_id].pos);
 				Vector3 spoint = f.get_closest_point_to(p_destination);
 				float dpoint = spoint.distance_to(p_destination);
 				if (dpoint < end_d) {
-					end_point = spoint;
+					r_end_point = spoint;
 					end_d = dpoint;
 				}
 			}
 
 			// Reset open and navigation_polys
+			for (size_t i(0); i < navigation_polys.size(); i++) {
+				polygon_navigation_ids[navigation_polys[i].poly->id] = -1;
+			}
 			gd::NavigationPoly np = navigation_polys[0];
+			np.closed = false;
 			navigation_polys.clear();
 			navigation_polys.push_back(np);
+			polygon_navigation_ids[np.poly->id] = 0;
 			open_list.clear();
-			open_list.push_back(0);
+			least_cost_id = 0;
 
 			reachable_end = nullptr;
 
 			continue;
 		}
 
-		// Now take the new least_cost_poly from the open list.
-		least_cost_id = -1;
-		float least_cost = 1e30;
-
-		for (auto element = open_list.front(); element != nullptr; element = element->next()) {
-			gd::NavigationPoly *np = &navigation_polys[element->get()];
-			float cost = np->traveled_distance;
-#ifdef USE_ENTRY_POINT
-			cost += np->entry.distance_to(end_point);
-#else
-			cost += np->poly->center.distance_to(end_point);
-#endif
-			if (cost < least_cost) {
-				least_cost_id = np->self_id;
-				least_cost = cost;
-			}
-		}
-
 		// Stores the further reachable end polygon, in case our goal is not reachable.
 		if (is_reachable) {
 			float d = navigation_polys[least_cost_id].entry.distance_to(p_destination);
@@ -259,261 +415,286 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 			}
 		}
 
-		ERR_BREAK(least_cost_id == -1);
-
 		// Check if we reached the end
-		if (navigation_polys[least_cost_id].poly == end_poly) {
+		if (navigation_polys[least_cost_id].poly == r_end_poly) {
 			// Yep, done!!
-			found_route = true;
-			break;
+			r_least_cost_id = least_cost_id;
+			return true;
 		}
 	}
+}
 
-	if (found_route) {
-		Vector<Vector3> path;
-		if (p_optimize) {
-			// String pulling
+bool NavMap::load_cached_route(const NavPathCache::Key &p_key, const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, std::vector<gd::NavigationPoly> &r_navigation_polys) const {
+	std::vector<NavPathCache::Step> corridor;
+	if (!path_cache.get(p_key, corridor)) {
+		return false;
+	}
 
-			gd::NavigationPoly *apex_poly = &navigation_polys[least_cost_id];
-			Vector3 apex_point = end_point;
-			Vector3 portal_left = apex_point;
-			Vector3 portal_right = apex_point;
-			gd::NavigationPoly *left_poly = apex_poly;
-			gd::NavigationPoly *right_poly = apex_poly;
-			gd::NavigationPoly *p = apex_poly;
+	r_navigation_polys.clear();
+	r_navigation_polys.reserve(corridor.size());
+	r_navigation_polys.push_back(gd::NavigationPoly(p_begin_poly));
+	r_navigation_polys[0].entry = p_begin_point;
 
-			path.push_back(end_point);
+	// Walk the corridor again from the new begin point, as the search would.
+	for (size_t i = 1; i < corridor.size(); i++) {
+		const gd::Polygon *poly = get_polygon(corridor[i].polygon);
+		if (!poly || corridor[i].back_edge >= poly->edges.size()) {
+			return false;
+		}
 
-			while (p) {
-				Vector3 left;
-				Vector3 right;
+		const gd::Edge &back_edge = poly->edges[corridor[i].back_edge];
+		const gd::NavigationPoly prev_poly = r_navigation_polys[i - 1];
+		if (back_edge.other_polygon != prev_poly.poly) {
+			// The links changed since it was cached.
+			return false;
+		}
 
-#define CLOCK_TANGENT(m_a, m_b, m_c) (((m_a) - (m_c)).cross((m_a) - (m_b)))
+		gd::NavigationPoly np(poly);
+		np.self_id = i;
+		np.prev_navigation_poly_id = i - 1;
+		np.back_navigation_edge = corridor[i].back_edge;
+#ifdef USE_ENTRY_POINT
+		const int prev_edge = back_edge.other_edge;
+		Vector3 edge_line[2] = {
+			prev_poly.poly->points[prev_edge].pos,
+			prev_poly.poly->points[(prev_edge + 1) % prev_poly.poly->points.size()].pos
+		};
+
+		np.entry = Geometry3D::get_closest_point_to_segment(prev_poly.entry, edge_line);
+		np.traveled_distance = prev_poly.entry.distance_to(np.entry) + prev_poly.traveled_distance;
+#else
+		np.traveled_distance = prev_poly.poly->center.distance_to(poly->center) + prev_poly.traveled_distance;
+#endif
+		r_navigation_polys.push_back(np);
+	}
 
-				if (p->poly == begin_poly) {
-					left = begin_point;
-					right = begin_point;
-				} else {
-					int prev = p->back_navigation_edge;
-					int prev_n = (p->back_navigation_edge + 1) % p->poly->points.size();
-					left = p->poly->points[prev].pos;
-					right = p->poly->points[prev_n].pos;
+	return true;
+}
 
-					if (p->poly->clockwise) {
-						SWAP(left, right);
-					}
-				}
+void NavMap::store_cached_route(const NavPathCache::Key &p_key, const std::vector<gd::NavigationPoly> &p_navigation_polys, int p_least_cost_id) const {
+	uint32_t size = 0;
+	for (int np_id = p_least_cost_id; np_id != -1; np_id = p_navigation_polys[np_id].prev_navigation_poly_id) {
+		size++;
+	}
 
-				bool skip = false;
-
-				if (CLOCK_TANGENT(apex_point, portal_left, left).dot(up) >= 0) {
-					//process
-					if (portal_left == apex_point || CLOCK_TANGENT(apex_point, left, portal_right).dot(up) > 0) {
-						left_poly = p;
-						portal_left = left;
-					} else {
-						clip_path(navigation_polys, path, apex_poly, portal_right, right_poly);
-
-						apex_point = portal_right;
-						p = right_poly;
-						left_poly = p;
-						apex_poly = p;
-						portal_left = apex_point;
-						portal_right = apex_point;
-						path.push_back(apex_point);
-						skip = true;
-					}
+	std::vector<NavPathCache::Step> corridor(size);
+	for (int np_id = p_least_cost_id; np_id != -1; np_id = p_navigation_polys[np_id].prev_navigation_poly_id) {
+		NavPathCache::Step &step = corridor[--size];
+		step.polygon.region = p_navigation_polys[np_id].poly->owner;
+		step.polygon.id = p_navigation_polys[np_id].poly->region_polygon_id;
+		step.back_edge = p_navigation_polys[np_id].back_navigation_edge;
+	}
+
+	path_cache.put(p_key, corridor);
+}
+
+const gd::Polygon *NavMap::get_polygon(const NavPathCache::PolygonKey &p_key) const {
+	const uint32_t *offset = region_polygons_offset.getptr(p_key.region);
+	if (!offset || *offset + p_key.id >= polygons.size()) {
+		return nullptr;
+	}
+
+	const gd::Polygon *poly = &polygons[*offset + p_key.id];
+	if (poly->owner != p_key.region || poly->region_polygon_id != p_key.id) {
+		return nullptr;
+	}
+	return poly;
+}
+
+Vector<Vector3> NavMap::build_path(std::vector<gd::NavigationPoly> &navigation_polys, int least_cost_id, const gd::Polygon *begin_poly, const Vector3 &begin_point, const Vector3 &end_point, bool p_optimize) const {
+	Vector<Vector3> path;
+	if (p_optimize) {
+		// String pulling
+
+		gd::NavigationPoly *apex_poly = &navigation_polys[least_cost_id];
+		Vector3 apex_point = end_point;
+		Vector3 portal_left = apex_point;
+		Vector3 portal_right = apex_point;
+		gd::NavigationPoly *left_poly = apex_poly;
+		gd::NavigationPoly *right_poly = apex_poly;
+		gd::NavigationPoly *p = apex_poly;
+
+		path.push_back(end_point);
+
+		while (p) {
+			Vector3 left;
+			Vector3 right;
+
+#define CLOCK_TANGENT(m_a, m_b, m_c) (((m_a) - (m_c)).cross((m_a) - (m_b)))
+
+			if (p->poly == begin_poly) {
+				left = begin_point;
+				right = begin_point;
+			} else {
+				int prev = p->back_navigation_edge;
+				int prev_n = (p->back_navigation_edge + 1) % p->poly->points.size();
+				left = p->poly->points[prev].pos;
+				right = p->poly->points[prev_n].pos;
+
+				if (p->poly->clockwise) {
+					SWAP(left, right);
 				}
+			}
 
-				if (!skip && CLOCK_TANGENT(apex_point, portal_right, right).dot(up) <= 0) {
-					//process
-					if (portal_right == apex_point || CLOCK_TANGENT(apex_point, right, portal_left).dot(up) < 0) {
-						right_poly = p;
-						portal_right = right;
-					} else {
-						clip_path(navigation_polys, path, apex_poly, portal_left, left_poly);
-
-						apex_point = portal_left;
-						p = left_poly;
-						right_poly = p;
-						apex_poly = p;
-						portal_right = apex_point;
-						portal_left = apex_point;
-						path.push_back(apex_point);
-					}
+			bool skip = false;
+
+			if (CLOCK_TANGENT(apex_point, portal_left, left).dot(up) >= 0) {
+				//process
+				if (portal_left == apex_point || CLOCK_TANGENT(apex_point, left, portal_right).dot(up) > 0) {
+					left_poly = p;
+					portal_left = left;
+				} else {
+					clip_path(navigation_polys, path, apex_poly, portal_right, right_poly);
+
+					apex_point = portal_right;
+					p = right_poly;
+					left_poly = p;
+					apex_poly = p;
+					portal_left = apex_point;
+					portal_right = apex_point;
+					path.push_back(apex_point);
+					skip = true;
 				}
+			}
 
-				if (p->prev_navigation_poly_id != -1) {
-					p = &navigation_polys[p->prev_navigation_poly_id];
+			if (!skip && CLOCK_TANGENT(apex_point, portal_right, right).dot(up) <= 0) {
+				//process
+				if (portal_right == apex_point || CLOCK_TANGENT(apex_point, right, portal_left).dot(up) < 0) {
+					right_poly = p;
+					portal_right = right;
 				} else {
-					// The end
-					p = nullptr;
+					clip_path(navigation_polys, path, apex_poly, portal_left, left_poly);
+
+					apex_point = portal_left;
+					p = left_poly;
+					right_poly = p;
+					apex_poly = p;
+					portal_right = apex_point;
+					portal_left = apex_point;
+					path.push_back(apex_point);
 				}
 			}
 
-			if (path[path.size() - 1] != begin_point) {
-				path.push_back(begin_point);
+			if (p->prev_navigation_poly_id != -1) {
+				p = &navigation_polys[p->prev_navigation_poly_id];
+			} else {
+				// The end
+				p = nullptr;
 			}
+		}
 
-			path.invert();
+		if (path[path.size() - 1] != begin_point) {
+			path.push_back(begin_point);
+		}
+
+		path.invert();
 
-		} else {
-			path.push_back(end_point);
+	} else {
+		path.push_back(end_point);
 
-			// Add mid points
-			int np_id = least_cost_id;
-			while (np_id != -1) {
+		// Add mid points
+		int np_id = least_cost_id;
+		while (np_id != -1) {
 #ifdef USE_ENTRY_POINT
-				Vector3 point = navigation_polys[np_id].entry;
+			Vector3 point = navigation_polys[np_id].entry;
 #else
-				int prev = navigation_polys[np_id].back_navigation_edge;
-				int prev_n = (navigation_polys[np_id].back_navigation_edge + 1) % navigation_polys[np_id].poly->points.size();
-				Vector3 point = (navigation_polys[np_id].poly->points[prev].pos + navigation_polys[np_id].poly->points[prev_n].pos) * 0.5;
+			int prev = navigation_polys[np_id].back_navigation_edge;
+			int prev_n = (navigation_polys[np_id].back_navigation_edge + 1) % navigation_polys[np_id].poly->points.size();
+			Vector3 point = (navigation_polys[np_id].poly->points[prev].pos + navigation_polys[np_id].poly->points[prev_n].pos) * 0.5;
 #endif
 
-				path.push_back(point);
-				np_id = navigation_polys[np_id].prev_navigation_poly_id;
-			}
-
-			path.invert();
+			path.push_back(point);
+			np_id = navigation_polys[np_id].prev_navigation_poly_id;
 		}
 
-		return path;
+		path.invert();
 	}
-	return Vector<Vector3>();
+
+	return path;
 }
 
-Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
-	bool use_collision = p_use_collision;
-	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
+struct NavMapPathQueries {
+	const NavMap *map;
+	const Vector3 *origins;
+	const Vector3 *destinations;
+	bool optimize;
+	Vector<Vector3> *paths;
 
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each point cast a face and check the distance to the segment
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			Vector3 inters;
-			if (f.intersects_segment(p_from, p_to, &inters)) {
-				const real_t d = closest_point_d = p_from.distance_to(inters);
-				if (use_collision == false) {
-					closest_point = inters;
-					use_collision = true;
-					closest_point_d = d;
-				} else if (closest_point_d > d) {
-					closest_point = inters;
-					closest_point_d = d;
-				}
-			}
+	void solve(uint32_t p_index, void *p_userdata) {
+		paths[p_index] = map->get_path(origins[p_index], destinations[p_index], optimize);
+	}
+};
+
+void NavMap::get_paths(const Vector3 *p_origins, const Vector3 *p_destinations, uint32_t p_count, bool p_optimize, Vector<Vector3> *r_paths, ThreadWorkPool &p_work_pool) const {
+	NavMapPathQueries queries;
+	queries.map = this;
+	queries.origins = p_origins;
+	queries.destinations = p_destinations;
+	queries.optimize = p_optimize;
+	queries.paths = r_paths;
+
+	// Below this amount waking the pool threads costs more than the queries.
+	if (p_count < PATH_QUERIES_PARALLEL_MIN || p_work_pool.get_thread_count() <= 1) {
+		for (uint32_t i = 0; i < p_count; i++) {
+			queries.solve(i, nullptr);
 		}
+		return;
+	}
 
-		if (use_collision == false) {
-			for (size_t point_id = 0; point_id < p.points.size(); point_id += 1) {
-				Vector3 a, b;
+	// `get_path` only reads the map, so the queries can run concurrently.
+	p_work_pool.do_work(p_count, &queries, &NavMapPathQueries::solve, (void *)nullptr);
+}
 
-				Geometry3D::get_closest_points_between_segments(
-						p_from,
-						p_to,
-						p.points[point_id].pos,
-						p.points[(point_id + 1) % p.points.size()].pos,
-						a,
-						b);
+Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
+	NavBVH::ClosestPoint closest;
 
-				const real_t d = a.distance_to(b);
-				if (d < closest_point_d) {
-					closest_point_d = d;
-					closest_point = b;
-				}
-			}
-		}
+	// The intersection closest to the segment start has the priority.
+	if (polygons_bvh.intersect_segment(p_from, p_to, closest)) {
+		return closest.point;
+	}
+
+	if (!p_use_collision && polygons_bvh.get_closest_point_to_segment(p_from, p_to, closest)) {
+		return closest.point;
 	}
 
-	return closest_point;
+	return Vector3();
 }
 
 Vector3 NavMap::get_closest_point(const Vector3 &p_point) const {
 	// TODO this is really not optimal, please redesign the API to directly return all this data
 
-	Vector3 closest_point;
-	real_t closest_point_d = 1e20;
-
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_d = d;
-			}
-		}
-	}
-
-	return closest_point;
+	NavBVH::ClosestPoint closest;
+	polygons_bvh.get_closest_point(p_point, closest);
+	return closest.point;
 }
 
 Vector3 NavMap::get_closest_point_normal(const Vector3 &p_point) const {
 	// TODO this is really not optimal, please redesign the API to directly return all this data
 
-	Vector3 closest_point;
-	Vector3 closest_point_normal;
-	real_t closest_point_d = 1e20;
-
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_normal = f.get_plane().normal;
-				closest_point_d = d;
-			}
-		}
+	NavBVH::ClosestPoint closest;
+	if (!polygons_bvh.get_closest_point(p_point, closest)) {
+		return Vector3();
 	}
 
-	return closest_point_normal;
+	const std::vector<gd::Point> &points = closest.polygon->points;
+	const Face3 f(points[closest.point_id - 2].pos, points[closest.point_id - 1].pos, points[closest.point_id].pos);
+	return f.get_plane().normal;
 }
 
 RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
 	// TODO this is really not optimal, please redesign the API to directly return all this data
 
-	Vector3 closest_point;
-	RID closest_point_owner;
-	real_t closest_point_d = 1e20;
-
-	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// For each point cast a face and check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t d = inters.distance_to(p_point);
-			if (d < closest_point_d) {
-				closest_point = inters;
-				closest_point_owner = p.owner->get_self();
-				closest_point_d = d;
-			}
-		}
+	NavBVH::ClosestPoint closest;
+	if (!polygons_bvh.get_closest_point(p_point, closest)) {
+		return RID();
 	}
 
-	return closest_point_owner;
+	return closest.polygon->owner->get_self();
 }
 
 void NavMap::add_region(NavRegion *p_region) {
 	regions.push_back(p_region);
+	changed_regions.push_back(p_region);
 	regenerate_links = true;
 }
 
@@ -522,6 +703,9 @@ void NavMap::remove_region(NavRegion *p_region) {
 	if (it != regions.end()) {
 		regions.erase(it);
 		regenerate_links = true;
+
+		changed_regions.erase(std::remove(changed_regions.begin(), changed_regions.end(), p_region), changed_regions.end());
+		path_cache.invalidate_region(p_region);
 	}
 }
 
@@ -550,6 +734,7 @@ void NavMap::set_agent_as_controlled(RvoAgent *agent) {
 	if (!exist) {
 		ERR_FAIL_COND(!has_agent(agent));
 		controlled_agents.push_back(agent);
+		controlled_agents_dirty = true;
 	}
 }
 
@@ -557,6 +742,7 @@ void NavMap::remove_agent_as_controlled(RvoAgent *agent) {
 	auto it = std::find(controlled_agents.begin(), controlled_agents.end(), agent);
 	if (it != controlled_agents.end()) {
 		controlled_agents.erase(it);
+		controlled_agents_dirty = true;
 	}
 }
 
@@ -566,11 +752,13 @@ void NavMap::sync() {
 			regions[r]->scratch_polygons();
 		}
 		regenerate_links = true;
+		path_cache.clear();
 	}
 
 	for (size_t r(0); r < regions.size(); r++) {
 		if (regions[r]->sync()) {
 			regenerate_links = true;
+			changed_regions.push_back(regions[r]);
 		}
 	}
 
@@ -583,6 +771,7 @@ void NavMap::sync() {
 
 		polygons.resize(count);
 		count = 0;
+		region_polygons_offset.clear();
 
 		for (size_t r(0); r < regions.size(); r++) {
 			std::copy(
@@ -590,9 +779,17 @@ void NavMap::sync() {
 					regions[r]->get_polygons().data() + regions[r]->get_polygons().size(),
 					polygons.begin() + count);
 
+			region_polygons_offset.set(regions[r], count);
 			count += regions[r]->get_polygons().size();
 		}
 
+		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+			polygons[poly_id].id = poly_id;
+		}
+
+		// Linking only touches the edges, so the index can be built right away.
+		polygons_bvh.build(polygons);
+
 		// Connects the `Edges` of all the `Polygons` of all `Regions` each other.
 		Map<gd::EdgeKey, gd::Connection> connections;
 
@@ -707,36 +904,266 @@ void NavMap::sync() {
 	}
 
 	if (regenerate_links) {
+		build_clusters();
+
+		// Drop the cached routes crossing the changed regions, and their
+		// neighbours which may have got new links.
+		std::vector<const NavRegion *> invalid_regions = changed_regions;
+		for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+			const gd::Polygon &poly = polygons[poly_id];
+			if (std::find(changed_regions.begin(), changed_regions.end(), poly.owner) == changed_regions.end()) {
+				continue;
+			}
+			for (size_t e(0); e < poly.edges.size(); e++) {
+				const gd::Polygon *other = poly.edges[e].other_polygon;
+				if (other && std::find(invalid_regions.begin(), invalid_regions.end(), other->owner) == invalid_regions.end()) {
+					invalid_regions.push_back(other->owner);
+				}
+			}
+		}
+		for (size_t r(0); r < invalid_regions.size(); r++) {
+			path_cache.invalidate_region(invalid_regions[r]);
+		}
+
 		map_update_id = map_update_id + 1 % 9999999;
 	}
+	changed_regions.clear();
 
 	if (agents_dirty) {
-		std::vector<RVO::Agent *> raw_agents;
-		raw_agents.reserve(agents.size());
+		// The hash refers to the agents by index.
+		agents_state.resize(agents.size());
+		agents_hash.reset(agents.size());
+	}
+
+	if (agents_dirty || controlled_agents_dirty) {
+		std::vector<std::pair<RvoAgent *, uint32_t>> agents_ids;
+		agents_ids.reserve(agents.size());
 		for (size_t i(0); i < agents.size(); i++) {
-			raw_agents.push_back(agents[i]->get_agent());
+			agents_ids.push_back(std::make_pair(agents[i], i));
+		}
+		std::sort(agents_ids.begin(), agents_ids.end());
+
+		controlled_agents_ids.resize(controlled_agents.size());
+		for (size_t i(0); i < controlled_agents.size(); i++) {
+			auto it = std::lower_bound(agents_ids.begin(), agents_ids.end(), std::make_pair(controlled_agents[i], uint32_t(0)));
+			controlled_agents_ids[i] = it->second;
 		}
-		rvo.buildAgentTree(raw_agents);
 	}
 
 	regenerate_polygons = false;
 	regenerate_links = false;
 	agents_dirty = false;
+	controlled_agents_dirty = false;
 }
 
-void NavMap::compute_single_step(uint32_t index, RvoAgent **agent) {
-	(*(agent + index))->get_agent()->computeNeighbors(&rvo);
-	(*(agent + index))->get_agent()->computeNewVelocity(deltatime);
+void NavMap::build_clusters() {
+	clusters.clear();
+	portals.clear();
+
+	// Split the regions in their connected parts.
+	for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+		polygons[poly_id].cluster_id = UINT32_MAX;
+	}
+
+	std::vector<uint32_t> stack;
+	for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+		if (polygons[poly_id].cluster_id != UINT32_MAX) {
+			continue;
+		}
+
+		const uint32_t cluster_id = clusters.size();
+		clusters.push_back(gd::Cluster());
+		gd::Cluster &cluster = clusters[cluster_id];
+		cluster.region = polygons[poly_id].owner;
+
+		polygons[poly_id].cluster_id = cluster_id;
+		stack.push_back(poly_id);
+		while (stack.size()) {
+			const gd::Polygon &poly = polygons[stack.back()];
+			stack.pop_back();
+			cluster.polygons.push_back(poly.id);
+
+			for (size_t e(0); e < poly.edges.size(); e++) {
+				gd::Polygon *other = poly.edges[e].other_polygon;
+				if (other && other->owner == cluster.region && other->cluster_id == UINT32_MAX) {
+					other->cluster_id = cluster_id;
+					stack.push_back(other->id);
+				}
+			}
+		}
+	}
+
+	// Merge the crossings between two clusters in a single portal, and keep
+	// track of the polygons touching it on both sides.
+	Map<uint64_t, uint32_t> portal_ids;
+	std::vector<uint32_t> portal_crossings;
+	std::vector<std::vector<uint32_t>> portal_polygons;
+
+	for (size_t poly_id(0); poly_id < polygons.size(); poly_id++) {
+		const gd::Polygon &poly = polygons[poly_id];
+
+		for (size_t e(0); e < poly.edges.size(); e++) {
+			const gd::Polygon *other = poly.edges[e].other_polygon;
+			if (!other || other->cluster_id == poly.cluster_id) {
+				continue;
+			}
+
+			const uint32_t cluster_a = MIN(poly.cluster_id, other->cluster_id);
+			const uint32_t cluster_b = MAX(poly.cluster_id, other->cluster_id);
+			const uint64_t key = (uint64_t(cluster_a) << 32) | cluster_b;
+
+			Map<uint64_t, uint32_t>::Element *portal_element = portal_ids.find(key);
+			if (!portal_element) {
+				const uint32_t portal_id = portals.size();
+				portals.push_back(gd::Portal());
+				gd::Portal &portal = portals[portal_id];
+				portal.clusters[0] = cluster_a;
+				portal.clusters[1] = cluster_b;
+				for (int side = 0; side < 2; side++) {
+					portal.cluster_portals[side] = clusters[portal.clusters[side]].portals.size();
+					clusters[portal.clusters[side]].portals.push_back(portal_id);
+				}
+
+				portal_crossings.push_back(0);
+				portal_polygons.resize(portal_polygons.size() + 2);
+				portal_element = portal_ids.insert(key, portal_id);
+			}
+
+			const uint32_t portal_id = portal_element->get();
+			const Vector3 &edge_a = poly.points[e].pos;
+			const Vector3 &edge_b = poly.points[(e + 1) % poly.points.size()].pos;
+			portals[portal_id].position += (edge_a + edge_b) * 0.5;
+			portal_crossings[portal_id] += 1;
+			portal_polygons[portal_id * 2 + (poly.cluster_id == cluster_a ? 0 : 1)].push_back(poly.id);
+		}
+	}
+
+	for (size_t portal_id(0); portal_id < portals.size(); portal_id++) {
+		portals[portal_id].position /= portal_crossings[portal_id];
+	}
+
+	// Find the distances across each cluster between its portals, with a
+	// Dijkstra from each portal through the polygon centers.
+	std::vector<float> distances(polygons.size(), Math_INF);
+	std::vector<NavMapOpenEntry> open_list;
+
+	for (size_t cluster_id(0); cluster_id < clusters.size(); cluster_id++) {
+		gd::Cluster &cluster = clusters[cluster_id];
+		const uint32_t portal_count = cluster.portals.size();
+		cluster.portal_distances.resize(portal_count * portal_count, 0.0);
+
+		for (uint32_t i = 0; i < portal_count; i++) {
+			const gd::Portal &portal = portals[cluster.portals[i]];
+			const std::vector<uint32_t> &seeds = portal_polygons[cluster.portals[i] * 2 + (portal.clusters[0] == cluster_id ? 0 : 1)];
+			for (size_t s(0); s < seeds.size(); s++) {
+				const float distance = portal.position.distance_to(polygons[seeds[s]].center);
+				if (distance < distances[seeds[s]]) {
+					distances[seeds[s]] = distance;
+					open_list_push(open_list, distance, distance, seeds[s]);
+				}
+			}
+
+			while (open_list.size()) {
+				const NavMapOpenEntry current = open_list_pop(open_list);
+				if (current.distance > distances[current.id]) {
+					// Outdated entry.
+					continue;
+				}
+
+				const gd::Polygon &poly = polygons[current.id];
+				for (size_t e(0); e < poly.edges.size(); e++) {
+					const gd::Polygon *other = poly.edges[e].other_polygon;
+					if (!other || other->cluster_id != cluster_id) {
+						continue;
+					}
+					const float distance = current.distance + poly.center.distance_to(other->center);
+					if (distance < distances[other->id]) {
+						distances[other->id] = distance;
+						open_list_push(open_list, distance, distance, other->id);
+					}
+				}
+			}
+
+			for (uint32_t j = 0; j < portal_count; j++) {
+				const gd::Portal &other_portal = portals[cluster.portals[j]];
+				const std::vector<uint32_t> &exits = portal_polygons[cluster.portals[j] * 2 + (other_portal.clusters[0] == cluster_id ? 0 : 1)];
+				float distance = i == j ? 0.0 : Math_INF;
+				for (size_t x(0); x < exits.size(); x++) {
+					distance = MIN(distance, distances[exits[x]] + polygons[exits[x]].center.distance_to(other_portal.position));
+				}
+				cluster.portal_distances[i * portal_count + j] = distance;
+			}
+
+			for (size_t p(0); p < cluster.polygons.size(); p++) {
+				distances[cluster.polygons[p]] = Math_INF;
+			}
+		}
+	}
 }
 
-void NavMap::step(real_t p_deltatime) {
+void NavMap::compute_single_step(uint32_t p_index, void *p_userdata) {
+	// Only this agent state is written, the others are just read, so the
+	// result doesn't depend on the order the agents are processed in.
+	RVO::Agent &agent = agents_state[controlled_agents_ids[p_index]];
+
+	agent.agentNeighbors_.clear();
+	if (agent.maxNeighbors_ > 0) {
+		real_t range_sq = agent.neighborDist_ * agent.neighborDist_;
+		auto insert_neighbor = [&](uint32_t p_other) {
+			float agent_range_sq = range_sq;
+			agent.insertAgentNeighbor(&agents_state[p_other], agent_range_sq);
+			range_sq = agent_range_sq;
+		};
+		const Vector3 position(agent.position_.x(), agent.position_.y(), agent.position_.z());
+		agents_hash.query(position, range_sq, insert_neighbor);
+	}
+
+	agent.computeNewVelocity(deltatime);
+	controlled_agents[p_index]->get_agent()->newVelocity_ = agent.newVelocity_;
+}
+
+void NavMap::step(real_t p_deltatime, ThreadWorkPool &p_work_pool) {
 	deltatime = p_deltatime;
-	if (controlled_agents.size() > 0) {
-		thread_process_array(
-				controlled_agents.size(),
-				this,
-				&NavMap::compute_single_step,
-				controlled_agents.data());
+	if (controlled_agents.size() == 0) {
+		return;
+	}
+
+	// The server writes the agents parameters directly into the `RvoAgent`.
+	float max_neighbor_dist = 0.0;
+	for (size_t i(0); i < agents.size(); i++) {
+		const RVO::Agent *source = agents[i]->get_agent();
+		RVO::Agent &state = agents_state[i];
+		state.position_ = source->position_;
+		state.prefVelocity_ = source->prefVelocity_;
+		state.velocity_ = source->velocity_;
+		state.maxNeighbors_ = source->maxNeighbors_;
+		state.maxSpeed_ = source->maxSpeed_;
+		state.neighborDist_ = source->neighborDist_;
+		state.radius_ = source->radius_;
+		state.timeHorizon_ = source->timeHorizon_;
+		state.ignore_y_ = source->ignore_y_;
+		max_neighbor_dist = MAX(max_neighbor_dist, state.neighborDist_);
+	}
+
+	// With cells twice as big as the widest neighbor search, each search
+	// visits at most 2x2x2 cells. Smaller cells hold fewer agents, but the
+	// searches look up many more of them.
+	const real_t hash_cell_size = max_neighbor_dist * 2.0;
+	if (hash_cell_size > 0.0 && (hash_cell_size > agents_hash.get_cell_size() || hash_cell_size < agents_hash.get_cell_size() * 0.5)) {
+		agents_hash.set_cell_size(hash_cell_size);
+	}
+
+	for (size_t i(0); i < agents.size(); i++) {
+		const RVO::Vector3 &position = agents_state[i].position_;
+		agents_hash.update(i, Vector3(position.x(), position.y(), position.z()));
+	}
+
+	if (controlled_agents.size() >= AGENTS_PARALLEL_MIN && p_work_pool.get_thread_count() > 1) {
+		p_work_pool.do_work(controlled_agents.size(), this, &NavMap::compute_single_step, (void *)nullptr);
+	} else {
+		for (size_t i(0); i < controlled_agents.size(); i++) {
+			compute_single_step(i, nullptr);
+		}
 	}
 }
 
@@ -34,8 +34,12 @@
 #include "nav_rid.h"
 
 #include "core/math/math_defs.h"
+#include "core/templates/thread_work_pool.h"
+#include "nav_agent_hash.h"
+#include "nav_bvh.h"
+#include "nav_path_cache.h"
 #include "nav_utils.h"
-#include <KdTree.h>
+#include <Agent.h>
 
 /**
 	@author AndreaCatania
@@ -64,18 +68,46 @@ class NavMap : public NavRid {
 	/// Map polygons
 	std::vector<gd::Polygon> polygons;
 
-	/// Rvo world
-	RVO::KdTree rvo;
+	/// Spatial index of `polygons`, rebuilt with the links.
+	NavBVH polygons_bvh;
+
+	/// The first polygon of each region in `polygons`.
+	HashMap<const NavRegion *, uint32_t, NavPathCache::RegionHasher> region_polygons_offset;
+
+	/// Hierarchical path finding graph, rebuilt with the links: the
+	/// connected parts of the regions, and the portals between them.
+	std::vector<gd::Cluster> clusters;
+	std::vector<gd::Portal> portals;
+
+	/// Regions added or changed since the last sync.
+	std::vector<const NavRegion *> changed_regions;
+
+	/// Recently found polygon corridors.
+	mutable NavPathCache path_cache;
 
 	/// Is agent array modified?
 	bool agents_dirty = false;
 
+	/// Is controlled agent array modified?
+	bool controlled_agents_dirty = false;
+
 	/// All the Agents (even the controlled one)
 	std::vector<RvoAgent *> agents;
 
 	/// Controlled agents
 	std::vector<RvoAgent *> controlled_agents;
 
+	/// Index in `agents` of each controlled agent.
+	std::vector<uint32_t> controlled_agents_ids;
+
+	/// Avoidance state of `agents`, copied each step into this contiguous
+	/// array: the neighbors searches and the velocity computations only
+	/// touch it.
+	std::vector<RVO::Agent> agents_state;
+
+	/// Spatial index of `agents_state`.
+	NavAgentHash agents_hash;
+
 	/// Physics delta time
 	real_t deltatime = 0.0;
 
@@ -103,6 +135,9 @@ public:
 	gd::PointKey get_point_key(const Vector3 &p_pos) const;
 
 	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize) const;
+	/// Solves `p_count` path queries, on `p_work_pool` when there are enough
+	/// of them. The path `i` goes from `p_origins[i]` to `p_destinations[i]`.
+	void get_paths(const Vector3 *p_origins, const Vector3 *p_destinations, uint32_t p_count, bool p_optimize, Vector<Vector3> *r_paths, ThreadWorkPool &p_work_pool) const;
 	Vector3 get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const;
 	Vector3 get_closest_point(const Vector3 &p_point) const;
 	Vector3 get_closest_point_normal(const Vector3 &p_point) const;
@@ -128,12 +163,28 @@ public:
 		return map_update_id;
 	}
 
+	/// Number of polygon corridors in the path cache.
+	uint32_t get_cached_route_count() const {
+		return path_cache.get_size();
+	}
+
 	void sync();
-	void step(real_t p_deltatime);
+	/// Computes the controlled agents velocities, on `p_work_pool` when
+	/// there are enough of them.
+	void step(real_t p_deltatime, ThreadWorkPool &p_work_pool);
 	void dispatch_callbacks();
 
 private:
-	void compute_single_step(uint32_t index, RvoAgent **agent);
+	void build_clusters();
+	const gd::Polygon *get_polygon(const NavPathCache::PolygonKey &p_key) const;
+
+	bool find_cluster_route(const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, const gd::Polygon *p_end_poly, const Vector3 &p_end_point, std::vector<uint8_t> &r_route_clusters) const;
+	bool find_polygon_route(const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, const gd::Polygon *&r_end_poly, Vector3 &r_end_point, const Vector3 &p_destination, const uint8_t *p_route_clusters, std::vector<gd::NavigationPoly> &r_navigation_polys, int &r_least_cost_id) const;
+	bool load_cached_route(const NavPathCache::Key &p_key, const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, std::vector<gd::NavigationPoly> &r_navigation_polys) const;
+	void store_cached_route(const NavPathCache::Key &p_key, const std::vector<gd::NavigationPoly> &p_navigation_polys, int p_least_cost_id) const;
+	Vector<Vector3> build_path(std::vector<gd::NavigationPoly> &navigation_polys, int least_cost_id, const gd::Polygon *begin_poly, const Vector3 &begin_point, const Vector3 &end_point, bool p_optimize) const;
+
+	void compute_single_step(uint32_t p_index, void *p_userdata);
 	void clip_path(const std::vector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly) const;
 };
 
@@ -0,0 +1,145 @@
+/*************************************************************************/
+/*  nav_path_cache.cpp                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_path_cache.h"
+
+void NavPathCache::_unlink(uint32_t p_entry) {
+	Entry &e = entries[p_entry];
+	if (e.prev != INVALID_ENTRY) {
+		entries[e.prev].next = e.next;
+	} else {
+		first = e.next;
+	}
+	if (e.next != INVALID_ENTRY) {
+		entries[e.next].prev = e.prev;
+	} else {
+		last = e.prev;
+	}
+	e.prev = INVALID_ENTRY;
+	e.next = INVALID_ENTRY;
+}
+
+void NavPathCache::_link_first(uint32_t p_entry) {
+	Entry &e = entries[p_entry];
+	e.prev = INVALID_ENTRY;
+	e.next = first;
+	if (first != INVALID_ENTRY) {
+		entries[first].prev = p_entry;
+	} else {
+		last = p_entry;
+	}
+	first = p_entry;
+}
+
+void NavPathCache::_remove(uint32_t p_entry) {
+	_unlink(p_entry);
+	lookup.erase(entries[p_entry].key);
+	entries[p_entry].corridor.clear();
+	free_entries.push_back(p_entry);
+}
+
+bool NavPathCache::get(const Key &p_key, std::vector<Step> &r_corridor) {
+	MutexLock lock(mutex);
+
+	const uint32_t *entry = lookup.getptr(p_key);
+	if (!entry) {
+		return false;
+	}
+
+	if (*entry != first) {
+		_unlink(*entry);
+		_link_first(*entry);
+	}
+	r_corridor = entries[*entry].corridor;
+	return true;
+}
+
+void NavPathCache::put(const Key &p_key, const std::vector<Step> &p_corridor) {
+	MutexLock lock(mutex);
+
+	uint32_t entry;
+	const uint32_t *existing = lookup.getptr(p_key);
+	if (existing) {
+		// Another thread solved the same query meanwhile.
+		entry = *existing;
+		_unlink(entry);
+	} else {
+		if (lookup.size() >= CAPACITY) {
+			_remove(last);
+		}
+
+		if (free_entries.size()) {
+			entry = free_entries.back();
+			free_entries.pop_back();
+		} else {
+			entry = entries.size();
+			entries.push_back(Entry());
+		}
+		entries[entry].key = p_key;
+		lookup.set(p_key, entry);
+	}
+
+	entries[entry].corridor = p_corridor;
+	_link_first(entry);
+}
+
+void NavPathCache::invalidate_region(const NavRegion *p_region) {
+	MutexLock lock(mutex);
+
+	uint32_t entry = first;
+	while (entry != INVALID_ENTRY) {
+		const uint32_t next = entries[entry].next;
+
+		const std::vector<Step> &corridor = entries[entry].corridor;
+		for (size_t i(0); i < corridor.size(); i++) {
+			if (corridor[i].polygon.region == p_region) {
+				_remove(entry);
+				break;
+			}
+		}
+
+		entry = next;
+	}
+}
+
+void NavPathCache::clear() {
+	MutexLock lock(mutex);
+
+	entries.clear();
+	free_entries.clear();
+	lookup.clear();
+	first = INVALID_ENTRY;
+	last = INVALID_ENTRY;
+}
+
+uint32_t NavPathCache::get_size() const {
+	MutexLock lock(mutex);
+	return lookup.size();
+}
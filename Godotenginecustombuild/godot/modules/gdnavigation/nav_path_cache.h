@@ -0,0 +1,133 @@
+/*************************************************************************/
+/*  nav_path_cache.h                                                     */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef NAV_PATH_CACHE_H
+#define NAV_PATH_CACHE_H
+
+#include "core/os/mutex.h"
+#include "core/templates/hash_map.h"
+
+#include <vector>
+
+class NavRegion;
+
+/// Least recently used cache of the polygon corridors found by the path
+/// finding, so the agents going between the same polygons share the search.
+///
+/// The map reallocates its polygons at each update, so they are identified by
+/// their region and their index in that region. The map invalidates the
+/// corridors crossing the regions that changed.
+///
+/// All the functions are thread safe.
+class NavPathCache {
+public:
+	struct PolygonKey {
+		const NavRegion *region = nullptr;
+		uint32_t id = 0;
+
+		bool operator==(const PolygonKey &p_key) const {
+			return region == p_key.region && id == p_key.id;
+		}
+	};
+
+	struct Key {
+		PolygonKey begin;
+		PolygonKey end;
+
+		bool operator==(const Key &p_key) const {
+			return begin == p_key.begin && end == p_key.end;
+		}
+	};
+
+	struct RegionHasher {
+		static _FORCE_INLINE_ uint32_t hash(const NavRegion *p_region) {
+			return hash_one_uint64((uint64_t)p_region);
+		}
+	};
+
+	struct KeyHasher {
+		static _FORCE_INLINE_ uint32_t hash(const Key &p_key) {
+			uint64_t h = hash_djb2_one_64((uint64_t)p_key.begin.region);
+			h = hash_djb2_one_64(p_key.begin.id, h);
+			h = hash_djb2_one_64((uint64_t)p_key.end.region, h);
+			h = hash_djb2_one_64(p_key.end.id, h);
+			return hash_one_uint64(h);
+		}
+	};
+
+	/// A polygon of the corridor, entered through its `back_edge`.
+	struct Step {
+		PolygonKey polygon;
+		uint32_t back_edge = 0;
+	};
+
+	enum {
+		CAPACITY = 256,
+	};
+
+private:
+	static const uint32_t INVALID_ENTRY = UINT32_MAX;
+
+	struct Entry {
+		Key key;
+		std::vector<Step> corridor;
+		/// Neighbours in the recently used list.
+		uint32_t prev = INVALID_ENTRY;
+		uint32_t next = INVALID_ENTRY;
+	};
+
+	BinaryMutex mutex;
+
+	std::vector<Entry> entries;
+	std::vector<uint32_t> free_entries;
+	HashMap<Key, uint32_t, KeyHasher> lookup;
+
+	/// Most recently used entry.
+	uint32_t first = INVALID_ENTRY;
+	/// Least recently used entry, the next one to be evicted.
+	uint32_t last = INVALID_ENTRY;
+
+	void _unlink(uint32_t p_entry);
+	void _link_first(uint32_t p_entry);
+	void _remove(uint32_t p_entry);
+
+public:
+	/// Copies the corridor cached for this key, if any.
+	bool get(const Key &p_key, std::vector<Step> &r_corridor);
+	void put(const Key &p_key, const std::vector<Step> &p_corridor);
+
+	/// Drops all the corridors going through this region.
+	void invalidate_region(const NavRegion *p_region);
+	void clear();
+
+	uint32_t get_size() const;
+};
+
+#endif // NAV_PATH_CACHE_H
@@ -88,6 +88,7 @@ void NavRegion::update_polygons() {
 	for (size_t i(0); i < polygons.size(); i++) {
 		gd::Polygon &p = polygons[i];
 		p.owner = this;
+		p.region_polygon_id = i;
 
 		Vector<int> mesh_poly = mesh->get_polygon(i);
 		const int *indices = mesh_poly.ptr();
@@ -104,6 +104,42 @@ struct Polygon {
 
 	/// The center of this `Polygon`
 	Vector3 center;
+
+	/// Index of this `Polygon` in its owner region.
+	uint32_t region_polygon_id = 0;
+
+	/// Index of this `Polygon` in the map.
+	uint32_t id = 0;
+
+	/// The `Cluster` of the map holding this `Polygon`.
+	uint32_t cluster_id = 0;
+};
+
+/// A connected part of a region, used by the hierarchical path finding.
+struct Cluster {
+	NavRegion *region = nullptr;
+
+	/// The map ids of the `Polygon`s in this cluster.
+	std::vector<uint32_t> polygons;
+
+	/// The `Portal`s leading out of this cluster.
+	std::vector<uint32_t> portals;
+
+	/// The distance to travel across this cluster from its portal `i` to its
+	/// portal `j`, at `i * portals.size() + j`.
+	std::vector<float> portal_distances;
+};
+
+/// All the crossings between two clusters, merged into a single node of the
+/// hierarchical graph.
+struct Portal {
+	uint32_t clusters[2] = { 0, 0 };
+
+	/// Index of this portal in the `portals` of each cluster.
+	uint32_t cluster_portals[2] = { 0, 0 };
+
+	/// The average of the crossed edges centers.
+	Vector3 position;
 };
 
 struct Connection {
@@ -127,6 +163,8 @@ struct NavigationPoly {
 	Vector3 entry;
 	/// The distance to the destination.
 	float traveled_distance = 0.0;
+	/// Was this poly already taken from the open list?
+	bool closed = false;
 
 	NavigationPoly(const Polygon *p_poly) :
 			poly(p_poly) {}
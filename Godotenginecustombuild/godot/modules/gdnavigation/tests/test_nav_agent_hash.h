@@ -0,0 +1,188 @@
+/*************************************************************************/
+/*  test_nav_agent_hash.h                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_NAV_AGENT_HASH_H
+#define TEST_NAV_AGENT_HASH_H
+
+#include "core/math/random_pcg.h"
+#include "modules/gdnavigation/nav_agent_hash.h"
+#include "modules/gdnavigation/nav_map.h"
+#include "modules/gdnavigation/rvo_agent.h"
+
+#include "tests/test_macros.h"
+
+#include <algorithm>
+
+namespace TestNavAgentHash {
+
+static Vector3 random_offset(RandomPCG &p_rng, real_t p_extent) {
+	return Vector3(p_rng.random(-p_extent, p_extent), p_rng.random(-p_extent, p_extent), p_rng.random(-p_extent, p_extent));
+}
+
+struct NeighborCollector {
+	std::vector<uint32_t> agents;
+
+	void operator()(uint32_t p_agent) {
+		agents.push_back(p_agent);
+	}
+};
+
+static void check_neighbors(const NavAgentHash &p_hash, const std::vector<Vector3> &p_positions, const Vector3 &p_point, real_t p_range) {
+	NeighborCollector collector;
+	real_t range_sq = p_range * p_range;
+	p_hash.query(p_point, range_sq, collector);
+	std::sort(collector.agents.begin(), collector.agents.end());
+
+	std::vector<uint32_t> expected;
+	for (size_t i = 0; i < p_positions.size(); i++) {
+		if (p_point.distance_squared_to(p_positions[i]) < p_range * p_range) {
+			expected.push_back(i);
+		}
+	}
+
+	// Sorted, so an agent visited twice shows up too.
+	CHECK(collector.agents == expected);
+}
+
+TEST_CASE("[NavAgentHash] Neighbors match a brute force search while the agents move") {
+	const uint32_t agent_count = 200;
+	const real_t cell_size = 2.0;
+	RandomPCG rng(1234);
+
+	NavAgentHash hash;
+	hash.set_cell_size(cell_size);
+	hash.reset(agent_count);
+
+	std::vector<Vector3> positions(agent_count);
+	for (uint32_t i = 0; i < agent_count; i++) {
+		positions[i] = random_offset(rng, 10.0);
+		CHECK_MESSAGE(hash.update(i, positions[i]), "Inserting an agent should put it in a cell.");
+	}
+
+	uint32_t cell_changes = 0;
+	for (int step = 0; step < 10; step++) {
+		for (uint32_t i = 0; i < agent_count; i++) {
+			const Vector3 position = positions[i] + random_offset(rng, 1.5);
+			const Vector3 cell = (positions[i] / cell_size).floor();
+			const bool crossed = (position / cell_size).floor() != cell;
+
+			CHECK(hash.update(i, position) == crossed);
+			cell_changes += crossed;
+			positions[i] = position;
+		}
+
+		for (int query = 0; query < 50; query++) {
+			check_neighbors(hash, positions, random_offset(rng, 12.0), rng.random(0.5f, 5.0f));
+		}
+		// Around an agent, so the range covers at least its own cell.
+		check_neighbors(hash, positions, positions[step], cell_size);
+	}
+
+	CHECK_MESSAGE(cell_changes > 0, "Some agents should have crossed a cell border.");
+
+	// Changing the cell size empties the hash.
+	hash.set_cell_size(cell_size * 2.0);
+	for (uint32_t i = 0; i < agent_count; i++) {
+		CHECK(hash.update(i, positions[i]));
+	}
+	for (int query = 0; query < 50; query++) {
+		check_neighbors(hash, positions, random_offset(rng, 12.0), rng.random(0.5f, 5.0f));
+	}
+}
+
+// Steps a crowd of agents walking across each other, and returns their
+// velocities after each step.
+static std::vector<Vector3> step_crowd(uint32_t p_thread_count) {
+	// Enough controlled agents to step them on the work pool.
+	const uint32_t agent_count = 100;
+	const real_t delta = 0.1;
+	RandomPCG rng(4321);
+
+	NavMap map;
+	std::vector<RvoAgent *> agents;
+	for (uint32_t i = 0; i < agent_count; i++) {
+		RvoAgent *agent = memnew(RvoAgent);
+		RVO::Agent *state = agent->get_agent();
+		const Vector3 position = random_offset(rng, 10.0) * Vector3(1, 0, 1);
+		state->position_ = RVO::Vector3(position.x, position.y, position.z);
+		state->prefVelocity_ = RVO::Vector3(-position.x * 0.2, 0, -position.z * 0.2);
+		state->velocity_ = state->prefVelocity_;
+		state->maxNeighbors_ = 10;
+		state->maxSpeed_ = 2.0;
+		state->neighborDist_ = 3.0;
+		state->radius_ = 0.5;
+		state->timeHorizon_ = 1.0;
+		state->ignore_y_ = true;
+
+		agent->set_map(&map);
+		map.add_agent(agent);
+		map.set_agent_as_controlled(agent);
+		agents.push_back(agent);
+	}
+
+	ThreadWorkPool work_pool;
+	work_pool.init(p_thread_count);
+
+	std::vector<Vector3> velocities;
+	for (int step = 0; step < 20; step++) {
+		map.sync();
+		map.step(delta, work_pool);
+
+		for (uint32_t i = 0; i < agent_count; i++) {
+			RVO::Agent *state = agents[i]->get_agent();
+			state->velocity_ = state->newVelocity_;
+			state->position_ = state->position_ + state->newVelocity_ * delta;
+			velocities.push_back(Vector3(state->newVelocity_.x(), state->newVelocity_.y(), state->newVelocity_.z()));
+		}
+	}
+
+	work_pool.finish();
+
+	for (uint32_t i = 0; i < agent_count; i++) {
+		map.remove_agent(agents[i]);
+		memdelete(agents[i]);
+	}
+
+	return velocities;
+}
+
+TEST_CASE("[NavMap] Agent velocities don't depend on the thread count") {
+	const std::vector<Vector3> serial_velocities = step_crowd(1);
+	const std::vector<Vector3> parallel_velocities = step_crowd(4);
+
+	REQUIRE(serial_velocities.size() == parallel_velocities.size());
+	for (size_t i = 0; i < serial_velocities.size(); i++) {
+		CHECK(serial_velocities[i] == parallel_velocities[i]);
+	}
+}
+
+} // namespace TestNavAgentHash
+
+#endif // TEST_NAV_AGENT_HASH_H
@@ -0,0 +1,437 @@
+/*************************************************************************/
+/*  test_nav_map.h                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_NAV_MAP_H
+#define TEST_NAV_MAP_H
+
+#include "core/math/face3.h"
+#include "core/math/geometry_3d.h"
+#include "core/math/random_pcg.h"
+#include "core/templates/rid_owner.h"
+#include "modules/gdnavigation/nav_map.h"
+#include "modules/gdnavigation/nav_region.h"
+
+#include "tests/test_macros.h"
+
+namespace TestNavMap {
+
+static const real_t TILE_SIZE = 4.0;
+
+// Navigation mesh covering the given tiles, each tile split in two triangles.
+static Ref<NavigationMesh> make_tiles_mesh(const Vector<Vector2i> &p_tiles) {
+	Ref<NavigationMesh> mesh = memnew(NavigationMesh);
+	Vector<Vector3> vertices;
+
+	for (int i = 0; i < p_tiles.size(); i++) {
+		const real_t x = p_tiles[i].x * TILE_SIZE;
+		const real_t z = p_tiles[i].y * TILE_SIZE;
+		const int first = vertices.size();
+		vertices.push_back(Vector3(x, 0, z));
+		vertices.push_back(Vector3(x, 0, z + TILE_SIZE));
+		vertices.push_back(Vector3(x + TILE_SIZE, 0, z + TILE_SIZE));
+		vertices.push_back(Vector3(x + TILE_SIZE, 0, z));
+
+		Vector<int> triangle;
+		triangle.push_back(first);
+		triangle.push_back(first + 1);
+		triangle.push_back(first + 2);
+		mesh->add_polygon(triangle);
+		triangle.write[1] = first + 2;
+		triangle.write[2] = first + 3;
+		mesh->add_polygon(triangle);
+	}
+
+	mesh->set_vertices(vertices);
+	return mesh;
+}
+
+// Ring of tiles around a 3x2 tiles hole, the lower side is the short way
+// between the lower corners:
+//
+//   z = 3  # # # # #
+//          #       #
+//          #       #
+//   z = 0  # # # # #
+static Vector<Vector2i> get_ring_tiles() {
+	Vector<Vector2i> tiles;
+	for (int x = 0; x < 5; x++) {
+		tiles.push_back(Vector2i(x, 0));
+		tiles.push_back(Vector2i(x, 3));
+	}
+	for (int z = 1; z < 3; z++) {
+		tiles.push_back(Vector2i(0, z));
+		tiles.push_back(Vector2i(4, z));
+	}
+	return tiles;
+}
+
+static real_t get_path_length(const Vector<Vector3> &p_path) {
+	real_t length = 0;
+	for (int i = 1; i < p_path.size(); i++) {
+		length += p_path[i - 1].distance_to(p_path[i]);
+	}
+	return length;
+}
+
+class TestNavigationMap {
+	Vector<Vector2i> tiles;
+	std::vector<NavRegion *> regions;
+	RID_PtrOwner<NavRegion> region_owner;
+
+public:
+	NavMap map;
+
+	TestNavigationMap() {
+		// Exact point keys for the tile corners, and no links between the
+		// edges facing each other across the hole.
+		map.set_cell_size(0.25);
+		map.set_edge_connection_margin(1.0);
+	}
+
+	// A region per tile, so a cluster per tile.
+	void add_tile_regions(const Vector<Vector2i> &p_tiles) {
+		for (int i = 0; i < p_tiles.size(); i++) {
+			Vector<Vector2i> tile;
+			tile.push_back(p_tiles[i]);
+			tiles.push_back(p_tiles[i]);
+			add_region(make_tiles_mesh(tile));
+		}
+	}
+
+	NavRegion *add_region(const Ref<NavigationMesh> &p_mesh) {
+		NavRegion *region = memnew(NavRegion);
+		region->set_self(region_owner.make_rid(region));
+		region->set_map(&map);
+		region->set_mesh(p_mesh);
+		map.add_region(region);
+		regions.push_back(region);
+		return region;
+	}
+
+	NavRegion *get_tile_region(const Vector2i &p_tile) const {
+		const int index = tiles.find(p_tile);
+		return index < 0 ? nullptr : regions[index];
+	}
+
+	~TestNavigationMap() {
+		for (size_t i = 0; i < regions.size(); i++) {
+			map.remove_region(regions[i]);
+			region_owner.free(regions[i]->get_self());
+			memdelete(regions[i]);
+		}
+	}
+};
+
+TEST_CASE("[NavMap] Clustered path search matches the whole map search") {
+	// A single region is a single cluster, so its search covers the whole map.
+	TestNavigationMap whole_map;
+	whole_map.add_region(make_tiles_mesh(get_ring_tiles()));
+	whole_map.map.sync();
+
+	TestNavigationMap tiled_map;
+	tiled_map.add_tile_regions(get_ring_tiles());
+	tiled_map.map.sync();
+
+	const Vector3 queries[][2] = {
+		{ Vector3(2, 0, 1), Vector3(18, 0, 1) },
+		{ Vector3(18, 0, 1), Vector3(2, 0, 1) },
+		{ Vector3(2, 0, 15), Vector3(18, 0, 15) },
+		{ Vector3(10, 0, 1), Vector3(19, 0, 10) },
+		{ Vector3(1, 0, 10), Vector3(10, 0, 15) },
+	};
+
+	for (int optimize = 0; optimize < 2; optimize++) {
+		for (int i = 0; i < 5; i++) {
+			const Vector<Vector3> whole_path = whole_map.map.get_path(queries[i][0], queries[i][1], optimize);
+			const Vector<Vector3> tiled_path = tiled_map.map.get_path(queries[i][0], queries[i][1], optimize);
+
+			REQUIRE(whole_path.size() >= 2);
+			REQUIRE(tiled_path.size() >= 2);
+			CHECK_MESSAGE(
+					tiled_path.size() == whole_path.size(),
+					"The clustered search should go through the same polygons.");
+			CHECK(Math::is_equal_approx(get_path_length(tiled_path), get_path_length(whole_path)));
+			CHECK(tiled_path[tiled_path.size() - 1].is_equal_approx(queries[i][1]));
+		}
+	}
+}
+
+TEST_CASE("[NavMap] Cached corridors are dropped when their regions or their neighbours change") {
+	TestNavigationMap tiled_map;
+	tiled_map.add_tile_regions(get_ring_tiles());
+	tiled_map.map.sync();
+	NavMap &map = tiled_map.map;
+
+	// Goes through the tiles (0, 0), (1, 0) and (2, 0).
+	const Vector3 from(2, 0, 1);
+	const Vector3 to(10, 0, 1);
+	const Vector<Vector3> path = map.get_path(from, to, true);
+	REQUIRE(path.size() >= 2);
+	CHECK(map.get_cached_route_count() == 1);
+	CHECK_MESSAGE(
+			map.get_path(from, to, true) == path,
+			"The cached corridor should give the same path.");
+	CHECK(map.get_cached_route_count() == 1);
+
+	// Neither on the corridor nor next to it.
+	NavRegion *far_region = tiled_map.get_tile_region(Vector2i(4, 3));
+	far_region->set_transform(far_region->get_transform());
+	map.sync();
+	CHECK_MESSAGE(
+			map.get_cached_route_count() == 1,
+			"A change away from the corridor should keep it.");
+
+	NavRegion *corridor_region = tiled_map.get_tile_region(Vector2i(1, 0));
+	corridor_region->set_transform(corridor_region->get_transform());
+	map.sync();
+	CHECK_MESSAGE(
+			map.get_cached_route_count() == 0,
+			"A change of a region of the corridor should drop it.");
+
+	CHECK(map.get_path(from, to, true) == path);
+	CHECK(map.get_cached_route_count() == 1);
+
+	// Linked to the last tile of the corridor.
+	NavRegion *neighbour_region = tiled_map.get_tile_region(Vector2i(3, 0));
+	neighbour_region->set_transform(neighbour_region->get_transform());
+	map.sync();
+	CHECK_MESSAGE(
+			map.get_cached_route_count() == 0,
+			"A change of a neighbour of the corridor should drop it.");
+}
+
+TEST_CASE("[NavMap] Unreachable destinations fall back to the nearest reachable point") {
+	TestNavigationMap tiled_map;
+	tiled_map.add_tile_regions(get_ring_tiles());
+
+	// Far from the ring, so nothing links it.
+	Vector<Vector2i> island;
+	island.push_back(Vector2i(25, 0));
+	tiled_map.add_region(make_tiles_mesh(island));
+	tiled_map.map.sync();
+	NavMap &map = tiled_map.map;
+
+	const Vector3 from(2, 0, 1);
+	const Vector3 to(102, 0, 1);
+	for (int optimize = 0; optimize < 2; optimize++) {
+		const Vector<Vector3> path = map.get_path(from, to, optimize);
+
+		REQUIRE(path.size() >= 2);
+		CHECK(path[0].is_equal_approx(from));
+		CHECK_MESSAGE(
+				Math::is_equal_approx(path[path.size() - 1].x, real_t(20)),
+				"The path should end on the ring side facing the destination.");
+	}
+
+	CHECK_MESSAGE(
+			map.get_cached_route_count() == 0,
+			"The corridor to a fallback point shouldn't be cached.");
+}
+
+// Square of 16x16 tiles with a few missing, in four regions at different heights.
+static void add_grid_regions(TestNavigationMap &r_map) {
+	for (int region = 0; region < 4; region++) {
+		Vector<Vector2i> tiles;
+		for (int x = 0; x < 8; x++) {
+			for (int z = 0; z < 8; z++) {
+				const Vector2i tile(x + (region % 2) * 8, z + (region / 2) * 8);
+				if ((tile.x * 7 + tile.y * 3) % 5 != 0) {
+					tiles.push_back(tile);
+				}
+			}
+		}
+		r_map.add_region(make_tiles_mesh(tiles))->set_transform(Transform(Basis(), Vector3(0, region * 0.5, 0)));
+	}
+	r_map.map.sync();
+}
+
+// The face closest to the point, searched through all the polygons like the
+// map did before indexing them.
+static const gd::Polygon *scan_closest_point(const NavMap &p_map, const Vector3 &p_point, Vector3 &r_point, Vector3 &r_normal) {
+	const gd::Polygon *closest = nullptr;
+	real_t closest_d = 1e20;
+
+	for (size_t r = 0; r < p_map.get_regions().size(); r++) {
+		const std::vector<gd::Polygon> &polygons = p_map.get_regions()[r]->get_polygons();
+		for (size_t i = 0; i < polygons.size(); i++) {
+			const gd::Polygon &p = polygons[i];
+			for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+				const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+				const Vector3 spoint = f.get_closest_point_to(p_point);
+				const real_t d = spoint.distance_to(p_point);
+				if (d < closest_d) {
+					closest = &p;
+					closest_d = d;
+					r_point = spoint;
+					r_normal = f.get_plane().normal;
+				}
+			}
+		}
+	}
+
+	return closest;
+}
+
+static Vector3 scan_closest_point_to_segment(const NavMap &p_map, const Vector3 &p_from, const Vector3 &p_to, bool p_use_collision) {
+	bool intersects = false;
+	Vector3 closest_point;
+	real_t closest_d = 1e20;
+
+	// The intersection closest to the segment start has the priority.
+	for (size_t r = 0; r < p_map.get_regions().size(); r++) {
+		const std::vector<gd::Polygon> &polygons = p_map.get_regions()[r]->get_polygons();
+		for (size_t i = 0; i < polygons.size(); i++) {
+			const gd::Polygon &p = polygons[i];
+			for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
+				const Face3 f(p.points[point_id - 2].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+				Vector3 inters;
+				if (f.intersects_segment(p_from, p_to, &inters) && p_from.distance_to(inters) < closest_d) {
+					intersects = true;
+					closest_point = inters;
+					closest_d = p_from.distance_to(inters);
+				}
+			}
+		}
+	}
+
+	if (intersects || p_use_collision) {
+		return closest_point;
+	}
+
+	for (size_t r = 0; r < p_map.get_regions().size(); r++) {
+		const std::vector<gd::Polygon> &polygons = p_map.get_regions()[r]->get_polygons();
+		for (size_t i = 0; i < polygons.size(); i++) {
+			const gd::Polygon &p = polygons[i];
+			for (size_t point_id = 0; point_id < p.points.size(); point_id++) {
+				Vector3 a, b;
+				Geometry3D::get_closest_points_between_segments(
+						p_from,
+						p_to,
+						p.points[point_id].pos,
+						p.points[(point_id + 1) % p.points.size()].pos,
+						a,
+						b);
+
+				if (a.distance_to(b) < closest_d) {
+					closest_point = b;
+					closest_d = a.distance_to(b);
+				}
+			}
+		}
+	}
+
+	return closest_point;
+}
+
+static Vector3 random_point(RandomPCG &p_rng) {
+	return Vector3(p_rng.random(-4.0f, 68.0f), p_rng.random(-2.0f, 4.0f), p_rng.random(-4.0f, 68.0f));
+}
+
+TEST_CASE("[NavMap] Closest point queries match a scan of all the polygons") {
+	TestNavigationMap grid_map;
+	add_grid_regions(grid_map);
+	const NavMap &map = grid_map.map;
+	RandomPCG rng(1234);
+
+	for (int i = 0; i < 500; i++) {
+		const Vector3 point = random_point(rng);
+		Vector3 closest_point;
+		Vector3 closest_normal;
+		const gd::Polygon *closest = scan_closest_point(map, point, closest_point, closest_normal);
+		REQUIRE(closest != nullptr);
+
+		CHECK(map.get_closest_point(point).is_equal_approx(closest_point));
+		CHECK(map.get_closest_point_normal(point).is_equal_approx(closest_normal));
+		CHECK(map.get_closest_point_owner(point) == closest->owner->get_self());
+	}
+}
+
+TEST_CASE("[NavMap] Closest point to segment queries match a scan of all the polygons") {
+	TestNavigationMap grid_map;
+	add_grid_regions(grid_map);
+	const NavMap &map = grid_map.map;
+	RandomPCG rng(4321);
+
+	for (int i = 0; i < 500; i++) {
+		// Some segments cross the regions, others only pass by.
+		const Vector3 from = random_point(rng);
+		const Vector3 to = random_point(rng);
+
+		for (int use_collision = 0; use_collision < 2; use_collision++) {
+			CHECK(map.get_closest_point_to_segment(from, to, use_collision).is_equal_approx(scan_closest_point_to_segment(map, from, to, use_collision)));
+		}
+	}
+}
+
+TEST_CASE("[NavMap] Batched path queries match the single ones") {
+	const Vector<Vector2i> ring_tiles = get_ring_tiles();
+	TestNavigationMap single_map;
+	single_map.add_tile_regions(ring_tiles);
+	single_map.map.sync();
+
+	// Each query starts from its own polygon, so none of them share a cached corridor.
+	const uint32_t query_count = 20;
+	Vector3 origins[query_count];
+	Vector3 destinations[query_count];
+	for (uint32_t i = 0; i < query_count; i++) {
+		const Vector2i from_tile = ring_tiles[i % ring_tiles.size()];
+		const Vector2i to_tile = ring_tiles[(i * 5 + 3) % ring_tiles.size()];
+		const Vector3 from_offset = i < uint32_t(ring_tiles.size()) ? Vector3(3, 0, 1) : Vector3(1, 0, 3);
+		origins[i] = Vector3(from_tile.x, 0, from_tile.y) * TILE_SIZE + from_offset;
+		destinations[i] = Vector3(to_tile.x, 0, to_tile.y) * TILE_SIZE + Vector3(2, 0, 1);
+	}
+
+	ThreadWorkPool work_pool;
+	work_pool.init(4);
+
+	// Solved one by one, then on the work pool.
+	const uint32_t batch_sizes[] = { 4, query_count };
+	for (int b = 0; b < 2; b++) {
+		TestNavigationMap batch_map;
+		batch_map.add_tile_regions(ring_tiles);
+		batch_map.map.sync();
+
+		for (int optimize = 0; optimize < 2; optimize++) {
+			Vector<Vector3> paths[query_count];
+			batch_map.map.get_paths(origins, destinations, batch_sizes[b], optimize, paths, work_pool);
+
+			for (uint32_t i = 0; i < batch_sizes[b]; i++) {
+				CHECK(paths[i].size() >= 2);
+				CHECK(paths[i] == single_map.map.get_path(origins[i], destinations[i], optimize));
+			}
+		}
+	}
+
+	work_pool.finish();
+}
+
+} // namespace TestNavMap
+
+#endif // TEST_NAV_MAP_H
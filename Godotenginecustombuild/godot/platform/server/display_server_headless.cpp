@@ -0,0 +1,72 @@
+/*************************************************************************/
+/*  display_server_headless.cpp                                          */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "display_server_headless.h"
+
+#include "drivers/dummy/rasterizer_dummy.h"
+
+void DisplayServerHeadless::alert(const String &p_alert, const String &p_title) {
+	// There is nobody to click a dialog away, so just log it.
+	print_line(p_title + ": " + p_alert);
+}
+
+Vector<DisplayServer::WindowID> DisplayServerHeadless::get_window_list() const {
+	Vector<WindowID> windows;
+	windows.push_back(MAIN_WINDOW_ID);
+	return windows;
+}
+
+Vector<String> DisplayServerHeadless::get_rendering_drivers_func() {
+	Vector<String> drivers;
+	drivers.push_back("dummy");
+	return drivers;
+}
+
+DisplayServer *DisplayServerHeadless::create_func(const String &p_rendering_driver, WindowMode p_mode, uint32_t p_flags, const Vector2i &p_resolution, Error &r_error) {
+	r_error = OK;
+	return memnew(DisplayServerHeadless(p_resolution));
+}
+
+void DisplayServerHeadless::register_headless_driver() {
+	register_create_function("headless", create_func, get_rendering_drivers_func);
+}
+
+DisplayServerHeadless::DisplayServerHeadless(const Vector2i &p_resolution) {
+	window_size = p_resolution;
+	RasterizerDummy::make_current();
+
+	resource_loader_dummy.instance();
+	ResourceLoader::add_resource_format_loader(resource_loader_dummy);
+}
+
+DisplayServerHeadless::~DisplayServerHeadless() {
+	ResourceLoader::remove_resource_format_loader(resource_loader_dummy);
+	resource_loader_dummy.unref();
+}
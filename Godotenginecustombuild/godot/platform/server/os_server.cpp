@@ -30,117 +30,27 @@
 
 #include "os_server.h"
 
-#include "core/string/print_string.h"
-#include "drivers/dummy/rasterizer_dummy.h"
-#include "drivers/dummy/texture_loader_dummy.h"
-#include "servers/rendering/rendering_server_raster.h"
-
+#include "display_server_headless.h"
 #include "main/main.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
-int OS_Server::get_video_driver_count() const {
-	return 1;
-}
-
-const char *OS_Server::get_video_driver_name(int p_driver) const {
-	return "Dummy";
-}
-
-int OS_Server::get_audio_driver_count() const {
-	return 1;
-}
-
-const char *OS_Server::get_audio_driver_name(int p_driver) const {
-	return "Dummy";
-}
-
-int OS_Server::get_current_video_driver() const {
-	return video_driver_index;
-}
-
-void OS_Server::initialize_core() {
+void OS_Server::initialize() {
 	crash_handler.initialize();
 
 	OS_Unix::initialize_core();
 }
 
-Error OS_Server::initialize(const VideoMode &p_desired, int p_video_driver, int p_audio_driver) {
-	args = OS::get_singleton()->get_cmdline_args();
-	current_videomode = p_desired;
-	main_loop = nullptr;
-
-	RasterizerDummy::make_current();
-
-	video_driver_index = p_video_driver; // unused in server platform, but should still be initialized
-
-	rendering_server = memnew(RenderingServerRaster);
-	rendering_server->init();
-
-	AudioDriverManager::initialize(p_audio_driver);
-
-	input = memnew(InputDefault);
-
-	_ensure_user_data_dir();
-
-	resource_loader_dummy.instance();
-	ResourceLoader::add_resource_format_loader(resource_loader_dummy);
-
-	return OK;
+void OS_Server::initialize_joypads() {
 }
 
 void OS_Server::finalize() {
-	if (main_loop)
+	if (main_loop) {
 		memdelete(main_loop);
+	}
 	main_loop = nullptr;
-
-	rendering_server->finish();
-	memdelete(rendering_server);
-
-	memdelete(input);
-
-	ResourceLoader::remove_resource_format_loader(resource_loader_dummy);
-	resource_loader_dummy.unref();
-
-	args.clear();
-}
-
-void OS_Server::set_mouse_show(bool p_show) {
-}
-
-void OS_Server::set_mouse_grab(bool p_grab) {
-	grab = p_grab;
-}
-
-bool OS_Server::is_mouse_grab_enabled() const {
-	return grab;
-}
-
-int OS_Server::get_mouse_button_state() const {
-	return 0;
-}
-
-Point2 OS_Server::get_mouse_position() const {
-	return Point2();
-}
-
-void OS_Server::set_window_title(const String &p_title) {
-}
-
-void OS_Server::set_video_mode(const VideoMode &p_video_mode, int p_screen) {
-}
-
-OS::VideoMode OS_Server::get_video_mode(int p_screen) const {
-	return current_videomode;
-}
-
-Size2 OS_Server::get_window_size() const {
-	return Vector2(current_videomode.width, current_videomode.height);
-}
-
-void OS_Server::get_fullscreen_mode_list(List<VideoMode> *p_list, int p_screen) const {
 }
 
 MainLoop *OS_Server::get_main_loop() const {
@@ -155,20 +65,12 @@ void OS_Server::delete_main_loop() {
 
 void OS_Server::set_main_loop(MainLoop *p_main_loop) {
 	main_loop = p_main_loop;
-	input->set_main_loop(p_main_loop);
 }
 
-bool OS_Server::can_draw() const {
-	return false; //can never draw
-};
-
 String OS_Server::get_name() const {
 	return "Server";
 }
 
-void OS_Server::move_window_to_foreground() {
-}
-
 bool OS_Server::_check_internal_feature_support(const String &p_feature) {
 	return p_feature == "pc";
 }
@@ -182,6 +84,7 @@ void OS_Server::run() {
 	main_loop->init();
 
 	while (!force_quit) {
+		DisplayServer::get_singleton()->process_events();
 		if (Main::iteration())
 			break;
 	};
@@ -274,6 +177,9 @@ bool OS_Server::is_disable_crash_handler() const {
 }
 
 OS_Server::OS_Server() {
-	//adriver here
-	grab = false;
-};
+	main_loop = nullptr;
+	force_quit = false;
+
+	// No audio driver is registered, AudioDriverManager falls back to its dummy driver.
+	DisplayServerHeadless::register_headless_driver();
+}
@@ -52,6 +52,15 @@ bool Area3D::is_gravity_a_point() const {
 	return gravity_is_point;
 }
 
+void Area3D::set_gravity_is_n_body(bool p_enabled) {
+	gravity_is_n_body = p_enabled;
+	PhysicsServer3D::get_singleton()->area_set_param(get_rid(), PhysicsServer3D::AREA_PARAM_GRAVITY_IS_N_BODY, p_enabled);
+}
+
+bool Area3D::is_gravity_n_body() const {
+	return gravity_is_n_body;
+}
+
 void Area3D::set_gravity_distance_scale(real_t p_scale) {
 	gravity_distance_scale = p_scale;
 	PhysicsServer3D::get_singleton()->area_set_param(get_rid(), PhysicsServer3D::AREA_PARAM_GRAVITY_DISTANCE_SCALE, p_scale);
@@ -577,6 +586,9 @@ void Area3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_gravity_is_point", "enable"), &Area3D::set_gravity_is_point);
 	ClassDB::bind_method(D_METHOD("is_gravity_a_point"), &Area3D::is_gravity_a_point);
 
+	ClassDB::bind_method(D_METHOD("set_gravity_is_n_body", "enable"), &Area3D::set_gravity_is_n_body);
+	ClassDB::bind_method(D_METHOD("is_gravity_n_body"), &Area3D::is_gravity_n_body);
+
 	ClassDB::bind_method(D_METHOD("set_gravity_distance_scale", "distance_scale"), &Area3D::set_gravity_distance_scale);
 	ClassDB::bind_method(D_METHOD("get_gravity_distance_scale"), &Area3D::get_gravity_distance_scale);
 
@@ -652,6 +664,7 @@ void Area3D::_bind_methods() {
 
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "space_override", PROPERTY_HINT_ENUM, "Disabled,Combine,Combine-Replace,Replace,Replace-Combine"), "set_space_override_mode", "get_space_override_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "gravity_point"), "set_gravity_is_point", "is_gravity_a_point");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "gravity_n_body"), "set_gravity_is_n_body", "is_gravity_n_body");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "gravity_distance_scale", PROPERTY_HINT_EXP_RANGE, "0,1024,0.001,or_greater"), "set_gravity_distance_scale", "get_gravity_distance_scale");
 	ADD_PROPERTY(PropertyInfo(Variant::VECTOR3, "gravity_vec"), "set_gravity_vector", "get_gravity_vector");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "gravity", PROPERTY_HINT_RANGE, "-1024,1024,0.01"), "set_gravity", "get_gravity");
@@ -686,6 +699,7 @@ Area3D::Area3D() :
 	locked = false;
 	set_gravity_vector(Vector3(0, -1, 0));
 	gravity_is_point = false;
+	gravity_is_n_body = false;
 	gravity_distance_scale = 0;
 	linear_damp = 0.1;
 	angular_damp = 0.1;
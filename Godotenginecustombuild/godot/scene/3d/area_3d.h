@@ -51,6 +51,7 @@ private:
 	Vector3 gravity_vec;
 	real_t gravity;
 	bool gravity_is_point;
+	bool gravity_is_n_body;
 	real_t gravity_distance_scale;
 	real_t angular_damp;
 	real_t linear_damp;
@@ -145,6 +146,9 @@ public:
 	void set_gravity_is_point(bool p_enabled);
 	bool is_gravity_a_point() const;
 
+	void set_gravity_is_n_body(bool p_enabled);
+	bool is_gravity_n_body() const;
+
 	void set_gravity_distance_scale(real_t p_scale);
 	real_t get_gravity_distance_scale() const;
 
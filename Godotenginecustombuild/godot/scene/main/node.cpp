@@ -296,6 +296,11 @@ void Node::move_child(Node *p_child, int p_pos) {
 	ERR_FAIL_COND_MSG(p_child->data.parent != this, "Child is not a child of this node.");
 	ERR_FAIL_COND_MSG(data.blocked > 0, "Parent node is busy setting up children, move_child() failed. Consider using call_deferred(\"move_child\") instead (or \"popup\" if this is from a popup).");
 
+	if (data.inside_tree && SceneTree::is_processing_thread()) {
+		SceneTree::push_thread_call(this, "move_child", p_child, p_pos);
+		return;
+	}
+
 	// Specifying one place beyond the end
 	// means the same as moving to the last position
 	if (p_pos == data.children.size()) {
@@ -326,13 +331,22 @@ void Node::move_child(Node *p_child, int p_pos) {
 	for (int i = motion_from; i <= motion_to; i++) {
 		data.children[i]->notification(NOTIFICATION_MOVED_IN_PARENT);
 	}
-	for (const Map<StringName, GroupData>::Element *E = p_child->data.grouped.front(); E; E = E->next()) {
+	// The whole subtree changed places, so groups holding any of its nodes are out of order.
+	p_child->_propagate_groups_changed();
+
+	data.blocked--;
+}
+
+void Node::_propagate_groups_changed() {
+	for (const Map<StringName, GroupData>::Element *E = data.grouped.front(); E; E = E->next()) {
 		if (E->get().group) {
 			E->get().group->changed = true;
 		}
 	}
 
-	data.blocked--;
+	for (int i = 0; i < data.children.size(); i++) {
+		data.children[i]->_propagate_groups_changed();
+	}
 }
 
 void Node::raise() {
@@ -892,6 +906,11 @@ bool Node::is_processing_internal() const {
 }
 
 void Node::set_process_priority(int p_priority) {
+	if (data.tree && SceneTree::is_processing_thread()) {
+		SceneTree::push_thread_call(this, "set_process_priority", p_priority);
+		return;
+	}
+
 	data.process_priority = p_priority;
 
 	// Make sure we are in SceneTree.
@@ -920,6 +939,14 @@ int Node::get_process_priority() const {
 	return data.process_priority;
 }
 
+void Node::set_process_thread_safe(bool p_enable) {
+	data.process_thread_safe = p_enable;
+}
+
+bool Node::is_process_thread_safe() const {
+	return data.process_thread_safe;
+}
+
 void Node::set_process_input(bool p_enable) {
 	if (p_enable == data.input) {
 		return;
@@ -1226,6 +1253,11 @@ void Node::add_child(Node *p_child, bool p_legible_unique_name) {
 	ERR_FAIL_COND_MSG(p_child->data.parent, "Can't add child '" + p_child->get_name() + "' to '" + get_name() + "', already has a parent '" + p_child->data.parent->get_name() + "'."); //Fail if node has a parent
 	ERR_FAIL_COND_MSG(data.blocked > 0, "Parent node is busy setting up children, add_node() failed. Consider using call_deferred(\"add_child\", child) instead.");
 
+	if (data.inside_tree && SceneTree::is_processing_thread()) {
+		SceneTree::push_thread_call(this, "add_child", p_child, p_legible_unique_name);
+		return;
+	}
+
 	/* Validate name */
 	_validate_child_name(p_child, p_legible_unique_name);
 
@@ -1270,6 +1302,11 @@ void Node::remove_child(Node *p_child) {
 	ERR_FAIL_NULL(p_child);
 	ERR_FAIL_COND_MSG(data.blocked > 0, "Parent node is busy setting up children, remove_node() failed. Consider using call_deferred(\"remove_child\", child) instead.");
 
+	if (data.inside_tree && SceneTree::is_processing_thread()) {
+		SceneTree::push_thread_call(this, "remove_child", p_child);
+		return;
+	}
+
 	int child_count = data.children.size();
 	Node **children = data.children.ptrw();
 	int idx = -1;
@@ -1703,6 +1740,11 @@ void Node::add_to_group(const StringName &p_identifier, bool p_persistent) {
 		return;
 	}
 
+	if (data.tree && SceneTree::is_processing_thread()) {
+		SceneTree::push_thread_call(this, "add_to_group", p_identifier, p_persistent);
+		return;
+	}
+
 	GroupData gd;
 
 	if (data.tree) {
@@ -1723,6 +1765,11 @@ void Node::remove_from_group(const StringName &p_identifier) {
 
 	ERR_FAIL_COND(!E);
 
+	if (data.tree && SceneTree::is_processing_thread()) {
+		SceneTree::push_thread_call(this, "remove_from_group", p_identifier);
+		return;
+	}
+
 	if (data.tree) {
 		data.tree->remove_from_group(E->key(), this);
 	}
@@ -2760,6 +2807,8 @@ void Node::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_process", "enable"), &Node::set_process);
 	ClassDB::bind_method(D_METHOD("set_process_priority", "priority"), &Node::set_process_priority);
 	ClassDB::bind_method(D_METHOD("get_process_priority"), &Node::get_process_priority);
+	ClassDB::bind_method(D_METHOD("set_process_thread_safe", "enable"), &Node::set_process_thread_safe);
+	ClassDB::bind_method(D_METHOD("is_process_thread_safe"), &Node::is_process_thread_safe);
 	ClassDB::bind_method(D_METHOD("is_processing"), &Node::is_processing);
 	ClassDB::bind_method(D_METHOD("set_process_input", "enable"), &Node::set_process_input);
 	ClassDB::bind_method(D_METHOD("is_processing_input"), &Node::is_processing_input);
@@ -2897,6 +2946,7 @@ void Node::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "multiplayer", PROPERTY_HINT_RESOURCE_TYPE, "MultiplayerAPI", 0), "", "get_multiplayer");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "custom_multiplayer", PROPERTY_HINT_RESOURCE_TYPE, "MultiplayerAPI", 0), "set_custom_multiplayer", "get_custom_multiplayer");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "process_priority"), "set_process_priority", "get_process_priority");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "process_thread_safe"), "set_process_thread_safe", "is_process_thread_safe");
 
 	BIND_VMETHOD(MethodInfo("_process", PropertyInfo(Variant::FLOAT, "delta")));
 	BIND_VMETHOD(MethodInfo("_physics_process", PropertyInfo(Variant::FLOAT, "delta")));
@@ -2932,6 +2982,7 @@ Node::Node() {
 	data.physics_process = false;
 	data.idle_process = false;
 	data.process_priority = 0;
+	data.process_thread_safe = false;
 	data.physics_process_internal = false;
 	data.idle_process_internal = false;
 	data.inside_tree = false;
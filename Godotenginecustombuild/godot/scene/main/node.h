@@ -124,6 +124,7 @@ private:
 		bool physics_process;
 		bool idle_process;
 		int process_priority;
+		bool process_thread_safe;
 
 		bool physics_process_internal;
 		bool idle_process_internal;
@@ -167,6 +168,7 @@ private:
 	void _propagate_exit_tree();
 	void _propagate_after_exit_tree();
 	void _propagate_validate_owner();
+	void _propagate_groups_changed();
 	void _print_stray_nodes();
 	void _propagate_pause_owner(Node *p_owner);
 	Array _get_node_and_resource(const NodePath &p_path);
@@ -353,6 +355,9 @@ public:
 	void set_process_priority(int p_priority);
 	int get_process_priority() const;
 
+	void set_process_thread_safe(bool p_enable);
+	bool is_process_thread_safe() const;
+
 	void set_process_input(bool p_enable);
 	bool is_processing_input() const;
 
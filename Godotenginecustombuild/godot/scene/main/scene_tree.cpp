@@ -118,33 +118,77 @@ void SceneTree::node_renamed(Node *p_node) {
 	emit_signal(node_renamed_name, p_node);
 }
 
+template <class C>
+static int _group_lower_bound(const Vector<Node *> &p_nodes, const Node *p_node) {
+	C compare;
+	int lo = 0;
+	int hi = p_nodes.size();
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (compare(p_nodes[mid], p_node)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+int SceneTree::_find_group_position(const Group &g, const Node *p_node) {
+	if (g.priority_order) {
+		return _group_lower_bound<Node::ComparatorWithPriority>(g.nodes, p_node);
+	} else {
+		return _group_lower_bound<Node::Comparator>(g.nodes, p_node);
+	}
+}
+
 SceneTree::Group *SceneTree::add_to_group(const StringName &p_group, Node *p_node) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
-		E = group_map.insert(p_group, Group());
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
+		g = &group_map.set(p_group, Group())->value();
+	}
+
+	if (g->changed) {
+		//will be sorted before the next call anyway
+		ERR_FAIL_COND_V_MSG(g->nodes.find(p_node) != -1, g, "Already in group: " + p_group + ".");
+		g->nodes.push_back(p_node);
+		return g;
 	}
 
-	ERR_FAIL_COND_V_MSG(E->get().nodes.find(p_node) != -1, &E->get(), "Already in group: " + p_group + ".");
-	E->get().nodes.push_back(p_node);
-	//E->get().last_tree_version=0;
-	E->get().changed = true;
-	return &E->get();
+	//keep the group sorted, so it never needs a full sort for new members
+	int pos = _find_group_position(*g, p_node);
+	ERR_FAIL_COND_V_MSG(pos < g->nodes.size() && g->nodes[pos] == p_node, g, "Already in group: " + p_group + ".");
+	g->nodes.insert(pos, p_node);
+	return g;
 }
 
 void SceneTree::remove_from_group(const StringName &p_group, Node *p_node) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	ERR_FAIL_COND(!E);
+	Group *g = group_map.getptr(p_group);
+	ERR_FAIL_COND(!g);
+
+	int pos = -1;
+	if (!g->changed) {
+		pos = _find_group_position(*g, p_node);
+		if (pos >= g->nodes.size() || g->nodes[pos] != p_node) {
+			pos = -1;
+		}
+	}
+	if (pos == -1) {
+		pos = g->nodes.find(p_node);
+	}
+	if (pos != -1) {
+		g->nodes.remove(pos);
+	}
 
-	E->get().nodes.erase(p_node);
-	if (E->get().nodes.empty()) {
-		group_map.erase(E);
+	if (g->nodes.empty()) {
+		group_map.erase(p_group);
 	}
 }
 
 void SceneTree::make_group_changed(const StringName &p_group) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (E) {
-		E->get().changed = true;
+	Group *g = group_map.getptr(p_group);
+	if (g) {
+		g->changed = true;
 	}
 }
 
@@ -180,6 +224,10 @@ void SceneTree::_flush_ugc() {
 }
 
 void SceneTree::_update_group_order(Group &g, bool p_use_priority) {
+	if (g.priority_order != p_use_priority) {
+		g.priority_order = p_use_priority;
+		g.changed = true;
+	}
 	if (!g.changed) {
 		return;
 	}
@@ -200,12 +248,31 @@ void SceneTree::_update_group_order(Group &g, bool p_use_priority) {
 	g.changed = false;
 }
 
+bool SceneTree::_group_node_has_method(Node *p_node, const StringName &p_method, LocalVector<GroupMethodCheck> &r_checks) {
+	ScriptInstance *script_instance = p_node->get_script_instance();
+	const Script *script = script_instance ? script_instance->get_script().ptr() : nullptr;
+	StringName class_name = p_node->get_class_name();
+
+	for (uint32_t i = 0; i < r_checks.size(); i++) {
+		if (r_checks[i].script == script && r_checks[i].class_name == class_name) {
+			return r_checks[i].has_method;
+		}
+	}
+
+	GroupMethodCheck check;
+	check.class_name = class_name;
+	check.script = script;
+	check.has_method = p_node->has_method(p_method);
+	r_checks.push_back(check);
+	return check.has_method;
+}
+
 void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_group, const StringName &p_function, VARIANT_ARG_DECLARE) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *gp = group_map.getptr(p_group);
+	if (!gp) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *gp;
 	if (g.nodes.empty()) {
 		return;
 	}
@@ -241,6 +308,9 @@ void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_grou
 	Node **nodes = nodes_copy.ptrw();
 	int node_count = nodes_copy.size();
 
+	//calling a missing method does nothing, so don't call or queue it at all
+	LocalVector<GroupMethodCheck> method_checks;
+
 	call_lock++;
 
 	if (p_call_flags & GROUP_CALL_REVERSE) {
@@ -248,6 +318,9 @@ void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_grou
 			if (call_lock && call_skip.has(nodes[i])) {
 				continue;
 			}
+			if (!_group_node_has_method(nodes[i], p_function, method_checks)) {
+				continue;
+			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
 				nodes[i]->call(p_function, VARIANT_ARG_PASS);
@@ -261,6 +334,9 @@ void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_grou
 			if (call_lock && call_skip.has(nodes[i])) {
 				continue;
 			}
+			if (!_group_node_has_method(nodes[i], p_function, method_checks)) {
+				continue;
+			}
 
 			if (p_call_flags & GROUP_CALL_REALTIME) {
 				nodes[i]->call(p_function, VARIANT_ARG_PASS);
@@ -277,11 +353,11 @@ void SceneTree::call_group_flags(uint32_t p_call_flags, const StringName &p_grou
 }
 
 void SceneTree::notify_group_flags(uint32_t p_call_flags, const StringName &p_group, int p_notification) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *gp = group_map.getptr(p_group);
+	if (!gp) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *gp;
 	if (g.nodes.empty()) {
 		return;
 	}
@@ -328,11 +404,11 @@ void SceneTree::notify_group_flags(uint32_t p_call_flags, const StringName &p_gr
 }
 
 void SceneTree::set_group_flags(uint32_t p_call_flags, const StringName &p_group, const String &p_name, const Variant &p_value) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *gp = group_map.getptr(p_group);
+	if (!gp) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *gp;
 	if (g.nodes.empty()) {
 		return;
 	}
@@ -782,11 +858,11 @@ bool SceneTree::is_paused() const {
 }
 
 void SceneTree::_notify_group_pause(const StringName &p_group, int p_notification) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *gp = group_map.getptr(p_group);
+	if (!gp) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *gp;
 	if (g.nodes.empty()) {
 		return;
 	}
@@ -800,6 +876,9 @@ void SceneTree::_notify_group_pause(const StringName &p_group, int p_notificatio
 	int node_count = nodes_copy.size();
 	Node **nodes = nodes_copy.ptrw();
 
+	//only user process callbacks may run threaded, internal processing is engine code
+	bool allow_threads = p_notification == Node::NOTIFICATION_PROCESS || p_notification == Node::NOTIFICATION_PHYSICS_PROCESS;
+
 	call_lock++;
 
 	for (int i = 0; i < node_count; i++) {
@@ -815,16 +894,108 @@ void SceneTree::_notify_group_pause(const StringName &p_group, int p_notificatio
 			continue;
 		}
 
+		if (allow_threads && n->is_process_thread_safe()) {
+			process_thread_batch.push_back(n);
+			continue;
+		}
+
+		if (process_thread_batch.size()) {
+			//run pending thread-safe nodes first, so process priority order is kept
+			_flush_process_thread_batch(p_notification);
+			if (call_skip.has(n)) {
+				continue;
+			}
+		}
+
 		n->notification(p_notification);
 		//ERR_FAIL_COND(node_count != g.nodes.size());
 	}
 
+	if (process_thread_batch.size()) {
+		_flush_process_thread_batch(p_notification);
+	}
+
 	call_lock--;
 	if (call_lock == 0) {
 		call_skip.clear();
 	}
 }
 
+void SceneTree::_process_thread_node(uint32_t p_index, int p_notification) {
+	thread_calls = &process_thread_calls[p_index];
+	process_thread_batch[p_index]->notification(p_notification);
+	thread_calls = nullptr;
+}
+
+void SceneTree::_flush_process_thread_batch(int p_notification) {
+	uint32_t count = process_thread_batch.size();
+	if (process_thread_calls.size() < count) {
+		process_thread_calls.resize(count);
+	}
+
+	if (count > 1 && OS::get_singleton()->get_processor_count() > 1) {
+		if (process_thread_pool.get_thread_count() == 0) {
+			process_thread_pool.init();
+		}
+		process_thread_pool.do_work(count, this, &SceneTree::_process_thread_node, p_notification);
+	} else {
+		for (uint32_t i = 0; i < count; i++) {
+			_process_thread_node(i, p_notification);
+		}
+	}
+
+	process_thread_batch.clear();
+
+	//sync point, calls are replayed in node order so the result does not depend on scheduling
+	replay_thread_calls(process_thread_calls, count);
+}
+
+void SceneTree::replay_thread_calls(LocalVector<LocalVector<ThreadCall>> &p_calls, uint32_t p_count) {
+	ERR_FAIL_COND(p_count > p_calls.size());
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		LocalVector<ThreadCall> &calls = p_calls[i];
+		for (uint32_t j = 0; j < calls.size(); j++) {
+			const ThreadCall &call = calls[j];
+			Object *obj = ObjectDB::get_instance(call.object);
+			if (!obj) {
+				continue;
+			}
+
+			const Variant *argptrs[VARIANT_ARG_MAX];
+			for (int k = 0; k < call.args.size(); k++) {
+				argptrs[k] = &call.args[k];
+			}
+
+			Callable::CallError ce;
+			obj->call(call.method, argptrs, call.args.size(), ce);
+			if (ce.error != Callable::CallError::CALL_OK) {
+				ERR_PRINT("Error calling deferred method: " + Variant::get_call_error_text(obj, call.method, argptrs, call.args.size(), ce) + ".");
+			}
+		}
+		calls.clear();
+	}
+}
+
+void SceneTree::push_thread_call(Object *p_object, const StringName &p_method, VARIANT_ARG_DECLARE) {
+	ERR_FAIL_COND(!thread_calls);
+	ERR_FAIL_NULL(p_object);
+
+	ThreadCall call;
+	call.object = p_object->get_instance_id();
+	call.method = p_method;
+
+	VARIANT_ARGPTRS;
+	for (int i = 0; i < VARIANT_ARG_MAX; i++) {
+		if (argptr[i]->get_type() == Variant::NIL) {
+			break;
+		}
+		call.args.push_back(*argptr[i]);
+	}
+
+	thread_calls->push_back(call);
+}
+
 /*
 void SceneMainLoop::_update_listener_2d() {
 	if (listener_2d.is_valid()) {
@@ -835,11 +1006,11 @@ void SceneMainLoop::_update_listener_2d() {
 */
 
 void SceneTree::_call_input_pause(const StringName &p_group, const StringName &p_method, const Ref<InputEvent> &p_input, Viewport *p_viewport) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *gp = group_map.getptr(p_group);
+	if (!gp) {
 		return;
 	}
-	Group &g = E->get();
+	Group &g = *gp;
 	if (g.nodes.empty()) {
 		return;
 	}
@@ -937,20 +1108,20 @@ int64_t SceneTree::get_frame() const {
 
 Array SceneTree::_get_nodes_in_group(const StringName &p_group) {
 	Array ret;
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
 		return ret;
 	}
 
-	_update_group_order(E->get()); //update order just in case
-	int nc = E->get().nodes.size();
+	_update_group_order(*g); //update order just in case
+	int nc = g->nodes.size();
 	if (nc == 0) {
 		return ret;
 	}
 
 	ret.resize(nc);
 
-	Node **ptr = E->get().nodes.ptrw();
+	Node **ptr = g->nodes.ptrw();
 	for (int i = 0; i < nc; i++) {
 		ret[i] = ptr[i];
 	}
@@ -963,17 +1134,17 @@ bool SceneTree::has_group(const StringName &p_identifier) const {
 }
 
 void SceneTree::get_nodes_in_group(const StringName &p_group, List<Node *> *p_list) {
-	Map<StringName, Group>::Element *E = group_map.find(p_group);
-	if (!E) {
+	Group *g = group_map.getptr(p_group);
+	if (!g) {
 		return;
 	}
 
-	_update_group_order(E->get()); //update order just in case
-	int nc = E->get().nodes.size();
+	_update_group_order(*g); //update order just in case
+	int nc = g->nodes.size();
 	if (nc == 0) {
 		return;
 	}
-	Node **ptr = E->get().nodes.ptrw();
+	Node **ptr = g->nodes.ptrw();
 	for (int i = 0; i < nc; i++) {
 		p_list->push_back(ptr[i]);
 	}
@@ -1282,6 +1453,7 @@ void SceneTree::_bind_methods() {
 }
 
 SceneTree *SceneTree::singleton = nullptr;
+thread_local LocalVector<SceneTree::ThreadCall> *SceneTree::thread_calls = nullptr;
 
 SceneTree::IdleCallback SceneTree::idle_callbacks[SceneTree::MAX_IDLE_CALLBACKS];
 int SceneTree::idle_callback_count = 0;
@@ -1447,6 +1619,10 @@ SceneTree::~SceneTree() {
 		memdelete(root);
 	}
 
+	if (process_thread_pool.get_thread_count()) {
+		process_thread_pool.finish();
+	}
+
 	if (singleton == this) {
 		singleton = nullptr;
 	}
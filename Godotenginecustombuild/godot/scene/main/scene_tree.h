@@ -34,7 +34,10 @@
 #include "core/io/multiplayer_api.h"
 #include "core/os/main_loop.h"
 #include "core/os/thread_safe.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/self_list.h"
+#include "core/templates/thread_work_pool.h"
 #include "scene/resources/mesh.h"
 #include "scene/resources/world_2d.h"
 #include "scene/resources/world_3d.h"
@@ -77,12 +80,30 @@ class SceneTree : public MainLoop {
 public:
 	typedef void (*IdleCallback)();
 
+	// A tree mutation made from a thread-safe process callback, waiting to run on the main thread.
+	struct ThreadCall {
+		ObjectID object;
+		StringName method;
+		Vector<Variant> args;
+	};
+
 private:
 	struct Group {
-		Vector<Node *> nodes;
+		Vector<Node *> nodes; // kept in tree order while not changed, new members are inserted in place
 		//uint64_t last_tree_version;
 		bool changed;
-		Group() { changed = false; };
+		bool priority_order; // order also accounts for process priority
+		Group() {
+			changed = false;
+			priority_order = false;
+		};
+	};
+
+	// Whether a given method exists, cached per class and script while calling a group.
+	struct GroupMethodCheck {
+		StringName class_name;
+		const Script *script;
+		bool has_method;
 	};
 
 	Window *root;
@@ -100,7 +121,7 @@ private:
 	bool pause;
 	int root_lock;
 
-	Map<StringName, Group> group_map;
+	HashMap<StringName, Group> group_map;
 	bool _quit;
 	bool initialized;
 
@@ -128,11 +149,23 @@ private:
 
 	List<ObjectID> delete_queue;
 
+	//nodes flagged process_thread_safe run their process callbacks on a pool,
+	//tree mutations made from there are recorded per node and replayed in order
+	ThreadWorkPool process_thread_pool;
+	LocalVector<Node *> process_thread_batch;
+	LocalVector<LocalVector<ThreadCall>> process_thread_calls;
+	static thread_local LocalVector<ThreadCall> *thread_calls;
+
+	void _process_thread_node(uint32_t p_index, int p_notification);
+	void _flush_process_thread_batch(int p_notification);
+
 	Map<UGCall, Vector<Variant>> unique_group_calls;
 	bool ugc_locked;
 	void _flush_ugc();
 
 	_FORCE_INLINE_ void _update_group_order(Group &g, bool p_use_priority = false);
+	int _find_group_position(const Group &g, const Node *p_node);
+	bool _group_node_has_method(Node *p_node, const StringName &p_method, LocalVector<GroupMethodCheck> &r_checks);
 	void _update_listener();
 
 	Array _get_nodes_in_group(const StringName &p_group);
@@ -303,6 +336,13 @@ public:
 
 	void queue_delete(Object *p_object);
 
+	// True while running the process callback of a thread-safe node on the process pool.
+	static bool is_processing_thread() { return thread_calls != nullptr; }
+	// Records a call to run on the main thread once the current thread-safe batch finishes.
+	static void push_thread_call(Object *p_object, const StringName &p_method, VARIANT_ARG_LIST);
+	// Runs and clears the first p_count call lists, list by list, so calls keep the order of the nodes that made them.
+	static void replay_thread_calls(LocalVector<LocalVector<ThreadCall>> &p_calls, uint32_t p_count);
+
 	void get_nodes_in_group(const StringName &p_group, List<Node *> *p_list);
 	bool has_group(const StringName &p_identifier) const;
 
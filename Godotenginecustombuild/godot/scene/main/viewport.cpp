@@ -34,6 +34,7 @@
 #include "core/core_string_names.h"
 #include "core/debugger/engine_debugger.h"
 #include "core/input/input.h"
+#include "core/object/message_queue.h"
 #include "core/os/os.h"
 #include "scene/2d/collision_object_2d.h"
 #include "scene/3d/camera_3d.h"
@@ -1058,9 +1059,75 @@ void Viewport::_listener_make_next_current(Listener3D *p_exclude) {
 
 void Viewport::_camera_transform_changed_notify() {
 #ifndef _3D_DISABLED
+	if (floating_origin_threshold > 0 && camera && !floating_origin_queued) {
+		if (camera->get_global_transform().origin.length_squared() > floating_origin_threshold * floating_origin_threshold) {
+			// Not while the camera is in the middle of a transform notification.
+			floating_origin_queued = true;
+			MessageQueue::get_singleton()->push_call(this, "_floating_origin_update");
+		}
+	}
 #endif
 }
 
+void Viewport::_floating_origin_update() {
+#ifndef _3D_DISABLED
+	floating_origin_queued = false;
+	if (floating_origin_threshold > 0 && camera && camera->is_inside_tree()) {
+		shift_world_origin(camera->get_global_transform().origin);
+	}
+#endif
+}
+
+void Viewport::_shift_node_origin(Node *p_node, bool p_parent_is_3d, const Vector3 &p_offset) {
+#ifndef _3D_DISABLED
+	Node3D *node_3d = Object::cast_to<Node3D>(p_node);
+	if (node_3d && (!p_parent_is_3d || node_3d->is_set_as_top_level())) {
+		// Children follow their parent, only nodes placed in global space move.
+		Transform xform = node_3d->get_global_transform();
+		xform.origin -= p_offset;
+		node_3d->set_global_transform(xform);
+	}
+
+	for (int i = 0; i < p_node->get_child_count(); i++) {
+		Node *child = p_node->get_child(i);
+		if (Object::cast_to<Viewport>(child)) {
+			continue; // Has its own scene.
+		}
+		_shift_node_origin(child, node_3d != nullptr, p_offset);
+	}
+#endif
+}
+
+void Viewport::set_floating_origin_threshold(real_t p_distance) {
+	floating_origin_threshold = MAX(p_distance, 0);
+}
+
+real_t Viewport::get_floating_origin_threshold() const {
+	return floating_origin_threshold;
+}
+
+void Viewport::shift_world_origin(const Vector3 &p_offset) {
+#ifndef _3D_DISABLED
+	if (p_offset == Vector3()) {
+		return;
+	}
+
+	for (int i = 0; i < get_child_count(); i++) {
+		Node *child = get_child(i);
+		if (!Object::cast_to<Viewport>(child)) {
+			_shift_node_origin(child, false, p_offset);
+		}
+	}
+
+	world_origin += p_offset;
+	emit_signal("world_origin_shifted", p_offset);
+#endif
+}
+
+Vector3 Viewport::get_world_origin() const {
+	return world_origin;
+}
+
 void Viewport::_camera_set(Camera3D *p_camera) {
 #ifndef _3D_DISABLED
 
@@ -3450,6 +3517,12 @@ void Viewport::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("_gui_remove_focus_for_window"), &Viewport::_gui_remove_focus_for_window);
 	ClassDB::bind_method(D_METHOD("_post_gui_grab_click_focus"), &Viewport::_post_gui_grab_click_focus);
+	ClassDB::bind_method(D_METHOD("_floating_origin_update"), &Viewport::_floating_origin_update);
+
+	ClassDB::bind_method(D_METHOD("set_floating_origin_threshold", "distance"), &Viewport::set_floating_origin_threshold);
+	ClassDB::bind_method(D_METHOD("get_floating_origin_threshold"), &Viewport::get_floating_origin_threshold);
+	ClassDB::bind_method(D_METHOD("shift_world_origin", "offset"), &Viewport::shift_world_origin);
+	ClassDB::bind_method(D_METHOD("get_world_origin"), &Viewport::get_world_origin);
 
 	ClassDB::bind_method(D_METHOD("set_shadow_atlas_size", "size"), &Viewport::set_shadow_atlas_size);
 	ClassDB::bind_method(D_METHOD("get_shadow_atlas_size"), &Viewport::get_shadow_atlas_size);
@@ -3485,6 +3558,7 @@ void Viewport::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "own_world_3d"), "set_use_own_world_3d", "is_using_own_world_3d");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "world_3d", PROPERTY_HINT_RESOURCE_TYPE, "World3D"), "set_world_3d", "get_world_3d");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "world_2d", PROPERTY_HINT_RESOURCE_TYPE, "World2D", 0), "set_world_2d", "get_world_2d");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "floating_origin_threshold", PROPERTY_HINT_RANGE, "0,100000,1,or_greater"), "set_floating_origin_threshold", "get_floating_origin_threshold");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "transparent_bg"), "set_transparent_background", "has_transparent_background");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "handle_input_locally"), "set_handle_input_locally", "is_handling_input_locally");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "snap_2d_transforms_to_pixel"), "set_snap_2d_transforms_to_pixel", "is_snap_2d_transforms_to_pixel_enabled");
@@ -3516,6 +3590,7 @@ void Viewport::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::TRANSFORM2D, "global_canvas_transform", PROPERTY_HINT_NONE, "", 0), "set_global_canvas_transform", "get_global_canvas_transform");
 
 	ADD_SIGNAL(MethodInfo("size_changed"));
+	ADD_SIGNAL(MethodInfo("world_origin_shifted", PropertyInfo(Variant::VECTOR3, "offset")));
 	ADD_SIGNAL(MethodInfo("gui_focus_changed", PropertyInfo(Variant::OBJECT, "node", PROPERTY_HINT_RESOURCE_TYPE, "Control")));
 
 	BIND_ENUM_CONSTANT(SHADOW_ATLAS_QUADRANT_SUBDIV_DISABLED);
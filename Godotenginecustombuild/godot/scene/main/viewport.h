@@ -191,6 +191,12 @@ private:
 
 	Camera3D *camera;
 	Set<Camera3D *> cameras;
+
+	// Floating origin: once the current camera strays further than the
+	// threshold, the whole 3D scene is moved back so the camera sits at zero.
+	real_t floating_origin_threshold = 0.0;
+	Vector3 world_origin;
+	bool floating_origin_queued = false;
 	Set<CanvasLayer *> canvas_layers;
 
 	RID viewport;
@@ -419,6 +425,9 @@ private:
 	void _camera_remove(Camera3D *p_camera);
 	void _camera_make_next_current(Camera3D *p_exclude);
 
+	void _floating_origin_update();
+	void _shift_node_origin(Node *p_node, bool p_parent_is_3d, const Vector3 &p_offset);
+
 	friend class CanvasLayer;
 	void _canvas_layer_add(CanvasLayer *p_canvas_layer);
 	void _canvas_layer_remove(CanvasLayer *p_canvas_layer);
@@ -471,6 +480,11 @@ public:
 	void set_camera_override_perspective(float p_fovy_degrees, float p_z_near, float p_z_far);
 	void set_camera_override_orthogonal(float p_size, float p_z_near, float p_z_far);
 
+	void set_floating_origin_threshold(real_t p_distance);
+	real_t get_floating_origin_threshold() const;
+	void shift_world_origin(const Vector3 &p_offset);
+	Vector3 get_world_origin() const;
+
 	void set_as_audio_listener(bool p_enable);
 	bool is_audio_listener() const;
 
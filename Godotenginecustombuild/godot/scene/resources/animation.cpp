@@ -358,7 +358,7 @@ bool Animation::_get(const StringName &p_name, Variant &r_ret) const {
 				int kk = track_get_key_count(track);
 				keys.resize(kk * 12);
 
-				real_t *w = keys.ptrw();
+				float *w = keys.ptrw();
 
 				int idx = 0;
 				for (int i = 0; i < track_get_key_count(track); i++) {
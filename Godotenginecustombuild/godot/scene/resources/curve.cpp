@@ -1234,7 +1234,7 @@ void Curve3D::_bake() const {
 	int idx = 0;
 
 	baked_tilt_cache.resize(pointlist.size());
-	real_t *wt = baked_tilt_cache.ptrw();
+	float *wt = baked_tilt_cache.ptrw();
 
 	baked_up_vector_cache.resize(up_vector_enabled ? pointlist.size() : 0);
 	Vector3 *up_write = baked_up_vector_cache.ptrw();
@@ -1352,7 +1352,7 @@ float Curve3D::interpolate_baked_tilt(float p_offset) const {
 	}
 
 	int bpc = baked_tilt_cache.size();
-	const real_t *r = baked_tilt_cache.ptr();
+	const float *r = baked_tilt_cache.ptr();
 
 	if (p_offset < 0) {
 		return r[0];
@@ -1393,7 +1393,7 @@ Vector3 Curve3D::interpolate_baked_up_vector(float p_offset, bool p_apply_tilt)
 
 	const Vector3 *r = baked_up_vector_cache.ptr();
 	const Vector3 *rp = baked_point_cache.ptr();
-	const real_t *rt = baked_tilt_cache.ptr();
+	const float *rt = baked_tilt_cache.ptr();
 
 	float offset = CLAMP(p_offset, 0.0f, baked_max_ofs);
 
@@ -1555,7 +1555,7 @@ Dictionary Curve3D::_get_data() const {
 	Vector3 *w = d.ptrw();
 	PackedFloat32Array t;
 	t.resize(points.size());
-	real_t *wt = t.ptrw();
+	float *wt = t.ptrw();
 
 	for (int i = 0; i < points.size(); i++) {
 		w[i * 3 + 0] = points[i].in;
@@ -1580,7 +1580,7 @@ void Curve3D::_set_data(const Dictionary &p_data) {
 	points.resize(pc / 3);
 	const Vector3 *r = rp.ptr();
 	PackedFloat32Array rtl = p_data["tilts"];
-	const real_t *rt = rtl.ptr();
+	const float *rt = rtl.ptr();
 
 	for (int i = 0; i < points.size(); i++) {
 		points.write[i].in = r[i * 3 + 0];
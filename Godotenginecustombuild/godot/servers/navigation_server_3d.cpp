@@ -36,6 +36,21 @@
 
 NavigationServer3D *NavigationServer3D::singleton = nullptr;
 
+Array NavigationServer3D::_map_get_paths(RID p_map, const PackedVector3Array &p_origins, const PackedVector3Array &p_destinations, bool p_optimize) const {
+	ERR_FAIL_COND_V_MSG(p_origins.size() != p_destinations.size(), Array(), "Each origin must have its destination.");
+
+	Vector<Vector<Vector3>> paths;
+	paths.resize(p_origins.size());
+	map_get_paths(p_map, p_origins.ptr(), p_destinations.ptr(), p_origins.size(), p_optimize, paths.ptrw());
+
+	Array ret;
+	ret.resize(paths.size());
+	for (int i = 0; i < paths.size(); i++) {
+		ret[i] = paths[i];
+	}
+	return ret;
+}
+
 void NavigationServer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_create"), &NavigationServer3D::map_create);
 	ClassDB::bind_method(D_METHOD("map_set_active", "map", "active"), &NavigationServer3D::map_set_active);
@@ -47,6 +62,7 @@ void NavigationServer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_set_edge_connection_margin", "map", "margin"), &NavigationServer3D::map_set_edge_connection_margin);
 	ClassDB::bind_method(D_METHOD("map_get_edge_connection_margin", "map"), &NavigationServer3D::map_get_edge_connection_margin);
 	ClassDB::bind_method(D_METHOD("map_get_path", "map", "origin", "destination", "optimize"), &NavigationServer3D::map_get_path);
+	ClassDB::bind_method(D_METHOD("map_get_paths", "map", "origins", "destinations", "optimize"), &NavigationServer3D::_map_get_paths);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_to_segment", "map", "start", "end", "use_collision"), &NavigationServer3D::map_get_closest_point_to_segment, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("map_get_closest_point", "map", "to_point"), &NavigationServer3D::map_get_closest_point);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_normal", "map", "to_point"), &NavigationServer3D::map_get_closest_point_normal);
@@ -50,6 +50,8 @@ class NavigationServer3D : public Object {
 
 	static NavigationServer3D *singleton;
 
+	Array _map_get_paths(RID p_map, const PackedVector3Array &p_origins, const PackedVector3Array &p_destinations, bool p_optimize) const;
+
 protected:
 	static void _bind_methods();
 
@@ -90,6 +92,10 @@ public:
 	/// Returns the navigation path to reach the destination from the origin.
 	virtual Vector<Vector3> map_get_path(RID p_map, Vector3 p_origin, Vector3 p_destination, bool p_optimize) const = 0;
 
+	/// Returns the navigation paths of many queries at once, `r_paths[i]`
+	/// going from `p_origins[i]` to `p_destinations[i]`.
+	virtual void map_get_paths(RID p_map, const Vector3 *p_origins, const Vector3 *p_destinations, int p_count, bool p_optimize, Vector<Vector3> *r_paths) const = 0;
+
 	virtual Vector3 map_get_closest_point_to_segment(RID p_map, const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision = false) const = 0;
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const = 0;
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const = 0;
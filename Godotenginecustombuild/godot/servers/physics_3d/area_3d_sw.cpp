@@ -155,6 +155,9 @@ void Area3DSW::set_param(PhysicsServer3D::AreaParameter p_param, const Variant &
 		case PhysicsServer3D::AREA_PARAM_PRIORITY:
 			priority = p_value;
 			break;
+		case PhysicsServer3D::AREA_PARAM_GRAVITY_IS_N_BODY:
+			gravity_is_n_body = p_value;
+			break;
 	}
 }
 
@@ -176,6 +179,8 @@ Variant Area3DSW::get_param(PhysicsServer3D::AreaParameter p_param) const {
 			return angular_damp;
 		case PhysicsServer3D::AREA_PARAM_PRIORITY:
 			return priority;
+		case PhysicsServer3D::AREA_PARAM_GRAVITY_IS_N_BODY:
+			return gravity_is_n_body;
 	}
 
 	return Variant();
@@ -279,6 +284,7 @@ Area3DSW::Area3DSW() :
 	gravity = 9.80665;
 	gravity_vector = Vector3(0, -1, 0);
 	gravity_is_point = false;
+	gravity_is_n_body = false;
 	gravity_distance_scale = 0;
 	point_attenuation = 1;
 	angular_damp = 0.1;
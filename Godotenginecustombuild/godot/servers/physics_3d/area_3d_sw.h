@@ -45,6 +45,7 @@ class Area3DSW : public CollisionObject3DSW {
 	real_t gravity;
 	Vector3 gravity_vector;
 	bool gravity_is_point;
+	bool gravity_is_n_body;
 	real_t gravity_distance_scale;
 	real_t point_attenuation;
 	real_t linear_damp;
@@ -133,6 +134,9 @@ public:
 	_FORCE_INLINE_ void set_gravity_as_point(bool p_enable) { gravity_is_point = p_enable; }
 	_FORCE_INLINE_ bool is_gravity_point() const { return gravity_is_point; }
 
+	_FORCE_INLINE_ void set_gravity_as_n_body(bool p_enable) { gravity_is_n_body = p_enable; }
+	_FORCE_INLINE_ bool is_gravity_n_body() const { return gravity_is_n_body; }
+
 	_FORCE_INLINE_ void set_gravity_distance_scale(real_t scale) { gravity_distance_scale = scale; }
 	_FORCE_INLINE_ real_t get_gravity_distance_scale() const { return gravity_distance_scale; }
 
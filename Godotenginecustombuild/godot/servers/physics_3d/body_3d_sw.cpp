@@ -32,27 +32,24 @@
 #include "area_3d_sw.h"
 #include "space_3d_sw.h"
 
+BodyStorage3DSW Body3DSW::unassigned_storage;
+
 void Body3DSW::_update_inertia() {
 	if (get_space() && !inertia_update_list.in_list()) {
 		get_space()->body_add_to_inertia_update_list(&inertia_update_list);
 	}
 }
 
-void Body3DSW::_update_transform_dependant() {
-	center_of_mass = get_transform().basis.xform(center_of_mass_local);
-	principal_inertia_axes = get_transform().basis * principal_inertia_axes_local;
-
-	// update inertia tensor
-	Basis tb = principal_inertia_axes;
-	Basis tbt = tb.transposed();
-	Basis diag;
-	diag.scale(_inv_inertia);
-	_inv_inertia_tensor = tb * diag * tbt;
-}
-
 void Body3DSW::update_inertias() {
 	//update shapes and motions
 
+	uint32_t index = _get_index();
+	real_t &_inv_mass = storage->inv_mass[index];
+	Vector3 &_inv_inertia = storage->inv_inertia[index];
+	Basis &_inv_inertia_tensor = storage->inv_inertia_tensor[index];
+	Basis &principal_inertia_axes_local = storage->principal_inertia_axes_local[index];
+	Vector3 &center_of_mass_local = storage->center_of_mass_local[index];
+
 	switch (mode) {
 		case PhysicsServer3D::BODY_MODE_RIGID: {
 			//update tensor for all shapes, not the best way but should be somehow OK. (inspired from bullet)
@@ -139,14 +136,14 @@ void Body3DSW::set_active(bool p_active) {
 	active = p_active;
 	if (!p_active) {
 		if (get_space()) {
-			get_space()->body_remove_from_active_list(&active_list);
+			storage->set_active(storage_handle, false);
 		}
 	} else {
 		if (mode == PhysicsServer3D::BODY_MODE_STATIC) {
 			return; //static bodies can't become active
 		}
 		if (get_space()) {
-			get_space()->body_add_to_active_list(&active_list);
+			storage->set_active(storage_handle, true);
 		}
 
 		//still_time=0;
@@ -187,6 +184,10 @@ void Body3DSW::set_param(PhysicsServer3D::BodyParameter p_param, real_t p_value)
 		case PhysicsServer3D::BODY_PARAM_ANGULAR_DAMP: {
 			angular_damp = p_value;
 		} break;
+		case PhysicsServer3D::BODY_PARAM_GRAVITY_MASS: {
+			gravity_mass = MAX(p_value, 0);
+			_update_gravity_attractor();
+		} break;
 		default: {
 		}
 	}
@@ -212,6 +213,9 @@ real_t Body3DSW::get_param(PhysicsServer3D::BodyParameter p_param) const {
 		case PhysicsServer3D::BODY_PARAM_ANGULAR_DAMP: {
 			return angular_damp;
 		} break;
+		case PhysicsServer3D::BODY_PARAM_GRAVITY_MASS: {
+			return gravity_mass;
+		} break;
 
 		default: {
 		}
@@ -229,28 +233,28 @@ void Body3DSW::set_mode(PhysicsServer3D::BodyMode p_mode) {
 		case PhysicsServer3D::BODY_MODE_STATIC:
 		case PhysicsServer3D::BODY_MODE_KINEMATIC: {
 			_set_inv_transform(get_transform().affine_inverse());
-			_inv_mass = 0;
+			storage->inv_mass[_get_index()] = 0;
 			_set_static(p_mode == PhysicsServer3D::BODY_MODE_STATIC);
 			//set_active(p_mode==PhysicsServer3D::BODY_MODE_KINEMATIC);
 			set_active(p_mode == PhysicsServer3D::BODY_MODE_KINEMATIC && contacts.size());
-			linear_velocity = Vector3();
-			angular_velocity = Vector3();
+			set_linear_velocity(Vector3());
+			set_angular_velocity(Vector3());
 			if (mode == PhysicsServer3D::BODY_MODE_KINEMATIC && prev != mode) {
 				first_time_kinematic = true;
 			}
 
 		} break;
 		case PhysicsServer3D::BODY_MODE_RIGID: {
-			_inv_mass = mass > 0 ? (1.0 / mass) : 0;
+			storage->inv_mass[_get_index()] = mass > 0 ? (1.0 / mass) : 0;
 			_set_static(false);
 			set_active(true);
 
 		} break;
 		case PhysicsServer3D::BODY_MODE_CHARACTER: {
-			_inv_mass = mass > 0 ? (1.0 / mass) : 0;
+			storage->inv_mass[_get_index()] = mass > 0 ? (1.0 / mass) : 0;
 			_set_static(false);
 			set_active(true);
-			angular_velocity = Vector3();
+			set_angular_velocity(Vector3());
 		} break;
 	}
 
@@ -277,13 +281,13 @@ void Body3DSW::set_state(PhysicsServer3D::BodyState p_state, const Variant &p_va
 				//wakeup_neighbours();
 				set_active(true);
 				if (first_time_kinematic) {
-					_set_transform(p_variant);
+					_set_body_transform(p_variant);
 					_set_inv_transform(get_transform().affine_inverse());
 					first_time_kinematic = false;
 				}
 
 			} else if (mode == PhysicsServer3D::BODY_MODE_STATIC) {
-				_set_transform(p_variant);
+				_set_body_transform(p_variant);
 				_set_inv_transform(get_transform().affine_inverse());
 				wakeup_neighbours();
 			} else {
@@ -293,7 +297,7 @@ void Body3DSW::set_state(PhysicsServer3D::BodyState p_state, const Variant &p_va
 				if (new_transform == t) {
 					break;
 				}
-				_set_transform(t);
+				_set_body_transform(t);
 				_set_inv_transform(get_transform().inverse());
 			}
 			wakeup();
@@ -304,7 +308,7 @@ void Body3DSW::set_state(PhysicsServer3D::BodyState p_state, const Variant &p_va
 			if (mode==PhysicsServer3D::BODY_MODE_STATIC)
 				break;
 			*/
-			linear_velocity = p_variant;
+			set_linear_velocity(p_variant);
 			wakeup();
 		} break;
 		case PhysicsServer3D::BODY_STATE_ANGULAR_VELOCITY: {
@@ -312,7 +316,7 @@ void Body3DSW::set_state(PhysicsServer3D::BodyState p_state, const Variant &p_va
 			if (mode!=PhysicsServer3D::BODY_MODE_RIGID)
 				break;
 			*/
-			angular_velocity = p_variant;
+			set_angular_velocity(p_variant);
 			wakeup();
 
 		} break;
@@ -323,9 +327,9 @@ void Body3DSW::set_state(PhysicsServer3D::BodyState p_state, const Variant &p_va
 			}
 			bool do_sleep = p_variant;
 			if (do_sleep) {
-				linear_velocity = Vector3();
+				set_linear_velocity(Vector3());
 				//biased_linear_velocity=Vector3();
-				angular_velocity = Vector3();
+				set_angular_velocity(Vector3());
 				//biased_angular_velocity=Vector3();
 				set_active(false);
 			} else {
@@ -348,10 +352,10 @@ Variant Body3DSW::get_state(PhysicsServer3D::BodyState p_state) const {
 			return get_transform();
 		} break;
 		case PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY: {
-			return linear_velocity;
+			return get_linear_velocity();
 		} break;
 		case PhysicsServer3D::BODY_STATE_ANGULAR_VELOCITY: {
-			return angular_velocity;
+			return get_angular_velocity();
 		} break;
 		case PhysicsServer3D::BODY_STATE_SLEEPING: {
 			return !is_active();
@@ -369,20 +373,28 @@ void Body3DSW::set_space(Space3DSW *p_space) {
 		if (inertia_update_list.in_list()) {
 			get_space()->body_remove_from_inertia_update_list(&inertia_update_list);
 		}
-		if (active_list.in_list()) {
-			get_space()->body_remove_from_active_list(&active_list);
-		}
 		if (direct_state_query_list.in_list()) {
 			get_space()->body_remove_from_state_query_list(&direct_state_query_list);
 		}
+		if (gravity_attractor_list.in_list()) {
+			get_space()->body_remove_from_gravity_attractor_list(&gravity_attractor_list);
+		}
 	}
 
 	_set_space(p_space);
 
+	// The state moves along, the body starts out inactive in the new storage.
+	BodyStorage3DSW *new_storage = get_space() ? &get_space()->get_body_storage() : &unassigned_storage;
+	if (new_storage != storage) {
+		storage_handle = storage->transfer(storage_handle, *new_storage);
+		storage = new_storage;
+	}
+
 	if (get_space()) {
 		_update_inertia();
+		_update_gravity_attractor();
 		if (active) {
-			get_space()->body_add_to_active_list(&active_list);
+			storage->set_active(storage_handle, true);
 		}
 		/*
 		_update_queries();
@@ -396,8 +408,23 @@ void Body3DSW::set_space(Space3DSW *p_space) {
 	first_integration = true;
 }
 
+void Body3DSW::_update_gravity_attractor() {
+	if (!get_space()) {
+		return;
+	}
+
+	if (gravity_mass > 0 && !gravity_attractor_list.in_list()) {
+		get_space()->body_add_to_gravity_attractor_list(&gravity_attractor_list);
+	} else if (gravity_mass <= 0 && gravity_attractor_list.in_list()) {
+		get_space()->body_remove_from_gravity_attractor_list(&gravity_attractor_list);
+	}
+}
+
 void Body3DSW::_compute_area_gravity_and_dampenings(const Area3DSW *p_area) {
-	if (p_area->is_gravity_point()) {
+	if (p_area->is_gravity_n_body()) {
+		// Field of the space attractors, evaluated by the step; the area gravity acts as the gravitational constant.
+		gravity += n_body_gravity * p_area->get_gravity();
+	} else if (p_area->is_gravity_point()) {
 		if (p_area->get_gravity_distance_scale() > 0) {
 			Vector3 v = p_area->get_transform().xform(p_area->get_gravity_vector()) - get_transform().get_origin();
 			gravity += v.normalized() * (p_area->get_gravity() / Math::pow(v.length() * p_area->get_gravity_distance_scale() + 1, 2));
@@ -413,6 +440,7 @@ void Body3DSW::_compute_area_gravity_and_dampenings(const Area3DSW *p_area) {
 }
 
 void Body3DSW::set_axis_lock(PhysicsServer3D::BodyAxis p_axis, bool lock) {
+	uint16_t &locked_axis = storage->locked_axis[_get_index()];
 	if (lock) {
 		locked_axis |= p_axis;
 	} else {
@@ -421,7 +449,7 @@ void Body3DSW::set_axis_lock(PhysicsServer3D::BodyAxis p_axis, bool lock) {
 }
 
 bool Body3DSW::is_axis_locked(PhysicsServer3D::BodyAxis p_axis) const {
-	return locked_axis & p_axis;
+	return storage->locked_axis[_get_index()] & p_axis;
 }
 
 void Body3DSW::integrate_forces(real_t p_step) {
@@ -488,12 +516,13 @@ void Body3DSW::integrate_forces(real_t p_step) {
 		area_linear_damp=damp_area->get_linear_damp();
 	*/
 
+	uint32_t index = _get_index();
 	Vector3 motion;
 	bool do_motion = false;
 
 	if (mode == PhysicsServer3D::BODY_MODE_KINEMATIC) {
 		//compute motion, angular and etc. velocities from prev transform
-		linear_velocity = (new_transform.origin - get_transform().origin) / p_step;
+		storage->linear_velocity[index] = (new_transform.origin - get_transform().origin) / p_step;
 
 		//compute a FAKE angular velocity, not so easy
 		Basis rot = new_transform.basis.orthonormalized().transposed() * get_transform().basis.orthonormalized();
@@ -502,42 +531,27 @@ void Body3DSW::integrate_forces(real_t p_step) {
 
 		rot.get_axis_angle(axis, angle);
 		axis.normalize();
-		angular_velocity = axis.normalized() * (angle / p_step);
+		storage->angular_velocity[index] = axis.normalized() * (angle / p_step);
 
 		motion = new_transform.origin - get_transform().origin;
 		do_motion = true;
+		storage->flags[index] = 0;
 
 	} else {
+		storage->flags[index] = BodyStorage3DSW::FLAG_INTEGRATE_VELOCITIES;
+
 		if (!omit_force_integration && !first_integration) {
 			//overridden by direct state query
 
-			Vector3 force = gravity * mass;
-			force += applied_force;
-			Vector3 torque = applied_torque;
-
-			real_t damp = 1.0 - p_step * area_linear_damp;
-
-			if (damp < 0) { // reached zero in the given time
-				damp = 0;
-			}
-
-			real_t angular_damp = 1.0 - p_step * area_angular_damp;
-
-			if (angular_damp < 0) { // reached zero in the given time
-				angular_damp = 0;
-			}
-
-			linear_velocity *= damp;
-			angular_velocity *= angular_damp;
-
-			linear_velocity += _inv_mass * force * p_step;
-			angular_velocity += _inv_inertia_tensor.xform(torque) * p_step;
+			storage->flags[index] |= BodyStorage3DSW::FLAG_INTEGRATE_FORCES;
+			storage->force[index] = gravity * mass + applied_force;
+			storage->torque[index] = applied_torque;
+			storage->linear_damp[index] = area_linear_damp;
+			storage->angular_damp[index] = area_angular_damp;
 		}
 
-		if (continuous_cd) {
-			motion = linear_velocity * p_step;
-			do_motion = true;
-		}
+		// The motion is known once the storage integrated the forces, see apply_pending_motion().
+		do_motion = continuous_cd;
 	}
 
 	applied_force = Vector3();
@@ -546,15 +560,24 @@ void Body3DSW::integrate_forces(real_t p_step) {
 
 	//motion=linear_velocity*p_step;
 
-	biased_angular_velocity = Vector3();
-	biased_linear_velocity = Vector3();
-
-	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
-	}
+	// Shapes temporarily extend for raycast, but the broadphase is only
+	// touched from apply_pending_motion() so this can run on any thread.
+	motion_pending = do_motion;
+	pending_motion = motion;
 
 	def_area = nullptr; // clear the area, so it is set in the next frame
 	contact_count = 0;
+	n_body_gravity = Vector3();
+}
+
+void Body3DSW::apply_pending_motion(real_t p_step) {
+	if (motion_pending) {
+		if (mode != PhysicsServer3D::BODY_MODE_KINEMATIC) {
+			pending_motion = get_linear_velocity() * p_step;
+		}
+		_update_shapes_with_motion(pending_motion);
+		motion_pending = false;
+	}
 }
 
 void Body3DSW::integrate_velocities(real_t p_step) {
@@ -566,60 +589,27 @@ void Body3DSW::integrate_velocities(real_t p_step) {
 		get_space()->body_add_to_state_query_list(&direct_state_query_list);
 	}
 
-	//apply axis lock linear
-	for (int i = 0; i < 3; i++) {
-		if (is_axis_locked((PhysicsServer3D::BodyAxis)(1 << i))) {
-			linear_velocity[i] = 0;
-			biased_linear_velocity[i] = 0;
-			new_transform.origin[i] = get_transform().origin[i];
-		}
-	}
-	//apply axis lock angular
-	for (int i = 0; i < 3; i++) {
-		if (is_axis_locked((PhysicsServer3D::BodyAxis)(1 << (i + 3)))) {
-			angular_velocity[i] = 0;
-			biased_angular_velocity[i] = 0;
+	if (mode == PhysicsServer3D::BODY_MODE_KINEMATIC) {
+		//apply axis lock linear
+		for (int i = 0; i < 3; i++) {
+			if (is_axis_locked((PhysicsServer3D::BodyAxis)(1 << i))) {
+				new_transform.origin[i] = get_transform().origin[i];
+			}
 		}
-	}
 
-	if (mode == PhysicsServer3D::BODY_MODE_KINEMATIC) {
-		_set_transform(new_transform, false);
+		_set_body_transform(new_transform, false);
 		_set_inv_transform(new_transform.affine_inverse());
-		if (contacts.size() == 0 && linear_velocity == Vector3() && angular_velocity == Vector3()) {
+		if (contacts.size() == 0 && get_linear_velocity() == Vector3() && get_angular_velocity() == Vector3()) {
 			set_active(false); //stopped moving, deactivate
 		}
 
 		return;
 	}
 
-	Vector3 total_angular_velocity = angular_velocity + biased_angular_velocity;
-
-	real_t ang_vel = total_angular_velocity.length();
-	Transform transform = get_transform();
-
-	if (ang_vel != 0.0) {
-		Vector3 ang_vel_axis = total_angular_velocity / ang_vel;
-		Basis rot(ang_vel_axis, ang_vel * p_step);
-		Basis identity3(1, 0, 0, 0, 1, 0, 0, 0, 1);
-		transform.origin += ((identity3 - rot) * transform.basis).xform(center_of_mass_local);
-		transform.basis = rot * transform.basis;
-		transform.orthonormalize();
-	}
-
-	Vector3 total_linear_velocity = linear_velocity + biased_linear_velocity;
-	/*for(int i=0;i<3;i++) {
-		if (axis_lock&(1<<i)) {
-			transform.origin[i]=0.0;
-		}
-	}*/
-
-	transform.origin += total_linear_velocity * p_step;
-
-	_set_transform(transform);
+	// The storage already moved the body, only the shapes are left to update.
+	_set_body_transform(storage->transform[_get_index()]);
 	_set_inv_transform(get_transform().inverse());
 
-	_update_transform_dependant();
-
 	/*
 	if (fi_callback) {
 		get_space()->body_add_to_state_query_list(&direct_state_query_list);
@@ -709,7 +699,10 @@ bool Body3DSW::sleep_test(real_t p_step) {
 		return false;
 	}
 
-	if (Math::abs(angular_velocity.length()) < get_space()->get_body_angular_velocity_sleep_threshold() && Math::abs(linear_velocity.length_squared()) < get_space()->get_body_linear_velocity_sleep_threshold() * get_space()->get_body_linear_velocity_sleep_threshold()) {
+	uint32_t index = _get_index();
+	real_t &still_time = storage->still_time[index];
+
+	if (Math::abs(storage->angular_velocity[index].length()) < get_space()->get_body_angular_velocity_sleep_threshold() && Math::abs(storage->linear_velocity[index].length_squared()) < get_space()->get_body_linear_velocity_sleep_threshold() * get_space()->get_body_linear_velocity_sleep_threshold()) {
 		still_time += p_step;
 
 		return still_time > get_space()->get_body_time_to_sleep();
@@ -740,21 +733,22 @@ void Body3DSW::set_kinematic_margin(real_t p_margin) {
 Body3DSW::Body3DSW() :
 		CollisionObject3DSW(TYPE_BODY),
 
-		active_list(this),
 		inertia_update_list(this),
-		direct_state_query_list(this) {
+		direct_state_query_list(this),
+		gravity_attractor_list(this) {
 	mode = PhysicsServer3D::BODY_MODE_RIGID;
 	active = true;
 
+	storage = &unassigned_storage;
+	storage_handle = storage->create(this);
+
 	mass = 1;
 	kinematic_safe_margin = 0.001;
 	//_inv_inertia=Transform();
-	_inv_mass = 1;
 	bounce = 0;
 	friction = 1;
 	omit_force_integration = false;
 	//applied_torque=0;
-	island_step = 0;
 	island_next = nullptr;
 	island_list_next = nullptr;
 	first_time_kinematic = false;
@@ -763,12 +757,12 @@ Body3DSW::Body3DSW() :
 
 	contact_count = 0;
 	gravity_scale = 1.0;
+	gravity_mass = 0;
 	linear_damp = -1;
 	angular_damp = -1;
 	area_angular_damp = 0;
 	area_linear_damp = 0;
 
-	still_time = 0;
 	continuous_cd = false;
 	can_sleep = true;
 	fi_callback = nullptr;
@@ -778,6 +772,7 @@ Body3DSW::~Body3DSW() {
 	if (fi_callback) {
 		memdelete(fi_callback);
 	}
+	storage->free(storage_handle);
 }
 
 PhysicsDirectBodyState3DSW *PhysicsDirectBodyState3DSW::singleton = nullptr;
@@ -32,6 +32,7 @@
 #define BODY_SW_H
 
 #include "area_3d_sw.h"
+#include "body_storage_3d_sw.h"
 #include "collision_object_3d_sw.h"
 #include "core/templates/vset.h"
 
@@ -40,11 +41,12 @@ class Constraint3DSW;
 class Body3DSW : public CollisionObject3DSW {
 	PhysicsServer3D::BodyMode mode;
 
-	Vector3 linear_velocity;
-	Vector3 angular_velocity;
+	// Velocities, inertia, transform and sleep state live in the storage of the space,
+	// so the step can integrate them in bulk.
+	static BodyStorage3DSW unassigned_storage;
+	BodyStorage3DSW *storage;
+	uint32_t storage_handle;
 
-	Vector3 biased_linear_velocity;
-	Vector3 biased_angular_velocity;
 	real_t mass;
 	real_t bounce;
 	real_t friction;
@@ -52,25 +54,12 @@ class Body3DSW : public CollisionObject3DSW {
 	real_t linear_damp;
 	real_t angular_damp;
 	real_t gravity_scale;
-
-	uint16_t locked_axis = 0;
+	real_t gravity_mass;
 
 	real_t kinematic_safe_margin;
-	real_t _inv_mass;
-	Vector3 _inv_inertia; // Relative to the principal axes of inertia
-
-	// Relative to the local frame of reference
-	Basis principal_inertia_axes_local;
-	Vector3 center_of_mass_local;
-
-	// In world orientation with local origin
-	Basis _inv_inertia_tensor;
-	Basis principal_inertia_axes;
-	Vector3 center_of_mass;
 
 	Vector3 gravity;
-
-	real_t still_time;
+	Vector3 n_body_gravity;
 
 	Vector3 applied_force;
 	Vector3 applied_torque;
@@ -78,9 +67,9 @@ class Body3DSW : public CollisionObject3DSW {
 	real_t area_angular_damp;
 	real_t area_linear_damp;
 
-	SelfList<Body3DSW> active_list;
 	SelfList<Body3DSW> inertia_update_list;
 	SelfList<Body3DSW> direct_state_query_list;
+	SelfList<Body3DSW> gravity_attractor_list;
 
 	VSet<RID> exceptions;
 	bool omit_force_integration;
@@ -88,10 +77,14 @@ class Body3DSW : public CollisionObject3DSW {
 
 	bool first_integration;
 
+	bool motion_pending = false;
+	Vector3 pending_motion;
+
 	bool continuous_cd;
 	bool can_sleep;
 	bool first_time_kinematic;
 	void _update_inertia();
+	void _update_gravity_attractor();
 	virtual void _shapes_changed();
 	Transform new_transform;
 
@@ -134,13 +127,17 @@ class Body3DSW : public CollisionObject3DSW {
 
 	ForceIntegrationCallback *fi_callback;
 
-	uint64_t island_step;
 	Body3DSW *island_next;
 	Body3DSW *island_list_next;
 
 	_FORCE_INLINE_ void _compute_area_gravity_and_dampenings(const Area3DSW *p_area);
 
-	_FORCE_INLINE_ void _update_transform_dependant();
+	_FORCE_INLINE_ uint32_t _get_index() const { return storage->get_index(storage_handle); }
+	_FORCE_INLINE_ void _update_transform_dependant() { storage->update_transform_dependant(_get_index()); }
+	_FORCE_INLINE_ void _set_body_transform(const Transform &p_transform, bool p_update_shapes = true) {
+		_set_transform(p_transform, p_update_shapes);
+		storage->transform[_get_index()] = get_transform();
+	}
 
 	friend class PhysicsDirectBodyState3DSW; // i give up, too many functions to expose
 
@@ -186,8 +183,8 @@ public:
 	_FORCE_INLINE_ bool has_exception(const RID &p_exception) const { return exceptions.has(p_exception); }
 	_FORCE_INLINE_ const VSet<RID> &get_exceptions() const { return exceptions; }
 
-	_FORCE_INLINE_ uint64_t get_island_step() const { return island_step; }
-	_FORCE_INLINE_ void set_island_step(uint64_t p_step) { island_step = p_step; }
+	_FORCE_INLINE_ uint64_t get_island_step() const { return storage->island_step[_get_index()]; }
+	_FORCE_INLINE_ void set_island_step(uint64_t p_step) { storage->island_step[_get_index()] = p_step; }
 
 	_FORCE_INLINE_ Body3DSW *get_island_next() const { return island_next; }
 	_FORCE_INLINE_ void set_island_next(Body3DSW *p_next) { island_next = p_next; }
@@ -203,45 +200,70 @@ public:
 	_FORCE_INLINE_ void set_omit_force_integration(bool p_omit_force_integration) { omit_force_integration = p_omit_force_integration; }
 	_FORCE_INLINE_ bool get_omit_force_integration() const { return omit_force_integration; }
 
-	_FORCE_INLINE_ Basis get_principal_inertia_axes() const { return principal_inertia_axes; }
-	_FORCE_INLINE_ Vector3 get_center_of_mass() const { return center_of_mass; }
-	_FORCE_INLINE_ Vector3 xform_local_to_principal(const Vector3 &p_pos) const { return principal_inertia_axes_local.xform(p_pos - center_of_mass_local); }
+	_FORCE_INLINE_ Basis get_principal_inertia_axes() const { return storage->principal_inertia_axes[_get_index()]; }
+	_FORCE_INLINE_ Vector3 get_center_of_mass() const { return storage->center_of_mass[_get_index()]; }
+	_FORCE_INLINE_ Vector3 xform_local_to_principal(const Vector3 &p_pos) const {
+		uint32_t index = _get_index();
+		return storage->principal_inertia_axes_local[index].xform(p_pos - storage->center_of_mass_local[index]);
+	}
 
-	_FORCE_INLINE_ void set_linear_velocity(const Vector3 &p_velocity) { linear_velocity = p_velocity; }
-	_FORCE_INLINE_ Vector3 get_linear_velocity() const { return linear_velocity; }
+	_FORCE_INLINE_ void set_linear_velocity(const Vector3 &p_velocity) { storage->linear_velocity[_get_index()] = p_velocity; }
+	_FORCE_INLINE_ Vector3 get_linear_velocity() const { return storage->linear_velocity[_get_index()]; }
 
-	_FORCE_INLINE_ void set_angular_velocity(const Vector3 &p_velocity) { angular_velocity = p_velocity; }
-	_FORCE_INLINE_ Vector3 get_angular_velocity() const { return angular_velocity; }
+	_FORCE_INLINE_ void set_angular_velocity(const Vector3 &p_velocity) { storage->angular_velocity[_get_index()] = p_velocity; }
+	_FORCE_INLINE_ Vector3 get_angular_velocity() const { return storage->angular_velocity[_get_index()]; }
 
-	_FORCE_INLINE_ const Vector3 &get_biased_linear_velocity() const { return biased_linear_velocity; }
-	_FORCE_INLINE_ const Vector3 &get_biased_angular_velocity() const { return biased_angular_velocity; }
+	_FORCE_INLINE_ const Vector3 &get_biased_linear_velocity() const { return storage->biased_linear_velocity[_get_index()]; }
+	_FORCE_INLINE_ const Vector3 &get_biased_angular_velocity() const { return storage->biased_angular_velocity[_get_index()]; }
 
+	// Impulses never move static and kinematic bodies, so they are not written to at all.
+	// These bodies can be shared by islands solved on different threads.
 	_FORCE_INLINE_ void apply_central_impulse(const Vector3 &p_impulse) {
-		linear_velocity += p_impulse * _inv_mass;
+		if (mode <= PhysicsServer3D::BODY_MODE_KINEMATIC) {
+			return;
+		}
+		uint32_t index = _get_index();
+		storage->linear_velocity[index] += p_impulse * storage->inv_mass[index];
 	}
 
 	_FORCE_INLINE_ void apply_impulse(const Vector3 &p_impulse, const Vector3 &p_position = Vector3()) {
-		linear_velocity += p_impulse * _inv_mass;
-		angular_velocity += _inv_inertia_tensor.xform((p_position - center_of_mass).cross(p_impulse));
+		if (mode <= PhysicsServer3D::BODY_MODE_KINEMATIC) {
+			return;
+		}
+		uint32_t index = _get_index();
+		storage->linear_velocity[index] += p_impulse * storage->inv_mass[index];
+		storage->angular_velocity[index] += storage->inv_inertia_tensor[index].xform((p_position - storage->center_of_mass[index]).cross(p_impulse));
 	}
 
 	_FORCE_INLINE_ void apply_torque_impulse(const Vector3 &p_impulse) {
-		angular_velocity += _inv_inertia_tensor.xform(p_impulse);
+		if (mode <= PhysicsServer3D::BODY_MODE_KINEMATIC) {
+			return;
+		}
+		uint32_t index = _get_index();
+		storage->angular_velocity[index] += storage->inv_inertia_tensor[index].xform(p_impulse);
 	}
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector3 &p_impulse, const Vector3 &p_position = Vector3(), real_t p_max_delta_av = -1.0) {
-		biased_linear_velocity += p_impulse * _inv_mass;
+		if (mode <= PhysicsServer3D::BODY_MODE_KINEMATIC) {
+			return;
+		}
+		uint32_t index = _get_index();
+		storage->biased_linear_velocity[index] += p_impulse * storage->inv_mass[index];
 		if (p_max_delta_av != 0.0) {
-			Vector3 delta_av = _inv_inertia_tensor.xform((p_position - center_of_mass).cross(p_impulse));
+			Vector3 delta_av = storage->inv_inertia_tensor[index].xform((p_position - storage->center_of_mass[index]).cross(p_impulse));
 			if (p_max_delta_av > 0 && delta_av.length() > p_max_delta_av) {
 				delta_av = delta_av.normalized() * p_max_delta_av;
 			}
-			biased_angular_velocity += delta_av;
+			storage->biased_angular_velocity[index] += delta_av;
 		}
 	}
 
 	_FORCE_INLINE_ void apply_bias_torque_impulse(const Vector3 &p_impulse) {
-		biased_angular_velocity += _inv_inertia_tensor.xform(p_impulse);
+		if (mode <= PhysicsServer3D::BODY_MODE_KINEMATIC) {
+			return;
+		}
+		uint32_t index = _get_index();
+		storage->biased_angular_velocity[index] += storage->inv_inertia_tensor[index].xform(p_impulse);
 	}
 
 	_FORCE_INLINE_ void add_central_force(const Vector3 &p_force) {
@@ -250,7 +272,7 @@ public:
 
 	_FORCE_INLINE_ void add_force(const Vector3 &p_force, const Vector3 &p_position = Vector3()) {
 		applied_force += p_force;
-		applied_torque += (p_position - center_of_mass).cross(p_force);
+		applied_torque += (p_position - get_center_of_mass()).cross(p_force);
 	}
 
 	_FORCE_INLINE_ void add_torque(const Vector3 &p_torque) {
@@ -284,40 +306,51 @@ public:
 
 	_FORCE_INLINE_ void set_continuous_collision_detection(bool p_enable) { continuous_cd = p_enable; }
 	_FORCE_INLINE_ bool is_continuous_collision_detection_enabled() const { return continuous_cd; }
+	_FORCE_INLINE_ void limit_motion(real_t p_fraction) {
+		real_t &motion_limit = storage->motion_limit[_get_index()];
+		motion_limit = MIN(motion_limit, p_fraction);
+	}
 
 	void set_space(Space3DSW *p_space);
 
 	void update_inertias();
 
-	_FORCE_INLINE_ real_t get_inv_mass() const { return _inv_mass; }
-	_FORCE_INLINE_ Vector3 get_inv_inertia() const { return _inv_inertia; }
-	_FORCE_INLINE_ Basis get_inv_inertia_tensor() const { return _inv_inertia_tensor; }
+	_FORCE_INLINE_ real_t get_inv_mass() const { return storage->inv_mass[_get_index()]; }
+	_FORCE_INLINE_ Vector3 get_inv_inertia() const { return storage->inv_inertia[_get_index()]; }
+	_FORCE_INLINE_ Basis get_inv_inertia_tensor() const { return storage->inv_inertia_tensor[_get_index()]; }
 	_FORCE_INLINE_ real_t get_friction() const { return friction; }
 	_FORCE_INLINE_ Vector3 get_gravity() const { return gravity; }
+	_FORCE_INLINE_ real_t get_gravity_mass() const { return gravity_mass; }
+	_FORCE_INLINE_ void set_n_body_gravity(const Vector3 &p_gravity) { n_body_gravity = p_gravity; }
 	_FORCE_INLINE_ real_t get_bounce() const { return bounce; }
 
 	void set_axis_lock(PhysicsServer3D::BodyAxis p_axis, bool lock);
 	bool is_axis_locked(PhysicsServer3D::BodyAxis p_axis) const;
 
+	// The velocities themselves are integrated in bulk by the storage of the space,
+	// these only handle what is specific to the body.
 	void integrate_forces(real_t p_step);
+	void apply_pending_motion(real_t p_step);
 	void integrate_velocities(real_t p_step);
 
 	_FORCE_INLINE_ Vector3 get_velocity_in_local_point(const Vector3 &rel_pos) const {
-		return linear_velocity + angular_velocity.cross(rel_pos - center_of_mass);
+		uint32_t index = _get_index();
+		return storage->linear_velocity[index] + storage->angular_velocity[index].cross(rel_pos - storage->center_of_mass[index]);
 	}
 
 	_FORCE_INLINE_ real_t compute_impulse_denominator(const Vector3 &p_pos, const Vector3 &p_normal) const {
-		Vector3 r0 = p_pos - get_transform().origin - center_of_mass;
+		uint32_t index = _get_index();
+		Vector3 r0 = p_pos - get_transform().origin - storage->center_of_mass[index];
 
 		Vector3 c0 = (r0).cross(p_normal);
 
-		Vector3 vec = (_inv_inertia_tensor.xform_inv(c0)).cross(r0);
+		Vector3 vec = (storage->inv_inertia_tensor[index].xform_inv(c0)).cross(r0);
 
-		return _inv_mass + p_normal.dot(vec);
+		return storage->inv_mass[index] + p_normal.dot(vec);
 	}
 
 	_FORCE_INLINE_ real_t compute_angular_impulse_denominator(const Vector3 &p_axis) const {
-		return p_axis.dot(_inv_inertia_tensor.xform_inv(p_axis));
+		return p_axis.dot(storage->inv_inertia_tensor[_get_index()].xform_inv(p_axis));
 	}
 
 	//void simulate_motion(const Transform& p_xform,real_t p_step);
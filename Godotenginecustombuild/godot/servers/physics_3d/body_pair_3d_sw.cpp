@@ -48,6 +48,8 @@
 #define RELAXATION_TIMESTEPS 3
 #define MIN_VELOCITY 0.0001
 #define MAX_BIAS_ROTATION (Math_PI / 8)
+#define MANIFOLD_MAX_DRIFT_RATIO 0.5 // Of the contact recycle radius.
+#define MANIFOLD_MAX_ROTATION (Math_PI / 90) // Relative rotation, whatever the size of the shapes.
 
 void BodyPair3DSW::_contact_added_callback(const Vector3 &p_point_A, const Vector3 &p_point_B, void *p_userdata) {
 	BodyPair3DSW *pair = (BodyPair3DSW *)p_userdata;
@@ -78,22 +80,30 @@ void BodyPair3DSW::contact_added_callback(const Vector3 &p_point_A, const Vector
 	contact.normal = (p_point_A - p_point_B).normalized();
 	contact.mass_normal = 0; // will be computed in setup()
 
-	// attempt to determine if the contact will be reused
+	// attempt to determine if the contact will be reused, by the closest match
 	real_t contact_recycle_radius = space->get_contact_recycle_radius();
+	real_t closest = 1e20;
 
 	for (int i = 0; i < contact_count; i++) {
 		Contact &c = contacts[i];
-		if (c.local_A.distance_squared_to(local_A) < (contact_recycle_radius * contact_recycle_radius) &&
-				c.local_B.distance_squared_to(local_B) < (contact_recycle_radius * contact_recycle_radius)) {
-			contact.acc_normal_impulse = c.acc_normal_impulse;
-			contact.acc_bias_impulse = c.acc_bias_impulse;
-			contact.acc_bias_impulse_center_of_mass = c.acc_bias_impulse_center_of_mass;
-			contact.acc_tangent_impulse = c.acc_tangent_impulse;
+		real_t dist_A = c.local_A.distance_squared_to(local_A);
+		real_t dist_B = c.local_B.distance_squared_to(local_B);
+		if (dist_A < (contact_recycle_radius * contact_recycle_radius) && dist_B < (contact_recycle_radius * contact_recycle_radius) && dist_A + dist_B < closest) {
+			closest = dist_A + dist_B;
 			new_index = i;
-			break;
 		}
 	}
 
+	if (new_index < contact_count) {
+		// Warm start with what the solver found last time.
+		const Contact &c = contacts[new_index];
+		contact.acc_normal_impulse = c.acc_normal_impulse;
+		contact.acc_bias_impulse = c.acc_bias_impulse;
+		contact.acc_bias_impulse_center_of_mass = c.acc_bias_impulse_center_of_mass;
+		// The normal may have turned a bit, friction only acts along the new tangent plane.
+		contact.acc_tangent_impulse = c.acc_tangent_impulse - contact.normal * contact.normal.dot(c.acc_tangent_impulse);
+	}
+
 	// figure out if the contact amount must be reduced to fit the new contact
 
 	if (new_index == MAX_CONTACTS) {
@@ -159,8 +169,61 @@ void BodyPair3DSW::validate_contacts() {
 	}
 }
 
+// Bound on how far any point inside p_aabb moved between two poses.
+static _FORCE_INLINE_ real_t _manifold_drift(const Transform &p_from, const Transform &p_to, const AABB &p_aabb) {
+	Vector3 begin = p_aabb.position.abs();
+	Vector3 end = (p_aabb.position + p_aabb.size).abs();
+	Vector3 corner(MAX(begin.x, end.x), MAX(begin.y, end.y), MAX(begin.z, end.z));
+
+	Basis delta = p_to.basis - p_from.basis;
+	real_t basis_drift = Math::sqrt(delta[0].length_squared() + delta[1].length_squared() + delta[2].length_squared());
+	return p_to.origin.distance_to(p_from.origin) + basis_drift * corner.length();
+}
+
+bool BodyPair3DSW::_can_reuse_manifold(const Transform &p_xform_A, const Transform &p_xform_B, const Shape3DSW *p_shape_A, const Shape3DSW *p_shape_B) const {
+	if (!manifold_cached || manifold_cached_steps >= MANIFOLD_MAX_CACHED_STEPS) {
+		return false;
+	}
+
+	if (p_shape_A != manifold_shape_A || p_shape_B != manifold_shape_B || p_shape_A->get_aabb() != manifold_aabb_A || p_shape_B->get_aabb() != manifold_aabb_B) {
+		return false;
+	}
+
+	Transform xform_A = p_xform_B.affine_inverse() * p_xform_A;
+
+	// Small shapes barely drift when they turn, but a corner can still come closer than the cached ones.
+	Basis rotation = xform_A.basis * manifold_xform_A.basis.inverse();
+	real_t cos_angle = (rotation[0][0] + rotation[1][1] + rotation[2][2] - 1) * 0.5;
+	if (cos_angle < Math::cos(MANIFOLD_MAX_ROTATION)) {
+		return false;
+	}
+
+	// Contacts lie on both shapes, so the relative motion measured over the smaller one is enough.
+	// It keeps a crate resting on a large concave floor from refreshing for every small rotation.
+	real_t drift_B = _manifold_drift(manifold_xform_B, p_xform_A.affine_inverse() * p_xform_B, manifold_aabb_B);
+	real_t drift_A = _manifold_drift(manifold_xform_A, xform_A, manifold_aabb_A);
+
+	return MIN(drift_A, drift_B) < space->get_contact_recycle_radius() * MANIFOLD_MAX_DRIFT_RATIO;
+}
+
+// Pose of a shape of A after a fraction of its motion, rotating around the center of mass.
+static _FORCE_INLINE_ Transform _ccd_transform(const Transform &p_xform, const Vector3 &p_center_of_mass, const Vector3 &p_motion, const Vector3 &p_rotation_axis, real_t p_rotation, real_t p_fraction) {
+	Transform xform = p_xform;
+	if (p_rotation != 0.0) {
+		Basis rot(p_rotation_axis, p_rotation * p_fraction);
+		xform.basis = rot * xform.basis;
+		xform.origin = p_center_of_mass + rot.xform(xform.origin - p_center_of_mass);
+	}
+	xform.origin += p_motion * p_fraction;
+	return xform;
+}
+
+// Sweeps A against a static or kinematic B. There is no substepping: a hit only shortens
+// A's motion for this step, which is all a substep would do for such a pair, without
+// solving the whole island several times. Fast bodies hitting dynamic ones are not swept.
 bool BodyPair3DSW::_test_ccd(real_t p_step, Body3DSW *p_A, int p_shape_A, const Transform &p_xform_A, Body3DSW *p_B, int p_shape_B, const Transform &p_xform_B) {
-	Vector3 motion = p_A->get_linear_velocity() * p_step;
+	// Motion relative to B, which is static or kinematic.
+	Vector3 motion = (p_A->get_linear_velocity() - p_B->get_linear_velocity()) * p_step;
 	real_t mlen = motion.length();
 	if (mlen < CMP_EPSILON) {
 		return false;
@@ -168,35 +231,80 @@ bool BodyPair3DSW::_test_ccd(real_t p_step, Body3DSW *p_A, int p_shape_A, const
 
 	Vector3 mnormal = motion / mlen;
 
+	const Shape3DSW *shape_A_ptr = p_A->get_shape(p_shape_A);
+	const Shape3DSW *shape_B_ptr = p_B->get_shape(p_shape_B);
+
+	if (shape_A_ptr->is_concave()) {
+		return false; // Distance queries need a convex moving shape.
+	}
+
 	real_t min, max;
-	p_A->get_shape(p_shape_A)->project_range(mnormal, p_xform_A, min, max);
+	shape_A_ptr->project_range(mnormal, p_xform_A, min, max);
 	bool fast_object = mlen > (max - min) * 0.3; //going too fast in that direction
 
-	if (!fast_object) { //did it move enough in this direction to even attempt raycast? let's say it should move more than 1/3 the size of the object in that axis
+	if (!fast_object) { //did it move enough in this direction to even attempt it? let's say it should move more than 1/3 the size of the object in that axis
 		return false;
 	}
 
-	//cast a segment from support in motion normal, in the same direction of motion by motion length
-	//support is the worst case collision point, so real collision happened before
-	Vector3 s = p_A->get_shape(p_shape_A)->get_support(p_xform_A.basis.xform(mnormal).normalized());
-	Vector3 from = p_xform_A.xform(s);
-	Vector3 to = from + motion;
+	Vector3 center_of_mass = p_A->get_center_of_mass();
+	Vector3 angular_velocity = p_A->get_angular_velocity();
+	real_t rotation = angular_velocity.length() * p_step;
+	Vector3 rotation_axis = rotation != 0.0 ? angular_velocity.normalized() : Vector3();
 
-	Transform from_inv = p_xform_B.affine_inverse();
+	// Farthest a point of the shape can get from the center of mass, bounds how fast rotation closes the gap.
+	AABB shape_aabb = p_xform_A.xform(shape_A_ptr->get_aabb());
+	real_t radius = (shape_aabb.position + shape_aabb.size * 0.5 - center_of_mass).length() + shape_aabb.size.length() * 0.5;
+	real_t rotation_bound = rotation * radius;
 
-	Vector3 local_from = from_inv.xform(from - mnormal * mlen * 0.1); //start from a little inside the bounding box
-	Vector3 local_to = from_inv.xform(to);
+	// A concave B is a soup of convex pieces, the closest piece may not be the one ahead, so only the full speed is a safe bound.
+	bool full_speed_bound = shape_B_ptr->is_concave();
 
-	Vector3 rpos, rnorm;
-	if (!p_B->get_shape(p_shape_B)->intersect_segment(local_from, local_to, rpos, rnorm)) {
-		return false;
-	}
+	AABB sweep_aabb = shape_aabb.merge(AABB(shape_aabb.position + motion, shape_aabb.size)).grow(rotation_bound);
+
+	real_t tolerance = (max - min) * 0.01;
+
+	// Conservative advancement: move A forward by the distance it is guaranteed not to cover before touching B.
+	real_t toi = 0;
+	real_t distance = 0;
+	Vector3 normal;
+	for (int i = 0; i < CCD_MAX_ITERATIONS; i++) {
+		Transform xform = _ccd_transform(p_xform_A, center_of_mass, motion, rotation_axis, rotation, toi);
+
+		Vector3 point_A, point_B;
+		if (!CollisionSolver3DSW::solve_distance(shape_A_ptr, xform, shape_B_ptr, p_xform_B, point_A, point_B, sweep_aabb)) {
+			if (toi == 0) {
+				return false; // Already touching, regular contacts take care of it.
+			}
+			break; // Advancement never overshoots, so this can only be numerical noise.
+		}
+
+		Vector3 gap = point_B - point_A;
+		distance = gap.length();
+		normal = distance > CMP_EPSILON ? gap / distance : mnormal;
+		if (distance < tolerance) {
+			break; // Also when A starts this close, it would skip over B otherwise.
+		}
 
-	//shorten the linear velocity so it does not hit, but gets close enough, next frame will hit softly or soft enough
-	Vector3 hitpos = p_xform_B.xform(rpos);
+		real_t closing = (full_speed_bound ? mlen : motion.dot(normal)) + rotation_bound;
+		if (closing <= CMP_EPSILON) {
+			return false; // Moving away.
+		}
 
-	real_t newlen = hitpos.distance_to(from) - (max - min) * 0.01;
-	p_A->set_linear_velocity((mnormal * newlen) / p_step);
+		toi += (distance - tolerance * 0.5) / closing;
+		if (toi >= 1) {
+			return false;
+		}
+	}
+
+	// Stopping A right before B would leave no contact for the next step, which then
+	// skips over B. Move it slightly into B instead, the next step finds the contact
+	// and solves it with the velocity A keeps.
+	real_t approach = motion.dot(normal);
+	if (approach <= CMP_EPSILON) {
+		return false; // Only rotating into B, regular contacts take care of it.
+	}
+	toi = MIN(toi + (distance + tolerance) / approach, (real_t)1.0);
+	p_A->limit_motion(toi);
 
 	return true;
 }
@@ -213,18 +321,18 @@ bool BodyPair3DSW::setup(real_t p_step) {
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self()) || (A->get_mode() <= PhysicsServer3D::BODY_MODE_KINEMATIC && B->get_mode() <= PhysicsServer3D::BODY_MODE_KINEMATIC && A->get_max_contacts_reported() == 0 && B->get_max_contacts_reported() == 0)) {
 		collided = false;
+		manifold_cached = false;
 		return false;
 	}
 
 	if (A->is_shape_set_as_disabled(shape_A) || B->is_shape_set_as_disabled(shape_B)) {
 		collided = false;
+		manifold_cached = false;
 		return false;
 	}
 
 	offset_B = B->get_transform().get_origin() - A->get_transform().get_origin();
 
-	validate_contacts();
-
 	Vector3 offset_A = A->get_transform().get_origin();
 	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
 	Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
@@ -236,11 +344,36 @@ bool BodyPair3DSW::setup(real_t p_step) {
 	Shape3DSW *shape_A_ptr = A->get_shape(shape_A);
 	Shape3DSW *shape_B_ptr = B->get_shape(shape_B);
 
-	bool collided = CollisionSolver3DSW::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
-	this->collided = collided;
+	bool reuse_manifold = _can_reuse_manifold(xform_A, xform_B, shape_A_ptr, shape_B_ptr);
+
+	if (reuse_manifold && xform_Au.basis != last_basis_A) {
+		Basis rotation = xform_Au.basis * last_basis_A.inverse();
+		for (int i = 0; i < contact_count; i++) {
+			contacts[i].normal = rotation.xform(contacts[i].normal).normalized();
+		}
+	}
+	last_basis_A = xform_Au.basis;
+
+	validate_contacts();
+
+	if (reuse_manifold) {
+		// The shapes barely moved relative to each other, the narrowphase would find the same contacts.
+		manifold_cached_steps++;
+	} else {
+		collided = CollisionSolver3DSW::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
+
+		manifold_cached = true;
+		manifold_cached_steps = 0;
+		manifold_xform_A = xform_B.affine_inverse() * xform_A;
+		manifold_xform_B = xform_A.affine_inverse() * xform_B;
+		manifold_shape_A = shape_A_ptr;
+		manifold_shape_B = shape_B_ptr;
+		manifold_aabb_A = shape_A_ptr->get_aabb();
+		manifold_aabb_B = shape_B_ptr->get_aabb();
+	}
 
 	if (!collided) {
-		//test ccd (currently just a raycast)
+		//test ccd
 
 		if (A->is_continuous_collision_detection_enabled() && A->get_mode() > PhysicsServer3D::BODY_MODE_KINEMATIC && B->get_mode() <= PhysicsServer3D::BODY_MODE_KINEMATIC) {
 			_test_ccd(p_step, A, shape_A, xform_A, B, shape_B, xform_B);
@@ -367,8 +500,8 @@ void BodyPair3DSW::solve(real_t p_step) {
 
 			Vector3 jb = c.normal * (c.acc_bias_impulse - jbnOld);
 
-			A->apply_bias_impulse(c.rA + A->get_center_of_mass(), -jb, MAX_BIAS_ROTATION / p_step);
-			B->apply_bias_impulse(c.rB + B->get_center_of_mass(), jb, MAX_BIAS_ROTATION / p_step);
+			A->apply_bias_impulse(-jb, c.rA + A->get_center_of_mass(), MAX_BIAS_ROTATION / p_step);
+			B->apply_bias_impulse(jb, c.rB + B->get_center_of_mass(), MAX_BIAS_ROTATION / p_step);
 
 			crbA = A->get_biased_angular_velocity().cross(c.rA);
 			crbB = B->get_biased_angular_velocity().cross(c.rB);
@@ -383,8 +516,8 @@ void BodyPair3DSW::solve(real_t p_step) {
 
 				Vector3 jb_com = c.normal * (c.acc_bias_impulse_center_of_mass - jbnOld_com);
 
-				A->apply_bias_impulse(A->get_center_of_mass(), -jb_com, 0.0f);
-				B->apply_bias_impulse(B->get_center_of_mass(), jb_com, 0.0f);
+				A->apply_bias_impulse(-jb_com, A->get_center_of_mass(), 0.0f);
+				B->apply_bias_impulse(jb_com, B->get_center_of_mass(), 0.0f);
 			}
 
 			c.active = true;
@@ -36,7 +36,9 @@
 
 class BodyPair3DSW : public Constraint3DSW {
 	enum {
-		MAX_CONTACTS = 4
+		MAX_CONTACTS = 4,
+		CCD_MAX_ITERATIONS = 16,
+		MANIFOLD_MAX_CACHED_STEPS = 30, // Shapes can change without moving, refresh the contacts now and then.
 	};
 
 	union {
@@ -75,11 +77,24 @@ class BodyPair3DSW : public Constraint3DSW {
 	int contact_count;
 	bool collided;
 
+	// Narrowphase input the contacts were generated for, while the shapes keep
+	// their relative pose the contacts and their impulses are reused as they are.
+	bool manifold_cached = false;
+	int manifold_cached_steps = 0;
+	Transform manifold_xform_A; // Shape A in the space of shape B.
+	Transform manifold_xform_B; // Shape B in the space of shape A.
+	const Shape3DSW *manifold_shape_A = nullptr;
+	const Shape3DSW *manifold_shape_B = nullptr;
+	AABB manifold_aabb_A;
+	AABB manifold_aabb_B;
+	Basis last_basis_A; // Contact normals are in world orientation, they follow A.
+
 	static void _contact_added_callback(const Vector3 &p_point_A, const Vector3 &p_point_B, void *p_userdata);
 
 	void contact_added_callback(const Vector3 &p_point_A, const Vector3 &p_point_B);
 
 	void validate_contacts();
+	bool _can_reuse_manifold(const Transform &p_xform_A, const Transform &p_xform_B, const Shape3DSW *p_shape_A, const Shape3DSW *p_shape_B) const;
 	bool _test_ccd(real_t p_step, Body3DSW *p_A, int p_shape_A, const Transform &p_xform_A, Body3DSW *p_B, int p_shape_B, const Transform &p_xform_B);
 
 	Space3DSW *space;
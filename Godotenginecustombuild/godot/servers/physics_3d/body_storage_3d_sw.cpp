@@ -0,0 +1,263 @@
+/*************************************************************************/
+/*  body_storage_3d_sw.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "body_storage_3d_sw.h"
+
+// Every per body array, keep in sync with the header.
+#define BODY_STORAGE_FIELDS(m)        \
+	m(body);                          \
+	m(handle);                        \
+	m(transform);                     \
+	m(linear_velocity);               \
+	m(angular_velocity);              \
+	m(biased_linear_velocity);        \
+	m(biased_angular_velocity);       \
+	m(force);                         \
+	m(torque);                        \
+	m(linear_damp);                   \
+	m(angular_damp);                  \
+	m(inv_mass);                      \
+	m(inv_inertia);                   \
+	m(principal_inertia_axes_local);  \
+	m(center_of_mass_local);          \
+	m(inv_inertia_tensor);            \
+	m(principal_inertia_axes);        \
+	m(center_of_mass);                \
+	m(motion_limit);                  \
+	m(still_time);                    \
+	m(island_step);                   \
+	m(locked_axis);                   \
+	m(flags)
+
+void BodyStorage3DSW::_resize(uint32_t p_size) {
+#define RESIZE_FIELD(m_field) m_field.resize(p_size)
+	BODY_STORAGE_FIELDS(RESIZE_FIELD);
+#undef RESIZE_FIELD
+}
+
+void BodyStorage3DSW::_swap(uint32_t p_a, uint32_t p_b) {
+	if (p_a == p_b) {
+		return;
+	}
+
+#define SWAP_FIELD(m_field) SWAP(m_field[p_a], m_field[p_b])
+	BODY_STORAGE_FIELDS(SWAP_FIELD);
+#undef SWAP_FIELD
+
+	handle_index[handle[p_a]] = p_a;
+	handle_index[handle[p_b]] = p_b;
+}
+
+uint32_t BodyStorage3DSW::create(Body3DSW *p_body) {
+	uint32_t h;
+	if (free_handle != INVALID_HANDLE) {
+		h = free_handle;
+		free_handle = handle_index[h];
+	} else {
+		h = handle_index.size();
+		handle_index.push_back(0);
+	}
+
+	// New bodies start asleep, at the end of the arrays.
+	uint32_t index = size();
+	_resize(index + 1);
+	handle_index[h] = index;
+
+	body[index] = p_body;
+	handle[index] = h;
+	transform[index] = Transform();
+	linear_velocity[index] = Vector3();
+	angular_velocity[index] = Vector3();
+	biased_linear_velocity[index] = Vector3();
+	biased_angular_velocity[index] = Vector3();
+	force[index] = Vector3();
+	torque[index] = Vector3();
+	linear_damp[index] = 0;
+	angular_damp[index] = 0;
+	inv_mass[index] = 1;
+	inv_inertia[index] = Vector3();
+	principal_inertia_axes_local[index] = Basis();
+	center_of_mass_local[index] = Vector3();
+	inv_inertia_tensor[index] = Basis();
+	principal_inertia_axes[index] = Basis();
+	center_of_mass[index] = Vector3();
+	motion_limit[index] = 1;
+	still_time[index] = 0;
+	island_step[index] = 0;
+	locked_axis[index] = 0;
+	flags[index] = 0;
+
+	return h;
+}
+
+void BodyStorage3DSW::free(uint32_t p_handle) {
+	set_active(p_handle, false);
+
+	uint32_t last = size() - 1;
+	_swap(handle_index[p_handle], last);
+	_resize(last);
+
+	handle_index[p_handle] = free_handle;
+	free_handle = p_handle;
+}
+
+uint32_t BodyStorage3DSW::transfer(uint32_t p_handle, BodyStorage3DSW &p_to) {
+	uint32_t from = handle_index[p_handle];
+	uint32_t to_handle = p_to.create(body[from]);
+	uint32_t to = p_to.handle_index[to_handle];
+
+#define COPY_FIELD(m_field) p_to.m_field[to] = m_field[from]
+	COPY_FIELD(transform);
+	COPY_FIELD(linear_velocity);
+	COPY_FIELD(angular_velocity);
+	COPY_FIELD(biased_linear_velocity);
+	COPY_FIELD(biased_angular_velocity);
+	COPY_FIELD(force);
+	COPY_FIELD(torque);
+	COPY_FIELD(linear_damp);
+	COPY_FIELD(angular_damp);
+	COPY_FIELD(inv_mass);
+	COPY_FIELD(inv_inertia);
+	COPY_FIELD(principal_inertia_axes_local);
+	COPY_FIELD(center_of_mass_local);
+	COPY_FIELD(inv_inertia_tensor);
+	COPY_FIELD(principal_inertia_axes);
+	COPY_FIELD(center_of_mass);
+	COPY_FIELD(motion_limit);
+	COPY_FIELD(still_time);
+	COPY_FIELD(island_step);
+	COPY_FIELD(locked_axis);
+	COPY_FIELD(flags);
+#undef COPY_FIELD
+
+	free(p_handle);
+	return to_handle;
+}
+
+void BodyStorage3DSW::set_active(uint32_t p_handle, bool p_active) {
+	uint32_t index = handle_index[p_handle];
+	if (p_active) {
+		if (index >= active_count) {
+			_swap(index, active_count);
+			active_count++;
+		}
+	} else if (index < active_count) {
+		active_count--;
+		_swap(index, active_count);
+	}
+}
+
+void BodyStorage3DSW::integrate_forces(uint32_t p_from, uint32_t p_to, real_t p_step) {
+	Vector3 *lv = linear_velocity.ptr();
+	Vector3 *av = angular_velocity.ptr();
+	Vector3 *blv = biased_linear_velocity.ptr();
+	Vector3 *bav = biased_angular_velocity.ptr();
+	Vector3 *f = force.ptr();
+	Vector3 *t = torque.ptr();
+	const real_t *ld = linear_damp.ptr();
+	const real_t *ad = angular_damp.ptr();
+	const real_t *im = inv_mass.ptr();
+	const Basis *iit = inv_inertia_tensor.ptr();
+	const uint8_t *fl = flags.ptr();
+
+	for (uint32_t i = p_from; i < p_to; i++) {
+		if (fl[i] & FLAG_INTEGRATE_FORCES) {
+			// Reaching zero in the given time clamps the damping.
+			real_t damp = MAX(1.0 - p_step * ld[i], 0.0);
+			real_t angular = MAX(1.0 - p_step * ad[i], 0.0);
+
+			lv[i] = lv[i] * damp + f[i] * (im[i] * p_step);
+			av[i] = av[i] * angular + iit[i].xform(t[i]) * p_step;
+		}
+
+		f[i] = Vector3();
+		t[i] = Vector3();
+		blv[i] = Vector3();
+		bav[i] = Vector3();
+	}
+}
+
+void BodyStorage3DSW::integrate_velocities(uint32_t p_from, uint32_t p_to, real_t p_step) {
+	Transform *tr = transform.ptr();
+	Vector3 *lv = linear_velocity.ptr();
+	Vector3 *av = angular_velocity.ptr();
+	Vector3 *blv = biased_linear_velocity.ptr();
+	Vector3 *bav = biased_angular_velocity.ptr();
+	const Vector3 *coml = center_of_mass_local.ptr();
+	real_t *ml = motion_limit.ptr();
+	const uint16_t *la = locked_axis.ptr();
+	const uint8_t *fl = flags.ptr();
+
+	const Basis identity3(1, 0, 0, 0, 1, 0, 0, 0, 1);
+
+	for (uint32_t i = p_from; i < p_to; i++) {
+		if (la[i]) {
+			for (int axis = 0; axis < 3; axis++) {
+				if (la[i] & (1 << axis)) {
+					lv[i][axis] = 0;
+					blv[i][axis] = 0;
+				}
+				if (la[i] & (1 << (axis + 3))) {
+					av[i][axis] = 0;
+					bav[i][axis] = 0;
+				}
+			}
+		}
+
+		// Continuous collision detection may have found an impact within this step, only move up to it.
+		real_t motion_step = p_step * ml[i];
+		ml[i] = 1.0;
+
+		if (!(fl[i] & FLAG_INTEGRATE_VELOCITIES)) {
+			continue;
+		}
+
+		Transform &t = tr[i];
+
+		Vector3 total_angular_velocity = av[i] + bav[i];
+		real_t ang_vel = total_angular_velocity.length();
+		if (ang_vel != 0.0) {
+			Vector3 ang_vel_axis = total_angular_velocity / ang_vel;
+			Basis rot(ang_vel_axis, ang_vel * motion_step);
+			t.origin += ((identity3 - rot) * t.basis).xform(coml[i]);
+			t.basis = rot * t.basis;
+			t.orthonormalize();
+		}
+
+		t.origin += (lv[i] + blv[i]) * motion_step;
+	}
+
+	// Separate pass, it vectorizes better on its own.
+	for (uint32_t i = p_from; i < p_to; i++) {
+		if (fl[i] & FLAG_INTEGRATE_VELOCITIES) {
+			update_transform_dependant(i);
+		}
+	}
+}
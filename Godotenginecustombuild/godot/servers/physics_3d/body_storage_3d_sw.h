@@ -0,0 +1,126 @@
+/*************************************************************************/
+/*  body_storage_3d_sw.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef BODY_STORAGE_3D_SW_H
+#define BODY_STORAGE_3D_SW_H
+
+#include "core/math/transform.h"
+#include "core/templates/local_vector.h"
+
+class Body3DSW;
+
+// Hot simulation state of the bodies of a space, one dense array per field so
+// integrating them is a linear pass. The arrays are kept packed with the active
+// bodies first, sleeping bodies are never visited by the step. Bodies refer to
+// their slot through a handle, which stays valid while they remain in the space.
+class BodyStorage3DSW {
+public:
+	enum {
+		INVALID_HANDLE = 0xFFFFFFFF,
+	};
+
+	enum Flags {
+		FLAG_INTEGRATE_FORCES = 1,
+		FLAG_INTEGRATE_VELOCITIES = 2,
+	};
+
+private:
+	LocalVector<uint32_t> handle_index; // Index of each handle in the arrays, or the next free handle.
+	uint32_t free_handle = INVALID_HANDLE;
+	uint32_t active_count = 0;
+
+	void _resize(uint32_t p_size);
+	void _swap(uint32_t p_a, uint32_t p_b);
+
+public:
+	LocalVector<Body3DSW *> body;
+	LocalVector<uint32_t> handle;
+
+	LocalVector<Transform> transform;
+	LocalVector<Vector3> linear_velocity;
+	LocalVector<Vector3> angular_velocity;
+	LocalVector<Vector3> biased_linear_velocity;
+	LocalVector<Vector3> biased_angular_velocity;
+
+	// Set up by the bodies before integrating forces, consumed by it.
+	LocalVector<Vector3> force;
+	LocalVector<Vector3> torque;
+	LocalVector<real_t> linear_damp;
+	LocalVector<real_t> angular_damp;
+
+	LocalVector<real_t> inv_mass;
+	LocalVector<Vector3> inv_inertia; // Relative to the principal axes of inertia
+
+	// Relative to the local frame of reference
+	LocalVector<Basis> principal_inertia_axes_local;
+	LocalVector<Vector3> center_of_mass_local;
+
+	// In world orientation with local origin
+	LocalVector<Basis> inv_inertia_tensor;
+	LocalVector<Basis> principal_inertia_axes;
+	LocalVector<Vector3> center_of_mass;
+
+	LocalVector<real_t> motion_limit; // Fraction of the step's motion that is free of tunneling, lowered by continuous collision detection.
+	LocalVector<real_t> still_time;
+	LocalVector<uint64_t> island_step;
+	LocalVector<uint16_t> locked_axis;
+	LocalVector<uint8_t> flags;
+
+	_FORCE_INLINE_ uint32_t get_index(uint32_t p_handle) const { return handle_index[p_handle]; }
+	_FORCE_INLINE_ uint32_t size() const { return body.size(); }
+	_FORCE_INLINE_ uint32_t get_active_count() const { return active_count; }
+	_FORCE_INLINE_ bool is_active(uint32_t p_handle) const { return handle_index[p_handle] < active_count; }
+
+	uint32_t create(Body3DSW *p_body);
+	void free(uint32_t p_handle);
+	// Moves the state to another storage, returns the handle there.
+	uint32_t transfer(uint32_t p_handle, BodyStorage3DSW &p_to);
+	// Moves the slot in or out of the active range, this changes the index of other active bodies.
+	void set_active(uint32_t p_handle, bool p_active);
+
+	_FORCE_INLINE_ void update_transform_dependant(uint32_t p_index) {
+		const Basis &basis = transform[p_index].basis;
+		center_of_mass[p_index] = basis.xform(center_of_mass_local[p_index]);
+		principal_inertia_axes[p_index] = basis * principal_inertia_axes_local[p_index];
+
+		// update inertia tensor
+		Basis tb = principal_inertia_axes[p_index];
+		Basis tbt = tb.transposed();
+		Basis diag;
+		diag.scale(inv_inertia[p_index]);
+		inv_inertia_tensor[p_index] = tb * diag * tbt;
+	}
+
+	// Only touch the given range, so batches can run on different threads.
+	void integrate_forces(uint32_t p_from, uint32_t p_to, real_t p_step);
+	void integrate_velocities(uint32_t p_from, uint32_t p_to, real_t p_step);
+};
+
+#endif // BODY_STORAGE_3D_SW_H
@@ -0,0 +1,213 @@
+/*************************************************************************/
+/*  gravity_field_3d_sw.cpp                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gravity_field_3d_sw.h"
+
+#include "core/math/aabb.h"
+
+void GravityField3DSW::clear() {
+	nodes.clear();
+	positions.clear();
+	unsorted_masses.clear();
+}
+
+void GravityField3DSW::add_attractor(const Vector3 &p_position, real_t p_mass) {
+	positions.push_back(p_position);
+	unsorted_masses.push_back(p_mass);
+}
+
+void GravityField3DSW::_build_node(uint32_t p_node, const Vector3 &p_center, real_t p_half_size, int p_depth) {
+	uint32_t begin = nodes[p_node].begin;
+	uint32_t end = nodes[p_node].end;
+
+	real_t mass = 0;
+	Vector3 weighted;
+	for (uint32_t i = begin; i < end; i++) {
+		uint32_t idx = order[i];
+		mass += unsorted_masses[idx];
+		weighted += positions[idx] * unsorted_masses[idx];
+	}
+
+	nodes[p_node].mass = mass;
+	nodes[p_node].mass_center = weighted / mass;
+	nodes[p_node].size = p_half_size * 2.0;
+
+	if (end - begin <= LEAF_MAX_ATTRACTORS || p_depth >= MAX_DEPTH) {
+		return;
+	}
+
+	// Counting sort of the range into the eight octants.
+	uint32_t counts[8] = {};
+	for (uint32_t i = begin; i < end; i++) {
+		const Vector3 &p = positions[order[i]];
+		int octant = (p.x >= p_center.x ? 1 : 0) | (p.y >= p_center.y ? 2 : 0) | (p.z >= p_center.z ? 4 : 0);
+		counts[octant]++;
+	}
+
+	uint32_t offsets[8];
+	uint32_t ofs = begin;
+	for (int i = 0; i < 8; i++) {
+		offsets[i] = ofs;
+		ofs += counts[i];
+	}
+
+	for (uint32_t i = begin; i < end; i++) {
+		const Vector3 &p = positions[order[i]];
+		int octant = (p.x >= p_center.x ? 1 : 0) | (p.y >= p_center.y ? 2 : 0) | (p.z >= p_center.z ? 4 : 0);
+		order_tmp[offsets[octant]++] = order[i];
+	}
+	for (uint32_t i = begin; i < end; i++) {
+		order[i] = order_tmp[i];
+	}
+
+	uint32_t first_child = nodes.size();
+	uint32_t child_count = 0;
+	int child_octants[8];
+	ofs = begin;
+	for (int i = 0; i < 8; i++) {
+		if (counts[i] == 0) {
+			continue;
+		}
+		Node child;
+		child.begin = ofs;
+		child.end = ofs + counts[i];
+		nodes.push_back(child);
+		child_octants[child_count++] = i;
+		ofs += counts[i];
+	}
+
+	nodes[p_node].first_child = first_child;
+	nodes[p_node].child_count = child_count;
+
+	real_t quarter = p_half_size * 0.5;
+	for (uint32_t i = 0; i < child_count; i++) {
+		int octant = child_octants[i];
+		Vector3 center = p_center;
+		center.x += (octant & 1) ? quarter : -quarter;
+		center.y += (octant & 2) ? quarter : -quarter;
+		center.z += (octant & 4) ? quarter : -quarter;
+		_build_node(first_child + i, center, quarter, p_depth + 1);
+	}
+}
+
+void GravityField3DSW::build(real_t p_theta, real_t p_softening) {
+	nodes.clear();
+	theta = CLAMP(p_theta, 0, 1);
+	softening = MAX(p_softening, 0);
+
+	uint32_t count = positions.size();
+	if (count == 0) {
+		return;
+	}
+
+	AABB bounds(positions[0], Vector3());
+	for (uint32_t i = 1; i < count; i++) {
+		bounds.expand_to(positions[i]);
+	}
+	real_t half_size = MAX(bounds.get_longest_axis_size() * 0.5, CMP_EPSILON);
+
+	order.resize(count);
+	order_tmp.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		order[i] = i;
+	}
+
+	Node root;
+	root.end = count;
+	nodes.push_back(root);
+	_build_node(0, bounds.position + bounds.size * 0.5, half_size, 0);
+
+	// Leaves point into these, in tree order.
+	pos_x.resize(count);
+	pos_y.resize(count);
+	pos_z.resize(count);
+	masses.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		const Vector3 &p = positions[order[i]];
+		pos_x[i] = p.x;
+		pos_y[i] = p.y;
+		pos_z[i] = p.z;
+		masses[i] = unsorted_masses[order[i]];
+	}
+}
+
+Vector3 GravityField3DSW::evaluate(const Vector3 &p_position) const {
+	Vector3 accel;
+	if (nodes.size() == 0) {
+		return accel;
+	}
+
+	const real_t theta2 = theta * theta;
+	const real_t softening2 = softening * softening;
+	const real_t *px = pos_x.ptr();
+	const real_t *py = pos_y.ptr();
+	const real_t *pz = pos_z.ptr();
+	const real_t *pm = masses.ptr();
+
+	// Every level pops one node and pushes at most eight.
+	uint32_t stack[MAX_DEPTH * 8 + 1];
+	int stack_size = 1;
+	stack[0] = 0;
+
+	while (stack_size) {
+		const Node &node = nodes[stack[--stack_size]];
+
+		if (node.child_count == 0) {
+			real_t ax = 0, ay = 0, az = 0;
+			for (uint32_t i = node.begin; i < node.end; i++) {
+				real_t dx = px[i] - p_position.x;
+				real_t dy = py[i] - p_position.y;
+				real_t dz = pz[i] - p_position.z;
+				real_t d2 = dx * dx + dy * dy + dz * dz + softening2;
+				// A body does not attract itself, d2 is zero for it unless softened.
+				real_t f = d2 > 0 ? pm[i] / (d2 * Math::sqrt(d2)) : 0;
+				ax += dx * f;
+				ay += dy * f;
+				az += dz * f;
+			}
+			accel += Vector3(ax, ay, az);
+			continue;
+		}
+
+		Vector3 d = node.mass_center - p_position;
+		real_t d2 = d.length_squared();
+		if (node.size * node.size < theta2 * d2) {
+			// Far enough to be seen as a single mass.
+			d2 += softening2;
+			accel += d * (node.mass / (d2 * Math::sqrt(d2)));
+		} else {
+			for (uint32_t i = 0; i < node.child_count; i++) {
+				stack[stack_size++] = node.first_child + i;
+			}
+		}
+	}
+
+	return accel;
+}
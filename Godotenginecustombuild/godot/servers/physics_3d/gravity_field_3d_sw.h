@@ -0,0 +1,85 @@
+/*************************************************************************/
+/*  gravity_field_3d_sw.h                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GRAVITY_FIELD_3D_SW_H
+#define GRAVITY_FIELD_3D_SW_H
+
+#include "core/math/vector3.h"
+#include "core/templates/local_vector.h"
+
+// Barnes-Hut octree over the gravity attractors of a space. Built once per
+// step, then evaluated for every body (read only, so from any thread).
+class GravityField3DSW {
+	enum {
+		LEAF_MAX_ATTRACTORS = 8,
+		MAX_DEPTH = 24,
+	};
+
+	struct Node {
+		Vector3 mass_center;
+		real_t mass = 0;
+		real_t size = 0; // Edge length of the cell.
+		uint32_t first_child = 0;
+		uint32_t child_count = 0;
+		uint32_t begin = 0; // Range in the attractor arrays, used by leaves.
+		uint32_t end = 0;
+	};
+
+	LocalVector<Node> nodes;
+
+	// Attractors, kept as separate arrays so the leaf loop vectorizes.
+	LocalVector<real_t> pos_x;
+	LocalVector<real_t> pos_y;
+	LocalVector<real_t> pos_z;
+	LocalVector<real_t> masses;
+
+	LocalVector<uint32_t> order;
+	LocalVector<uint32_t> order_tmp;
+	LocalVector<Vector3> positions;
+	LocalVector<real_t> unsorted_masses;
+
+	real_t theta = 0.5;
+	real_t softening = 0;
+
+	void _build_node(uint32_t p_node, const Vector3 &p_center, real_t p_half_size, int p_depth);
+
+public:
+	void clear();
+	void add_attractor(const Vector3 &p_position, real_t p_mass);
+	void build(real_t p_theta, real_t p_softening);
+
+	_FORCE_INLINE_ bool is_empty() const { return nodes.size() == 0; }
+	_FORCE_INLINE_ uint32_t get_attractor_count() const { return masses.size(); }
+
+	// Acceleration at p_position for a gravitational constant of 1.
+	Vector3 evaluate(const Vector3 &p_position) const;
+};
+
+#endif // GRAVITY_FIELD_3D_SW_H
@@ -31,7 +31,9 @@
 #include "physics_server_3d_sw.h"
 
 #include "broad_phase_3d_basic.h"
+#include "broad_phase_bvh.h"
 #include "broad_phase_octree.h"
+#include "core/config/project_settings.h"
 #include "core/debugger/engine_debugger.h"
 #include "core/os/os.h"
 #include "joints/cone_twist_joint_3d_sw.h"
@@ -174,7 +176,7 @@ real_t PhysicsServer3DSW::space_get_param(RID p_space, SpaceParameter p_param) c
 PhysicsDirectSpaceState3D *PhysicsServer3DSW::space_get_direct_state(RID p_space) {
 	Space3DSW *space = space_owner.getornull(p_space);
 	ERR_FAIL_COND_V(!space, nullptr);
-	ERR_FAIL_COND_V_MSG(space->is_locked(), nullptr, "Space state is inaccessible right now, wait for iteration or physics process notification.");
+	ERR_FAIL_COND_V_MSG((using_threads && !doing_sync) || space->is_locked(), nullptr, "Space state is inaccessible right now, wait for iteration or physics process notification.");
 
 	return space->get_direct_state();
 }
@@ -888,7 +890,7 @@ int PhysicsServer3DSW::body_test_ray_separation(RID p_body, const Transform &p_t
 PhysicsDirectBodyState3D *PhysicsServer3DSW::body_get_direct_state(RID p_body) {
 	Body3DSW *body = body_owner.getornull(p_body);
 	ERR_FAIL_COND_V(!body, nullptr);
-	ERR_FAIL_COND_V_MSG(body->get_space()->is_locked(), nullptr, "Body state is inaccessible right now, wait for iteration or physics process notification.");
+	ERR_FAIL_COND_V_MSG((using_threads && !doing_sync) || body->get_space()->is_locked(), nullptr, "Body state is inaccessible right now, wait for iteration or physics process notification.");
 
 	direct_state->body = body;
 	return direct_state;
@@ -1287,13 +1289,15 @@ void PhysicsServer3DSW::set_active(bool p_active) {
 };
 
 void PhysicsServer3DSW::init() {
+	doing_sync = false;
 	last_step = 0.001;
 	iterations = 8; // 8?
 	stepper = memnew(Step3DSW);
 	direct_state = memnew(PhysicsDirectBodyState3DSW);
+	query_work_pool.init();
 };
 
-void PhysicsServer3DSW::step(real_t p_step) {
+void PhysicsServer3DSW::step(float p_step) {
 #ifndef _3D_DISABLED
 
 	if (!active) {
@@ -1317,6 +1321,10 @@ void PhysicsServer3DSW::step(real_t p_step) {
 #endif
 }
 
+void PhysicsServer3DSW::sync() {
+	doing_sync = true;
+};
+
 void PhysicsServer3DSW::flush_queries() {
 #ifndef _3D_DISABLED
 
@@ -1361,6 +1369,26 @@ void PhysicsServer3DSW::flush_queries() {
 			values[i * 2 + 0] = time_name[i];
 			values[i * 2 + 1] = USEC_TO_SEC(total_time[i]);
 		}
+		// Work done by each thread of the step, only the parallel phases have more than one.
+		uint32_t thread_count = 0;
+		for (Set<const Space3DSW *>::Element *E = active_spaces.front(); E; E = E->next()) {
+			thread_count = MAX(thread_count, E->get()->get_elapsed_time_thread_count());
+		}
+		for (uint32_t t = 0; t < thread_count; t++) {
+			for (int i = 0; i < Space3DSW::ELAPSED_TIME_MAX; i++) {
+				uint64_t thread_time = 0;
+				for (Set<const Space3DSW *>::Element *E = active_spaces.front(); E; E = E->next()) {
+					if (t < E->get()->get_elapsed_time_thread_count()) {
+						thread_time += E->get()->get_thread_elapsed_time(Space3DSW::ElapsedTime(i), t);
+					}
+				}
+				if (thread_time) {
+					values.push_back(String(time_name[i]) + "_thread_" + itos(t));
+					values.push_back(USEC_TO_SEC(thread_time));
+				}
+			}
+		}
+
 		values.push_back("flush_queries");
 		values.push_back(USEC_TO_SEC(OS::get_singleton()->get_ticks_usec() - time_beg));
 
@@ -1370,9 +1398,14 @@ void PhysicsServer3DSW::flush_queries() {
 #endif
 };
 
+void PhysicsServer3DSW::end_sync() {
+	doing_sync = false;
+};
+
 void PhysicsServer3DSW::finish() {
 	memdelete(stepper);
 	memdelete(direct_state);
+	query_work_pool.finish();
 };
 
 int PhysicsServer3DSW::get_process_info(ProcessInfo p_info) {
@@ -1434,11 +1467,17 @@ void PhysicsServer3DSW::_shape_col_cbk(const Vector3 &p_point_A, const Vector3 &
 PhysicsServer3DSW *PhysicsServer3DSW::singleton = nullptr;
 PhysicsServer3DSW::PhysicsServer3DSW() {
 	singleton = this;
-	BroadPhase3DSW::create_func = BroadPhaseOctree::_create;
+	if (GLOBAL_DEF("physics/3d/use_bvh", true)) {
+		BroadPhase3DSW::create_func = BroadPhaseBVH::_create;
+	} else {
+		BroadPhase3DSW::create_func = BroadPhaseOctree::_create;
+	}
 	island_count = 0;
 	active_objects = 0;
 	collision_pairs = 0;
 
 	active = true;
 	flushing_queries = false;
+	doing_sync = false;
+	using_threads = int(ProjectSettings::get_singleton()->get("physics/3d/thread_model")) == 2;
 };
@@ -50,11 +50,20 @@ class PhysicsServer3DSW : public PhysicsServer3D {
 	int active_objects;
 	int collision_pairs;
 
+	bool using_threads;
+
+	bool doing_sync;
+
 	bool flushing_queries;
 
 	Step3DSW *stepper;
 	Set<const Space3DSW *> active_spaces;
 
+	// Narrow phase of batched space queries, separate from the stepper's pool so queries
+	// made while a space steps on another thread don't need it.
+	ThreadWorkPool query_work_pool;
+	BinaryMutex query_work_pool_mutex;
+
 	PhysicsDirectBodyState3DSW *direct_state;
 
 	mutable RID_PtrOwner<Shape3DSW> shape_owner;
@@ -363,8 +372,10 @@ public:
 
 	virtual void set_active(bool p_active) override;
 	virtual void init() override;
-	virtual void step(real_t p_step) override;
+	virtual void step(float p_step) override;
+	virtual void sync() override;
 	virtual void flush_queries() override;
+	virtual void end_sync() override;
 	virtual void finish() override;
 
 	virtual bool is_flushing_queries() const override { return flushing_queries; }
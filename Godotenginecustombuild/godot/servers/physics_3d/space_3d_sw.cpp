@@ -97,6 +97,41 @@ int PhysicsDirectSpaceState3DSW::intersect_point(const Vector3 &p_point, ShapeRe
 	return cc;
 }
 
+// Point and normal are returned in global coordinates.
+static bool _intersect_ray_shape(const CollisionObject3DSW *p_col_obj, int p_shape_idx, const Vector3 &p_from, const Vector3 &p_to, Vector3 &r_point, Vector3 &r_normal) {
+	Transform inv_xform = p_col_obj->get_shape_inv_transform(p_shape_idx) * p_col_obj->get_inv_transform();
+
+	Vector3 local_from = inv_xform.xform(p_from);
+	Vector3 local_to = inv_xform.xform(p_to);
+
+	const Shape3DSW *shape = p_col_obj->get_shape(p_shape_idx);
+
+	Vector3 shape_point, shape_normal;
+
+	if (!shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+		return false;
+	}
+
+	Transform xform = p_col_obj->get_transform() * p_col_obj->get_shape_transform(p_shape_idx);
+	r_point = xform.xform(shape_point);
+	r_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+
+	return true;
+}
+
+static void _fill_ray_result(PhysicsDirectSpaceState3D::RayResult &r_result, const CollisionObject3DSW *p_col_obj, int p_shape_idx, const Vector3 &p_point, const Vector3 &p_normal) {
+	r_result.collider_id = p_col_obj->get_instance_id();
+	if (r_result.collider_id.is_valid()) {
+		r_result.collider = ObjectDB::get_instance(r_result.collider_id);
+	} else {
+		r_result.collider = nullptr;
+	}
+	r_result.normal = p_normal;
+	r_result.position = p_point;
+	r_result.rid = p_col_obj->get_self();
+	r_result.shape = p_shape_idx;
+}
+
 bool PhysicsDirectSpaceState3DSW::intersect_ray(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_ray) {
 	ERR_FAIL_COND_V(space->locked, false);
 
@@ -132,25 +167,16 @@ bool PhysicsDirectSpaceState3DSW::intersect_ray(const Vector3 &p_from, const Vec
 		const CollisionObject3DSW *col_obj = space->intersection_query_results[i];
 
 		int shape_idx = space->intersection_query_subindex_results[i];
-		Transform inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
-
-		Vector3 local_from = inv_xform.xform(begin);
-		Vector3 local_to = inv_xform.xform(end);
-
-		const Shape3DSW *shape = col_obj->get_shape(shape_idx);
 
 		Vector3 shape_point, shape_normal;
 
-		if (shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
-			Transform xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-			shape_point = xform.xform(shape_point);
-
+		if (_intersect_ray_shape(col_obj, shape_idx, begin, end, shape_point, shape_normal)) {
 			real_t ld = normal.dot(shape_point);
 
 			if (ld < min_d) {
 				min_d = ld;
 				res_point = shape_point;
-				res_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+				res_normal = shape_normal;
 				res_shape = shape_idx;
 				res_obj = col_obj;
 				collided = true;
@@ -162,16 +188,7 @@ bool PhysicsDirectSpaceState3DSW::intersect_ray(const Vector3 &p_from, const Vec
 		return false;
 	}
 
-	r_result.collider_id = res_obj->get_instance_id();
-	if (r_result.collider_id.is_valid()) {
-		r_result.collider = ObjectDB::get_instance(r_result.collider_id);
-	} else {
-		r_result.collider = nullptr;
-	}
-	r_result.normal = res_normal;
-	r_result.position = res_point;
-	r_result.rid = res_obj->get_self();
-	r_result.shape = res_shape;
+	_fill_ray_result(r_result, res_obj, res_shape, res_point, res_normal);
 
 	return true;
 }
@@ -181,7 +198,7 @@ int PhysicsDirectSpaceState3DSW::intersect_shape(const RID &p_shape, const Trans
 		return 0;
 	}
 
-	Shape3DSW *shape = static_cast<PhysicsServer3DSW *>(PhysicsServer3D::get_singleton())->shape_owner.getornull(p_shape);
+	Shape3DSW *shape = PhysicsServer3DSW::singleton->shape_owner.getornull(p_shape);
 	ERR_FAIL_COND_V(!shape, 0);
 
 	AABB aabb = p_xform.xform(shape->get_aabb());
@@ -231,8 +248,71 @@ int PhysicsDirectSpaceState3DSW::intersect_shape(const RID &p_shape, const Trans
 	return cc;
 }
 
+enum CastMotionResult {
+	CAST_MOTION_CLEAR,
+	CAST_MOTION_HIT,
+	CAST_MOTION_OVERLAP, // Already touching at the start of the motion.
+};
+
+// Sweeps p_shape against one shape of an object. On a hit, r_safe and r_unsafe are the fractions of the motion right before and after the contact.
+static CastMotionResult _cast_motion_shape(Shape3DSW *p_shape, const Transform &p_xform, const Vector3 &p_motion, const AABB &p_aabb, const CollisionObject3DSW *p_col_obj, int p_shape_idx, real_t &r_safe, real_t &r_unsafe, Vector3 &r_point_A, Vector3 &r_point_B) {
+	Transform xform_inv = p_xform.affine_inverse();
+	MotionShape3DSW mshape;
+	mshape.shape = p_shape;
+	mshape.motion = xform_inv.basis.xform(p_motion);
+
+	Vector3 point_A, point_B;
+	Vector3 sep_axis = p_motion.normalized();
+
+	Transform col_obj_xform = p_col_obj->get_transform() * p_col_obj->get_shape_transform(p_shape_idx);
+	//test initial overlap, does it collide if going all the way?
+	if (CollisionSolver3DSW::solve_distance(&mshape, p_xform, p_col_obj->get_shape(p_shape_idx), col_obj_xform, point_A, point_B, p_aabb, &sep_axis)) {
+		return CAST_MOTION_CLEAR;
+	}
+
+	//test initial overlap
+	sep_axis = p_motion.normalized();
+
+	if (!CollisionSolver3DSW::solve_distance(p_shape, p_xform, p_col_obj->get_shape(p_shape_idx), col_obj_xform, point_A, point_B, p_aabb, &sep_axis)) {
+		return CAST_MOTION_OVERLAP;
+	}
+
+	//just do kinematic solving
+	real_t low = 0;
+	real_t hi = 1;
+	Vector3 mnormal = p_motion.normalized();
+
+	for (int j = 0; j < 8; j++) { //steps should be customizable..
+
+		real_t ofs = (low + hi) * 0.5;
+
+		Vector3 sep = mnormal; //important optimization for this to work fast enough
+
+		mshape.motion = xform_inv.basis.xform(p_motion * ofs);
+
+		Vector3 lA, lB;
+
+		bool collided = !CollisionSolver3DSW::solve_distance(&mshape, p_xform, p_col_obj->get_shape(p_shape_idx), col_obj_xform, lA, lB, p_aabb, &sep);
+
+		if (collided) {
+			hi = ofs;
+		} else {
+			point_A = lA;
+			point_B = lB;
+			low = ofs;
+		}
+	}
+
+	r_safe = low;
+	r_unsafe = hi;
+	r_point_A = point_A;
+	r_point_B = point_B;
+
+	return CAST_MOTION_HIT;
+}
+
 bool PhysicsDirectSpaceState3DSW::cast_motion(const RID &p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info) {
-	Shape3DSW *shape = static_cast<PhysicsServer3DSW *>(PhysicsServer3D::get_singleton())->shape_owner.getornull(p_shape);
+	Shape3DSW *shape = PhysicsServer3DSW::singleton->shape_owner.getornull(p_shape);
 	ERR_FAIL_COND_V(!shape, false);
 
 	AABB aabb = p_xform.xform(shape->get_aabb());
@@ -244,11 +324,6 @@ bool PhysicsDirectSpaceState3DSW::cast_motion(const RID &p_shape, const Transfor
 	real_t best_safe = 1;
 	real_t best_unsafe = 1;
 
-	Transform xform_inv = p_xform.affine_inverse();
-	MotionShape3DSW mshape;
-	mshape.shape = shape;
-	mshape.motion = xform_inv.basis.xform(p_motion);
-
 	bool best_first = true;
 
 	Vector3 closest_A, closest_B;
@@ -265,48 +340,17 @@ bool PhysicsDirectSpaceState3DSW::cast_motion(const RID &p_shape, const Transfor
 		const CollisionObject3DSW *col_obj = space->intersection_query_results[i];
 		int shape_idx = space->intersection_query_subindex_results[i];
 
+		real_t low, hi;
 		Vector3 point_A, point_B;
-		Vector3 sep_axis = p_motion.normalized();
 
-		Transform col_obj_xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-		//test initial overlap, does it collide if going all the way?
-		if (CollisionSolver3DSW::solve_distance(&mshape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, point_A, point_B, aabb, &sep_axis)) {
+		CastMotionResult res = _cast_motion_shape(shape, p_xform, p_motion, aabb, col_obj, shape_idx, low, hi, point_A, point_B);
+		if (res == CAST_MOTION_CLEAR) {
 			continue;
 		}
-
-		//test initial overlap
-		sep_axis = p_motion.normalized();
-
-		if (!CollisionSolver3DSW::solve_distance(shape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, point_A, point_B, aabb, &sep_axis)) {
+		if (res == CAST_MOTION_OVERLAP) {
 			return false;
 		}
 
-		//just do kinematic solving
-		real_t low = 0;
-		real_t hi = 1;
-		Vector3 mnormal = p_motion.normalized();
-
-		for (int j = 0; j < 8; j++) { //steps should be customizable..
-
-			real_t ofs = (low + hi) * 0.5;
-
-			Vector3 sep = mnormal; //important optimization for this to work fast enough
-
-			mshape.motion = xform_inv.basis.xform(p_motion * ofs);
-
-			Vector3 lA, lB;
-
-			bool collided = !CollisionSolver3DSW::solve_distance(&mshape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, lA, lB, aabb, &sep);
-
-			if (collided) {
-				hi = ofs;
-			} else {
-				point_A = lA;
-				point_B = lB;
-				low = ofs;
-			}
-		}
-
 		if (low < best_safe) {
 			best_first = true; //force reset
 			best_safe = low;
@@ -340,7 +384,7 @@ bool PhysicsDirectSpaceState3DSW::collide_shape(RID p_shape, const Transform &p_
 		return false;
 	}
 
-	Shape3DSW *shape = static_cast<PhysicsServer3DSW *>(PhysicsServer3D::get_singleton())->shape_owner.getornull(p_shape);
+	Shape3DSW *shape = PhysicsServer3DSW::singleton->shape_owner.getornull(p_shape);
 	ERR_FAIL_COND_V(!shape, 0);
 
 	AABB aabb = p_shape_xform.xform(shape->get_aabb());
@@ -412,7 +456,7 @@ static void _rest_cbk_result(const Vector3 &p_point_A, const Vector3 &p_point_B,
 }
 
 bool PhysicsDirectSpaceState3DSW::rest_info(RID p_shape, const Transform &p_shape_xform, real_t p_margin, ShapeRestInfo *r_info, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
-	Shape3DSW *shape = static_cast<PhysicsServer3DSW *>(PhysicsServer3D::get_singleton())->shape_owner.getornull(p_shape);
+	Shape3DSW *shape = PhysicsServer3DSW::singleton->shape_owner.getornull(p_shape);
 	ERR_FAIL_COND_V(!shape, 0);
 
 	AABB aabb = p_shape_xform.xform(shape->get_aabb());
@@ -507,6 +551,240 @@ Vector3 PhysicsDirectSpaceState3DSW::get_closest_point_to_object_volume(RID p_ob
 	}
 }
 
+void PhysicsDirectSpaceState3DSW::_batch_add_candidates(Batch &r_batch, int p_amount, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	for (int i = 0; i < p_amount; i++) {
+		const CollisionObject3DSW *col_obj = space->intersection_query_results[i];
+
+		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			continue;
+		}
+
+		if (p_exclude.has(col_obj->get_self())) {
+			continue;
+		}
+
+		BatchCandidate candidate;
+		candidate.object = col_obj;
+		candidate.shape = space->intersection_query_subindex_results[i];
+		r_batch.candidates.push_back(candidate);
+	}
+}
+
+void PhysicsDirectSpaceState3DSW::_batch_cull(Batch &r_batch, const RayQuery *p_rays, int p_query_count, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	// Expects r_batch.bounds to hold the bounds of every query.
+	r_batch.candidates.clear();
+	r_batch.ranges.resize(p_query_count);
+
+	for (int chunk_from = 0; chunk_from < p_query_count; chunk_from += BATCH_CHUNK_SIZE) {
+		int chunk_to = MIN(chunk_from + BATCH_CHUNK_SIZE, p_query_count);
+
+		AABB chunk_bounds = r_batch.bounds[chunk_from];
+		for (int i = chunk_from + 1; i < chunk_to; i++) {
+			chunk_bounds.merge_with(r_batch.bounds[i]);
+		}
+
+		// Queries close to each other (sensor fans, volleys) share one broadphase query and one filtering pass.
+		int amount = space->broadphase->cull_aabb(chunk_bounds, space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+		if (amount < Space3DSW::INTERSECTION_QUERY_MAX && amount <= (chunk_to - chunk_from) * BATCH_SHARED_CANDIDATES) {
+			BatchRange range;
+			range.from = r_batch.candidates.size();
+			_batch_add_candidates(r_batch, amount, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+			range.count = r_batch.candidates.size() - range.from;
+			range.shared = true;
+
+			for (int i = chunk_from; i < chunk_to; i++) {
+				r_batch.ranges[i] = range;
+			}
+			continue;
+		}
+
+		// Spread out chunk, cull each query on its own.
+		for (int i = chunk_from; i < chunk_to; i++) {
+			if (p_rays) {
+				amount = space->broadphase->cull_segment(p_rays[i].from, p_rays[i].to, space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+			} else {
+				amount = space->broadphase->cull_aabb(r_batch.bounds[i], space->intersection_query_results, Space3DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+			}
+
+			BatchRange &range = r_batch.ranges[i];
+			range.from = r_batch.candidates.size();
+			_batch_add_candidates(r_batch, amount, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+			range.count = r_batch.candidates.size() - range.from;
+			range.shared = false;
+		}
+	}
+}
+
+template <class T>
+void PhysicsDirectSpaceState3DSW::_batch_dispatch(int p_query_count, void (PhysicsDirectSpaceState3DSW::*p_method)(uint32_t, T *), T *p_batch) {
+	// Only the narrow phase runs on the pool, broadphase culling is not thread safe.
+	// The pool takes one batch at a time, a call made while it is busy runs serially.
+	PhysicsServer3DSW *server = PhysicsServer3DSW::singleton;
+	if (p_query_count >= BATCH_PARALLEL_MIN && server->query_work_pool.get_thread_count() > 1 && server->query_work_pool_mutex.try_lock() == OK) {
+		server->query_work_pool.do_work(p_query_count, this, p_method, p_batch);
+		server->query_work_pool_mutex.unlock();
+	} else {
+		for (int i = 0; i < p_query_count; i++) {
+			(this->*p_method)(i, p_batch);
+		}
+	}
+}
+
+void PhysicsDirectSpaceState3DSW::_intersect_ray_work(uint32_t p_index, RayBatch *p_batch) {
+	const RayQuery &query = p_batch->queries[p_index];
+	const BatchRange &range = p_batch->ranges[p_index];
+
+	Vector3 normal = (query.to - query.from).normalized();
+
+	const CollisionObject3DSW *res_obj = nullptr;
+	Vector3 res_point, res_normal;
+	int res_shape = 0;
+	real_t min_d = 1e10;
+
+	for (uint32_t i = range.from; i < range.from + range.count; i++) {
+		const BatchCandidate &candidate = p_batch->candidates[i];
+
+		if (range.shared && !candidate.object->get_shape_aabb(candidate.shape).intersects_segment(query.from, query.to)) {
+			continue;
+		}
+
+		Vector3 shape_point, shape_normal;
+
+		if (!_intersect_ray_shape(candidate.object, candidate.shape, query.from, query.to, shape_point, shape_normal)) {
+			continue;
+		}
+
+		real_t ld = normal.dot(shape_point);
+
+		if (ld < min_d) {
+			min_d = ld;
+			res_point = shape_point;
+			res_normal = shape_normal;
+			res_shape = candidate.shape;
+			res_obj = candidate.object;
+		}
+	}
+
+	if (res_obj) {
+		_fill_ray_result(p_batch->results[p_index], res_obj, res_shape, res_point, res_normal);
+	} else {
+		p_batch->results[p_index].rid = RID();
+	}
+}
+
+void PhysicsDirectSpaceState3DSW::_cast_motion_work(uint32_t p_index, MotionBatch *p_batch) {
+	const MotionQuery &query = p_batch->queries[p_index];
+	const BatchRange &range = p_batch->ranges[p_index];
+	const AABB &aabb = p_batch->bounds[p_index];
+	MotionQueryResult &result = p_batch->results[p_index];
+
+	result.closest_safe = 1;
+	result.closest_unsafe = 1;
+
+	if (!p_batch->shapes[p_index]) {
+		return;
+	}
+
+	for (uint32_t i = range.from; i < range.from + range.count; i++) {
+		const BatchCandidate &candidate = p_batch->candidates[i];
+
+		if (range.shared && !candidate.object->get_shape_aabb(candidate.shape).intersects_inclusive(aabb)) {
+			continue;
+		}
+
+		real_t low, hi;
+		Vector3 point_A, point_B;
+
+		CastMotionResult res = _cast_motion_shape(p_batch->shapes[p_index], query.transform, query.motion, aabb, candidate.object, candidate.shape, low, hi, point_A, point_B);
+		if (res == CAST_MOTION_CLEAR) {
+			continue;
+		}
+		if (res == CAST_MOTION_OVERLAP) {
+			result.closest_safe = 0;
+			result.closest_unsafe = 0;
+			return;
+		}
+
+		if (low < result.closest_safe) {
+			result.closest_safe = low;
+			result.closest_unsafe = hi;
+		}
+	}
+}
+
+int PhysicsDirectSpaceState3DSW::intersect_rays(const RayQuery *p_queries, int p_query_count, RayResult *r_results, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	if (p_query_count <= 0) {
+		return 0;
+	}
+
+	RayBatch batch;
+	batch.queries = p_queries;
+	batch.results = r_results;
+	batch.bounds.resize(p_query_count);
+	for (int i = 0; i < p_query_count; i++) {
+		AABB bounds(p_queries[i].from, Vector3());
+		bounds.expand_to(p_queries[i].to);
+		batch.bounds[i] = bounds;
+	}
+
+	_batch_cull(batch, p_queries, p_query_count, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	_batch_dispatch(p_query_count, &PhysicsDirectSpaceState3DSW::_intersect_ray_work, &batch);
+
+	int hits = 0;
+	for (int i = 0; i < p_query_count; i++) {
+		if (r_results[i].rid.is_valid()) {
+			hits++;
+		}
+	}
+
+	return hits;
+}
+
+int PhysicsDirectSpaceState3DSW::cast_motions(const MotionQuery *p_queries, int p_query_count, real_t p_margin, MotionQueryResult *r_results, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	if (p_query_count <= 0) {
+		return 0;
+	}
+
+	MotionBatch batch;
+	batch.queries = p_queries;
+	batch.results = r_results;
+	batch.shapes.resize(p_query_count);
+	batch.bounds.resize(p_query_count);
+	for (int i = 0; i < p_query_count; i++) {
+		Shape3DSW *shape = PhysicsServer3DSW::singleton->shape_owner.getornull(p_queries[i].shape);
+		batch.shapes[i] = shape;
+		if (!shape) {
+			// Only this query fails, it reports its whole motion as clear.
+			batch.bounds[i] = AABB(p_queries[i].transform.origin, Vector3());
+			ERR_CONTINUE_MSG(true, "Invalid shape in motion query " + itos(i) + ".");
+		}
+
+		AABB aabb = p_queries[i].transform.xform(shape->get_aabb());
+		aabb = aabb.merge(AABB(aabb.position + p_queries[i].motion, aabb.size)); //motion
+		aabb = aabb.grow(p_margin);
+
+		batch.bounds[i] = aabb;
+	}
+
+	_batch_cull(batch, nullptr, p_query_count, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	_batch_dispatch(p_query_count, &PhysicsDirectSpaceState3DSW::_cast_motion_work, &batch);
+
+	int hits = 0;
+	for (int i = 0; i < p_query_count; i++) {
+		if (r_results[i].closest_safe < 1) {
+			hits++;
+		}
+	}
+
+	return hits;
+}
+
 PhysicsDirectSpaceState3DSW::PhysicsDirectSpaceState3DSW() {
 	space = nullptr;
 }
@@ -1033,18 +1311,6 @@ void Space3DSW::_broadphase_unpair(CollisionObject3DSW *A, int p_subindex_A, Col
 	memdelete(c);
 }
 
-const SelfList<Body3DSW>::List &Space3DSW::get_active_body_list() const {
-	return active_list;
-}
-
-void Space3DSW::body_add_to_active_list(SelfList<Body3DSW> *p_body) {
-	active_list.add(p_body);
-}
-
-void Space3DSW::body_remove_from_active_list(SelfList<Body3DSW> *p_body) {
-	active_list.remove(p_body);
-}
-
 void Space3DSW::body_add_to_inertia_update_list(SelfList<Body3DSW> *p_body) {
 	inertia_update_list.add(p_body);
 }
@@ -1079,6 +1345,23 @@ void Space3DSW::body_remove_from_state_query_list(SelfList<Body3DSW> *p_body) {
 	state_query_list.remove(p_body);
 }
 
+void Space3DSW::body_add_to_gravity_attractor_list(SelfList<Body3DSW> *p_body) {
+	gravity_attractor_list.add(p_body);
+}
+
+void Space3DSW::body_remove_from_gravity_attractor_list(SelfList<Body3DSW> *p_body) {
+	gravity_attractor_list.remove(p_body);
+}
+
+void Space3DSW::update_gravity_field() {
+	gravity_field.clear();
+	for (const SelfList<Body3DSW> *b = gravity_attractor_list.first(); b; b = b->next()) {
+		Body3DSW *body = b->self();
+		gravity_field.add_attractor(body->get_transform().origin + body->get_center_of_mass(), body->get_gravity_mass());
+	}
+	gravity_field.build(n_body_gravity_theta, n_body_gravity_softening);
+}
+
 void Space3DSW::area_add_to_monitor_query_list(SelfList<Area3DSW> *p_area) {
 	monitor_query_list.add(p_area);
 }
@@ -1154,6 +1437,12 @@ void Space3DSW::set_param(PhysicsServer3D::SpaceParameter p_param, real_t p_valu
 		case PhysicsServer3D::SPACE_PARAM_TEST_MOTION_MIN_CONTACT_DEPTH:
 			test_motion_min_contact_depth = p_value;
 			break;
+		case PhysicsServer3D::SPACE_PARAM_N_BODY_GRAVITY_THETA:
+			n_body_gravity_theta = p_value;
+			break;
+		case PhysicsServer3D::SPACE_PARAM_N_BODY_GRAVITY_SOFTENING:
+			n_body_gravity_softening = p_value;
+			break;
 	}
 }
 
@@ -1177,6 +1466,10 @@ real_t Space3DSW::get_param(PhysicsServer3D::SpaceParameter p_param) const {
 			return constraint_bias;
 		case PhysicsServer3D::SPACE_PARAM_TEST_MOTION_MIN_CONTACT_DEPTH:
 			return test_motion_min_contact_depth;
+		case PhysicsServer3D::SPACE_PARAM_N_BODY_GRAVITY_THETA:
+			return n_body_gravity_theta;
+		case PhysicsServer3D::SPACE_PARAM_N_BODY_GRAVITY_SOFTENING:
+			return n_body_gravity_softening;
 	}
 	return 0;
 }
@@ -1208,6 +1501,8 @@ Space3DSW::Space3DSW() {
 	contact_max_separation = 0.05;
 	contact_max_allowed_penetration = 0.01;
 	test_motion_min_contact_depth = 0.00001;
+	n_body_gravity_theta = 0.5;
+	n_body_gravity_softening = 0;
 
 	constraint_bias = 0.01;
 	body_linear_velocity_sleep_threshold = GLOBAL_DEF("physics/3d/sleep_threshold_linear", 0.1);
@@ -35,15 +35,62 @@
 #include "area_pair_3d_sw.h"
 #include "body_3d_sw.h"
 #include "body_pair_3d_sw.h"
+#include "body_storage_3d_sw.h"
 #include "broad_phase_3d_sw.h"
 #include "collision_object_3d_sw.h"
+#include "gravity_field_3d_sw.h"
 #include "core/config/project_settings.h"
 #include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/typedefs.h"
 
 class PhysicsDirectSpaceState3DSW : public PhysicsDirectSpaceState3D {
 	GDCLASS(PhysicsDirectSpaceState3DSW, PhysicsDirectSpaceState3D);
 
+	enum {
+		BATCH_CHUNK_SIZE = 32,
+		BATCH_SHARED_CANDIDATES = 8, // Per query, chunks culling fewer candidates share a single broadphase query.
+		BATCH_PARALLEL_MIN = 64,
+	};
+
+	struct BatchCandidate {
+		const CollisionObject3DSW *object;
+		int shape;
+	};
+
+	struct BatchRange {
+		uint32_t from;
+		uint32_t count;
+		bool shared; // Candidates were culled for the whole chunk, test them against the query bounds first.
+	};
+
+	// Scratch of one batched call, kept on its stack so concurrent and nested calls don't share it.
+	// The broadphase results are filled on the calling thread.
+	struct Batch {
+		LocalVector<BatchCandidate> candidates;
+		LocalVector<BatchRange> ranges;
+		LocalVector<AABB> bounds;
+	};
+
+	struct RayBatch : public Batch {
+		const RayQuery *queries;
+		RayResult *results;
+	};
+
+	struct MotionBatch : public Batch {
+		const MotionQuery *queries;
+		MotionQueryResult *results;
+		LocalVector<Shape3DSW *> shapes;
+	};
+
+	void _batch_cull(Batch &r_batch, const RayQuery *p_rays, int p_query_count, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+	void _batch_add_candidates(Batch &r_batch, int p_amount, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+	template <class T>
+	void _batch_dispatch(int p_query_count, void (PhysicsDirectSpaceState3DSW::*p_method)(uint32_t, T *), T *p_batch);
+
+	void _intersect_ray_work(uint32_t p_index, RayBatch *p_batch);
+	void _cast_motion_work(uint32_t p_index, MotionBatch *p_batch);
+
 public:
 	Space3DSW *space;
 
@@ -55,6 +102,9 @@ public:
 	virtual bool rest_info(RID p_shape, const Transform &p_shape_xform, real_t p_margin, ShapeRestInfo *r_info, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false) override;
 	virtual Vector3 get_closest_point_to_object_volume(RID p_object, const Vector3 p_point) const override;
 
+	virtual int intersect_rays(const RayQuery *p_queries, int p_query_count, RayResult *r_results, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false) override;
+	virtual int cast_motions(const MotionQuery *p_queries, int p_query_count, real_t p_margin, MotionQueryResult *r_results, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false) override;
+
 	PhysicsDirectSpaceState3DSW();
 };
 
@@ -72,14 +122,16 @@ public:
 
 private:
 	uint64_t elapsed_time[ELAPSED_TIME_MAX];
+	LocalVector<uint64_t> thread_elapsed_time; // ELAPSED_TIME_MAX values per thread of the step.
 
 	PhysicsDirectSpaceState3DSW *direct_access;
 	RID self;
 
 	BroadPhase3DSW *broadphase;
-	SelfList<Body3DSW>::List active_list;
+	BodyStorage3DSW body_storage;
 	SelfList<Body3DSW>::List inertia_update_list;
 	SelfList<Body3DSW>::List state_query_list;
+	SelfList<Body3DSW>::List gravity_attractor_list;
 	SelfList<Area3DSW>::List monitor_query_list;
 	SelfList<Area3DSW>::List area_moved_list;
 
@@ -95,6 +147,10 @@ private:
 	real_t contact_max_allowed_penetration;
 	real_t constraint_bias;
 	real_t test_motion_min_contact_depth;
+	real_t n_body_gravity_theta;
+	real_t n_body_gravity_softening;
+
+	GravityField3DSW gravity_field;
 
 	enum {
 		INTERSECTION_QUERY_MAX = 2048
@@ -130,15 +186,20 @@ public:
 	void set_default_area(Area3DSW *p_area) { area = p_area; }
 	Area3DSW *get_default_area() const { return area; }
 
-	const SelfList<Body3DSW>::List &get_active_body_list() const;
-	void body_add_to_active_list(SelfList<Body3DSW> *p_body);
-	void body_remove_from_active_list(SelfList<Body3DSW> *p_body);
+	// Active bodies are the first ones of the storage.
+	_FORCE_INLINE_ BodyStorage3DSW &get_body_storage() { return body_storage; }
 	void body_add_to_inertia_update_list(SelfList<Body3DSW> *p_body);
 	void body_remove_from_inertia_update_list(SelfList<Body3DSW> *p_body);
 
 	void body_add_to_state_query_list(SelfList<Body3DSW> *p_body);
 	void body_remove_from_state_query_list(SelfList<Body3DSW> *p_body);
 
+	const SelfList<Body3DSW>::List &get_gravity_attractor_list() const { return gravity_attractor_list; }
+	void body_add_to_gravity_attractor_list(SelfList<Body3DSW> *p_body);
+	void body_remove_from_gravity_attractor_list(SelfList<Body3DSW> *p_body);
+	void update_gravity_field();
+	_FORCE_INLINE_ const GravityField3DSW &get_gravity_field() const { return gravity_field; }
+
 	void area_add_to_monitor_query_list(SelfList<Area3DSW> *p_area);
 	void area_remove_from_monitor_query_list(SelfList<Area3DSW> *p_area);
 	void area_add_to_moved_list(SelfList<Area3DSW> *p_area);
@@ -197,6 +258,12 @@ public:
 	void set_elapsed_time(ElapsedTime p_time, uint64_t p_msec) { elapsed_time[p_time] = p_msec; }
 	uint64_t get_elapsed_time(ElapsedTime p_time) const { return elapsed_time[p_time]; }
 
+	// Thread 0 is the one stepping the space, the rest are its workers.
+	void set_elapsed_time_thread_count(uint32_t p_count) { thread_elapsed_time.resize(p_count * ELAPSED_TIME_MAX); }
+	uint32_t get_elapsed_time_thread_count() const { return thread_elapsed_time.size() / ELAPSED_TIME_MAX; }
+	void set_thread_elapsed_time(ElapsedTime p_time, uint32_t p_thread, uint64_t p_usec) { thread_elapsed_time[p_thread * ELAPSED_TIME_MAX + p_time] = p_usec; }
+	uint64_t get_thread_elapsed_time(ElapsedTime p_time, uint32_t p_thread) const { return thread_elapsed_time[p_thread * ELAPSED_TIME_MAX + p_time]; }
+
 	int test_body_ray_separation(Body3DSW *p_body, const Transform &p_transform, bool p_infinite_inertia, Vector3 &r_recover_motion, PhysicsServer3D::SeparationResult *r_results, int p_result_max, real_t p_margin);
 	bool test_body_motion(Body3DSW *p_body, const Transform &p_from, const Vector3 &p_motion, bool p_infinite_inertia, real_t p_margin, PhysicsServer3D::MotionResult *r_result, bool p_exclude_raycast_shapes);
 
@@ -33,7 +33,7 @@
 
 #include "core/os/os.h"
 
-void Step3DSW::_populate_island(Body3DSW *p_body, Body3DSW **p_island, Constraint3DSW **p_constraint_island) {
+void Step3DSW::_populate_island(Body3DSW *p_body, Body3DSW **p_island, Constraint3DSW **p_constraint_island, Constraint3DSW **p_shared_island) {
 	p_body->set_island_step(_step);
 	p_body->set_island_next(*p_island);
 	*p_island = p_body;
@@ -44,8 +44,24 @@ void Step3DSW::_populate_island(Body3DSW *p_body, Body3DSW **p_island, Constrain
 			continue; //already processed
 		}
 		c->set_island_step(_step);
-		c->set_island_next(*p_constraint_island);
-		*p_constraint_island = c;
+		if (c->get_body_count() == 0) {
+			// Area pairs, their setup changes the area which other islands may share.
+			area_constraints.push_back(c);
+			continue;
+		}
+		// Contacts reported to a static or kinematic body are written during setup, and
+		// such a body can be part of several islands.
+		bool shared_report = false;
+		for (int i = 0; i < c->get_body_count(); i++) {
+			Body3DSW *b = c->get_body_ptr()[i];
+			if (b->get_mode() <= PhysicsServer3D::BODY_MODE_KINEMATIC && b->can_report_contacts()) {
+				shared_report = true;
+				break;
+			}
+		}
+		Constraint3DSW **list = shared_report ? p_shared_island : p_constraint_island;
+		c->set_island_next(*list);
+		*list = c;
 
 		for (int i = 0; i < c->get_body_count(); i++) {
 			if (i == E->get()) {
@@ -55,7 +71,7 @@ void Step3DSW::_populate_island(Body3DSW *p_body, Body3DSW **p_island, Constrain
 			if (b->get_island_step() == _step || b->get_mode() == PhysicsServer3D::BODY_MODE_STATIC || b->get_mode() == PhysicsServer3D::BODY_MODE_KINEMATIC) {
 				continue; //no go
 			}
-			_populate_island(c->get_body_ptr()[i], p_island, p_constraint_island);
+			_populate_island(c->get_body_ptr()[i], p_island, p_constraint_island, p_shared_island);
 		}
 	}
 }
@@ -139,28 +155,106 @@ void Step3DSW::_check_suspend(Body3DSW *p_island, real_t p_delta) {
 	}
 }
 
+void Step3DSW::_add_thread_time(Space3DSW::ElapsedTime p_time, uint64_t p_usec) {
+	uint32_t thread = ThreadWorkPool::get_thread_index() + 1;
+	if (thread * Space3DSW::ELAPSED_TIME_MAX >= thread_elapsed_time.size()) {
+		thread = 0; // Not one of our workers.
+	}
+	thread_elapsed_time[thread * Space3DSW::ELAPSED_TIME_MAX + p_time] += p_usec;
+}
+
+void Step3DSW::_dispatch(uint32_t p_count, uint32_t p_parallel_min, void (Step3DSW::*p_method)(uint32_t, void *)) {
+	if (p_count >= p_parallel_min && work_pool.get_thread_count() > 1) {
+		work_pool.do_work(p_count, this, p_method, (void *)nullptr);
+	} else {
+		for (uint32_t i = 0; i < p_count; i++) {
+			(this->*p_method)(i, nullptr);
+		}
+	}
+}
+
+void Step3DSW::_integrate_forces_batch(uint32_t p_batch, void *p_userdata) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	uint32_t from = p_batch * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, active_bodies.size());
+	for (uint32_t i = from; i < to; i++) {
+		Body3DSW *body = active_bodies[i];
+		if (gravity_field) {
+			body->set_n_body_gravity(gravity_field->evaluate(body->get_transform().origin + body->get_center_of_mass()));
+		}
+		body->integrate_forces(delta);
+	}
+	body_storage->integrate_forces(from, to, delta);
+
+	_add_thread_time(Space3DSW::ELAPSED_TIME_INTEGRATE_FORCES, OS::get_singleton()->get_ticks_usec() - begin);
+}
+
+void Step3DSW::_integrate_velocities_batch(uint32_t p_batch, void *p_userdata) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	uint32_t from = p_batch * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, active_bodies.size());
+	body_storage->integrate_velocities(from, to, delta);
+
+	_add_thread_time(Space3DSW::ELAPSED_TIME_INTEGRATE_VELOCITIES, OS::get_singleton()->get_ticks_usec() - begin);
+}
+
+void Step3DSW::_setup_island_work(uint32_t p_island, void *p_userdata) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	_setup_island(constraint_island_parallel_setup[p_island], delta);
+	_add_thread_time(Space3DSW::ELAPSED_TIME_SETUP_CONSTRAINTS, OS::get_singleton()->get_ticks_usec() - begin);
+}
+
+void Step3DSW::_solve_island_work(uint32_t p_island, void *p_userdata) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	_solve_island(constraint_islands[p_island], iterations, delta);
+	_add_thread_time(Space3DSW::ELAPSED_TIME_SOLVE_CONSTRAINTS, OS::get_singleton()->get_ticks_usec() - begin);
+}
+
 void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 	p_space->lock(); // can't access space during this
 
 	p_space->setup(); //update inertias, etc
 
-	const SelfList<Body3DSW>::List *body_list = &p_space->get_active_body_list();
+	delta = p_delta;
+	iterations = p_iterations;
+
+	uint32_t thread_count = work_pool.get_thread_count() + 1;
+	thread_elapsed_time.resize(thread_count * Space3DSW::ELAPSED_TIME_MAX);
+	for (uint32_t i = 0; i < thread_elapsed_time.size(); i++) {
+		thread_elapsed_time[i] = 0;
+	}
 
 	/* INTEGRATE FORCES */
 
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	// Bodies woken up during the step are appended after the active ones, and bodies
+	// only go to sleep once integrated, so these indices stay valid for the storage.
+	body_storage = &p_space->get_body_storage();
+	active_bodies.resize(body_storage->get_active_count());
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		active_bodies[i] = body_storage->body[i];
+	}
 
-	const SelfList<Body3DSW> *b = body_list->first();
-	while (b) {
-		b->self()->integrate_forces(p_delta);
-		b = b->next();
-		active_count++;
+	p_space->set_active_objects(active_bodies.size());
+
+	gravity_field = nullptr;
+	if (p_space->get_gravity_attractor_list().first()) {
+		p_space->update_gravity_field();
+		gravity_field = &p_space->get_gravity_field();
 	}
 
-	p_space->set_active_objects(active_count);
+	// Bodies only touch their own state here, each one is integrated by exactly one thread.
+	uint32_t body_batches = (active_bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE;
+	_dispatch(body_batches, BODY_PARALLEL_MIN / BODY_BATCH_SIZE, &Step3DSW::_integrate_forces_batch);
+
+	// The broadphase is not thread safe.
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		active_bodies[i]->apply_pending_motion(p_delta);
+	}
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -171,32 +265,39 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 	/* GENERATE CONSTRAINT ISLANDS */
 
 	Body3DSW *island_list = nullptr;
-	Constraint3DSW *constraint_island_list = nullptr;
-	b = body_list->first();
-
-	int island_count = 0;
+	constraint_islands.clear();
+	constraint_island_parallel_setup.clear();
+	area_constraints.clear();
 
-	while (b) {
-		Body3DSW *body = b->self();
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		Body3DSW *body = active_bodies[i];
 
 		if (body->get_island_step() != _step) {
 			Body3DSW *island = nullptr;
 			Constraint3DSW *constraint_island = nullptr;
-			_populate_island(body, &island, &constraint_island);
+			Constraint3DSW *shared_island = nullptr;
+			_populate_island(body, &island, &constraint_island, &shared_island);
 
 			island->set_island_list_next(island_list);
 			island_list = island;
 
-			if (constraint_island) {
-				constraint_island->set_island_list_next(constraint_island_list);
-				constraint_island_list = constraint_island;
-				island_count++;
+			if (shared_island) {
+				// Solved as one island, the shared constraints go first.
+				Constraint3DSW *last = shared_island;
+				while (last->get_island_next()) {
+					last = last->get_island_next();
+				}
+				last->set_island_next(constraint_island);
+				constraint_islands.push_back(shared_island);
+				constraint_island_parallel_setup.push_back(constraint_island);
+			} else if (constraint_island) {
+				constraint_islands.push_back(constraint_island);
+				constraint_island_parallel_setup.push_back(constraint_island);
 			}
 		}
-		b = b->next();
 	}
 
-	p_space->set_island_count(island_count);
+	p_space->set_island_count(constraint_islands.size());
 
 	const SelfList<Area3DSW>::List &aml = p_space->get_moved_area_list();
 
@@ -207,9 +308,7 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 				continue;
 			}
 			c->set_island_step(_step);
-			c->set_island_next(nullptr);
-			c->set_island_list_next(constraint_island_list);
-			constraint_island_list = c;
+			area_constraints.push_back(c);
 		}
 		p_space->area_remove_from_moved_list((SelfList<Area3DSW> *)aml.first()); //faster to remove here
 	}
@@ -222,14 +321,22 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SETUP CONSTRAINT ISLANDS */
 
-	{
-		Constraint3DSW *ci = constraint_island_list;
-		while (ci) {
-			_setup_island(ci, p_delta);
-			ci = ci->get_island_list_next();
+	for (uint32_t i = 0; i < area_constraints.size(); i++) {
+		area_constraints[i]->setup(p_delta);
+	}
+
+	for (uint32_t i = 0; i < constraint_islands.size(); i++) {
+		Constraint3DSW *ci = constraint_islands[i];
+		while (ci != constraint_island_parallel_setup[i]) {
+			ci->setup(p_delta);
+			ci = ci->get_island_next();
 		}
 	}
 
+	// Islands share no dynamic bodies, so they can be set up and solved in any order
+	// with the same result. Debug contacts are collected in a shared buffer though.
+	_dispatch(constraint_islands.size(), p_space->is_debugging_contacts() ? UINT32_MAX : ISLAND_PARALLEL_MIN, &Step3DSW::_setup_island_work);
+
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
 		p_space->set_elapsed_time(Space3DSW::ELAPSED_TIME_SETUP_CONSTRAINTS, profile_endtime - profile_begtime);
@@ -238,14 +345,8 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
-		Constraint3DSW *ci = constraint_island_list;
-		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
-			ci = ci->get_island_list_next();
-		}
-	}
+	//iterating each island separatedly improves cache efficiency
+	_dispatch(constraint_islands.size(), ISLAND_PARALLEL_MIN, &Step3DSW::_solve_island_work);
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -255,11 +356,11 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-		const SelfList<Body3DSW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n;
+	_dispatch(body_batches, BODY_PARALLEL_MIN / BODY_BATCH_SIZE, &Step3DSW::_integrate_velocities_batch);
+
+	// Kept serial, moving bodies updates the broadphase and the space lists.
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		active_bodies[i]->integrate_velocities(p_delta);
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
@@ -278,6 +379,13 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 		profile_begtime = profile_endtime;
 	}
 
+	p_space->set_elapsed_time_thread_count(thread_count);
+	for (uint32_t i = 0; i < thread_count; i++) {
+		for (int j = 0; j < Space3DSW::ELAPSED_TIME_MAX; j++) {
+			p_space->set_thread_elapsed_time(Space3DSW::ElapsedTime(j), i, thread_elapsed_time[i * Space3DSW::ELAPSED_TIME_MAX + j]);
+		}
+	}
+
 	p_space->update();
 	p_space->unlock();
 	_step++;
@@ -285,4 +393,9 @@ void Step3DSW::step(Space3DSW *p_space, real_t p_delta, int p_iterations) {
 
 Step3DSW::Step3DSW() {
 	_step = 1;
+	work_pool.init();
+}
+
+Step3DSW::~Step3DSW() {
+	work_pool.finish();
 }
@@ -33,10 +33,42 @@
 
 #include "space_3d_sw.h"
 
+#include "core/templates/local_vector.h"
+#include "core/templates/thread_work_pool.h"
+
 class Step3DSW {
+	enum {
+		BODY_BATCH_SIZE = 64,
+		BODY_PARALLEL_MIN = 256,
+		ISLAND_PARALLEL_MIN = 8,
+	};
+
 	uint64_t _step;
 
-	void _populate_island(Body3DSW *p_body, Body3DSW **p_island, Constraint3DSW **p_constraint_island);
+	ThreadWorkPool work_pool;
+
+	// State of the current step, shared with the work pool.
+	real_t delta = 0;
+	int iterations = 0;
+	const GravityField3DSW *gravity_field = nullptr;
+	BodyStorage3DSW *body_storage = nullptr;
+	LocalVector<Body3DSW *> active_bodies; // Same order as the storage at the start of the step.
+	LocalVector<Constraint3DSW *> constraint_islands;
+	// Where the parallel setup of each island starts. The constraints before it report
+	// contacts to a static or kinematic body other islands share, they are set up serially.
+	LocalVector<Constraint3DSW *> constraint_island_parallel_setup;
+	LocalVector<Constraint3DSW *> area_constraints;
+	LocalVector<uint64_t> thread_elapsed_time;
+
+	void _add_thread_time(Space3DSW::ElapsedTime p_time, uint64_t p_usec);
+	void _dispatch(uint32_t p_count, uint32_t p_parallel_min, void (Step3DSW::*p_method)(uint32_t, void *));
+
+	void _integrate_forces_batch(uint32_t p_batch, void *p_userdata);
+	void _integrate_velocities_batch(uint32_t p_batch, void *p_userdata);
+	void _setup_island_work(uint32_t p_island, void *p_userdata);
+	void _solve_island_work(uint32_t p_island, void *p_userdata);
+
+	void _populate_island(Body3DSW *p_body, Body3DSW **p_island, Constraint3DSW **p_constraint_island, Constraint3DSW **p_shared_island);
 	void _setup_island(Constraint3DSW *p_island, real_t p_delta);
 	void _solve_island(Constraint3DSW *p_island, int p_iterations, real_t p_delta);
 	void _check_suspend(Body3DSW *p_island, real_t p_delta);
@@ -44,6 +76,7 @@ class Step3DSW {
 public:
 	void step(Space3DSW *p_space, real_t p_delta, int p_iterations);
 	Step3DSW();
+	~Step3DSW();
 };
 
 #endif // STEP__SW_H
@@ -280,6 +280,51 @@ Dictionary PhysicsDirectSpaceState3D::_intersect_ray(const Vector3 &p_from, cons
 	return d;
 }
 
+Array PhysicsDirectSpaceState3D::_intersect_rays(const PackedVector3Array &p_rays, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V_MSG(p_rays.size() & 1, Array(), "Rays must be given as pairs of from and to points.");
+
+	int ray_count = p_rays.size() / 2;
+	if (ray_count == 0) {
+		return Array();
+	}
+
+	Set<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++) {
+		exclude.insert(p_exclude[i]);
+	}
+
+	Vector<RayQuery> queries;
+	queries.resize(ray_count);
+	RayQuery *queries_ptr = queries.ptrw();
+	const Vector3 *rays_ptr = p_rays.ptr();
+	for (int i = 0; i < ray_count; i++) {
+		queries_ptr[i].from = rays_ptr[i * 2 + 0];
+		queries_ptr[i].to = rays_ptr[i * 2 + 1];
+	}
+
+	Vector<RayResult> results;
+	results.resize(ray_count);
+	intersect_rays(queries.ptr(), ray_count, results.ptrw(), exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	Array ret;
+	ret.resize(ray_count);
+	const RayResult *results_ptr = results.ptr();
+	for (int i = 0; i < ray_count; i++) {
+		Dictionary d;
+		if (results_ptr[i].rid.is_valid()) {
+			d["position"] = results_ptr[i].position;
+			d["normal"] = results_ptr[i].normal;
+			d["collider_id"] = results_ptr[i].collider_id;
+			d["collider"] = results_ptr[i].collider;
+			d["shape"] = results_ptr[i].shape;
+			d["rid"] = results_ptr[i].rid;
+		}
+		ret[i] = d;
+	}
+
+	return ret;
+}
+
 Array PhysicsDirectSpaceState3D::_intersect_shape(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, int p_max_results) {
 	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Array());
 
@@ -303,7 +348,7 @@ Array PhysicsDirectSpaceState3D::_intersect_shape(const Ref<PhysicsShapeQueryPar
 Array PhysicsDirectSpaceState3D::_cast_motion(const Ref<PhysicsShapeQueryParameters3D> &p_shape_query, const Vector3 &p_motion) {
 	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Array());
 
-	float closest_safe = 1.0f, closest_unsafe = 1.0f;
+	real_t closest_safe = 1.0f, closest_unsafe = 1.0f;
 	bool res = cast_motion(p_shape_query->shape, p_shape_query->transform, p_motion, p_shape_query->margin, closest_safe, closest_unsafe, p_shape_query->exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas);
 	if (!res) {
 		return Array();
@@ -354,11 +399,39 @@ Dictionary PhysicsDirectSpaceState3D::_get_rest_info(const Ref<PhysicsShapeQuery
 	return r;
 }
 
+int PhysicsDirectSpaceState3D::intersect_rays(const RayQuery *p_queries, int p_query_count, RayResult *r_results, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	int hits = 0;
+	for (int i = 0; i < p_query_count; i++) {
+		if (intersect_ray(p_queries[i].from, p_queries[i].to, r_results[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			hits++;
+		} else {
+			r_results[i].rid = RID();
+		}
+	}
+	return hits;
+}
+
+int PhysicsDirectSpaceState3D::cast_motions(const MotionQuery *p_queries, int p_query_count, real_t p_margin, MotionQueryResult *r_results, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	int hits = 0;
+	for (int i = 0; i < p_query_count; i++) {
+		MotionQueryResult &result = r_results[i];
+		if (!cast_motion(p_queries[i].shape, p_queries[i].transform, p_queries[i].motion, p_margin, result.closest_safe, result.closest_unsafe, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			result.closest_safe = 0;
+			result.closest_unsafe = 0;
+		}
+		if (result.closest_safe < 1) {
+			hits++;
+		}
+	}
+	return hits;
+}
+
 PhysicsDirectSpaceState3D::PhysicsDirectSpaceState3D() {
 }
 
 void PhysicsDirectSpaceState3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("intersect_ray", "from", "to", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas"), &PhysicsDirectSpaceState3D::_intersect_ray, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("intersect_rays", "rays", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas"), &PhysicsDirectSpaceState3D::_intersect_rays, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("intersect_shape", "shape", "max_results"), &PhysicsDirectSpaceState3D::_intersect_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("cast_motion", "shape", "motion"), &PhysicsDirectSpaceState3D::_cast_motion);
 	ClassDB::bind_method(D_METHOD("collide_shape", "shape", "max_results"), &PhysicsDirectSpaceState3D::_collide_shape, DEFVAL(32));
@@ -664,6 +737,7 @@ void PhysicsServer3D::_bind_methods() {
 	BIND_ENUM_CONSTANT(AREA_PARAM_LINEAR_DAMP);
 	BIND_ENUM_CONSTANT(AREA_PARAM_ANGULAR_DAMP);
 	BIND_ENUM_CONSTANT(AREA_PARAM_PRIORITY);
+	BIND_ENUM_CONSTANT(AREA_PARAM_GRAVITY_IS_N_BODY);
 
 	BIND_ENUM_CONSTANT(AREA_SPACE_OVERRIDE_DISABLED);
 	BIND_ENUM_CONSTANT(AREA_SPACE_OVERRIDE_COMBINE);
@@ -682,6 +756,7 @@ void PhysicsServer3D::_bind_methods() {
 	BIND_ENUM_CONSTANT(BODY_PARAM_GRAVITY_SCALE);
 	BIND_ENUM_CONSTANT(BODY_PARAM_LINEAR_DAMP);
 	BIND_ENUM_CONSTANT(BODY_PARAM_ANGULAR_DAMP);
+	BIND_ENUM_CONSTANT(BODY_PARAM_GRAVITY_MASS);
 	BIND_ENUM_CONSTANT(BODY_PARAM_MAX);
 
 	BIND_ENUM_CONSTANT(BODY_STATE_TRANSFORM);
@@ -706,6 +781,8 @@ void PhysicsServer3D::_bind_methods() {
 	BIND_ENUM_CONSTANT(SPACE_PARAM_BODY_ANGULAR_VELOCITY_DAMP_RATIO);
 	BIND_ENUM_CONSTANT(SPACE_PARAM_CONSTRAINT_DEFAULT_BIAS);
 	BIND_ENUM_CONSTANT(SPACE_PARAM_TEST_MOTION_MIN_CONTACT_DEPTH);
+	BIND_ENUM_CONSTANT(SPACE_PARAM_N_BODY_GRAVITY_THETA);
+	BIND_ENUM_CONSTANT(SPACE_PARAM_N_BODY_GRAVITY_SOFTENING);
 
 	BIND_ENUM_CONSTANT(BODY_AXIS_LINEAR_X);
 	BIND_ENUM_CONSTANT(BODY_AXIS_LINEAR_Y);
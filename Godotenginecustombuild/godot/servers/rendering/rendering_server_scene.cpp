@@ -30,6 +30,7 @@
 
 #include "rendering_server_scene.h"
 
+#include "core/config/project_settings.h"
 #include "core/os/os.h"
 #include "rendering_server_globals.h"
 #include "rendering_server_raster.h"
@@ -287,8 +288,9 @@ RID RenderingServerScene::scenario_create() {
 	RID scenario_rid = scenario_owner.make_rid(scenario);
 	scenario->self = scenario_rid;
 
-	scenario->octree.set_pair_callback(_instance_pair, this);
-	scenario->octree.set_unpair_callback(_instance_unpair, this);
+	scenario->spatial_index.set_use_bvh(GLOBAL_GET("rendering/quality/spatial_partitioning/use_bvh"));
+	scenario->spatial_index.set_pair_callback(_instance_pair, this);
+	scenario->spatial_index.set_unpair_callback(_instance_unpair, this);
 	scenario->reflection_probe_shadow_atlas = RSG::scene_render->shadow_atlas_create();
 	RSG::scene_render->shadow_atlas_set_size(scenario->reflection_probe_shadow_atlas, 1024); //make enough shadows for close distance, don't bother with rest
 	RSG::scene_render->shadow_atlas_set_quadrant_subdivision(scenario->reflection_probe_shadow_atlas, 0, 4);
@@ -365,9 +367,9 @@ void RenderingServerScene::instance_set_base(RID p_instance, RID p_base) {
 	if (instance->base_type != RS::INSTANCE_NONE) {
 		//free anything related to that base
 
-		if (scenario && instance->octree_id) {
-			scenario->octree.erase(instance->octree_id); //make dependencies generated by the octree go away
-			instance->octree_id = 0;
+		if (scenario && instance->spatial_index_id) {
+			scenario->spatial_index.erase(instance->spatial_index_id); //make dependencies generated by the spatial index go away
+			instance->spatial_index_id = 0;
 		}
 
 		switch (instance->base_type) {
@@ -520,9 +522,9 @@ void RenderingServerScene::instance_set_scenario(RID p_instance, RID p_scenario)
 	if (instance->scenario) {
 		instance->scenario->instances.remove(&instance->scenario_item);
 
-		if (instance->octree_id) {
-			instance->scenario->octree.erase(instance->octree_id); //make dependencies generated by the octree go away
-			instance->octree_id = 0;
+		if (instance->spatial_index_id) {
+			instance->scenario->spatial_index.erase(instance->spatial_index_id); //make dependencies generated by the spatial index go away
+			instance->spatial_index_id = 0;
 		}
 
 		switch (instance->base_type) {
@@ -680,38 +682,38 @@ void RenderingServerScene::instance_set_visible(RID p_instance, bool p_visible)
 
 	switch (instance->base_type) {
 		case RS::INSTANCE_LIGHT: {
-			if (RSG::storage->light_get_type(instance->base) != RS::LIGHT_DIRECTIONAL && instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << RS::INSTANCE_LIGHT, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
+			if (RSG::storage->light_get_type(instance->base) != RS::LIGHT_DIRECTIONAL && instance->spatial_index_id && instance->scenario) {
+				instance->scenario->spatial_index.set_pairable(instance->spatial_index_id, p_visible, 1 << RS::INSTANCE_LIGHT, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case RS::INSTANCE_REFLECTION_PROBE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << RS::INSTANCE_REFLECTION_PROBE, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->spatial_index_id && instance->scenario) {
+				instance->scenario->spatial_index.set_pairable(instance->spatial_index_id, p_visible, 1 << RS::INSTANCE_REFLECTION_PROBE, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case RS::INSTANCE_DECAL: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << RS::INSTANCE_DECAL, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->spatial_index_id && instance->scenario) {
+				instance->scenario->spatial_index.set_pairable(instance->spatial_index_id, p_visible, 1 << RS::INSTANCE_DECAL, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case RS::INSTANCE_LIGHTMAP: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << RS::INSTANCE_LIGHTMAP, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->spatial_index_id && instance->scenario) {
+				instance->scenario->spatial_index.set_pairable(instance->spatial_index_id, p_visible, 1 << RS::INSTANCE_LIGHTMAP, p_visible ? RS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case RS::INSTANCE_GI_PROBE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << RS::INSTANCE_GI_PROBE, p_visible ? (RS::INSTANCE_GEOMETRY_MASK | (1 << RS::INSTANCE_LIGHT)) : 0);
+			if (instance->spatial_index_id && instance->scenario) {
+				instance->scenario->spatial_index.set_pairable(instance->spatial_index_id, p_visible, 1 << RS::INSTANCE_GI_PROBE, p_visible ? (RS::INSTANCE_GEOMETRY_MASK | (1 << RS::INSTANCE_LIGHT)) : 0);
 			}
 
 		} break;
 		case RS::INSTANCE_PARTICLES_COLLISION: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << RS::INSTANCE_PARTICLES_COLLISION, p_visible ? (1 << RS::INSTANCE_PARTICLES) : 0);
+			if (instance->spatial_index_id && instance->scenario) {
+				instance->scenario->spatial_index.set_pairable(instance->spatial_index_id, p_visible, 1 << RS::INSTANCE_PARTICLES_COLLISION, p_visible ? (1 << RS::INSTANCE_PARTICLES) : 0);
 			}
 
 		} break;
@@ -786,7 +788,7 @@ Vector<ObjectID> RenderingServerScene::instances_cull_aabb(const AABB &p_aabb, R
 
 	int culled = 0;
 	Instance *cull[1024];
-	culled = scenario->octree.cull_aabb(p_aabb, cull, 1024);
+	culled = scenario->spatial_index.cull_aabb(p_aabb, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 		Instance *instance = cull[i];
@@ -809,7 +811,7 @@ Vector<ObjectID> RenderingServerScene::instances_cull_ray(const Vector3 &p_from,
 
 	int culled = 0;
 	Instance *cull[1024];
-	culled = scenario->octree.cull_segment(p_from, p_from + p_to * 10000, cull, 1024);
+	culled = scenario->spatial_index.cull_segment(p_from, p_from + p_to * 10000, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 		Instance *instance = cull[i];
@@ -833,7 +835,7 @@ Vector<ObjectID> RenderingServerScene::instances_cull_convex(const Vector<Plane>
 	int culled = 0;
 	Instance *cull[1024];
 
-	culled = scenario->octree.cull_convex(p_convex, cull, 1024);
+	culled = scenario->spatial_index.cull_convex(p_convex, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 		Instance *instance = cull[i];
@@ -865,14 +867,14 @@ void RenderingServerScene::instance_geometry_set_flag(RID p_instance, RS::Instan
 				return;
 			}
 
-			if (instance->octree_id != 0) {
-				//remove from octree, it needs to be re-paired
-				instance->scenario->octree.erase(instance->octree_id);
-				instance->octree_id = 0;
+			if (instance->spatial_index_id != 0) {
+				//remove from spatial index, it needs to be re-paired
+				instance->scenario->spatial_index.erase(instance->spatial_index_id);
+				instance->spatial_index_id = 0;
 				_instance_queue_update(instance, true, true);
 			}
 
-			//once out of octree, can be changed
+			//once out of spatial index, can be changed
 			instance->dynamic_gi = p_enabled;
 
 		} break;
@@ -1095,7 +1097,7 @@ void RenderingServerScene::_update_instance(Instance *p_instance) {
 		return;
 	}
 
-	if (p_instance->octree_id == 0) {
+	if (p_instance->spatial_index_id == 0) {
 		uint32_t base_type = 1 << p_instance->base_type;
 		uint32_t pairable_mask = 0;
 		bool pairable = false;
@@ -1116,8 +1118,8 @@ void RenderingServerScene::_update_instance(Instance *p_instance) {
 			pairable = true;
 		}
 
-		// not inside octree
-		p_instance->octree_id = p_instance->scenario->octree.create(p_instance, new_aabb, 0, pairable, base_type, pairable_mask);
+		// not inside spatial index
+		p_instance->spatial_index_id = p_instance->scenario->spatial_index.create(p_instance, new_aabb, 0, pairable, base_type, pairable_mask);
 
 	} else {
 		/*
@@ -1125,7 +1127,7 @@ void RenderingServerScene::_update_instance(Instance *p_instance) {
 			return;
 		*/
 
-		p_instance->scenario->octree.move(p_instance->octree_id, new_aabb);
+		p_instance->scenario->spatial_index.move(p_instance->spatial_index_id, new_aabb);
 	}
 }
 
@@ -1242,7 +1244,7 @@ void RenderingServerScene::_update_instance_lightmap_captures(Instance *p_instan
 		//rotate it
 		Basis rot = lightmap->transform.basis.orthonormalized();
 		for (int i = 0; i < 3; i++) {
-			float csh[9];
+			real_t csh[9];
 			for (int j = 0; j < 9; j++) {
 				csh[j] = sh[j][i];
 			}
@@ -1310,7 +1312,7 @@ bool RenderingServerScene::_light_instance_update_shadow(Instance *p_instance, c
 			if (depth_range_mode == RS::LIGHT_DIRECTIONAL_SHADOW_DEPTH_RANGE_OPTIMIZED) {
 				//optimize min/max
 				Vector<Plane> planes = p_cam_projection.get_projection_planes(p_cam_transform);
-				int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
+				int cull_count = p_scenario->spatial_index.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
 				Plane base(p_cam_transform.origin, -p_cam_transform.basis.get_axis(2));
 				//check distance max and min
 
@@ -1534,7 +1536,7 @@ bool RenderingServerScene::_light_instance_update_shadow(Instance *p_instance, c
 				light_frustum_planes.write[4] = Plane(z_vec, z_max + 1e6);
 				light_frustum_planes.write[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
 
-				int cull_count = p_scenario->octree.cull_convex(light_frustum_planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
+				int cull_count = p_scenario->spatial_index.cull_convex(light_frustum_planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
 
 				// a pre pass will need to be needed to determine the actual z-near to be used
 
@@ -1681,7 +1683,7 @@ bool RenderingServerScene::_light_instance_update_shadow(Instance *p_instance, c
 					planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
 					planes.write[5] = light_transform.xform(Plane(Vector3(0, 0, -z), 0));
 
-					int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
+					int cull_count = p_scenario->spatial_index.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
 					Plane near_plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
 
 					for (int j = 0; j < cull_count; j++) {
@@ -1734,7 +1736,7 @@ bool RenderingServerScene::_light_instance_update_shadow(Instance *p_instance, c
 
 					Vector<Plane> planes = cm.get_projection_planes(xform);
 
-					int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
+					int cull_count = p_scenario->spatial_index.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
 
 					Plane near_plane(xform.origin, -xform.basis.get_axis(2));
 					for (int j = 0; j < cull_count; j++) {
@@ -1771,7 +1773,7 @@ bool RenderingServerScene::_light_instance_update_shadow(Instance *p_instance, c
 			cm.set_perspective(angle * 2.0, 1.0, 0.01, radius);
 
 			Vector<Plane> planes = cm.get_projection_planes(light_transform);
-			int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
+			int cull_count = p_scenario->spatial_index.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, RS::INSTANCE_GEOMETRY_MASK);
 
 			Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
 			for (int j = 0; j < cull_count; j++) {
@@ -1958,7 +1960,7 @@ void RenderingServerScene::_prepare_scene(const Transform p_cam_transform, const
 	float z_far = p_cam_projection.get_z_far();
 
 	/* STEP 2 - CULL */
-	instance_cull_count = scenario->octree.cull_convex(planes, instance_cull_result, MAX_INSTANCE_CULL);
+	instance_cull_count = scenario->spatial_index.cull_convex(planes, instance_cull_result, MAX_INSTANCE_CULL);
 	light_cull_count = 0;
 
 	reflection_probe_cull_count = 0;
@@ -1970,9 +1972,9 @@ void RenderingServerScene::_prepare_scene(const Transform p_cam_transform, const
 
 	/*
 	print_line("OT: "+rtos( (OS::get_singleton()->get_ticks_usec()-t)/1000.0));
-	print_line("OTO: "+itos(p_scenario->octree.get_octant_count()));
-	print_line("OTE: "+itos(p_scenario->octree.get_elem_count()));
-	print_line("OTP: "+itos(p_scenario->octree.get_pair_count()));
+	print_line("OTO: "+itos(p_scenario->spatial_index.get_octant_count()));
+	print_line("OTE: "+itos(p_scenario->spatial_index.get_elem_count()));
+	print_line("OTP: "+itos(p_scenario->spatial_index.get_pair_count()));
 	*/
 
 	/* STEP 3 - PROCESS PORTALS, VALIDATE ROOMS */
@@ -2309,7 +2311,7 @@ void RenderingServerScene::_prepare_scene(const Transform p_cam_transform, const
 				sdfgi_light_cull_pass++;
 				prev_cascade = region_cascade;
 			}
-			uint32_t sdfgi_cull_count = scenario->octree.cull_aabb(region, instance_shadow_cull_result, MAX_INSTANCE_CULL);
+			uint32_t sdfgi_cull_count = scenario->spatial_index.cull_aabb(region, instance_shadow_cull_result, MAX_INSTANCE_CULL);
 
 			for (uint32_t j = 0; j < sdfgi_cull_count; j++) {
 				Instance *ins = instance_shadow_cull_result[j];
@@ -2714,7 +2716,7 @@ void RenderingServerScene::render_particle_colliders() {
 
 		if (hfpc->scenario && hfpc->base_type == RS::INSTANCE_PARTICLES_COLLISION && RSG::storage->particles_collision_is_heightfield(hfpc->base)) {
 			//update heightfield
-			int cull_count = hfpc->scenario->octree.cull_aabb(hfpc->transformed_aabb, instance_cull_result, MAX_INSTANCE_CULL); //@TODO: cull mask missing
+			int cull_count = hfpc->scenario->spatial_index.cull_aabb(hfpc->transformed_aabb, instance_cull_result, MAX_INSTANCE_CULL); //@TODO: cull mask missing
 			for (int i = 0; i < cull_count; i++) {
 				Instance *instance = instance_cull_result[i];
 				if (!instance->visible || !((1 << instance->base_type) & (RS::INSTANCE_GEOMETRY_MASK & (~(1 << RS::INSTANCE_PARTICLES))))) { //all but particles to avoid self collision
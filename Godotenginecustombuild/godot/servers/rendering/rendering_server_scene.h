@@ -33,6 +33,7 @@
 
 #include "servers/rendering/rasterizer.h"
 
+#include "core/math/dynamic_bvh.h"
 #include "core/math/geometry_3d.h"
 #include "core/math/octree.h"
 #include "core/os/semaphore.h"
@@ -107,11 +108,71 @@ public:
 
 	struct Instance;
 
+	// Octree or DynamicBVH, as chosen by rendering/quality/spatial_partitioning/use_bvh
+	// when the scenario is created.
+	class SpatialIndex {
+		bool use_bvh = false;
+		Octree<Instance, true> octree;
+		DynamicBVH<Instance, true> bvh;
+
+	public:
+		typedef Octree<Instance, true>::PairCallback PairCallback;
+		typedef Octree<Instance, true>::UnpairCallback UnpairCallback;
+
+		void set_use_bvh(bool p_enable) { use_bvh = p_enable; }
+
+		_FORCE_INLINE_ OctreeElementID create(Instance *p_instance, const AABB &p_aabb, int p_subindex, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+			return use_bvh ? bvh.create(p_instance, p_aabb, p_subindex, p_pairable, p_pairable_type, p_pairable_mask) : octree.create(p_instance, p_aabb, p_subindex, p_pairable, p_pairable_type, p_pairable_mask);
+		}
+		_FORCE_INLINE_ void move(OctreeElementID p_id, const AABB &p_aabb) {
+			if (use_bvh) {
+				bvh.move(p_id, p_aabb);
+			} else {
+				octree.move(p_id, p_aabb);
+			}
+		}
+		_FORCE_INLINE_ void set_pairable(OctreeElementID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+			if (use_bvh) {
+				bvh.set_pairable(p_id, p_pairable, p_pairable_type, p_pairable_mask);
+			} else {
+				octree.set_pairable(p_id, p_pairable, p_pairable_type, p_pairable_mask);
+			}
+		}
+		_FORCE_INLINE_ void erase(OctreeElementID p_id) {
+			if (use_bvh) {
+				bvh.erase(p_id);
+			} else {
+				octree.erase(p_id);
+			}
+		}
+
+		_FORCE_INLINE_ int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) {
+			return use_bvh ? bvh.cull_convex(p_convex, p_result_array, p_result_max, p_mask) : octree.cull_convex(p_convex, p_result_array, p_result_max, p_mask);
+		}
+		_FORCE_INLINE_ int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF) {
+			return use_bvh ? bvh.cull_aabb(p_aabb, p_result_array, p_result_max, p_subindex_array, p_mask) : octree.cull_aabb(p_aabb, p_result_array, p_result_max, p_subindex_array, p_mask);
+		}
+		_FORCE_INLINE_ int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, int *p_subindex_array = nullptr, uint32_t p_mask = 0xFFFFFFFF) {
+			return use_bvh ? bvh.cull_segment(p_from, p_to, p_result_array, p_result_max, p_subindex_array, p_mask) : octree.cull_segment(p_from, p_to, p_result_array, p_result_max, p_subindex_array, p_mask);
+		}
+
+		void set_pair_callback(PairCallback p_callback, void *p_userdata) {
+			octree.set_pair_callback(p_callback, p_userdata);
+			bvh.set_pair_callback(p_callback, p_userdata);
+		}
+		void set_unpair_callback(UnpairCallback p_callback, void *p_userdata) {
+			octree.set_unpair_callback(p_callback, p_userdata);
+			bvh.set_unpair_callback(p_callback, p_userdata);
+		}
+
+		int get_pair_count() const { return use_bvh ? bvh.get_pair_count() : octree.get_pair_count(); }
+	};
+
 	struct Scenario {
 		RS::ScenarioDebugMode debug;
 		RID self;
 
-		Octree<Instance, true> octree;
+		SpatialIndex spatial_index;
 
 		List<Instance *> directional_lights;
 		RID environment;
@@ -149,7 +210,7 @@ public:
 	struct Instance : RasterizerScene::InstanceBase {
 		RID self;
 		//scenario stuff
-		OctreeElementID octree_id;
+		OctreeElementID spatial_index_id;
 		Scenario *scenario;
 		SelfList<Instance> scenario_item;
 
@@ -195,7 +256,7 @@ public:
 		Instance() :
 				scenario_item(this),
 				update_item(this) {
-			octree_id = 0;
+			spatial_index_id = 0;
 			scenario = nullptr;
 
 			update_aabb = false;
@@ -90,6 +90,29 @@ TEST_CASE("[AStar] ABCX path") {
 	CHECK(path[3] == ABCX::C);
 }
 
+TEST_CASE("[AStar] Batched paths") {
+	ABCX abcx;
+	Vector<int> from_ids;
+	Vector<int> to_ids;
+	// Enough queries to be solved in parallel.
+	for (int i = 0; i < 64; i++) {
+		from_ids.push_back(i % 2 ? ABCX::X : ABCX::A);
+		to_ids.push_back(i % 3 ? ABCX::C : ABCX::A);
+	}
+	from_ids.push_back(ABCX::A);
+	to_ids.push_back(42); // Missing point, gives an empty path.
+
+	ERR_PRINT_OFF;
+	Array paths = abcx.get_id_paths(from_ids, to_ids);
+	ERR_PRINT_ON;
+	REQUIRE(paths.size() == from_ids.size());
+	for (int i = 0; i < 64; i++) {
+		Vector<int> path = paths[i];
+		CHECK(path == abcx.get_id_path(from_ids[i], to_ids[i]));
+	}
+	CHECK(Vector<int>(paths[64]).size() == 0);
+}
+
 TEST_CASE("[AStar] Add/Remove") {
 	AStar a;
 
@@ -0,0 +1,226 @@
+/*************************************************************************/
+/*  test_body_storage_3d.h                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_BODY_STORAGE_3D_H
+#define TEST_BODY_STORAGE_3D_H
+
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "core/string/print_string.h"
+#include "servers/physics_3d/body_storage_3d_sw.h"
+#include "servers/physics_server_3d.h"
+
+#include "tests/test_macros.h"
+
+namespace TestBodyStorage3D {
+
+TEST_CASE("[BodyStorage3D] Handles survive activation and removal") {
+	BodyStorage3DSW storage;
+	LocalVector<uint32_t> handles;
+	for (int i = 0; i < 100; i++) {
+		handles.push_back(storage.create(nullptr));
+		storage.linear_velocity[storage.get_index(handles[i])] = Vector3(i, 0, 0);
+	}
+	CHECK(storage.get_active_count() == 0);
+
+	for (int i = 0; i < 100; i += 3) {
+		storage.set_active(handles[i], true);
+	}
+	storage.free(handles[30]);
+	storage.free(handles[31]);
+
+	CHECK(storage.size() == 98);
+	CHECK(storage.get_active_count() == 33);
+	for (int i = 0; i < 100; i++) {
+		if (i == 30 || i == 31) {
+			continue;
+		}
+		uint32_t index = storage.get_index(handles[i]);
+		CHECK(storage.handle[index] == handles[i]);
+		CHECK(storage.linear_velocity[index].x == i);
+		CHECK(storage.is_active(handles[i]) == (i % 3 == 0));
+	}
+
+	BodyStorage3DSW other;
+	uint32_t moved = storage.transfer(handles[3], other);
+	CHECK(storage.size() == 97);
+	CHECK(other.size() == 1);
+	CHECK(other.linear_velocity[other.get_index(moved)].x == 3);
+	CHECK_MESSAGE(!other.is_active(moved), "Bodies should start out inactive in their new storage.");
+}
+
+TEST_CASE("[BodyStorage3D] Integration") {
+	BodyStorage3DSW storage;
+	uint32_t falling = storage.create(nullptr);
+	uint32_t locked = storage.create(nullptr);
+	storage.set_active(falling, true);
+	storage.set_active(locked, true);
+
+	const real_t step = 0.5;
+	for (uint32_t i = 0; i < storage.size(); i++) {
+		storage.flags[i] = BodyStorage3DSW::FLAG_INTEGRATE_FORCES | BodyStorage3DSW::FLAG_INTEGRATE_VELOCITIES;
+		storage.force[i] = Vector3(0, -10, 0);
+	}
+	storage.locked_axis[storage.get_index(locked)] = PhysicsServer3D::BODY_AXIS_LINEAR_Y;
+
+	storage.integrate_forces(0, storage.get_active_count(), step);
+	CHECK(storage.linear_velocity[storage.get_index(falling)].is_equal_approx(Vector3(0, -5, 0)));
+	CHECK_MESSAGE(storage.force[storage.get_index(falling)] == Vector3(), "Forces should be consumed.");
+
+	storage.integrate_velocities(0, storage.get_active_count(), step);
+	CHECK(storage.transform[storage.get_index(falling)].origin.is_equal_approx(Vector3(0, -2.5, 0)));
+	CHECK(storage.transform[storage.get_index(locked)].origin == Vector3());
+	CHECK(storage.linear_velocity[storage.get_index(locked)] == Vector3());
+}
+
+// Same state and integration as the storage, with each body allocated on its own
+// like the bodies themselves are. Only there for comparison.
+struct ScatteredBody {
+	Transform transform;
+	Vector3 linear_velocity;
+	Vector3 angular_velocity;
+	Vector3 force;
+	Vector3 torque;
+	real_t inv_mass = 1;
+	Vector3 inv_inertia = Vector3(1, 1, 1);
+	Basis inv_inertia_tensor;
+	Basis principal_inertia_axes_local;
+	Basis principal_inertia_axes;
+	Vector3 center_of_mass_local;
+	Vector3 center_of_mass;
+	uint8_t padding[512]; // The cold state of a body.
+};
+
+// Run with `godot --test body-storage-benchmark`.
+void benchmark() {
+	const int count = 10000;
+	const int frames = 300;
+	const real_t step = 1.0 / 60.0;
+
+	RandomPCG rng(42);
+	BodyStorage3DSW storage;
+	LocalVector<ScatteredBody *> scattered;
+
+	for (int i = 0; i < count; i++) {
+		Vector3 origin(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f));
+		Vector3 angular_velocity(rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f));
+
+		uint32_t index = storage.get_index(storage.create(nullptr));
+		storage.transform[index].origin = origin;
+		storage.angular_velocity[index] = angular_velocity;
+		storage.inv_inertia[index] = Vector3(1, 1, 1);
+		storage.update_transform_dependant(index);
+
+		ScatteredBody *body = memnew(ScatteredBody);
+		body->transform.origin = origin;
+		body->angular_velocity = angular_velocity;
+		scattered.push_back(body);
+	}
+	// A third of the bodies sleep, they are spread over the whole storage.
+	for (int i = 0; i < count; i++) {
+		storage.set_active(storage.handle[i], i % 3 != 0);
+	}
+	// Bodies are allocated over time, in no particular order.
+	for (int i = count - 1; i > 0; i--) {
+		SWAP(scattered[i], scattered[rng.random(0, i)]);
+	}
+
+	uint64_t forces_usec = 0;
+	uint64_t velocities_usec = 0;
+	for (int frame = 0; frame < frames; frame++) {
+		uint32_t active = storage.get_active_count();
+		for (uint32_t i = 0; i < active; i++) {
+			storage.flags[i] = BodyStorage3DSW::FLAG_INTEGRATE_FORCES | BodyStorage3DSW::FLAG_INTEGRATE_VELOCITIES;
+			storage.force[i] = Vector3(0, -9.8, 0);
+		}
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		storage.integrate_forces(0, active, step);
+		uint64_t middle = OS::get_singleton()->get_ticks_usec();
+		storage.integrate_velocities(0, active, step);
+		forces_usec += middle - begin;
+		velocities_usec += OS::get_singleton()->get_ticks_usec() - middle;
+	}
+
+	uint64_t scattered_forces_usec = 0;
+	uint64_t scattered_velocities_usec = 0;
+	for (int frame = 0; frame < frames; frame++) {
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < count; i++) {
+			ScatteredBody *body = scattered[i];
+			if (i % 3 == 0) {
+				continue; // Asleep.
+			}
+			body->force = Vector3(0, -9.8, 0);
+			body->linear_velocity += body->force * (body->inv_mass * step);
+			body->angular_velocity += body->inv_inertia_tensor.xform(body->torque) * step;
+			body->force = Vector3();
+		}
+		uint64_t middle = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < count; i++) {
+			ScatteredBody *body = scattered[i];
+			if (i % 3 == 0) {
+				continue;
+			}
+			Transform &t = body->transform;
+			real_t ang_vel = body->angular_velocity.length();
+			if (ang_vel != 0.0) {
+				Basis rot(body->angular_velocity / ang_vel, ang_vel * step);
+				t.origin += ((Basis() - rot) * t.basis).xform(body->center_of_mass_local);
+				t.basis = rot * t.basis;
+				t.orthonormalize();
+			}
+			t.origin += body->linear_velocity * step;
+
+			body->center_of_mass = t.basis.xform(body->center_of_mass_local);
+			body->principal_inertia_axes = t.basis * body->principal_inertia_axes_local;
+			Basis diag;
+			diag.scale(body->inv_inertia);
+			body->inv_inertia_tensor = body->principal_inertia_axes * diag * body->principal_inertia_axes.transposed();
+		}
+		scattered_forces_usec += middle - begin;
+		scattered_velocities_usec += OS::get_singleton()->get_ticks_usec() - middle;
+	}
+
+	for (int i = 0; i < count; i++) {
+		memdelete(scattered[i]);
+	}
+
+	print_line(vformat("%d bodies, %d active: integrate_forces %.3f ms/frame, integrate_velocities %.3f ms/frame",
+			count, storage.get_active_count(), forces_usec / 1000.0 / frames, velocities_usec / 1000.0 / frames));
+	print_line(vformat("Separately allocated bodies: integrate_forces %.3f ms/frame, integrate_velocities %.3f ms/frame",
+			scattered_forces_usec / 1000.0 / frames, scattered_velocities_usec / 1000.0 / frames));
+}
+
+REGISTER_TEST_COMMAND("body-storage-benchmark", &benchmark);
+
+} // namespace TestBodyStorage3D
+
+#endif // TEST_BODY_STORAGE_3D_H
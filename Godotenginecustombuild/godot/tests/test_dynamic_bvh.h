@@ -0,0 +1,309 @@
+/*************************************************************************/
+/*  test_dynamic_bvh.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_DYNAMIC_BVH_H
+#define TEST_DYNAMIC_BVH_H
+
+#include "core/math/dynamic_bvh.h"
+#include "core/math/octree.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "core/string/print_string.h"
+#include "core/templates/set.h"
+
+#include "tests/test_macros.h"
+
+namespace TestDynamicBVH {
+
+struct Item {
+	int index = 0;
+};
+
+// Remembers which pairs the tree reported as overlapping.
+struct PairTracker {
+	Set<uint64_t> pairs;
+
+	static uint64_t key(Item *p_A, Item *p_B) {
+		int a = MIN(p_A->index, p_B->index);
+		int b = MAX(p_A->index, p_B->index);
+		return (uint64_t(a) << 32) | uint64_t(b);
+	}
+
+	static void *pair(void *p_self, DynamicBVHElementID, Item *p_A, int, DynamicBVHElementID, Item *p_B, int) {
+		PairTracker *self = (PairTracker *)p_self;
+		CHECK_MESSAGE(!self->pairs.has(key(p_A, p_B)), "Pairs should not be reported twice.");
+		self->pairs.insert(key(p_A, p_B));
+		return nullptr;
+	}
+
+	static void unpair(void *p_self, DynamicBVHElementID, Item *p_A, int, DynamicBVHElementID, Item *p_B, int, void *) {
+		PairTracker *self = (PairTracker *)p_self;
+		CHECK_MESSAGE(self->pairs.has(key(p_A, p_B)), "Only reported pairs should be unpaired.");
+		self->pairs.erase(key(p_A, p_B));
+	}
+};
+
+AABB random_aabb(RandomPCG &p_rng, real_t p_extent, real_t p_max_size) {
+	Vector3 pos(p_rng.random(-p_extent, p_extent), p_rng.random(-p_extent, p_extent), p_rng.random(-p_extent, p_extent));
+	real_t size = p_rng.random(real_t(0.1), p_max_size);
+	return AABB(pos, Vector3(size, size, size));
+}
+
+TEST_CASE("[DynamicBVH] Culling matches brute force") {
+	const int count = 500;
+	RandomPCG rng(1234);
+	Item items[count];
+	AABB aabbs[count];
+	DynamicBVHElementID ids[count];
+	DynamicBVH<Item> bvh;
+
+	for (int i = 0; i < count; i++) {
+		items[i].index = i;
+		aabbs[i] = random_aabb(rng, 100, 5);
+		ids[i] = bvh.create(&items[i], aabbs[i]);
+	}
+	CHECK(bvh.get_element_count() == count);
+	CHECK(bvh.get_node_count() == count * 2 - 1);
+
+	Item *results[count];
+	for (int step = 0; step < 20; step++) {
+		for (int i = 0; i < count; i++) {
+			aabbs[i].position += Vector3(rng.random(-3.0f, 3.0f), rng.random(-3.0f, 3.0f), rng.random(-3.0f, 3.0f));
+			bvh.move(ids[i], aabbs[i]);
+		}
+
+		AABB query = random_aabb(rng, 100, 40);
+		int culled = bvh.cull_aabb(query, results, count);
+		int expected = 0;
+		for (int i = 0; i < count; i++) {
+			if (query.intersects_inclusive(aabbs[i])) {
+				expected++;
+			}
+		}
+		CHECK(culled == expected);
+		for (int i = 0; i < culled; i++) {
+			CHECK(query.intersects_inclusive(aabbs[results[i]->index]));
+		}
+
+		Vector3 point = aabbs[step].position + aabbs[step].size * 0.5;
+		culled = bvh.cull_point(point, results, count);
+		expected = 0;
+		for (int i = 0; i < count; i++) {
+			if (aabbs[i].has_point(point)) {
+				expected++;
+			}
+		}
+		CHECK(culled == expected);
+	}
+
+	// A balanced tree of 500 leaves is far from the 256 levels the traversal stack can hold.
+	CHECK(bvh.get_height() < 20);
+
+	for (int i = 0; i < count; i += 2) {
+		bvh.erase(ids[i]);
+	}
+	CHECK(bvh.get_element_count() == count / 2);
+	CHECK(bvh.get_node_count() == count - 1);
+	CHECK(bvh.cull_aabb(AABB(Vector3(-1000, -1000, -1000), Vector3(2000, 2000, 2000)), results, count) == count / 2);
+}
+
+TEST_CASE("[DynamicBVH] Pairs follow the exact AABBs") {
+	const int count = 300;
+	RandomPCG rng(4321);
+	Item items[count];
+	AABB aabbs[count];
+	DynamicBVHElementID ids[count];
+	PairTracker tracker;
+	DynamicBVH<Item, true> bvh;
+	bvh.set_pair_callback(PairTracker::pair, &tracker);
+	bvh.set_unpair_callback(PairTracker::unpair, &tracker);
+
+	for (int i = 0; i < count; i++) {
+		items[i].index = i;
+		aabbs[i] = random_aabb(rng, 40, 6);
+		// One in four is static, statics never pair with each other.
+		bool pairable = i % 4 != 0;
+		ids[i] = bvh.create(&items[i], aabbs[i], 0, pairable, 1, pairable ? 0xFFFFF : 0);
+	}
+
+	for (int step = 0; step < 30; step++) {
+		for (int i = 0; i < count; i++) {
+			if (i % 4 == 0) {
+				continue;
+			}
+			// Every now and then something jumps far away.
+			Vector3 motion = step % 10 == 9 && i % 7 == 0 ? Vector3(rng.random(-60.0f, 60.0f), 0, 0) : Vector3(rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f));
+			aabbs[i].position += motion;
+			bvh.move(ids[i], aabbs[i]);
+		}
+
+		int expected = 0;
+		for (int i = 0; i < count; i++) {
+			for (int j = i + 1; j < count; j++) {
+				if (i % 4 == 0 && j % 4 == 0) {
+					continue;
+				}
+				if (aabbs[i].intersects_inclusive(aabbs[j])) {
+					expected++;
+					CHECK(tracker.pairs.has((uint64_t(i) << 32) | uint64_t(j)));
+				}
+			}
+		}
+		CHECK(bvh.get_pair_count() == expected);
+		CHECK(tracker.pairs.size() == expected);
+	}
+
+	// Making everything static drops every pair.
+	for (int i = 0; i < count; i++) {
+		bvh.set_pairable(ids[i], false, 1, 0);
+	}
+	CHECK(bvh.get_pair_count() == 0);
+	CHECK(tracker.pairs.size() == 0);
+
+	for (int i = 0; i < count; i++) {
+		bvh.erase(ids[i]);
+	}
+	CHECK(bvh.get_element_count() == 0);
+	CHECK(bvh.get_node_count() == 0);
+}
+
+TEST_CASE("[DynamicBVH] Elements without a surface are kept out of the tree") {
+	Item a;
+	Item b;
+	PairTracker tracker;
+	DynamicBVH<Item, true> bvh;
+	bvh.set_pair_callback(PairTracker::pair, &tracker);
+	bvh.set_unpair_callback(PairTracker::unpair, &tracker);
+
+	DynamicBVHElementID id_a = bvh.create(&a, AABB(), 0, true, 1, 1);
+	DynamicBVHElementID id_b = bvh.create(&b, AABB(Vector3(), Vector3(1, 1, 1)), 0, true, 1, 1);
+	CHECK(id_a != DYNAMIC_BVH_ELEMENT_INVALID_ID);
+	CHECK(bvh.get(id_a) == &a);
+	CHECK(bvh.get_node_count() == 1);
+
+	bvh.move(id_a, AABB(Vector3(0.5, 0.5, 0.5), Vector3(1, 1, 1)));
+	CHECK(bvh.get_pair_count() == 1);
+
+	bvh.move(id_a, AABB());
+	CHECK(bvh.get_pair_count() == 0);
+	CHECK(tracker.pairs.size() == 0);
+	CHECK(bvh.get_node_count() == 1);
+
+	bvh.erase(id_a);
+	bvh.erase(id_b);
+	CHECK(bvh.get_element_count() == 0);
+}
+
+// Moving objects in a sparse asteroid field, as seen by a physics
+// broadphase: every object is pairable except one in ten, which is static.
+// Run with `godot --test dynamic-bvh-benchmark`.
+template <class Tree>
+uint64_t benchmark_asteroid_field(Tree &p_tree, int p_count, int p_frames, int &r_pairs) {
+	RandomPCG rng(42);
+	// About one asteroid per 200x200x200 meter cell.
+	real_t extent = Math::pow(real_t(p_count), real_t(1.0 / 3.0)) * 100;
+
+	LocalVector<Item> items;
+	LocalVector<AABB> aabbs;
+	LocalVector<Vector3> velocities;
+	LocalVector<uint32_t> ids;
+	items.resize(p_count);
+	aabbs.resize(p_count);
+	velocities.resize(p_count);
+	ids.resize(p_count);
+
+	for (int i = 0; i < p_count; i++) {
+		items[i].index = i;
+		aabbs[i] = random_aabb(rng, extent, 40);
+		// Up to 1.5 km/s, a fair share of objects leave their cell every frame.
+		velocities[i] = Vector3(rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f)) * rng.random(0.0f, 1500.0f);
+		bool pairable = i % 10 != 0;
+		ids[i] = p_tree.create(&items[i], aabbs[i], 0, pairable, 1, pairable ? 0xFFFFF : 0);
+	}
+
+	Item *results[1024];
+	const real_t delta = 1.0 / 60.0;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int frame = 0; frame < p_frames; frame++) {
+		for (int i = 0; i < p_count; i++) {
+			if (i % 10 == 0) {
+				continue;
+			}
+			Vector3 &pos = aabbs[i].position;
+			pos += velocities[i] * delta;
+			// Bounce off the edge of the field.
+			for (int axis = 0; axis < 3; axis++) {
+				if (pos[axis] < -extent || pos[axis] > extent) {
+					velocities[i][axis] = -velocities[i][axis];
+				}
+			}
+			p_tree.move(ids[i], aabbs[i]);
+		}
+
+		// A few queries, like rays and area checks from ships.
+		for (int i = 0; i < 64; i++) {
+			p_tree.cull_aabb(random_aabb(rng, extent, 500), results, 1024);
+		}
+	}
+
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+	r_pairs = p_tree.get_pair_count();
+
+	for (int i = 0; i < p_count; i++) {
+		p_tree.erase(ids[i]);
+	}
+
+	return elapsed;
+}
+
+void benchmark() {
+	const int counts[] = { 10000, 30000, 100000 };
+	const int frames = 60;
+
+	for (int i = 0; i < 3; i++) {
+		int bvh_pairs = 0;
+		int octree_pairs = 0;
+
+		DynamicBVH<Item, true> bvh;
+		uint64_t bvh_usec = benchmark_asteroid_field(bvh, counts[i], frames, bvh_pairs);
+		Octree<Item, true> octree;
+		uint64_t octree_usec = benchmark_asteroid_field(octree, counts[i], frames, octree_pairs);
+
+		print_line(vformat("%d objects: DynamicBVH %.3f ms/frame (%d pairs), Octree %.3f ms/frame (%d pairs)",
+				counts[i], bvh_usec / 1000.0 / frames, bvh_pairs, octree_usec / 1000.0 / frames, octree_pairs));
+	}
+}
+
+REGISTER_TEST_COMMAND("dynamic-bvh-benchmark", &benchmark);
+
+} // namespace TestDynamicBVH
+
+#endif // TEST_DYNAMIC_BVH_H
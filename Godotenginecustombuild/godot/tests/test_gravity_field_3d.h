@@ -0,0 +1,84 @@
+/*************************************************************************/
+/*  test_gravity_field_3d.h                                              */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_GRAVITY_FIELD_3D_H
+#define TEST_GRAVITY_FIELD_3D_H
+
+#include "core/math/random_pcg.h"
+#include "servers/physics_3d/gravity_field_3d_sw.h"
+
+#include "tests/test_macros.h"
+
+namespace TestGravityField3D {
+
+TEST_CASE("[GravityField3D] Empty field") {
+	GravityField3DSW field;
+	field.build(0.5, 0);
+	CHECK(field.is_empty());
+	CHECK(field.evaluate(Vector3(1, 2, 3)) == Vector3());
+}
+
+TEST_CASE("[GravityField3D] Single attractor") {
+	GravityField3DSW field;
+	field.add_attractor(Vector3(10, 0, 0), 400);
+	field.build(0.5, 0);
+
+	Vector3 accel = field.evaluate(Vector3(0, 0, 0));
+	CHECK(accel.is_equal_approx(Vector3(4, 0, 0)));
+
+	// No self attraction.
+	CHECK(field.evaluate(Vector3(10, 0, 0)) == Vector3());
+}
+
+TEST_CASE("[GravityField3D] Barnes-Hut matches direct sum") {
+	RandomPCG rng(1234);
+	GravityField3DSW approx;
+	GravityField3DSW exact;
+	for (int i = 0; i < 2000; i++) {
+		Vector3 pos(rng.random(-1000.0f, 1000.0f), rng.random(-1000.0f, 1000.0f), rng.random(-1000.0f, 1000.0f));
+		real_t mass = rng.random(1.0f, 100.0f);
+		approx.add_attractor(pos, mass);
+		exact.add_attractor(pos, mass);
+	}
+	approx.build(0.5, 1);
+	exact.build(0, 1);
+	CHECK(approx.get_attractor_count() == 2000);
+
+	for (int i = 0; i < 20; i++) {
+		Vector3 pos(rng.random(-3000.0f, 3000.0f), rng.random(-3000.0f, 3000.0f), rng.random(-3000.0f, 3000.0f));
+		Vector3 a = approx.evaluate(pos);
+		Vector3 e = exact.evaluate(pos);
+		CHECK_MESSAGE((a - e).length() < e.length() * 0.01, "Error should stay below one percent.");
+	}
+}
+
+} // namespace TestGravityField3D
+
+#endif // TEST_GRAVITY_FIELD_3D_H
@@ -35,17 +35,21 @@
 #include "test_aabb.h"
 #include "test_astar.h"
 #include "test_basis.h"
+#include "test_body_storage_3d.h"
 #include "test_class_db.h"
 #include "test_color.h"
 #include "test_command_queue.h"
 #include "test_config_file.h"
 #include "test_curve.h"
+#include "test_dynamic_bvh.h"
 #include "test_expression.h"
 #include "test_gradient.h"
+#include "test_gravity_field_3d.h"
 #include "test_gui.h"
 #include "test_json.h"
 #include "test_list.h"
 #include "test_math.h"
+#include "test_message_queue.h"
 #include "test_method_bind.h"
 #include "test_node_path.h"
 #include "test_oa_hash_map.h"
@@ -54,10 +58,13 @@
 #include "test_pck_packer.h"
 #include "test_physics_2d.h"
 #include "test_physics_3d.h"
+#include "test_physics_server_3d.h"
 #include "test_rect2.h"
 #include "test_render.h"
+#include "test_scene_tree.h"
 #include "test_shader_lang.h"
 #include "test_string.h"
+#include "test_string_name.h"
 #include "test_validate_testing.h"
 #include "test_variant.h"
 
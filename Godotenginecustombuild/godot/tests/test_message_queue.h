@@ -0,0 +1,166 @@
+/*************************************************************************/
+/*  test_message_queue.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_MESSAGE_QUEUE_H
+#define TEST_MESSAGE_QUEUE_H
+
+#include "core/object/message_queue.h"
+#include "core/os/thread.h"
+
+#include "tests/test_macros.h"
+
+#include <atomic>
+
+namespace TestMessageQueue {
+
+class Receiver : public Object {
+	GDCLASS(Receiver, Object);
+
+public:
+	enum {
+		FIRST_MESSAGE = 100, // below are Object's own notifications
+		THREAD_COUNT = 4,
+		MESSAGES_PER_THREAD = 2000,
+	};
+
+	MessageQueue *queue = nullptr;
+	int last[THREAD_COUNT];
+	int received = 0;
+	bool in_order = true;
+	int requeue = 0;
+
+	void _notification(int p_what) {
+		if (p_what < FIRST_MESSAGE) {
+			return;
+		}
+		received++;
+		if (requeue > 0) {
+			queue->push_notification(this, FIRST_MESSAGE + requeue--);
+			return;
+		}
+		int thread = (p_what - FIRST_MESSAGE - 1) / MESSAGES_PER_THREAD;
+		if (thread >= 0 && thread < THREAD_COUNT) {
+			in_order = in_order && p_what == last[thread] + 1;
+			last[thread] = p_what;
+		}
+	}
+
+	Receiver() {
+		for (int i = 0; i < THREAD_COUNT; i++) {
+			last[i] = FIRST_MESSAGE + i * MESSAGES_PER_THREAD;
+		}
+	}
+};
+
+#if !defined(NO_THREADS)
+
+struct Sender {
+	Receiver *receiver;
+	int thread;
+	std::atomic<bool> done;
+};
+
+static void _send(void *p_sender) {
+	Sender *sender = (Sender *)p_sender;
+	for (int i = 1; i <= Receiver::MESSAGES_PER_THREAD; i++) {
+		sender->receiver->queue->push_notification(sender->receiver, Receiver::FIRST_MESSAGE + sender->thread * Receiver::MESSAGES_PER_THREAD + i);
+	}
+	sender->done.store(true);
+}
+
+TEST_CASE("[MessageQueue] Messages from several threads keep their order") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receiver = memnew(Receiver);
+	receiver->queue = queue;
+
+	Sender senders[Receiver::THREAD_COUNT];
+	Thread *threads[Receiver::THREAD_COUNT];
+	for (int i = 0; i < Receiver::THREAD_COUNT; i++) {
+		senders[i].receiver = receiver;
+		senders[i].thread = i;
+		senders[i].done.store(false);
+		threads[i] = Thread::create(_send, &senders[i]);
+	}
+
+	// Flush while the threads are still sending.
+	bool sending = true;
+	while (sending) {
+		queue->flush();
+		sending = false;
+		for (int i = 0; i < Receiver::THREAD_COUNT; i++) {
+			sending = sending || !senders[i].done.load();
+		}
+	}
+	for (int i = 0; i < Receiver::THREAD_COUNT; i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+	queue->flush();
+
+	CHECK(receiver->received == Receiver::THREAD_COUNT * Receiver::MESSAGES_PER_THREAD);
+	CHECK_MESSAGE(receiver->in_order, "Messages of each thread should arrive in the order they were sent.");
+
+	memdelete(receiver);
+	memdelete(queue);
+}
+
+#endif // !defined(NO_THREADS)
+
+TEST_CASE("[MessageQueue] Growing and queueing while flushing") {
+	MessageQueue *queue = memnew(MessageQueue);
+	Receiver *receiver = memnew(Receiver);
+	receiver->queue = queue;
+
+	// Far more than one segment holds.
+	for (int i = 1; i <= Receiver::MESSAGES_PER_THREAD; i++) {
+		for (int j = 0; j < 50; j++) {
+			queue->push_notification(receiver, Receiver::FIRST_MESSAGE + i);
+		}
+	}
+	queue->flush();
+	CHECK(receiver->received == Receiver::MESSAGES_PER_THREAD * 50);
+
+	// Messages pushed by a message are handled by the same flush.
+	receiver->received = 0;
+	receiver->requeue = 1000;
+	queue->push_notification(receiver, Receiver::FIRST_MESSAGE);
+	queue->flush();
+	CHECK(receiver->received == 1001);
+	CHECK(!queue->is_flushing());
+
+	// Pending messages are released with the queue.
+	queue->push_notification(receiver, Receiver::FIRST_MESSAGE);
+	memdelete(queue);
+	memdelete(receiver);
+}
+
+} // namespace TestMessageQueue
+
+#endif // TEST_MESSAGE_QUEUE_H
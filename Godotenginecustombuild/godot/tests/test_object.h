@@ -87,6 +87,46 @@ TEST_CASE("[Object] Metadata") {
 			meta_list2.size() == 0,
 			"The metadata list should contain 0 items after removing all metadata items.");
 }
+
+TEST_CASE("[Object] Signal emission") {
+	Object emitter;
+	Object receiver;
+	emitter.add_user_signal(MethodInfo("changed", PropertyInfo(Variant::STRING, "name"), PropertyInfo(Variant::NIL, "value")));
+	emitter.add_user_signal(MethodInfo("renamed", PropertyInfo(Variant::STRING, "name")));
+	emitter.add_user_signal(MethodInfo("cleared", PropertyInfo(Variant::STRING, "name")));
+
+	emitter.connect("changed", Callable(&receiver, "set_meta"));
+	emitter.emit_signal("changed", "speed", 3.5);
+	CHECK_MESSAGE(
+			double(receiver.get_meta("speed")) == 3.5,
+			"Emitting with the exact argument types should call the native method.");
+
+	emitter.emit_signal("changed", StringName("speed"), 4.5);
+	CHECK_MESSAGE(
+			double(receiver.get_meta("speed")) == 4.5,
+			"Emitting with convertible argument types should call the native method.");
+
+	emitter.connect("renamed", Callable(&receiver, "set_meta"), varray(7));
+	emitter.emit_signal("renamed", "count");
+	CHECK_MESSAGE(
+			int(receiver.get_meta("count")) == 7,
+			"Bound arguments should be passed after the emitted ones.");
+
+	emitter.connect("cleared", Callable(&receiver, "remove_meta"), Vector<Variant>(), Object::CONNECT_ONESHOT);
+	emitter.emit_signal("cleared", "count");
+	CHECK_MESSAGE(
+			!receiver.has_meta("count"),
+			"The one-shot connection should have been called.");
+	CHECK_MESSAGE(
+			!emitter.is_connected("cleared", Callable(&receiver, "remove_meta")),
+			"The one-shot connection should be disconnected after emitting.");
+
+	emitter.disconnect("changed", Callable(&receiver, "set_meta"));
+	emitter.emit_signal("changed", "speed", 5.5);
+	CHECK_MESSAGE(
+			double(receiver.get_meta("speed")) == 4.5,
+			"Disconnected callables should not be called.");
+}
 } // namespace TestObject
 
 #endif // TEST_OBJECT_H
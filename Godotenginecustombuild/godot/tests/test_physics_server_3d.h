@@ -0,0 +1,243 @@
+/*************************************************************************/
+/*  test_physics_server_3d.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_PHYSICS_SERVER_3D_H
+#define TEST_PHYSICS_SERVER_3D_H
+
+#include "core/math/random_pcg.h"
+#include "servers/physics_3d/physics_server_3d_sw.h"
+
+#include "tests/test_macros.h"
+
+namespace TestPhysicsServer3D {
+
+// A bare server with one active space, without the scene tree around it.
+class TestSpace {
+	LocalVector<RID> rids;
+
+public:
+	PhysicsServer3DSW *server;
+	RID space;
+
+	RID create_shape(PhysicsServer3D::ShapeType p_type, const Variant &p_data) {
+		RID shape = server->shape_create(p_type);
+		server->shape_set_data(shape, p_data);
+		rids.push_back(shape);
+		return shape;
+	}
+
+	RID create_body(PhysicsServer3D::BodyMode p_mode, RID p_shape, const Vector3 &p_origin) {
+		RID body = server->body_create(p_mode);
+		server->body_set_space(body, space);
+		server->body_add_shape(body, p_shape);
+		server->body_set_state(body, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform(Basis(), p_origin));
+		// Bodies go first, they still need their shapes when freed.
+		rids.insert(0, body);
+		return body;
+	}
+
+	PhysicsDirectSpaceState3D *get_direct_state() {
+		return server->space_get_direct_state(space);
+	}
+
+	TestSpace() {
+		server = memnew(PhysicsServer3DSW);
+		server->init();
+		space = server->space_create();
+		server->space_set_active(space, true);
+	}
+
+	~TestSpace() {
+		for (uint32_t i = 0; i < rids.size(); i++) {
+			server->free(rids[i]);
+		}
+		server->free(space);
+		server->finish();
+		memdelete(server);
+	}
+};
+
+TEST_CASE("[PhysicsServer3D] Batched rays and casts match single queries") {
+	TestSpace test;
+	RID box = test.create_shape(PhysicsServer3D::SHAPE_BOX, Vector3(0.5, 0.5, 0.5));
+	RID sphere = test.create_shape(PhysicsServer3D::SHAPE_SPHERE, 0.4);
+	for (int x = 0; x < 8; x++) {
+		for (int z = 0; z < 8; z++) {
+			test.create_body(PhysicsServer3D::BODY_MODE_STATIC, (x + z) % 2 ? box : sphere, Vector3(x * 3, 0, z * 3));
+		}
+	}
+	// Moves the shapes into the broadphase.
+	test.server->step(1.0 / 60.0);
+
+	PhysicsDirectSpaceState3D *state = test.get_direct_state();
+	REQUIRE(state);
+
+	// Enough queries for the pool. The first half fans out from one point and shares
+	// broadphase chunks, the second half is spread over the whole space.
+	const int count = 256;
+	RandomPCG rng(7);
+	LocalVector<PhysicsDirectSpaceState3D::RayQuery> rays;
+	LocalVector<PhysicsDirectSpaceState3D::MotionQuery> motions;
+	rays.resize(count);
+	motions.resize(count);
+	for (int i = 0; i < count; i++) {
+		Vector3 from = i < count / 2 ? Vector3(10, 5, 10) : Vector3(rng.random(-2.0f, 23.0f), 5, rng.random(-2.0f, 23.0f));
+		Vector3 to = from + Vector3(rng.random(-8.0f, 8.0f), -10, rng.random(-8.0f, 8.0f));
+		rays[i].from = from;
+		rays[i].to = to;
+		motions[i].shape = sphere;
+		motions[i].transform = Transform(Basis(), from);
+		motions[i].motion = to - from;
+	}
+
+	LocalVector<PhysicsDirectSpaceState3D::RayResult> ray_results;
+	ray_results.resize(count);
+	int ray_hits = state->intersect_rays(rays.ptr(), count, ray_results.ptr());
+	CHECK_MESSAGE(ray_hits > 0, "Some rays should hit the grid.");
+	CHECK_MESSAGE(ray_hits < count, "Some rays should pass between the shapes.");
+
+	int single_ray_hits = 0;
+	for (int i = 0; i < count; i++) {
+		PhysicsDirectSpaceState3D::RayResult single;
+		bool hit = state->intersect_ray(rays[i].from, rays[i].to, single);
+		single_ray_hits += hit;
+		CHECK(ray_results[i].rid.is_valid() == hit);
+		if (hit) {
+			CHECK(ray_results[i].rid == single.rid);
+			CHECK(ray_results[i].shape == single.shape);
+			CHECK(ray_results[i].position.is_equal_approx(single.position));
+			CHECK(ray_results[i].normal.is_equal_approx(single.normal));
+		}
+	}
+	CHECK(ray_hits == single_ray_hits);
+
+	const real_t margin = 0.01;
+	LocalVector<PhysicsDirectSpaceState3D::MotionQueryResult> motion_results;
+	motion_results.resize(count);
+	int motion_hits = state->cast_motions(motions.ptr(), count, margin, motion_results.ptr());
+	CHECK(motion_hits > 0);
+
+	int single_motion_hits = 0;
+	for (int i = 0; i < count; i++) {
+		real_t safe = 1, unsafe = 1;
+		if (!state->cast_motion(sphere, motions[i].transform, motions[i].motion, margin, safe, unsafe)) {
+			// Overlapping at the start, which the batch reports as 0.
+			safe = 0;
+			unsafe = 0;
+		}
+		single_motion_hits += safe < 1;
+		CHECK(Math::is_equal_approx(motion_results[i].closest_safe, safe));
+		CHECK(Math::is_equal_approx(motion_results[i].closest_unsafe, unsafe));
+	}
+	CHECK(motion_hits == single_motion_hits);
+
+	// An invalid shape only fails its own query, the others are still filled in.
+	LocalVector<PhysicsDirectSpaceState3D::MotionQueryResult> valid_results;
+	valid_results.resize(count);
+	for (int i = 0; i < count; i++) {
+		valid_results[i] = motion_results[i];
+		motion_results[i].closest_safe = -1;
+		motion_results[i].closest_unsafe = -1;
+	}
+	motions[1].shape = RID();
+	ERR_PRINT_OFF;
+	int hits_with_invalid = state->cast_motions(motions.ptr(), count, margin, motion_results.ptr());
+	ERR_PRINT_ON;
+	CHECK(motion_results[1].closest_safe == 1);
+	CHECK(motion_results[1].closest_unsafe == 1);
+	for (int i = 0; i < count; i++) {
+		if (i != 1) {
+			CHECK(Math::is_equal_approx(motion_results[i].closest_safe, valid_results[i].closest_safe));
+			CHECK(Math::is_equal_approx(motion_results[i].closest_unsafe, valid_results[i].closest_unsafe));
+		}
+	}
+	CHECK(hits_with_invalid == motion_hits - (valid_results[1].closest_safe < 1));
+}
+
+TEST_CASE("[PhysicsServer3D] Continuous collision detection stops fast bodies at thin walls") {
+	for (int ccd = 0; ccd < 2; ccd++) {
+		TestSpace test;
+		RID wall_shape = test.create_shape(PhysicsServer3D::SHAPE_BOX, Vector3(5, 0.05, 5));
+		RID ball_shape = test.create_shape(PhysicsServer3D::SHAPE_SPHERE, 0.25);
+		test.create_body(PhysicsServer3D::BODY_MODE_STATIC, wall_shape, Vector3());
+		RID ball = test.create_body(PhysicsServer3D::BODY_MODE_RIGID, ball_shape, Vector3(0, 2.3, 0));
+		test.server->body_set_enable_continuous_collision_detection(ball, ccd);
+		// About 5 units per step against a wall 0.1 units thick.
+		test.server->body_set_state(ball, PhysicsServer3D::BODY_STATE_LINEAR_VELOCITY, Vector3(0, -300, 0));
+
+		real_t lowest = 2.3;
+		for (int i = 0; i < 30; i++) {
+			test.server->step(1.0 / 60.0);
+			Transform xform = test.server->body_get_state(ball, PhysicsServer3D::BODY_STATE_TRANSFORM);
+			lowest = MIN(lowest, xform.origin.y);
+		}
+
+		if (ccd) {
+			CHECK_MESSAGE(lowest > 0, "The ball should not pass through the wall.");
+			Transform xform = test.server->body_get_state(ball, PhysicsServer3D::BODY_STATE_TRANSFORM);
+			CHECK_MESSAGE(xform.origin.y > 0.2, "The ball should end up resting on the wall.");
+		} else {
+			CHECK_MESSAGE(lowest < -1, "Without continuous collision detection the ball skips over the wall.");
+		}
+	}
+}
+
+TEST_CASE("[PhysicsServer3D] Resting contacts follow a changed relative pose") {
+	TestSpace test;
+	RID box = test.create_shape(PhysicsServer3D::SHAPE_BOX, Vector3(0.5, 0.5, 0.5));
+	test.create_body(PhysicsServer3D::BODY_MODE_STATIC, box, Vector3());
+	RID crate = test.create_body(PhysicsServer3D::BODY_MODE_RIGID, box, Vector3(0, 1, 0));
+	test.server->body_set_max_contacts_reported(crate, 4);
+
+	// Long enough for the pair to reuse its contacts.
+	for (int i = 0; i < 20; i++) {
+		test.server->step(1.0 / 60.0);
+	}
+	Transform xform = test.server->body_get_state(crate, PhysicsServer3D::BODY_STATE_TRANSFORM);
+	CHECK(xform.origin.y > 0.95);
+
+	// Slid and turned on the pedestal, the old contacts no longer line up. Reusing them
+	// would drop every contact and let the crate sink until the cache expires.
+	test.server->body_set_state(crate, PhysicsServer3D::BODY_STATE_TRANSFORM, Transform(Basis(Vector3(0, 1, 0), Math_PI / 12), Vector3(0.3, xform.origin.y, 0)));
+	test.server->step(1.0 / 60.0);
+	PhysicsDirectBodyState3D *state = test.server->body_get_direct_state(crate);
+	REQUIRE(state);
+	CHECK_MESSAGE(state->get_contact_count() > 0, "The moved crate should be in contact right away.");
+
+	for (int i = 0; i < 30; i++) {
+		test.server->step(1.0 / 60.0);
+		xform = test.server->body_get_state(crate, PhysicsServer3D::BODY_STATE_TRANSFORM);
+		CHECK(xform.origin.y > 0.95);
+	}
+}
+
+} // namespace TestPhysicsServer3D
+
+#endif // TEST_PHYSICS_SERVER_3D_H
@@ -0,0 +1,422 @@
+/*************************************************************************/
+/*  test_scene_tree.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#ifndef TEST_SCENE_TREE_H
+#define TEST_SCENE_TREE_H
+
+#include "core/object/message_queue.h"
+#include "drivers/dummy/rasterizer_dummy.h"
+#include "scene/main/node.h"
+#include "scene/main/scene_tree.h"
+#include "scene/main/window.h"
+#include "servers/display_server.h"
+#include "servers/physics_2d/physics_server_2d_sw.h"
+#include "servers/physics_3d/physics_server_3d_sw.h"
+#include "servers/rendering/rendering_server_raster.h"
+
+#include "tests/test_macros.h"
+
+#include <atomic>
+
+namespace TestSceneTree {
+
+// Just enough of a display server for the root window to enter the tree.
+class TestDisplayServer : public DisplayServer {
+	ObjectID window_attached_instance_id;
+
+public:
+	bool has_feature(Feature p_feature) const override { return false; }
+	String get_name() const override { return "test"; }
+
+	void alert(const String &p_alert, const String &p_title = "ALERT!") override {}
+
+	int get_screen_count() const override { return 1; }
+	Point2i screen_get_position(int p_screen = SCREEN_OF_MAIN_WINDOW) const override { return Point2i(); }
+	Size2i screen_get_size(int p_screen = SCREEN_OF_MAIN_WINDOW) const override { return Size2i(); }
+	Rect2i screen_get_usable_rect(int p_screen = SCREEN_OF_MAIN_WINDOW) const override { return Rect2i(); }
+	int screen_get_dpi(int p_screen = SCREEN_OF_MAIN_WINDOW) const override { return 96; }
+
+	Vector<DisplayServer::WindowID> get_window_list() const override {
+		Vector<WindowID> windows;
+		windows.push_back(MAIN_WINDOW_ID);
+		return windows;
+	}
+
+	WindowID get_window_at_screen_position(const Point2i &p_position) const override { return MAIN_WINDOW_ID; }
+
+	void window_attach_instance_id(ObjectID p_instance, WindowID p_window = MAIN_WINDOW_ID) override { window_attached_instance_id = p_instance; }
+	ObjectID window_get_attached_instance_id(WindowID p_window = MAIN_WINDOW_ID) const override { return window_attached_instance_id; }
+
+	void window_set_rect_changed_callback(const Callable &p_callable, WindowID p_window = MAIN_WINDOW_ID) override {}
+	void window_set_window_event_callback(const Callable &p_callable, WindowID p_window = MAIN_WINDOW_ID) override {}
+	void window_set_input_event_callback(const Callable &p_callable, WindowID p_window = MAIN_WINDOW_ID) override {}
+	void window_set_input_text_callback(const Callable &p_callable, WindowID p_window = MAIN_WINDOW_ID) override {}
+	void window_set_drop_files_callback(const Callable &p_callable, WindowID p_window = MAIN_WINDOW_ID) override {}
+
+	void window_set_title(const String &p_title, WindowID p_window = MAIN_WINDOW_ID) override {}
+
+	int window_get_current_screen(WindowID p_window = MAIN_WINDOW_ID) const override { return 0; }
+	void window_set_current_screen(int p_screen, WindowID p_window = MAIN_WINDOW_ID) override {}
+
+	Point2i window_get_position(WindowID p_window = MAIN_WINDOW_ID) const override { return Point2i(); }
+	void window_set_position(const Point2i &p_position, WindowID p_window = MAIN_WINDOW_ID) override {}
+
+	void window_set_transient(WindowID p_window, WindowID p_parent) override {}
+
+	void window_set_max_size(const Size2i p_size, WindowID p_window = MAIN_WINDOW_ID) override {}
+	Size2i window_get_max_size(WindowID p_window = MAIN_WINDOW_ID) const override { return Size2i(); }
+
+	void window_set_min_size(const Size2i p_size, WindowID p_window = MAIN_WINDOW_ID) override {}
+	Size2i window_get_min_size(WindowID p_window = MAIN_WINDOW_ID) const override { return Size2i(); }
+
+	void window_set_size(const Size2i p_size, WindowID p_window = MAIN_WINDOW_ID) override {}
+	Size2i window_get_size(WindowID p_window = MAIN_WINDOW_ID) const override { return Size2i(); }
+	Size2i window_get_real_size(WindowID p_window = MAIN_WINDOW_ID) const override { return Size2i(); }
+
+	void window_set_mode(WindowMode p_mode, WindowID p_window = MAIN_WINDOW_ID) override {}
+	WindowMode window_get_mode(WindowID p_window = MAIN_WINDOW_ID) const override { return WINDOW_MODE_MINIMIZED; }
+
+	bool window_is_maximize_allowed(WindowID p_window = MAIN_WINDOW_ID) const override { return false; }
+
+	void window_set_flag(WindowFlags p_flag, bool p_enabled, WindowID p_window = MAIN_WINDOW_ID) override {}
+	bool window_get_flag(WindowFlags p_flag, WindowID p_window = MAIN_WINDOW_ID) const override { return false; }
+
+	void window_request_attention(WindowID p_window = MAIN_WINDOW_ID) override {}
+	void window_move_to_foreground(WindowID p_window = MAIN_WINDOW_ID) override {}
+
+	bool window_can_draw(WindowID p_window = MAIN_WINDOW_ID) const override { return false; }
+	bool can_any_window_draw() const override { return false; }
+
+	void process_events() override {}
+};
+
+// A running scene tree on dummy servers, the same setup the headless server platform uses.
+class TestTree {
+	MessageQueue *message_queue;
+	DisplayServer *display_server;
+	RenderingServer *rendering_server;
+	PhysicsServer2D *physics_server_2d;
+	PhysicsServer3D *physics_server_3d;
+
+public:
+	SceneTree *tree;
+
+	Vector<Node *> get_group(const StringName &p_group) {
+		List<Node *> nodes;
+		tree->get_nodes_in_group(p_group, &nodes);
+
+		Vector<Node *> ret;
+		for (List<Node *>::Element *E = nodes.front(); E; E = E->next()) {
+			ret.push_back(E->get());
+		}
+		return ret;
+	}
+
+	TestTree() {
+		message_queue = memnew(MessageQueue);
+		display_server = memnew(TestDisplayServer);
+
+		RasterizerDummy::make_current();
+		rendering_server = memnew(RenderingServerRaster);
+		rendering_server->init();
+
+		physics_server_2d = memnew(PhysicsServer2DSW);
+		physics_server_2d->init();
+		physics_server_3d = memnew(PhysicsServer3DSW);
+		physics_server_3d->init();
+
+		tree = memnew(SceneTree);
+		tree->init();
+	}
+
+	~TestTree() {
+		message_queue->flush();
+		tree->finish();
+		memdelete(tree);
+
+		physics_server_3d->finish();
+		memdelete(physics_server_3d);
+		physics_server_2d->finish();
+		memdelete(physics_server_2d);
+
+		rendering_server->finish();
+		memdelete(rendering_server);
+
+		memdelete(display_server);
+		memdelete(message_queue);
+	}
+};
+
+// Records when it processes, and can change the tree while processing.
+class ProcessRecorder : public Node {
+	GDCLASS(ProcessRecorder, Node);
+
+public:
+	// Shared by the recorders of a test, gives their process order.
+	std::atomic<int> *counter = nullptr;
+	int order = -1;
+	int process_count = 0;
+	bool on_processing_thread = false;
+
+	// Added as child and joined while processing.
+	Node *child_to_add = nullptr;
+	StringName group_to_join;
+	bool saw_own_child = false;
+	bool saw_own_group = false;
+
+	// Another recorder whose changes are looked for while processing.
+	ProcessRecorder *watched = nullptr;
+	bool saw_watched_child = false;
+	bool saw_watched_group = false;
+
+	void _notification(int p_what) {
+		if (p_what != NOTIFICATION_PROCESS) {
+			return;
+		}
+
+		order = counter->fetch_add(1);
+		process_count++;
+		on_processing_thread = SceneTree::is_processing_thread();
+
+		if (child_to_add) {
+			add_child(child_to_add);
+			saw_own_child = child_to_add->get_parent() == this;
+		}
+		if (group_to_join != StringName()) {
+			add_to_group(group_to_join);
+			saw_own_group = is_in_group(group_to_join);
+		}
+
+		if (watched) {
+			saw_watched_child = watched->child_to_add->get_parent() == watched;
+			saw_watched_group = watched->is_in_group(watched->group_to_join);
+		}
+	}
+};
+
+static ProcessRecorder *add_recorder(Node *p_parent, std::atomic<int> &p_counter, int p_priority, bool p_thread_safe) {
+	ProcessRecorder *recorder = memnew(ProcessRecorder);
+	recorder->counter = &p_counter;
+	recorder->set_process(true);
+	recorder->set_process_priority(p_priority);
+	recorder->set_process_thread_safe(p_thread_safe);
+	p_parent->add_child(recorder);
+	return recorder;
+}
+
+SceneTree::ThreadCall make_thread_call(Object *p_object, const StringName &p_method, const Variant &p_arg1 = Variant(), const Variant &p_arg2 = Variant()) {
+	SceneTree::ThreadCall call;
+	call.object = p_object->get_instance_id();
+	call.method = p_method;
+	if (p_arg1.get_type() != Variant::NIL) {
+		call.args.push_back(p_arg1);
+	}
+	if (p_arg2.get_type() != Variant::NIL) {
+		call.args.push_back(p_arg2);
+	}
+	return call;
+}
+
+TEST_CASE("[SceneTree] Calls deferred by thread-safe processing replay in node order") {
+	Node *parent = memnew(Node);
+	Node *first = memnew(Node);
+	Node *second = memnew(Node);
+	Node *third = memnew(Node);
+	Node *freed = memnew(Node);
+
+	// One call list per node of the batch, filled back to front like workers finishing out of order.
+	LocalVector<LocalVector<SceneTree::ThreadCall>> calls;
+	calls.resize(4);
+	calls[2].push_back(make_thread_call(freed, "add_child", third));
+	calls[2].push_back(make_thread_call(parent, "add_child", third));
+	calls[1].push_back(make_thread_call(parent, "add_child", second));
+	calls[1].push_back(make_thread_call(parent, "move_child", second, 0));
+	calls[0].push_back(make_thread_call(parent, "add_child", first));
+	calls[3].push_back(make_thread_call(parent, "move_child", first, 2));
+	memdelete(freed);
+
+	SceneTree::replay_thread_calls(calls, 3);
+
+	REQUIRE(parent->get_child_count() == 3);
+	CHECK(parent->get_child(0) == second);
+	CHECK(parent->get_child(1) == first);
+	CHECK(parent->get_child(2) == third);
+	CHECK(calls[0].empty());
+	CHECK(calls[1].empty());
+	CHECK(calls[2].empty());
+	// Lists past the batch size are left alone.
+	CHECK(calls[3].size() == 1);
+
+	memdelete(parent);
+}
+
+TEST_CASE("[SceneTree] Groups stay in tree order when a subtree moves") {
+	TestTree test;
+
+	Node *parent = memnew(Node);
+	Node *first = memnew(Node);
+	Node *second = memnew(Node);
+	Node *first_member = memnew(Node);
+	Node *second_member = memnew(Node);
+	first->add_child(first_member);
+	second->add_child(second_member);
+	parent->add_child(first);
+	parent->add_child(second);
+	test.tree->get_root()->add_child(parent);
+
+	// Only descendants of the moved node are in the group.
+	first_member->add_to_group("members");
+	second_member->add_to_group("members");
+
+	Vector<Node *> members = test.get_group("members");
+	REQUIRE(members.size() == 2);
+	CHECK(members[0] == first_member);
+	CHECK(members[1] == second_member);
+
+	parent->move_child(second, 0);
+
+	members = test.get_group("members");
+	REQUIRE(members.size() == 2);
+	CHECK(members[0] == second_member);
+	CHECK(members[1] == first_member);
+
+	// New members are placed by binary search, which relies on the group having been sorted again.
+	Node *late_member = memnew(Node);
+	first->add_child(late_member);
+	late_member->add_to_group("members");
+
+	members = test.get_group("members");
+	REQUIRE(members.size() == 3);
+	CHECK(members[0] == second_member);
+	CHECK(members[1] == first_member);
+	CHECK(members[2] == late_member);
+
+	// add_sibling adds at the end and then moves the subtree next to its sibling.
+	Node *sibling = memnew(Node);
+	Node *sibling_member = memnew(Node);
+	sibling_member->add_to_group("members");
+	sibling->add_child(sibling_member);
+	second->add_sibling(sibling);
+
+	members = test.get_group("members");
+	REQUIRE(members.size() == 4);
+	CHECK(members[0] == second_member);
+	CHECK(members[1] == sibling_member);
+	CHECK(members[2] == first_member);
+	CHECK(members[3] == late_member);
+}
+
+TEST_CASE("[SceneTree] Thread-safe nodes process between their serial neighbours") {
+	TestTree test;
+	std::atomic<int> counter(0);
+	Node *root = test.tree->get_root();
+
+	// Added against the process order, the priorities sort them.
+	ProcessRecorder *last = add_recorder(root, counter, 4, false);
+	ProcessRecorder *late_batch[2];
+	for (int i = 0; i < 2; i++) {
+		late_batch[i] = add_recorder(root, counter, 3, true);
+	}
+	ProcessRecorder *middle = add_recorder(root, counter, 2, false);
+	ProcessRecorder *early_batch[4];
+	for (int i = 0; i < 4; i++) {
+		early_batch[i] = add_recorder(root, counter, 1, true);
+	}
+	ProcessRecorder *first = add_recorder(root, counter, 0, false);
+
+	for (int frame = 1; frame <= 2; frame++) {
+		counter.store(0);
+		test.tree->idle(0.1);
+
+		CHECK(first->process_count == frame);
+		CHECK(first->order == 0);
+		CHECK_FALSE(first->on_processing_thread);
+
+		for (int i = 0; i < 4; i++) {
+			CHECK(early_batch[i]->process_count == frame);
+			CHECK(early_batch[i]->on_processing_thread);
+			CHECK(early_batch[i]->order > first->order);
+			CHECK(early_batch[i]->order < middle->order);
+		}
+
+		CHECK(middle->process_count == frame);
+		CHECK(middle->order == 5);
+		CHECK_FALSE(middle->on_processing_thread);
+
+		for (int i = 0; i < 2; i++) {
+			CHECK(late_batch[i]->process_count == frame);
+			CHECK(late_batch[i]->on_processing_thread);
+			CHECK(late_batch[i]->order > middle->order);
+			CHECK(late_batch[i]->order < last->order);
+		}
+
+		CHECK(last->process_count == frame);
+		CHECK(last->order == 8);
+		CHECK_FALSE(last->on_processing_thread);
+	}
+}
+
+TEST_CASE("[SceneTree] Tree changes from thread-safe processing wait for the sync point") {
+	TestTree test;
+	std::atomic<int> counter(0);
+	Node *root = test.tree->get_root();
+
+	ProcessRecorder *before = add_recorder(root, counter, 0, false);
+	ProcessRecorder *changers[2];
+	for (int i = 0; i < 2; i++) {
+		changers[i] = add_recorder(root, counter, 1, true);
+		changers[i]->child_to_add = memnew(Node);
+		changers[i]->group_to_join = "joined";
+	}
+	ProcessRecorder *after = add_recorder(root, counter, 2, false);
+	before->watched = changers[0];
+	after->watched = changers[1];
+
+	test.tree->idle(0.1);
+
+	for (int i = 0; i < 2; i++) {
+		REQUIRE(changers[i]->process_count == 1);
+		CHECK_MESSAGE(!changers[i]->saw_own_child, "add_child should be deferred while the batch runs.");
+		CHECK_MESSAGE(!changers[i]->saw_own_group, "add_to_group should be deferred while the batch runs.");
+		CHECK(changers[i]->child_to_add->get_parent() == changers[i]);
+		CHECK(changers[i]->is_in_group("joined"));
+	}
+
+	CHECK_FALSE(before->saw_watched_child);
+	CHECK_FALSE(before->saw_watched_group);
+	CHECK_MESSAGE(after->saw_watched_child, "The batch changes should be applied before the next serial node.");
+	CHECK_MESSAGE(after->saw_watched_group, "The batch changes should be applied before the next serial node.");
+	CHECK(test.get_group("joined").size() == 2);
+}
+
+} // namespace TestSceneTree
+
+#endif // TEST_SCENE_TREE_H
@@ -0,0 +1,193 @@
+/*************************************************************************/
+/*  test_string_name.h                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2020 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2020 Godot Engine contributors (cf. AUTHORS.md).   */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_STRING_NAME_H
+#define TEST_STRING_NAME_H
+
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/string/print_string.h"
+#include "core/string/string_name.h"
+#include "core/templates/local_vector.h"
+
+#include "tests/test_macros.h"
+
+namespace TestStringName {
+
+TEST_CASE("[StringName] Interning") {
+	StringName from_cstring("test_string_name_interning");
+	StringName from_string(String("test_string_name_interning"));
+	StringName from_static = _scs_create("test_string_name_interning");
+
+	CHECK(from_cstring == from_string);
+	CHECK(from_cstring == from_static);
+	CHECK(from_cstring.hash() == String("test_string_name_interning").hash());
+	CHECK(StringName::search("test_string_name_interning") == from_cstring);
+	CHECK(StringName::search(String("test_string_name_interning")) == from_cstring);
+	CHECK(StringName::search(U"test_string_name_interning") == from_cstring);
+	CHECK_MESSAGE(
+			StringName::search("test_string_name_never_interned") == StringName(),
+			"Searching should not add names.");
+}
+
+TEST_CASE("[StringName] Names survive the table growing and are removed when released") {
+	const int count = 20000; // Well past the initial table size.
+	LocalVector<StringName> names;
+	LocalVector<const void *> pointers;
+	for (int i = 0; i < count; i++) {
+		names.push_back(StringName("test_string_name_growth_" + itos(i)));
+		pointers.push_back(names[i].data_unique_pointer());
+	}
+
+	bool all_found = true;
+	for (int i = 0; i < count; i++) {
+		all_found = all_found && StringName("test_string_name_growth_" + itos(i)).data_unique_pointer() == pointers[i];
+	}
+	CHECK_MESSAGE(all_found, "Interning again should return the same names after growing.");
+
+	names.clear();
+	bool all_removed = true;
+	for (int i = 0; i < count; i++) {
+		all_removed = all_removed && StringName::search("test_string_name_growth_" + itos(i)) == StringName();
+	}
+	CHECK_MESSAGE(all_removed, "Released names should no longer be found.");
+}
+
+#if !defined(NO_THREADS)
+
+struct Interner {
+	int thread;
+	int count;
+	LocalVector<StringName> names;
+};
+
+static void _intern(void *p_interner) {
+	Interner *interner = (Interner *)p_interner;
+	// Every thread interns the same names starting at a different one, and adds and
+	// removes names of its own in between.
+	for (int i = 0; i < interner->count; i++) {
+		int index = (i + interner->thread * interner->count / 4) % interner->count;
+		interner->names.push_back(StringName("test_string_name_shared_" + itos(index)));
+		StringName own("test_string_name_own_" + itos(interner->thread) + "_" + itos(i));
+	}
+}
+
+TEST_CASE("[StringName] Interning from several threads") {
+	const int thread_count = 4;
+	Interner interners[thread_count];
+	Thread *threads[thread_count];
+	for (int i = 0; i < thread_count; i++) {
+		interners[i].thread = i;
+		interners[i].count = 5000;
+		threads[i] = Thread::create(_intern, &interners[i]);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+
+	bool unique = true;
+	for (int i = 0; i < thread_count; i++) {
+		for (uint32_t j = 0; j < interners[i].names.size(); j++) {
+			StringName name = interners[i].names[j];
+			unique = unique && name == interners[0].names[(j + i * 5000 / 4) % 5000];
+		}
+	}
+	CHECK_MESSAGE(unique, "A name interned by several threads at once should be interned only once.");
+}
+
+struct BenchmarkThread {
+	const LocalVector<String> *existing;
+	int thread;
+	int iterations;
+};
+
+static void _benchmark_lookups(void *p_data) {
+	BenchmarkThread *data = (BenchmarkThread *)p_data;
+	uint32_t size = data->existing->size();
+	for (int i = 0; i < data->iterations; i++) {
+		StringName name((*data->existing)[(i * 7 + data->thread * 131) % size]);
+	}
+}
+
+static void _benchmark_inserts(void *p_data) {
+	BenchmarkThread *data = (BenchmarkThread *)p_data;
+	String prefix = "benchmark_" + itos(data->thread) + "_";
+	for (int i = 0; i < data->iterations; i++) {
+		StringName name(prefix + itos(i)); // Added and removed again.
+	}
+}
+
+static uint64_t _benchmark_threads(ThreadCreateCallback p_callback, const LocalVector<String> &p_existing, int p_threads, int p_iterations) {
+	LocalVector<BenchmarkThread> data;
+	LocalVector<Thread *> threads;
+	data.resize(p_threads);
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_threads; i++) {
+		data[i].existing = &p_existing;
+		data[i].thread = i;
+		data[i].iterations = p_iterations;
+		threads.push_back(Thread::create(p_callback, &data[i]));
+	}
+	for (int i = 0; i < p_threads; i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+	return OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+// Run with `godot --test string-name-benchmark`.
+void benchmark() {
+	const int names = 50000;
+	const int iterations = 200000;
+
+	LocalVector<String> existing;
+	LocalVector<StringName> held;
+	for (int i = 0; i < names; i++) {
+		existing.push_back("benchmark_existing_" + itos(i));
+		held.push_back(StringName(existing[i]));
+	}
+
+	print_line(vformat("%d processors, %d names interned, %d operations per thread", OS::get_singleton()->get_processor_count(), names, iterations));
+	for (int threads = 1; threads <= 8; threads *= 2) {
+		uint64_t lookup_usec = _benchmark_threads(_benchmark_lookups, existing, threads, iterations);
+		uint64_t insert_usec = _benchmark_threads(_benchmark_inserts, existing, threads, iterations);
+		print_line(vformat("%d threads: lookups %.2f Mops/s, inserts and removals %.2f Mops/s",
+				threads, double(threads) * iterations / lookup_usec, double(threads) * iterations / insert_usec));
+	}
+}
+
+REGISTER_TEST_COMMAND("string-name-benchmark", &benchmark);
+
+#endif // !defined(NO_THREADS)
+
+} // namespace TestStringName
+
+#endif // TEST_STRING_NAME_H
@@ -0,0 +1,64 @@
+# Build profile for the dedicated Spacecavate server.
+# From Godotenginecustombuild/godot run:
+#   scons profile=../server_profile.py -j<cores>
+# which produces bin/godot_server.linuxbsd.opt.64, a Linux binary without the
+# editor, renderer, audio or input stacks (see platform/server).
+
+platform = "server"
+tools = "no"
+target = "release"
+debug_symbols = "no"
+deprecated = "no"
+use_lto = "yes"
+
+# The server never draws, drop the bulky GUI controls.
+disable_advanced_gui = "yes"
+
+# Unused sections go away at link time, smaller binary and resident set.
+CCFLAGS = "-ffunction-sections -fdata-sections"
+LINKFLAGS = "-Wl,--gc-sections"
+
+# Kept: gdscript, gdnative (Servermanagement), enet, mbedtls, regex,
+# gdnavigation, bullet and csg for server side simulation, freetype for the
+# default theme. Everything below only matters for rendering, audio, media
+# import, the editor or other platforms.
+module_arkit_enabled = "no"
+module_assimp_enabled = "no"
+module_basis_universal_enabled = "no"
+module_bmp_enabled = "no"
+module_camera_enabled = "no"
+module_camera_iphone_enabled = "no"
+module_cvtt_enabled = "no"
+module_dds_enabled = "no"
+module_denoise_enabled = "no"
+module_etc_enabled = "no"
+module_gamecenter_enabled = "no"
+module_glslang_enabled = "no"
+module_gridmap_enabled = "no"
+module_hdr_enabled = "no"
+module_icloud_enabled = "no"
+module_inappstore_enabled = "no"
+module_jpg_enabled = "no"
+module_jsonrpc_enabled = "no"
+module_lightmapper_rd_enabled = "no"
+module_mobile_vr_enabled = "no"
+module_mono_enabled = "no"
+module_ogg_enabled = "no"
+module_opensimplex_enabled = "no"
+module_opus_enabled = "no"
+module_pvr_enabled = "no"
+module_squish_enabled = "no"
+module_stb_vorbis_enabled = "no"
+module_svg_enabled = "no"
+module_tga_enabled = "no"
+module_theora_enabled = "no"
+module_tinyexr_enabled = "no"
+module_upnp_enabled = "no"
+module_vhacd_enabled = "no"
+module_visual_script_enabled = "no"
+module_vorbis_enabled = "no"
+module_webm_enabled = "no"
+module_webp_enabled = "no"
+module_webrtc_enabled = "no"
+module_websocket_enabled = "no"
+module_xatlas_unwrap_enabled = "no"
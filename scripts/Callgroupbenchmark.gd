@@ -0,0 +1,70 @@
+# Cost of calling a method on every member of large groups, the way the
+# server ticks ships and drones. Half of the "fleet" members are markers
+# without the method, which the calls skip. Run it with the custom engine:
+#   bin/godot_server.linuxbsd.opt.64 --path <project folder> -s scripts/Callgroupbenchmark.gd
+extends SceneTree
+
+const MEMBERS = 10000
+const CALLS = 100
+
+var fleet
+var frame = 0
+var deferred_usec = {"ships": 0, "fleet": 0}
+
+
+class Ship:
+	extends Node
+	var ticks = 0
+
+	func tick(_delta):
+		ticks += 1
+
+
+class Marker:
+	extends Node
+
+
+func _initialize():
+	fleet = Node.new()
+	fleet.name = "Fleet"
+	root.add_child(fleet)
+
+	var begin = OS.get_ticks_usec()
+	for i in MEMBERS:
+		var ship = Ship.new()
+		ship.add_to_group("ships")
+		ship.add_to_group("fleet")
+		fleet.add_child(ship)
+		var marker = Marker.new()
+		marker.add_to_group("fleet")
+		fleet.add_child(marker)
+	print("adding ", MEMBERS * 2, " nodes to groups: ", (OS.get_ticks_usec() - begin) / 1000.0, " ms")
+
+	for group in ["ships", "fleet"]:
+		begin = OS.get_ticks_usec()
+		for i in CALLS:
+			call_group_flags(GROUP_CALL_REALTIME, group, "tick", 0.016)
+		report("realtime call_group", group, OS.get_ticks_usec() - begin)
+
+
+# Deferred calls are queued once per frame, so the message queue is flushed
+# in between; only the queueing is timed.
+func _idle(_delta):
+	if frame < CALLS:
+		for group in ["ships", "fleet"]:
+			var begin = OS.get_ticks_usec()
+			call_group(group, "tick", 0.016)
+			deferred_usec[group] += OS.get_ticks_usec() - begin
+		frame += 1
+		return false
+
+	for group in ["ships", "fleet"]:
+		report("deferred call_group", group, deferred_usec[group])
+	fleet.free()
+	return true
+
+
+func report(label, group, usec):
+	var members = get_nodes_in_group(group).size()
+	var note = ", half without the method" if group == "fleet" else ""
+	print(label, " on ", members, " members", note, ": ", usec / 1000.0 / CALLS, " ms/call")
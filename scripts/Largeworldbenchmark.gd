@@ -0,0 +1,68 @@
+# Per-frame cost and precision of a scene far away from the origin.
+# Run it with a normal and with a float=64 build, each with and without
+# --no-floating-origin, and compare:
+#   bin/godot_server.linuxbsd.opt.64 --path <project folder> -s scripts/Largeworldbenchmark.gd
+#   bin/godot_server.linuxbsd.opt.64.double --path <project folder> -s scripts/Largeworldbenchmark.gd
+extends SceneTree
+
+const BODIES = 2000
+const FRAMES = 600
+const DISTANCE = 1.0e8 # about a quarter of the way to the moon, in meters
+const ORIGIN_THRESHOLD = 5000.0
+const CAMERA_OFFSET = Vector3(0, 0, 10)
+
+var camera
+var bodies = []
+var frame = 0
+var start_usec = 0
+var shifts = 0
+var worst_error = 0.0
+
+
+func _initialize():
+	var world = Node3D.new()
+	root.add_child(world)
+	camera = Camera3D.new()
+	world.add_child(camera)
+	camera.current = true
+	root.connect("world_origin_shifted", Callable(self, "_on_world_origin_shifted"))
+	if not "--no-floating-origin" in OS.get_cmdline_args():
+		root.floating_origin_threshold = ORIGIN_THRESHOLD
+
+	var shape = SphereShape3D.new()
+	var rng = RandomNumberGenerator.new()
+	rng.seed = 42
+	for i in BODIES:
+		var body = RigidBody3D.new()
+		body.gravity_scale = 0
+		var collision = CollisionShape3D.new()
+		collision.shape = shape
+		body.add_child(collision)
+		body.translation = Vector3(DISTANCE, 0, 0) + Vector3(rng.randf_range(-1000, 1000), rng.randf_range(-1000, 1000), rng.randf_range(-1000, 1000))
+		body.linear_velocity = Vector3(rng.randf_range(-1, 1), rng.randf_range(-1, 1), rng.randf_range(-1, 1))
+		world.add_child(body)
+		bodies.append(body)
+	camera.translation = bodies[0].translation + CAMERA_OFFSET
+	start_usec = OS.get_ticks_usec()
+
+
+func _on_world_origin_shifted(_offset):
+	shifts += 1
+
+
+func _idle(_delta):
+	frame += 1
+	# Follow one body the way the game camera follows the ship, then check
+	# how far the offset drifted once it went through the transforms.
+	camera.translation = bodies[0].translation + CAMERA_OFFSET
+	var error = abs((camera.global_transform.origin - bodies[0].global_transform.origin).length() - CAMERA_OFFSET.length())
+	worst_error = max(worst_error, error)
+	if frame < FRAMES:
+		return false
+
+	var usec = OS.get_ticks_usec() - start_usec
+	var precision = "double" if Vector3(DISTANCE, 0, 0) + Vector3(0.01, 0, 0) != Vector3(DISTANCE, 0, 0) else "float"
+	print("real_t: ", precision, ", floating origin threshold: ", root.floating_origin_threshold)
+	print(BODIES, " bodies at ", DISTANCE, " m: ", usec / float(FRAMES), " usec/frame, ", shifts, " origin shifts")
+	print("worst camera offset error: ", worst_error, " m")
+	return true
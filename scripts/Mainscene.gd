@@ -5,7 +5,7 @@ extends Control
 # var a = 2
 # var b = "text"
 func _ready():
-	pass
+	Servermanagement.setsnapshotbuffer(Snapshotbuffer)
 
 # Called when the node enters the scene tree for the first time.
 func _resized():
@@ -1,5 +1,7 @@
 #include "Common.h"
 #include "Servermanagement.h"
+#include "Trajectorypropagator.h"
+#include "Snapshotbuffer.h"
 
 extern "C" void GDN_EXPORT godot_gdnative_init(godot_gdnative_init_options *o) {
 	godot::Godot::gdnative_init(o);
@@ -14,4 +16,6 @@ extern "C" void GDN_EXPORT godot_nativescript_init(void *handle) {
 	godot::Godot::nativescript_init(handle);
 
 	godot::register_class<Servermanagement>();
+	godot::register_class<Trajectorypropagator>();
+	godot::register_class<Snapshotbuffer>();
 }
@@ -0,0 +1,734 @@
+#include "Netprotocol.h"
+#include <StreamPeerBuffer.hpp>
+#include <climits>
+#include <cstring>
+#include <string>
+
+
+
+
+namespace {
+
+enum Tag : uint8_t {
+    TAG_NIL = 0,
+    TAG_FALSE,
+    TAG_TRUE,
+    TAG_INT,
+    TAG_REAL,
+    TAG_STRING,
+    TAG_ARRAY,
+    TAG_VECTOR3,
+    TAG_BYTES,
+    TAG_REALS,
+    TAG_ENCODEDVARIANT, // anything else, through the engine's encode_variant
+    TAG_DOUBLE, // reals that do not survive f32, timestamps mostly
+    TAG_INTS,
+};
+
+const int MAX_DEPTH = 16;
+
+struct Command {
+    const char *name;
+    uint8_t opcode;
+};
+
+const Command commands[] = {
+    { "contact", Netprotocol::OP_CONTACT },
+    { "addneweventtolaunchtimeline", Netprotocol::OP_ADDEVENT },
+    { "deleteeventfromlaunchtimeline", Netprotocol::OP_DELETEEVENT },
+    { "changeeventfromlaunchtimeline", Netprotocol::OP_CHANGEEVENT },
+    { "telemetry", Netprotocol::OP_TELEMETRY },
+    { "entitystates", Netprotocol::OP_ENTITYSTATES },
+};
+
+uint16_t read16(const uint8_t *ptr)
+{
+    return uint16_t(ptr[0] | (ptr[1] << 8));
+}
+
+void write16(uint8_t *ptr, uint16_t value)
+{
+    ptr[0] = value & 0xFF;
+    ptr[1] = value >> 8;
+}
+
+} // namespace
+
+Netprotocol::Netprotocol()
+{
+    reset();
+}
+
+void Netprotocol::reset()
+{
+    for (int c = 0; c < CHANNEL_MAX; c++) {
+        channels[c].localsequence = 0;
+        channels[c].remotesequence = 0;
+        channels[c].receivedbits = 0;
+        channels[c].receivedany = false;
+        channels[c].ackpending = false;
+        channels[c].pending.clear();
+    }
+    for (int i = 0; i < SNAPSHOT_WINDOW; i++) {
+        sentsnapshots[i].sequence = -1;
+        receivedsnapshots[i].sequence = -1;
+    }
+    ackedsnapshot = -1;
+    newestreceivedsnapshot = -1;
+    lost = false;
+}
+
+uint8_t Netprotocol::opcodefor(const String &command)
+{
+    for (const Command &c : commands) {
+        if (command == String(c.name)) {
+            return c.opcode;
+        }
+    }
+    return OP_VARIANT;
+}
+
+String Netprotocol::commandfor(uint8_t opcode)
+{
+    for (const Command &c : commands) {
+        if (c.opcode == opcode) {
+            return String(c.name);
+        }
+    }
+    return String();
+}
+
+bool Netprotocol::isframe(const PoolByteArray &packet)
+{
+    if (packet.size() < HEADER_SIZE) {
+        return false;
+    }
+    PoolByteArray::Read read = packet.read();
+    return read[0] < OP_MAX && (read[1] & CHANNEL_MASK) < CHANNEL_MAX;
+}
+
+bool Netprotocol::sequencenewer(uint16_t a, uint16_t b)
+{
+    return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+}
+
+void Netprotocol::writeheader(uint8_t opcode, uint8_t channel, bool reliable, uint16_t sequence)
+{
+    buffer.clear();
+    buffer.resize(HEADER_SIZE);
+    buffer[0] = opcode;
+    buffer[1] = channel | (reliable ? FLAG_RELIABLE : 0);
+    write16(&buffer[2], sequence);
+    writeacks(&buffer[0], channel);
+}
+
+void Netprotocol::writeacks(uint8_t *header, uint8_t channel) const
+{
+    if (channels[channel].receivedany) {
+        header[1] |= FLAG_ACKVALID;
+    } else {
+        header[1] &= ~FLAG_ACKVALID;
+    }
+    write16(header + 4, channels[channel].remotesequence);
+    write16(header + 6, channels[channel].receivedbits);
+}
+
+// drops every reliable message the other side confirmed and advances the telemetry baseline
+void Netprotocol::acknowledge(uint8_t channel, uint16_t ack, uint16_t ackbits)
+{
+    Channelstate &state = channels[channel];
+    for (size_t i = 0; i < state.pending.size();) {
+        uint16_t distance = uint16_t(ack - state.pending[i].sequence);
+        if (distance == 0 || (distance <= 16 && (ackbits & (1 << (distance - 1))))) {
+            state.pending[i] = state.pending.back();
+            state.pending.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    if (channel == CHANNEL_TELEMETRY) {
+        for (int n = -1; n < 16; n++) {
+            if (n >= 0 && !(ackbits & (1 << n))) {
+                continue;
+            }
+            uint16_t sequence = uint16_t(ack - 1 - n);
+            const Snapshot &snapshot = sentsnapshots[sequence % SNAPSHOT_WINDOW];
+            if (snapshot.sequence == sequence && (ackedsnapshot < 0 || sequencenewer(sequence, uint16_t(ackedsnapshot)))) {
+                ackedsnapshot = sequence;
+            }
+        }
+    }
+}
+
+// false for duplicates and for sequences too old to tell
+bool Netprotocol::isnew(uint8_t channel, uint16_t sequence) const
+{
+    const Channelstate &state = channels[channel];
+    if (!state.receivedany || sequencenewer(sequence, state.remotesequence)) {
+        return true;
+    }
+    uint16_t distance = uint16_t(state.remotesequence - sequence);
+    if (distance == 0 || distance > 16) {
+        return false;
+    }
+    return !(state.receivedbits & (1 << (distance - 1)));
+}
+
+// records a sequence whose payload decoded, only those get acked
+void Netprotocol::receive(uint8_t channel, uint16_t sequence)
+{
+    Channelstate &state = channels[channel];
+    state.ackpending = true;
+    if (!state.receivedany) {
+        state.receivedany = true;
+        state.remotesequence = sequence;
+        state.receivedbits = 0;
+    } else if (sequencenewer(sequence, state.remotesequence)) {
+        uint16_t shift = uint16_t(sequence - state.remotesequence);
+        state.receivedbits = shift >= 16 ? 0 : uint16_t((state.receivedbits << shift) | (1 << (shift - 1)));
+        state.remotesequence = sequence;
+    } else {
+        state.receivedbits |= uint16_t(1 << (uint16_t(state.remotesequence - sequence) - 1));
+    }
+}
+
+// the other side stopped acking, nothing queued is going to arrive anymore
+void Netprotocol::droplink()
+{
+    lost = true;
+    for (int c = 0; c < CHANNEL_MAX; c++) {
+        channels[c].pending.clear();
+    }
+}
+
+PoolByteArray Netprotocol::finish(uint8_t channel, bool reliable, uint16_t sequence, uint64_t now)
+{
+    channels[channel].ackpending = false;
+    if (reliable && !lost) {
+        if (channels[channel].pending.size() >= MAX_PENDING) {
+            droplink();
+        } else {
+            Pending pending;
+            pending.sequence = sequence;
+            pending.lastsent = now;
+            pending.resends = 0;
+            pending.bytes = buffer;
+            channels[channel].pending.push_back(pending);
+        }
+    }
+    PoolByteArray packet;
+    packet.resize(int(buffer.size()));
+    PoolByteArray::Write write = packet.write();
+    memcpy(write.ptr(), buffer.data(), buffer.size());
+    return packet;
+}
+
+void Netprotocol::putvarint(uint64_t value)
+{
+    while (value >= 0x80) {
+        buffer.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(uint8_t(value));
+}
+
+void Netprotocol::putfloat(float value)
+{
+    uint8_t bytes[4];
+    memcpy(bytes, &value, 4);
+    buffer.insert(buffer.end(), bytes, bytes + 4);
+}
+
+void Netprotocol::putdouble(double value)
+{
+    uint8_t bytes[8];
+    memcpy(bytes, &value, 8);
+    buffer.insert(buffer.end(), bytes, bytes + 8);
+}
+
+void Netprotocol::putstring(const String &value)
+{
+    CharString utf8 = value.utf8();
+    putvarint(uint64_t(utf8.length()));
+    buffer.insert(buffer.end(), utf8.get_data(), utf8.get_data() + utf8.length());
+}
+
+void Netprotocol::putvalue(const Variant &value)
+{
+    switch (value.get_type()) {
+        case Variant::NIL: {
+            putbyte(TAG_NIL);
+        } break;
+        case Variant::BOOL: {
+            putbyte(bool(value) ? TAG_TRUE : TAG_FALSE);
+        } break;
+        case Variant::INT: {
+            int64_t i = value;
+            putbyte(TAG_INT);
+            putvarint((uint64_t(i) << 1) ^ uint64_t(i >> 63));
+        } break;
+        case Variant::REAL: {
+            double d = value;
+            if (double(float(d)) == d) {
+                putbyte(TAG_REAL);
+                putfloat(float(d));
+            } else {
+                putbyte(TAG_DOUBLE);
+                putdouble(d);
+            }
+        } break;
+        case Variant::STRING: {
+            putbyte(TAG_STRING);
+            putstring(value);
+        } break;
+        case Variant::VECTOR3: {
+            Vector3 v = value;
+            putbyte(TAG_VECTOR3);
+            putfloat(v.x);
+            putfloat(v.y);
+            putfloat(v.z);
+        } break;
+        case Variant::ARRAY: {
+            Array array = value;
+            putbyte(TAG_ARRAY);
+            putvarint(uint64_t(array.size()));
+            for (int i = 0; i < array.size(); i++) {
+                putvalue(array[i]);
+            }
+        } break;
+        case Variant::POOL_BYTE_ARRAY: {
+            PoolByteArray bytes = value;
+            PoolByteArray::Read read = bytes.read();
+            putbyte(TAG_BYTES);
+            putvarint(uint64_t(bytes.size()));
+            buffer.insert(buffer.end(), read.ptr(), read.ptr() + bytes.size());
+        } break;
+        case Variant::POOL_REAL_ARRAY: {
+            PoolRealArray reals = value;
+            PoolRealArray::Read read = reals.read();
+            putbyte(TAG_REALS);
+            putvarint(uint64_t(reals.size()));
+            for (int i = 0; i < reals.size(); i++) {
+                putfloat(read[i]);
+            }
+        } break;
+        case Variant::POOL_INT_ARRAY: {
+            PoolIntArray ints = value;
+            PoolIntArray::Read read = ints.read();
+            putbyte(TAG_INTS);
+            putvarint(uint64_t(ints.size()));
+            for (int i = 0; i < ints.size(); i++) {
+                int64_t v = read[i];
+                putvarint((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+            }
+        } break;
+        default: {
+            Ref<StreamPeerBuffer> encoder = Ref<StreamPeerBuffer>(StreamPeerBuffer::_new());
+            encoder->put_var(value);
+            PoolByteArray bytes = encoder->get_data_array();
+            PoolByteArray::Read read = bytes.read();
+            putbyte(TAG_ENCODEDVARIANT);
+            putvarint(uint64_t(bytes.size()));
+            buffer.insert(buffer.end(), read.ptr(), read.ptr() + bytes.size());
+        } break;
+    }
+}
+
+bool Netprotocol::getvarint(const uint8_t *&ptr, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (ptr >= end) {
+            return false;
+        }
+        uint8_t byte = *ptr++;
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Netprotocol::getfloat(const uint8_t *&ptr, const uint8_t *end, float &value)
+{
+    if (end - ptr < 4) {
+        return false;
+    }
+    memcpy(&value, ptr, 4);
+    ptr += 4;
+    return true;
+}
+
+bool Netprotocol::getdouble(const uint8_t *&ptr, const uint8_t *end, double &value)
+{
+    if (end - ptr < 8) {
+        return false;
+    }
+    memcpy(&value, ptr, 8);
+    ptr += 8;
+    return true;
+}
+
+bool Netprotocol::getstring(const uint8_t *&ptr, const uint8_t *end, String &value)
+{
+    uint64_t length;
+    if (!getvarint(ptr, end, length) || uint64_t(end - ptr) < length) {
+        return false;
+    }
+    std::string utf8((const char *)ptr, size_t(length));
+    value = String(utf8.c_str());
+    ptr += length;
+    return true;
+}
+
+bool Netprotocol::getvalue(const uint8_t *&ptr, const uint8_t *end, Variant &value, int depth)
+{
+    if (ptr >= end || depth > MAX_DEPTH) {
+        return false;
+    }
+    uint8_t tag = *ptr++;
+    switch (tag) {
+        case TAG_NIL: {
+            value = Variant();
+        } break;
+        case TAG_FALSE: {
+            value = false;
+        } break;
+        case TAG_TRUE: {
+            value = true;
+        } break;
+        case TAG_INT: {
+            uint64_t zigzag;
+            if (!getvarint(ptr, end, zigzag)) {
+                return false;
+            }
+            value = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+        } break;
+        case TAG_REAL: {
+            float f;
+            if (!getfloat(ptr, end, f)) {
+                return false;
+            }
+            value = f;
+        } break;
+        case TAG_DOUBLE: {
+            double d;
+            if (!getdouble(ptr, end, d)) {
+                return false;
+            }
+            value = d;
+        } break;
+        case TAG_STRING: {
+            String s;
+            if (!getstring(ptr, end, s)) {
+                return false;
+            }
+            value = s;
+        } break;
+        case TAG_VECTOR3: {
+            float x, y, z;
+            if (!getfloat(ptr, end, x) || !getfloat(ptr, end, y) || !getfloat(ptr, end, z)) {
+                return false;
+            }
+            value = Vector3(x, y, z);
+        } break;
+        case TAG_ARRAY: {
+            uint64_t count;
+            // every element takes at least one byte
+            if (!getvarint(ptr, end, count) || uint64_t(end - ptr) < count) {
+                return false;
+            }
+            Array array;
+            array.resize(int(count));
+            for (uint64_t i = 0; i < count; i++) {
+                Variant element;
+                if (!getvalue(ptr, end, element, depth + 1)) {
+                    return false;
+                }
+                array[int(i)] = element;
+            }
+            value = array;
+        } break;
+        case TAG_BYTES:
+        case TAG_ENCODEDVARIANT: {
+            uint64_t length;
+            if (!getvarint(ptr, end, length) || uint64_t(end - ptr) < length) {
+                return false;
+            }
+            PoolByteArray bytes;
+            bytes.resize(int(length));
+            {
+                PoolByteArray::Write write = bytes.write();
+                memcpy(write.ptr(), ptr, size_t(length));
+            }
+            ptr += length;
+            if (tag == TAG_BYTES) {
+                value = bytes;
+            } else {
+                Ref<StreamPeerBuffer> decoder = Ref<StreamPeerBuffer>(StreamPeerBuffer::_new());
+                decoder->set_data_array(bytes);
+                value = decoder->get_var();
+            }
+        } break;
+        case TAG_REALS: {
+            uint64_t count;
+            // divide instead of multiplying, count * 4 wraps around for huge counts
+            if (!getvarint(ptr, end, count) || count > uint64_t(end - ptr) / 4 || count > uint64_t(INT_MAX)) {
+                return false;
+            }
+            PoolRealArray reals;
+            reals.resize(int(count));
+            PoolRealArray::Write write = reals.write();
+            for (uint64_t i = 0; i < count; i++) {
+                float f;
+                if (!getfloat(ptr, end, f)) {
+                    return false;
+                }
+                write[int(i)] = f;
+            }
+            value = reals;
+        } break;
+        case TAG_INTS: {
+            uint64_t count;
+            // every varint takes at least one byte
+            if (!getvarint(ptr, end, count) || uint64_t(end - ptr) < count) {
+                return false;
+            }
+            PoolIntArray ints;
+            ints.resize(int(count));
+            PoolIntArray::Write write = ints.write();
+            for (uint64_t i = 0; i < count; i++) {
+                uint64_t zigzag;
+                if (!getvarint(ptr, end, zigzag)) {
+                    return false;
+                }
+                write[int(i)] = int(int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1));
+            }
+            value = ints;
+        } break;
+        default: {
+            return false;
+        }
+    }
+    return true;
+}
+
+PoolByteArray Netprotocol::encode(const Variant &message, bool reliable, uint64_t now)
+{
+    uint8_t opcode = OP_VARIANT;
+    Array array;
+    if (message.get_type() == Variant::ARRAY) {
+        array = message;
+        if (array.size() > 0 && Variant(array[0]).get_type() == Variant::STRING) {
+            opcode = opcodefor(array[0]);
+        }
+    }
+
+    Channelstate &state = channels[CHANNEL_TIMELINE];
+    uint16_t sequence = state.localsequence++;
+    writeheader(opcode, CHANNEL_TIMELINE, reliable, sequence);
+    if (opcode == OP_VARIANT) {
+        putvalue(message);
+    } else {
+        // the command name is implied by the opcode
+        putvarint(uint64_t(array.size() - 1));
+        for (int i = 1; i < array.size(); i++) {
+            putvalue(array[i]);
+        }
+    }
+    return finish(CHANNEL_TIMELINE, reliable, sequence, now);
+}
+
+// payload: u8 distance back to the baseline snapshot (0 = none), varint field count,
+// with a baseline a bitmask of changed fields followed by only those fields as f32
+PoolByteArray Netprotocol::encodetelemetry(const PoolRealArray &fields, uint64_t now)
+{
+    Channelstate &state = channels[CHANNEL_TELEMETRY];
+    uint16_t sequence = state.localsequence++;
+    writeheader(OP_TELEMETRY, CHANNEL_TELEMETRY, false, sequence);
+
+    const int count = fields.size();
+    PoolRealArray::Read read = fields.read();
+    const Snapshot *baseline = nullptr;
+    uint16_t distance = 0;
+    if (ackedsnapshot >= 0) {
+        distance = uint16_t(sequence - uint16_t(ackedsnapshot));
+        const Snapshot &acked = sentsnapshots[ackedsnapshot % SNAPSHOT_WINDOW];
+        if (distance < SNAPSHOT_WINDOW && acked.sequence == ackedsnapshot && int(acked.fields.size()) == count) {
+            baseline = &acked;
+        }
+    }
+
+    putbyte(baseline ? uint8_t(distance) : 0);
+    putvarint(uint64_t(count));
+    if (baseline) {
+        size_t mask = buffer.size();
+        buffer.resize(mask + (count + 7) / 8, 0);
+        for (int i = 0; i < count; i++) {
+            if (memcmp(&read[i], &baseline->fields[i], sizeof(real_t)) != 0) {
+                buffer[mask + i / 8] |= uint8_t(1 << (i % 8));
+                putfloat(read[i]);
+            }
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            putfloat(read[i]);
+        }
+    }
+
+    // what the receiver reconstructs, so both sides share the same baseline
+    Snapshot &sent = sentsnapshots[sequence % SNAPSHOT_WINDOW];
+    sent.sequence = sequence;
+    sent.fields.resize(count);
+    for (int i = 0; i < count; i++) {
+        sent.fields[i] = float(read[i]);
+    }
+    return finish(CHANNEL_TELEMETRY, false, sequence, now);
+}
+
+bool Netprotocol::decode(const PoolByteArray &packet, Variant &message)
+{
+    if (packet.size() < HEADER_SIZE) {
+        return false;
+    }
+    PoolByteArray::Read read = packet.read();
+    const uint8_t *ptr = read.ptr();
+    const uint8_t *end = ptr + packet.size();
+
+    uint8_t opcode = ptr[0];
+    uint8_t channel = ptr[1] & CHANNEL_MASK;
+    uint16_t sequence = read16(ptr + 2);
+    if (opcode >= OP_MAX || channel >= CHANNEL_MAX) {
+        return false;
+    }
+    if (ptr[1] & FLAG_ACKVALID) {
+        acknowledge(channel, read16(ptr + 4), read16(ptr + 6));
+    }
+    ptr += HEADER_SIZE;
+
+    if (opcode == OP_ACK) {
+        return false;
+    }
+    if (!isnew(channel, sequence)) {
+        // a resend whose ack got lost, ack it again
+        channels[channel].ackpending = true;
+        return false;
+    }
+
+    // nothing below marks the sequence as received until the payload decoded, a
+    // truncated or corrupt packet stays unacked and its reliable sender resends it
+    if (opcode == OP_TELEMETRY) {
+        if (newestreceivedsnapshot >= 0 && !sequencenewer(sequence, uint16_t(newestreceivedsnapshot))) {
+            // an older snapshot than the one already applied
+            receive(channel, sequence);
+            return false;
+        }
+        if (ptr >= end) {
+            return false;
+        }
+        uint8_t distance = *ptr++;
+        uint64_t count;
+        if (!getvarint(ptr, end, count) || count > uint64_t(end - ptr) * 8) {
+            return false;
+        }
+        const Snapshot *baseline = nullptr;
+        if (distance) {
+            uint16_t baselinesequence = uint16_t(sequence - distance);
+            const Snapshot &candidate = receivedsnapshots[baselinesequence % SNAPSHOT_WINDOW];
+            if (distance >= SNAPSHOT_WINDOW || candidate.sequence != baselinesequence || candidate.fields.size() != count) {
+                return false;
+            }
+            baseline = &candidate;
+        }
+
+        PoolRealArray fields;
+        fields.resize(int(count));
+        {
+            PoolRealArray::Write write = fields.write();
+            const uint8_t *mask = ptr;
+            if (baseline) {
+                ptr += (count + 7) / 8;
+                if (ptr > end) {
+                    return false;
+                }
+            }
+            for (uint64_t i = 0; i < count; i++) {
+                float f;
+                if (!baseline || (mask[i / 8] & (1 << (i % 8)))) {
+                    if (!getfloat(ptr, end, f)) {
+                        return false;
+                    }
+                } else {
+                    f = baseline->fields[i];
+                }
+                write[int(i)] = f;
+            }
+            receive(channel, sequence);
+            Snapshot &received = receivedsnapshots[sequence % SNAPSHOT_WINDOW];
+            received.sequence = sequence;
+            received.fields.assign(write.ptr(), write.ptr() + count);
+        }
+        newestreceivedsnapshot = sequence;
+        message = Array::make(commandfor(OP_TELEMETRY), fields);
+        return true;
+    }
+
+    if (opcode == OP_VARIANT) {
+        if (!getvalue(ptr, end, message)) {
+            return false;
+        }
+        receive(channel, sequence);
+        return true;
+    }
+
+    uint64_t count;
+    if (!getvarint(ptr, end, count) || uint64_t(end - ptr) < count) {
+        return false;
+    }
+    Array array;
+    array.append(commandfor(opcode));
+    for (uint64_t i = 0; i < count; i++) {
+        Variant element;
+        if (!getvalue(ptr, end, element)) {
+            return false;
+        }
+        array.append(element);
+    }
+    receive(channel, sequence);
+    message = array;
+    return true;
+}
+
+void Netprotocol::flush(uint64_t now, vector<PoolByteArray> &out)
+{
+    for (int c = 0; c < CHANNEL_MAX; c++) {
+        Channelstate &state = channels[c];
+        for (Pending &pending : state.pending) {
+            if (now - pending.lastsent < RESEND_MSEC) {
+                continue;
+            }
+            if (pending.resends >= MAX_RESENDS) {
+                droplink();
+                return;
+            }
+            pending.resends++;
+            pending.lastsent = now;
+            // a resend carries the newest acks, the sequence stays the same
+            writeacks(pending.bytes.data(), uint8_t(c));
+            PoolByteArray packet;
+            packet.resize(int(pending.bytes.size()));
+            PoolByteArray::Write write = packet.write();
+            memcpy(write.ptr(), pending.bytes.data(), pending.bytes.size());
+            out.push_back(packet);
+            state.ackpending = false;
+        }
+        if (state.ackpending) {
+            // acks do not take a sequence number and are never acked themselves
+            writeheader(OP_ACK, uint8_t(c), false, state.localsequence);
+            state.ackpending = false;
+            out.push_back(finish(uint8_t(c), false, state.localsequence, now));
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include "Common.h"
+#include <Array.hpp>
+#include <PoolArrays.hpp>
+#include <vector>
+#include <cstdint>
+
+// Compact wire format for the Servermanagement UDP link.
+//
+// every packet starts with an 8 byte header:
+//   u8  opcode
+//   u8  channel, FLAG_RELIABLE set for messages that are resent until acked,
+//       FLAG_ACKVALID once the sender has received anything on this channel
+//   u16 sequence   per channel, little endian
+//   u16 ack        newest sequence received from the other side on this channel
+//   u16 ackbits    bit n set means ack - 1 - n was received too
+// followed by the opcode specific payload.
+//
+// Known commands such as ["addneweventtolaunchtimeline", ...] travel as a numeric
+// opcode plus tagged values, telemetry is delta encoded against the newest snapshot
+// the other side has acked.
+class Netprotocol
+{
+public:
+    enum Opcode : uint8_t {
+        OP_VARIANT = 0, // message without a dedicated opcode, the whole variant as tagged value
+        OP_CONTACT,
+        OP_ADDEVENT,
+        OP_DELETEEVENT,
+        OP_CHANGEEVENT,
+        OP_TELEMETRY,
+        OP_ACK,
+        OP_ENTITYSTATES, // [servertime, PoolIntArray entities, PoolRealArray states] for the Snapshotbuffer
+        OP_MAX
+    };
+
+    enum Channel : uint8_t {
+        CHANNEL_TIMELINE = 0,
+        CHANNEL_TELEMETRY,
+        CHANNEL_MAX
+    };
+
+    static const uint8_t FLAG_RELIABLE = 0x80;
+    static const uint8_t FLAG_ACKVALID = 0x40;
+    static const uint8_t CHANNEL_MASK = 0x3F;
+    static const int HEADER_SIZE = 8;
+    static const int SNAPSHOT_WINDOW = 16;
+    static const uint64_t RESEND_MSEC = 200;
+    // about five seconds of resends, or this many unacked reliable messages, and the link counts as lost
+    static const uint32_t MAX_RESENDS = 25;
+    static const size_t MAX_PENDING = 256;
+    // sent with the contact message, bumped whenever the wire format changes
+    static const int VERSION = 1;
+
+private:
+    struct Pending {
+        uint16_t sequence;
+        uint64_t lastsent;
+        uint32_t resends;
+        vector<uint8_t> bytes;
+    };
+
+    struct Snapshot {
+        int32_t sequence; // -1 while the slot is empty
+        vector<real_t> fields;
+    };
+
+    struct Channelstate {
+        uint16_t localsequence;
+        uint16_t remotesequence;
+        uint16_t receivedbits;
+        bool receivedany;
+        bool ackpending;
+        vector<Pending> pending;
+    };
+
+    Channelstate channels[CHANNEL_MAX];
+    // telemetry delta state, sent snapshots wait for their ack to become a baseline
+    Snapshot sentsnapshots[SNAPSHOT_WINDOW];
+    Snapshot receivedsnapshots[SNAPSHOT_WINDOW];
+    int32_t ackedsnapshot;
+    int32_t newestreceivedsnapshot;
+    bool lost;
+
+    vector<uint8_t> buffer;
+
+    static bool sequencenewer(uint16_t a, uint16_t b);
+
+    void writeheader(uint8_t opcode, uint8_t channel, bool reliable, uint16_t sequence);
+    void writeacks(uint8_t *header, uint8_t channel) const;
+    void acknowledge(uint8_t channel, uint16_t ack, uint16_t ackbits);
+    bool isnew(uint8_t channel, uint16_t sequence) const;
+    void receive(uint8_t channel, uint16_t sequence);
+    void droplink();
+    PoolByteArray finish(uint8_t channel, bool reliable, uint16_t sequence, uint64_t now);
+
+    void putbyte(uint8_t value) { buffer.push_back(value); }
+    void putvarint(uint64_t value);
+    void putfloat(float value);
+    void putdouble(double value);
+    void putstring(const String &value);
+    void putvalue(const Variant &value);
+
+    static bool getvarint(const uint8_t *&ptr, const uint8_t *end, uint64_t &value);
+    static bool getfloat(const uint8_t *&ptr, const uint8_t *end, float &value);
+    static bool getdouble(const uint8_t *&ptr, const uint8_t *end, double &value);
+    static bool getstring(const uint8_t *&ptr, const uint8_t *end, String &value);
+    static bool getvalue(const uint8_t *&ptr, const uint8_t *end, Variant &value, int depth = 0);
+
+public:
+    static uint8_t opcodefor(const String &command);
+    static String commandfor(uint8_t opcode);
+    // false for anything that cannot be a frame, like the text and put_var packets of older peers
+    static bool isframe(const PoolByteArray &packet);
+
+    // encodes one message, arrays starting with a known command name get their opcode
+    PoolByteArray encode(const Variant &message, bool reliable, uint64_t now);
+    PoolByteArray encodetelemetry(const PoolRealArray &fields, uint64_t now);
+    // returns true and fills message if the packet carries something new for the game
+    // telemetry comes back as ["telemetry", PoolRealArray]
+    bool decode(const PoolByteArray &packet, Variant &message);
+    // reliable messages due for a resend and pure acks for channels nothing else answered
+    void flush(uint64_t now, vector<PoolByteArray> &out);
+    // set once a reliable message ran out of resends or too many wait for their ack
+    bool connectionlost() const { return lost; }
+    // back to the state of a fresh link, sequences and baselines included
+    void reset();
+
+    Netprotocol();
+};
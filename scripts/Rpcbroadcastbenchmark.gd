@@ -0,0 +1,112 @@
+# Measures how long the server spends fanning RPCs out to many peers.
+# Every peer is a local ENet client with its own MultiplayerAPI, all polled
+# from here, so no frames are needed. Run it with the custom engine:
+#   bin/godot_server.linuxbsd.opt.64 --path <project folder> -s scripts/Rpcbroadcastbenchmark.gd
+extends SceneTree
+
+const PORT = 4271
+const PEER_COUNTS = [64, 256]
+const CALLS = 2000
+const CONNECT_TIMEOUT_MSEC = 10000
+
+
+class Ship:
+	extends Node
+	var received = 0
+
+	func state(_position, _rotation, _fuel):
+		received += 1
+
+
+func _initialize():
+	for count in PEER_COUNTS:
+		run(count)
+	quit()
+
+
+func make_ship(parent, api):
+	var ship = Ship.new()
+	ship.name = "Ship"
+	ship.custom_multiplayer = api
+	ship.rpc_config("state", MultiplayerAPI.RPC_MODE_REMOTE)
+	parent.add_child(ship)
+	return ship
+
+
+func poll_all(apis):
+	for api in apis:
+		api.poll()
+
+
+func run(count):
+	var server_root = Node.new()
+	server_root.name = "Benchmark"
+	root.add_child(server_root)
+	var server_peer = NetworkedMultiplayerENet.new()
+	if server_peer.create_server(PORT, count) != OK:
+		print("could not listen on port ", PORT)
+		return
+	var server = MultiplayerAPI.new()
+	server.set_root_node(server_root)
+	server.network_peer = server_peer
+	var server_ship = make_ship(server_root, server)
+
+	var apis = [server]
+	var ships = []
+	var client_roots = []
+	for i in count:
+		var client_root = Node.new()
+		client_root.name = "Client" + str(i)
+		root.add_child(client_root)
+		var client_peer = NetworkedMultiplayerENet.new()
+		client_peer.create_client("127.0.0.1", PORT)
+		var api = MultiplayerAPI.new()
+		api.set_root_node(client_root)
+		api.network_peer = client_peer
+		apis.append(api)
+		ships.append(make_ship(client_root, api))
+		client_roots.append(client_root)
+
+	var deadline = OS.get_ticks_msec() + CONNECT_TIMEOUT_MSEC
+	while server.get_network_connected_peers().size() < count and OS.get_ticks_msec() < deadline:
+		poll_all(apis)
+		OS.delay_msec(1)
+	if server.get_network_connected_peers().size() < count:
+		print(count, " peers: only ", server.get_network_connected_peers().size(), " connected, skipped")
+	else:
+		# One reliable call first so every peer confirms the node path,
+		# afterwards the server sends the compact form.
+		server_ship.rpc("state", Vector3(), Quat(), 1.0)
+		deadline = OS.get_ticks_msec() + CONNECT_TIMEOUT_MSEC
+		var confirmed = false
+		while not confirmed and OS.get_ticks_msec() < deadline:
+			poll_all(apis)
+			OS.delay_msec(1)
+			confirmed = true
+			for ship in ships:
+				if ship.received == 0:
+					confirmed = false
+					break
+		# Let the confirmations reach the server.
+		for i in 50:
+			poll_all(apis)
+			OS.delay_msec(1)
+
+		var start = OS.get_ticks_usec()
+		for i in CALLS:
+			server_ship.rpc_unreliable("state", Vector3(i, 0, 0), Quat(), 1.0)
+		var broadcast_usec = OS.get_ticks_usec() - start
+
+		var excluded = server.get_network_connected_peers()[0]
+		start = OS.get_ticks_usec()
+		for i in CALLS:
+			server_ship.rpc_unreliable_id(-excluded, "state", Vector3(i, 0, 0), Quat(), 1.0)
+		var exclude_usec = OS.get_ticks_usec() - start
+
+		print(count, " peers: broadcast ", broadcast_usec / float(CALLS), " usec/call, all but one ", exclude_usec / float(CALLS), " usec/call")
+
+	for api in apis:
+		api.network_peer.close_connection()
+	server_root.queue_free()
+	for client_root in client_roots:
+		client_root.queue_free()
@@ -1,4 +1,6 @@
 #include "Servermanagement.h"
+#include <StreamPeerBuffer.hpp>
+#include <chrono>
 
 
 
@@ -8,18 +10,26 @@ void Servermanagement::_register_methods()
     register_method("_process", &Servermanagement::_process);
     register_method("_init", &Servermanagement::_init);
     register_method("_ready", &Servermanagement::_ready);
+    register_method("_exit_tree", &Servermanagement::_exit_tree);
+    register_method("setthreadedreceive", &Servermanagement::setthreadedreceive);
+    register_method("setsnapshotbuffer", &Servermanagement::setsnapshotbuffer);
     register_method("recieveddatamethode", &Servermanagement::recieveddatamethode);
     register_method("connecttoserver",&Servermanagement::connecttoserver);
     register_method("sendtoserver",&Servermanagement::sendtoserver);
+    register_method("sendtelemetry",&Servermanagement::sendtelemetry);
+    register_method("benchmarkprotocol",&Servermanagement::benchmarkprotocol);
 
     register_signal<Servermanagement>((char *)"recieveddata","data", GODOT_VARIANT_TYPE_STRING);
 }
 
 void Servermanagement::_init()
 {
-    servercontactmessage = String("REQUEST valid Spacecavate Server ");
     connected = false;
     sendingport = 56;
+    listenport = defaultport;
+    receiving = false;
+    threadedreceive = true;
+    snapshots = nullptr;
     godot_signal recieveddata;
     Godot::print("Servermangementinitcalled");
     Godot::print("Servermangementinitcalled");
@@ -38,24 +48,175 @@ void Servermanagement::_ready()
 
 void Servermanagement::_process(float delta)
 {
-    if (udp2 -> get_available_packet_count() > 0){
-        connected = true;
-        emit_signal("recieveddata",udp2 -> get_packet());
+    // drain everything that arrived since the last frame in one go, the queue also
+    // holds what was left in the socket when the receive thread stopped
+    PoolByteArray packet;
+    while (incoming.pop(packet)) {
+        handlepacket(packet);
+    }
+    if (!receivethread.joinable()) {
+        while (udp2 -> get_available_packet_count() > 0) {
+            handlepacket(udp2 -> get_packet());
+        }
+    }
+    protocol.flush(OS::get_singleton() -> get_ticks_msec(), outgoing);
+    for (size_t i = 0; i < outgoing.size(); i++) {
+        udp -> put_packet(outgoing[i]);
+    }
+    outgoing.clear();
+    if (protocol.connectionlost()) {
+        Godot::print_error("server stopped acknowledging, dropping the connection", "_process", __FILE__, __LINE__);
+        dropconnection();
     }
 }
 
 void Servermanagement::connecttoserver(godot::String ip_address, int port  , godot::String password ){
     udp -> set_dest_address(ip_address,port);
-    udp -> put_var(servercontactmessage + "127.0.0.1");
+    protocol.reset();
+    // the server answers with its own contact message, see handlepacket for the version check
+    udp -> put_packet(protocol.encode(Array::make("contact", "127.0.0.1", Netprotocol::VERSION), true, OS::get_singleton() -> get_ticks_msec()));
     //udp -> put_var(ip.get_local_addresses());
     Godot::print("sendedrequest...");
+    stopreceivethread();
+    // packets of the previous connection must not reach the fresh protocol state
+    udp2 -> close();
+    PoolByteArray stale;
+    while (incoming.pop(stale)) {
+    }
+    listenport = port;
     Error err = udp2 -> listen(port);
+    if (err == Error::OK && threadedreceive) {
+        startreceivethread();
+    }
     //Godot::print(err);
     Godot::print("startedlistening");
     connected = true;
 }
 
 
+void Servermanagement::dropconnection()
+{
+    stopreceivethread();
+    udp2 -> close();
+    PoolByteArray stale;
+    while (incoming.pop(stale)) {
+    }
+    protocol.reset();
+    outgoing.clear();
+    connected = false;
+}
+
+void Servermanagement::_exit_tree()
+{
+    stopreceivethread();
+}
+
+Servermanagement::~Servermanagement()
+{
+    stopreceivethread();
+}
+
+void Servermanagement::setthreadedreceive(bool enabled)
+{
+    threadedreceive = enabled;
+    if (!enabled) {
+        stopreceivethread();
+    } else if (udp2.is_valid() && udp2 -> is_listening()) {
+        startreceivethread();
+    }
+}
+
+void Servermanagement::handlepacket(const PoolByteArray &packet)
+{
+    if (!Netprotocol::isframe(packet)) {
+        // utf8 text or put_var from an endpoint that predates Netprotocol
+        Godot::print_error("packet is not a protocol frame, the server has to speak protocol version " + String::num_int64(Netprotocol::VERSION), "handlepacket", __FILE__, __LINE__);
+        return;
+    }
+    connected = true;
+    Variant message;
+    if (!protocol.decode(packet, message)) {
+        return;
+    }
+    if (packet.read()[0] == Netprotocol::OP_CONTACT) {
+        Array contact = message;
+        if (contact.size() < 3 || int(contact[2]) != Netprotocol::VERSION) {
+            Godot::print_error("server speaks another protocol version than " + String::num_int64(Netprotocol::VERSION), "handlepacket", __FILE__, __LINE__);
+            dropconnection();
+            return;
+        }
+    }
+    if (snapshots && packet.read()[0] == Netprotocol::OP_ENTITYSTATES) {
+        Array states = message;
+        if (states.size() == 4) {
+            snapshots -> pushstates(states[1], states[2], states[3]);
+            return;
+        }
+    }
+    emit_signal("recieveddata",message);
+}
+
+void Servermanagement::setsnapshotbuffer(Snapshotbuffer *buffer)
+{
+    snapshots = buffer;
+}
+
+// runs on receivethread, wakes up as soon as the socket has data instead of once per frame
+void Servermanagement::receiveloop()
+{
+    while (receiving.load()) {
+        if (udp2 -> wait() != Error::OK) {
+            return;
+        }
+        while (udp2 -> get_available_packet_count() > 0) {
+            PoolByteArray packet = udp2 -> get_packet();
+            if (!receiving.load()) {
+                return;
+            }
+            // a full queue leaves the rest in the socket buffer until the main thread catches up
+            while (!incoming.push(packet)) {
+                if (!receiving.load()) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+void Servermanagement::startreceivethread()
+{
+    if (receivethread.joinable()) {
+        return;
+    }
+    receiving = true;
+    receivethread = std::thread(&Servermanagement::receiveloop, this);
+}
+
+void Servermanagement::stopreceivethread()
+{
+    if (!receivethread.joinable()) {
+        return;
+    }
+    receiving = false;
+    // wait() has no timeout, a packet to ourselves gets the thread out of it
+    Ref<PacketPeerUDP> wakeup = Ref<PacketPeerUDP>(PacketPeerUDP::_new());
+    wakeup -> set_dest_address("127.0.0.1", listenport);
+    PoolByteArray empty;
+    empty.resize(1);
+    wakeup -> put_packet(empty);
+    receivethread.join();
+    // the thread may have left before reading the wakeup, it must not stay in the
+    // socket and show up as data once polling or a new thread takes over. the rest
+    // goes to incoming, whatever does not fit is lost like on a full socket buffer
+    while (udp2 -> get_available_packet_count() > 0) {
+        PoolByteArray packet = udp2 -> get_packet();
+        if (packet.size() != 1) {
+            incoming.push(packet);
+        }
+    }
+}
+
 void Servermanagement::recieveddatamethode(Variant data)
 {
     Godot::print(data);
@@ -63,5 +224,98 @@ void Servermanagement::recieveddatamethode(Variant data)
 }
 
 void Servermanagement::sendtoserver(Variant tosend){
-    udp -> put_var(tosend);
+    // timeline commands must arrive, they are resent from _process until acked
+    udp -> put_packet(protocol.encode(tosend, true, OS::get_singleton() -> get_ticks_msec()));
+}
+
+void Servermanagement::sendtelemetry(PoolRealArray fields){
+    udp -> put_packet(protocol.encodetelemetry(fields, OS::get_singleton() -> get_ticks_msec()));
+}
+
+// sends the same mix of timeline and telemetry messages over loopback once with
+// put_var (encode_variant) and once with Netprotocol, results are per message
+Dictionary Servermanagement::benchmarkprotocol(int messages){
+    typedef std::chrono::steady_clock clock;
+    Dictionary result;
+    Ref<PacketPeerUDP> sender = Ref<PacketPeerUDP>(PacketPeerUDP::_new());
+    Ref<PacketPeerUDP> receiver = Ref<PacketPeerUDP>(PacketPeerUDP::_new());
+    if (messages <= 0 || receiver -> listen(benchmarkport, "127.0.0.1") != Error::OK) {
+        Godot::print_error("could not listen on the benchmark port", "benchmarkprotocol", __FILE__, __LINE__);
+        return result;
+    }
+    sender -> set_dest_address("127.0.0.1", benchmarkport);
+
+    Array workload;
+    PoolRealArray fields;
+    fields.resize(16);
+    for (int i = 0; i < fields.size(); i++) {
+        fields.set(i, 0);
+    }
+    for (int i = 0; i < messages; i++) {
+        if (i % 2 == 0) {
+            workload.append(Array::make("addneweventtolaunchtimeline", "test", "set", Array::make("throttle", i % 100)));
+        } else {
+            // a couple of fields move per tick, like throttle and fuel
+            fields.set(i % 16, fields[i % 16] + 0.5);
+            fields.set(0, float(i));
+            workload.append(Array::make("telemetry", fields));
+        }
+    }
+
+    Ref<StreamPeerBuffer> encoder = Ref<StreamPeerBuffer>(StreamPeerBuffer::_new());
+    int64_t variantbytes = 0, variantencode = 0, variantdecode = 0;
+    for (int i = 0; i < messages; i++) {
+        Variant message = workload[i];
+        clock::time_point start = clock::now();
+        encoder -> clear();
+        encoder -> put_var(message);
+        variantencode += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        // put_var sends encode_variant without the stream's length prefix
+        variantbytes += encoder -> get_size() - 4;
+
+        sender -> put_var(message);
+        receiver -> wait();
+        start = clock::now();
+        Variant decoded = receiver -> get_var();
+        variantdecode += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+    }
+
+    Netprotocol client;
+    Netprotocol server;
+    vector<PoolByteArray> acks;
+    int64_t protocolbytes = 0, protocolencode = 0, protocoldecode = 0;
+    for (int i = 0; i < messages; i++) {
+        Array message = workload[i];
+        uint64_t now = OS::get_singleton() -> get_ticks_msec();
+        clock::time_point start = clock::now();
+        PoolByteArray packet = i % 2 == 0 ? client.encode(message, true, now) : client.encodetelemetry(message[1], now);
+        protocolencode += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        protocolbytes += packet.size();
+
+        sender -> put_packet(packet);
+        receiver -> wait();
+        PoolByteArray received = receiver -> get_packet();
+        start = clock::now();
+        Variant decoded;
+        server.decode(received, decoded);
+        protocoldecode += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+        // acks go straight back so baselines and the resend queue behave like on a live link
+        server.flush(now, acks);
+        for (size_t a = 0; a < acks.size(); a++) {
+            Variant ignored;
+            client.decode(acks[a], ignored);
+        }
+        acks.clear();
+    }
+    receiver -> close();
+
+    result["messages"] = messages;
+    result["variant_bytes_per_msg"] = double(variantbytes) / messages;
+    result["variant_encode_ns"] = double(variantencode) / messages;
+    result["variant_decode_ns"] = double(variantdecode) / messages;
+    result["protocol_bytes_per_msg"] = double(protocolbytes) / messages;
+    result["protocol_encode_ns"] = double(protocolencode) / messages;
+    result["protocol_decode_ns"] = double(protocoldecode) / messages;
+    return result;
 }
\ No newline at end of file
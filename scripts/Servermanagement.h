@@ -3,6 +3,12 @@
 #include <PacketPeerUDP.hpp>
 #include <OS.hpp>
 #include <IP.hpp>
+#include <Dictionary.hpp>
+#include "Netprotocol.h"
+#include "Spscqueue.h"
+#include "Snapshotbuffer.h"
+#include <atomic>
+#include <thread>
 
 class Servermanagement : public Node
 {
@@ -15,21 +21,42 @@ class Servermanagement : public Node
     int sendingport;
     godot_signal recieveddata;
     GODOT_CLASS(Servermanagement, Node);
-    String servercontactmessage;
+    Netprotocol protocol;
+    vector<PoolByteArray> outgoing;
+    // threaded receive: the thread blocks on udp2 and only touches udp2 and incoming
+    std::thread receivethread;
+    std::atomic<bool> receiving;
+    Spscqueue<PoolByteArray> incoming;
+    int listenport;
+    bool threadedreceive;
+    // entity states from the server go straight into this buffer when set
+    Snapshotbuffer *snapshots;
 
     // Exposed properties
 
 public:
     static const int defaultport = 70;
+    static const int benchmarkport = 4270;
     static void _register_methods();
     void sendtoserver(Variant data);
+    void sendtelemetry(PoolRealArray fields);
+    Dictionary benchmarkprotocol(int messages);
     void _init();
     void _ready();
     void _process(float delta);
+    void _exit_tree();
+    void setthreadedreceive(bool enabled);
+    void setsnapshotbuffer(Snapshotbuffer *buffer);
+    ~Servermanagement();
     void connecttoserver(String ip_address = "127.0.0.1", int port = Servermanagement::defaultport , String password = "");
 
 private:
     void recieveddatamethode(Variant data);
+    void handlepacket(const PoolByteArray &packet);
+    void dropconnection();
+    void receiveloop();
+    void startreceivethread();
+    void stopreceivethread();
 
     // add the methods here
 };
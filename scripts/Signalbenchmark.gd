@@ -0,0 +1,52 @@
+# Cost of emitting a value-changed signal to many receivers, the way the
+# timeline and navball widgets are updated while scrubbing. One signal feeds
+# native setters, the other script callbacks. Run it with the custom engine:
+#   bin/godot_server.linuxbsd.opt.64 --path <project folder> -s scripts/Signalbenchmark.gd
+extends SceneTree
+
+const RECEIVERS = 1000
+const EMITS = 1000
+
+var ranges = []
+var scrubbers = []
+
+
+class Emitter:
+	extends Object
+	signal native_changed(value)
+	signal script_changed(value)
+
+
+class Scrubber:
+	extends Reference
+	var value = 0.0
+
+	func on_changed(new_value):
+		value = new_value
+
+
+func _initialize():
+	var emitter = Emitter.new()
+	for i in RECEIVERS:
+		var range_node = Range.new()
+		range_node.max_value = EMITS
+		emitter.connect("native_changed", Callable(range_node, "set_value"))
+		ranges.append(range_node)
+		var scrubber = Scrubber.new()
+		emitter.connect("script_changed", Callable(scrubber, "on_changed"))
+		scrubbers.append(scrubber)
+
+	for signal_name in ["native_changed", "script_changed"]:
+		var begin = OS.get_ticks_usec()
+		for i in EMITS:
+			emitter.emit_signal(signal_name, float(i))
+		var usec = OS.get_ticks_usec() - begin
+		print(signal_name, " to ", RECEIVERS, " receivers: ", usec / 1000.0 / EMITS, " ms/emit")
+
+	for range_node in ranges:
+		range_node.free()
+	emitter.free()
+
+
+func _idle(_delta):
+	return true
@@ -0,0 +1,241 @@
+#include "Snapshotbuffer.h"
+#include <OS.hpp>
+#include <cmath>
+
+
+
+
+void Snapshotbuffer::_register_methods()
+{
+    register_method("_init", &Snapshotbuffer::_init);
+    register_method("_process", &Snapshotbuffer::_process);
+    register_method("configure", &Snapshotbuffer::configure);
+    register_method("setdelay", &Snapshotbuffer::setdelay);
+    register_method("setmaxextrapolation", &Snapshotbuffer::setmaxextrapolation);
+    register_method("pushstate", &Snapshotbuffer::pushstate);
+    register_method("pushstates", &Snapshotbuffer::pushstates);
+    register_method("clear", &Snapshotbuffer::clear);
+    register_method("getrendertime", &Snapshotbuffer::getrendertime);
+    register_method("gettransform", &Snapshotbuffer::gettransform);
+    register_method("bindnode", &Snapshotbuffer::bindnode);
+    register_method("unbindnode", &Snapshotbuffer::unbindnode);
+    register_method("apply", &Snapshotbuffer::apply);
+}
+
+void Snapshotbuffer::_init()
+{
+    capacity = 0;
+    depth = 0;
+    delay = 0.1;
+    maxextrapolation = 0.25;
+    clockoffset = 0;
+    clockvalid = false;
+    configure(64, defaultdepth);
+}
+
+void Snapshotbuffer::_process(float delta)
+{
+    apply(getrendertime());
+}
+
+void Snapshotbuffer::configure(int entities, int snapshotdepth)
+{
+    if (entities < 0 || snapshotdepth < 2) {
+        Godot::print_error("Snapshotbuffer needs at least 2 snapshots per entity", "configure", __FILE__, __LINE__);
+        return;
+    }
+    capacity = entities;
+    depth = snapshotdepth;
+    const size_t size = size_t(capacity) * depth;
+    times.assign(size, 0);
+    px.assign(size, 0);
+    py.assign(size, 0);
+    pz.assign(size, 0);
+    qx.assign(size, 0);
+    qy.assign(size, 0);
+    qz.assign(size, 0);
+    qw.assign(size, 1);
+    newest.assign(capacity, 0);
+    count.assign(capacity, 0);
+    nodes.assign(capacity, nullptr);
+}
+
+void Snapshotbuffer::setdelay(float seconds)
+{
+    delay = seconds;
+}
+
+void Snapshotbuffer::setmaxextrapolation(float seconds)
+{
+    maxextrapolation = seconds;
+}
+
+double Snapshotbuffer::localtime() const
+{
+    return OS::get_singleton() -> get_ticks_usec() / 1000000.0;
+}
+
+// tracks server time minus local time, late packets only nudge the estimate
+void Snapshotbuffer::observe(double servertime)
+{
+    double offset = servertime - localtime();
+    if (!clockvalid || std::fabs(offset - clockoffset) > 1.0) {
+        clockoffset = offset;
+        clockvalid = true;
+    } else {
+        clockoffset += (offset - clockoffset) * 0.05;
+    }
+}
+
+void Snapshotbuffer::store(int entity, double servertime, real_t x, real_t y, real_t z, const Quat &rotation)
+{
+    const size_t base = size_t(entity) * depth;
+    if (count[entity] > 0 && servertime <= times[base + newest[entity]]) {
+        // out of order or duplicate, the ring only ever grows forward in time
+        return;
+    }
+    int slot = count[entity] > 0 ? (newest[entity] + 1) % depth : 0;
+    const size_t i = base + slot;
+    times[i] = servertime;
+    px[i] = x;
+    py[i] = y;
+    pz[i] = z;
+    qx[i] = rotation.x;
+    qy[i] = rotation.y;
+    qz[i] = rotation.z;
+    qw[i] = rotation.w;
+    newest[entity] = slot;
+    if (count[entity] < depth) {
+        count[entity]++;
+    }
+}
+
+void Snapshotbuffer::pushstate(int entity, double servertime, Vector3 position, Quat rotation)
+{
+    if (entity < 0 || entity >= capacity) {
+        return;
+    }
+    observe(servertime);
+    store(entity, servertime, position.x, position.y, position.z, rotation);
+}
+
+void Snapshotbuffer::pushstates(double servertime, PoolIntArray entities, PoolRealArray states)
+{
+    if (states.size() < entities.size() * 7) {
+        Godot::print_error("pushstates needs 7 reals per entity", "pushstates", __FILE__, __LINE__);
+        return;
+    }
+    observe(servertime);
+    PoolIntArray::Read ids = entities.read();
+    PoolRealArray::Read values = states.read();
+    for (int e = 0; e < entities.size(); e++) {
+        int entity = ids[e];
+        if (entity < 0 || entity >= capacity) {
+            continue;
+        }
+        const real_t *v = values.ptr() + e * 7;
+        store(entity, servertime, v[0], v[1], v[2], Quat(v[3], v[4], v[5], v[6]));
+    }
+}
+
+void Snapshotbuffer::clear(int entity)
+{
+    if (entity < 0 || entity >= capacity) {
+        return;
+    }
+    count[entity] = 0;
+    newest[entity] = 0;
+}
+
+double Snapshotbuffer::getrendertime() const
+{
+    return localtime() + clockoffset - delay;
+}
+
+void Snapshotbuffer::sample(int entity, double time, Vector3 &position, Quat &rotation) const
+{
+    const size_t base = size_t(entity) * depth;
+    const int n = count[entity];
+    const size_t latest = base + newest[entity];
+
+    if (time >= times[latest]) {
+        position = Vector3(px[latest], py[latest], pz[latest]);
+        rotation = Quat(qx[latest], qy[latest], qz[latest], qw[latest]);
+        if (n < 2) {
+            return;
+        }
+        const size_t previous = base + (newest[entity] + depth - 1) % depth;
+        double span = times[latest] - times[previous];
+        if (span <= 0) {
+            return;
+        }
+        double ahead = time - times[latest];
+        if (ahead > maxextrapolation) {
+            ahead = maxextrapolation;
+        }
+        real_t factor = real_t(ahead / span);
+        position += (position - Vector3(px[previous], py[previous], pz[previous])) * factor;
+        return;
+    }
+
+    // walk back from the newest snapshot to the pair around time
+    int later = newest[entity];
+    for (int k = 1; k < n; k++) {
+        int earlier = (later + depth - 1) % depth;
+        const size_t a = base + earlier;
+        const size_t b = base + later;
+        if (times[a] <= time) {
+            real_t t = real_t((time - times[a]) / (times[b] - times[a]));
+            position = Vector3(px[a], py[a], pz[a]).linear_interpolate(Vector3(px[b], py[b], pz[b]), t);
+            rotation = Quat(qx[a], qy[a], qz[a], qw[a]).slerp(Quat(qx[b], qy[b], qz[b], qw[b]), t);
+            return;
+        }
+        later = earlier;
+    }
+
+    // older than anything buffered, hold the oldest snapshot
+    const size_t oldest = base + later;
+    position = Vector3(px[oldest], py[oldest], pz[oldest]);
+    rotation = Quat(qx[oldest], qy[oldest], qz[oldest], qw[oldest]);
+}
+
+Transform Snapshotbuffer::gettransform(int entity, double rendertime) const
+{
+    if (entity < 0 || entity >= capacity || count[entity] == 0) {
+        return Transform();
+    }
+    Vector3 position;
+    Quat rotation;
+    sample(entity, rendertime, position, rotation);
+    return Transform(Basis(rotation), position);
+}
+
+void Snapshotbuffer::bindnode(int entity, Spatial *node)
+{
+    if (entity < 0 || entity >= capacity) {
+        return;
+    }
+    nodes[entity] = node;
+}
+
+void Snapshotbuffer::unbindnode(int entity)
+{
+    if (entity < 0 || entity >= capacity) {
+        return;
+    }
+    nodes[entity] = nullptr;
+}
+
+// moves every bound node, bound nodes must call unbindnode before they are freed
+void Snapshotbuffer::apply(double rendertime)
+{
+    Vector3 position;
+    Quat rotation;
+    for (int entity = 0; entity < capacity; entity++) {
+        if (!nodes[entity] || count[entity] == 0) {
+            continue;
+        }
+        sample(entity, rendertime, position, rotation);
+        nodes[entity] -> set_transform(Transform(Basis(rotation), position));
+    }
+}
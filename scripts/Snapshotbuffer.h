@@ -0,0 +1,55 @@
+#pragma once
+#include "Common.h"
+#include <Node.hpp>
+#include <Spatial.hpp>
+#include <PoolArrays.hpp>
+#include <vector>
+
+// Jitter buffer for timestamped server states of many entities.
+// Every entity owns a fixed ring of depth snapshots in SoA arrays, everything is
+// allocated in configure so pushing states and sampling transforms never allocate.
+// Rendering runs delay seconds behind the estimated server clock, so there are
+// usually two snapshots to interpolate between, past the newest one the last
+// velocity is extrapolated for at most maxextrapolation seconds.
+class Snapshotbuffer : public Node
+{
+    GODOT_CLASS(Snapshotbuffer, Node);
+
+    int capacity;
+    int depth;
+    vector<double> times;
+    vector<real_t> px, py, pz;
+    vector<real_t> qx, qy, qz, qw;
+    vector<int> newest;
+    vector<int> count;
+    vector<Spatial *> nodes;
+
+    real_t delay;
+    real_t maxextrapolation;
+    double clockoffset;
+    bool clockvalid;
+
+    double localtime() const;
+    void observe(double servertime);
+    void store(int entity, double servertime, real_t x, real_t y, real_t z, const Quat &rotation);
+    void sample(int entity, double time, Vector3 &position, Quat &rotation) const;
+
+public:
+    static const int defaultdepth = 8;
+    static void _register_methods();
+    void _init();
+    void _process(float delta);
+
+    void configure(int entities, int snapshotdepth);
+    void setdelay(float seconds);
+    void setmaxextrapolation(float seconds);
+    void pushstate(int entity, double servertime, Vector3 position, Quat rotation);
+    // states holds 7 reals per entity: position xyz then rotation quaternion xyzw
+    void pushstates(double servertime, PoolIntArray entities, PoolRealArray states);
+    void clear(int entity);
+    double getrendertime() const;
+    Transform gettransform(int entity, double rendertime) const;
+    void bindnode(int entity, Spatial *node);
+    void unbindnode(int entity);
+    void apply(double rendertime);
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// capacity is rounded up to a power of two, push fails instead of blocking when full.
+template <class T>
+class Spscqueue
+{
+    std::vector<T> slots;
+    size_t mask;
+    // producer and consumer indices on their own cache lines
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) std::atomic<size_t> head;
+
+public:
+    explicit Spscqueue(size_t capacity = 1024) :
+            tail(0),
+            head(0)
+    {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // producer only
+    bool push(const T &value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool pop(T &value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[h & mask];
+        // drop the queue's reference right away instead of when the slot is reused
+        slots[h & mask] = T();
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
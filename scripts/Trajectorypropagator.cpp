@@ -0,0 +1,309 @@
+#include "Trajectorypropagator.h"
+#include <cmath>
+
+
+
+
+void Trajectorypropagator::_register_methods()
+{
+    register_method("_init", &Trajectorypropagator::_init);
+    register_method("_process", &Trajectorypropagator::_process);
+    register_method("configure", &Trajectorypropagator::configure);
+    register_method("addattractor", &Trajectorypropagator::addattractor);
+    register_method("clearattractors", &Trajectorypropagator::clearattractors);
+    register_method("addship", &Trajectorypropagator::addship);
+    register_method("removeship", &Trajectorypropagator::removeship);
+    register_method("setshipstate", &Trajectorypropagator::setshipstate);
+    register_method("advance", &Trajectorypropagator::advance);
+    register_method("gettime", &Trajectorypropagator::gettime);
+    register_method("getposition", &Trajectorypropagator::getposition);
+    register_method("getvelocity", &Trajectorypropagator::getvelocity);
+    register_method("getpositions", &Trajectorypropagator::getpositions);
+}
+
+void Trajectorypropagator::_init()
+{
+    shipcount = 0;
+    shipcapacity = 0;
+    samples = defaultsamples;
+    head = 0;
+    step = 0.2;
+    basetime = 0;
+    currenttime = 0;
+    grow(16);
+}
+
+void Trajectorypropagator::_process(float delta)
+{
+    advance(delta);
+}
+
+void Trajectorypropagator::grow(int capacity)
+{
+    // relayout every slot, the ship stride of the time-major buffer changes
+    vector<real_t> *buffers[6] = { &px, &py, &pz, &vx, &vy, &vz };
+    for (int b = 0; b < 6; b++) {
+        vector<real_t> resized(size_t(samples) * capacity, 0);
+        for (int s = 0; s < samples && shipcapacity > 0; s++) {
+            for (int i = 0; i < shipcount; i++) {
+                resized[size_t(s) * capacity + i] = (*buffers[b])[size_t(s) * shipcapacity + i];
+            }
+        }
+        buffers[b]->swap(resized);
+    }
+    ax.resize(capacity, 0);
+    ay.resize(capacity, 0);
+    az.resize(capacity, 0);
+    active.resize(capacity, 0);
+    shipcapacity = capacity;
+}
+
+void Trajectorypropagator::acceleration(real_t x, real_t y, real_t z, real_t &outx, real_t &outy, real_t &outz) const
+{
+    // softening keeps a ship passing through an attractor from blowing up
+    const real_t softening = 1e-4;
+    outx = 0;
+    outy = 0;
+    outz = 0;
+    for (size_t a = 0; a < attractormu.size(); a++) {
+        real_t dx = attractorx[a] - x;
+        real_t dy = attractory[a] - y;
+        real_t dz = attractorz[a] - z;
+        real_t distsq = dx * dx + dy * dy + dz * dz + softening;
+        real_t factor = attractormu[a] / (distsq * std::sqrt(distsq));
+        outx += dx * factor;
+        outy += dy * factor;
+        outz += dz * factor;
+    }
+}
+
+// velocity verlet from one slot to another for the ships [first, last)
+// fromslot may equal toslot, every ship is read before it is written
+void Trajectorypropagator::integrate(int fromslot, int toslot, int first, int last, real_t h)
+{
+    const size_t from = size_t(fromslot) * shipcapacity;
+    const size_t to = size_t(toslot) * shipcapacity;
+    const real_t halfh = h * 0.5;
+    for (int i = first; i < last; i++) {
+        real_t halfvx = vx[from + i] + ax[i] * halfh;
+        real_t halfvy = vy[from + i] + ay[i] * halfh;
+        real_t halfvz = vz[from + i] + az[i] * halfh;
+        real_t x = px[from + i] + halfvx * h;
+        real_t y = py[from + i] + halfvy * h;
+        real_t z = pz[from + i] + halfvz * h;
+        acceleration(x, y, z, ax[i], ay[i], az[i]);
+        px[to + i] = x;
+        py[to + i] = y;
+        pz[to + i] = z;
+        vx[to + i] = halfvx + ax[i] * halfh;
+        vy[to + i] = halfvy + ay[i] * halfh;
+        vz[to + i] = halfvz + az[i] * halfh;
+    }
+}
+
+// fills the whole horizon of one ship from its state at currenttime
+void Trajectorypropagator::seed(int ship, Vector3 position, Vector3 velocity)
+{
+    const size_t first = size_t(head) * shipcapacity + ship;
+    px[first] = position.x;
+    py[first] = position.y;
+    pz[first] = position.z;
+    vx[first] = velocity.x;
+    vy[first] = velocity.y;
+    vz[first] = velocity.z;
+    acceleration(position.x, position.y, position.z, ax[ship], ay[ship], az[ship]);
+
+    // the oldest sample lies up to one step in the past, verlet runs backwards fine
+    real_t offset = real_t(currenttime - basetime);
+    if (offset > 0) {
+        integrate(head, head, ship, ship + 1, -offset);
+    }
+    for (int s = 1; s < samples; s++) {
+        integrate(slot(s - 1), slot(s), ship, ship + 1, step);
+    }
+}
+
+void Trajectorypropagator::repredict()
+{
+    vector<Vector3> positions(shipcount);
+    vector<Vector3> velocities(shipcount);
+    for (int i = 0; i < shipcount; i++) {
+        if (active[i]) {
+            sample(i, currenttime, &positions[i], &velocities[i]);
+        }
+    }
+    head = 0;
+    basetime = currenttime;
+    for (int i = 0; i < shipcount; i++) {
+        if (active[i]) {
+            seed(i, positions[i], velocities[i]);
+        }
+    }
+}
+
+// cubic hermite between the two samples around time, O(1) per lookup
+void Trajectorypropagator::sample(int ship, double time, Vector3 *position, Vector3 *velocity) const
+{
+    double local = (time - basetime) / step;
+    if (local < 0) {
+        local = 0;
+    }
+    int index = int(local);
+    if (index > samples - 2) {
+        index = samples - 2;
+    }
+    real_t s = real_t(local - index);
+    if (s > 1) {
+        s = 1;
+    }
+
+    const size_t a = size_t(slot(index)) * shipcapacity + ship;
+    const size_t b = size_t(slot(index + 1)) * shipcapacity + ship;
+    Vector3 p0(px[a], py[a], pz[a]);
+    Vector3 v0(vx[a], vy[a], vz[a]);
+    Vector3 p1(px[b], py[b], pz[b]);
+    Vector3 v1(vx[b], vy[b], vz[b]);
+
+    if (position) {
+        real_t s2 = s * s;
+        real_t s3 = s2 * s;
+        *position = p0 * (2 * s3 - 3 * s2 + 1) + v0 * ((s3 - 2 * s2 + s) * step) + p1 * (3 * s2 - 2 * s3) + v1 * ((s3 - s2) * step);
+    }
+    if (velocity) {
+        real_t s2 = s * s;
+        *velocity = (p0 - p1) * ((6 * s2 - 6 * s) / step) + v0 * (3 * s2 - 4 * s + 1) + v1 * (3 * s2 - 2 * s);
+    }
+}
+
+void Trajectorypropagator::configure(double steplength, int samplecount)
+{
+    if (steplength <= 0 || samplecount < 2) {
+        Godot::print_error("Trajectorypropagator needs a positive step and at least 2 samples", "configure", __FILE__, __LINE__);
+        return;
+    }
+    vector<Vector3> positions(shipcount);
+    vector<Vector3> velocities(shipcount);
+    for (int i = 0; i < shipcount; i++) {
+        if (active[i]) {
+            sample(i, currenttime, &positions[i], &velocities[i]);
+        }
+    }
+
+    int capacity = shipcapacity;
+    shipcapacity = 0;
+    samples = samplecount;
+    step = steplength;
+    grow(capacity);
+
+    head = 0;
+    basetime = currenttime;
+    for (int i = 0; i < shipcount; i++) {
+        if (active[i]) {
+            seed(i, positions[i], velocities[i]);
+        }
+    }
+}
+
+int Trajectorypropagator::addattractor(Vector3 position, float mu)
+{
+    attractorx.push_back(position.x);
+    attractory.push_back(position.y);
+    attractorz.push_back(position.z);
+    attractormu.push_back(mu);
+    repredict();
+    return int(attractormu.size()) - 1;
+}
+
+void Trajectorypropagator::clearattractors()
+{
+    attractorx.clear();
+    attractory.clear();
+    attractorz.clear();
+    attractormu.clear();
+    repredict();
+}
+
+int Trajectorypropagator::addship(Vector3 position, Vector3 velocity)
+{
+    int id;
+    if (!freeids.empty()) {
+        id = freeids.back();
+        freeids.pop_back();
+    } else {
+        if (shipcount == shipcapacity) {
+            grow(shipcapacity * 2);
+        }
+        id = shipcount++;
+    }
+    active[id] = 1;
+    seed(id, position, velocity);
+    return id;
+}
+
+void Trajectorypropagator::removeship(int id)
+{
+    if (id < 0 || id >= shipcount || !active[id]) {
+        return;
+    }
+    active[id] = 0;
+    freeids.push_back(id);
+}
+
+void Trajectorypropagator::setshipstate(int id, Vector3 position, Vector3 velocity)
+{
+    if (id < 0 || id >= shipcount || !active[id]) {
+        return;
+    }
+    seed(id, position, velocity);
+}
+
+void Trajectorypropagator::advance(double delta)
+{
+    currenttime += delta;
+    // keep currenttime between the two oldest samples, recycling the oldest slot as the new tail
+    while (currenttime >= basetime + step) {
+        integrate(slot(samples - 1), head, 0, shipcount, step);
+        head = (head + 1) % samples;
+        basetime += step;
+    }
+}
+
+double Trajectorypropagator::gettime() const
+{
+    return currenttime;
+}
+
+Vector3 Trajectorypropagator::getposition(int id, double time) const
+{
+    Vector3 position;
+    if (id < 0 || id >= shipcount || !active[id]) {
+        return position;
+    }
+    sample(id, time, &position, nullptr);
+    return position;
+}
+
+Vector3 Trajectorypropagator::getvelocity(int id, double time) const
+{
+    Vector3 velocity;
+    if (id < 0 || id >= shipcount || !active[id]) {
+        return velocity;
+    }
+    sample(id, time, nullptr, &velocity);
+    return velocity;
+}
+
+PoolVector3Array Trajectorypropagator::getpositions(double time) const
+{
+    PoolVector3Array positions;
+    positions.resize(shipcount);
+    PoolVector3Array::Write write = positions.write();
+    Vector3 *ptr = write.ptr();
+    for (int i = 0; i < shipcount; i++) {
+        ptr[i] = Vector3();
+        if (active[i]) {
+            sample(i, time, &ptr[i], nullptr);
+        }
+    }
+    return positions;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "Common.h"
+#include <Node.hpp>
+#include <PoolArrays.hpp>
+#include <vector>
+
+// Predicts the orbits of many ships at once.
+// The predicted states live in a ring buffer of fixed time steps, stored
+// time-major (slot * shipcapacity + ship) so integrating one new step for every
+// ship and reading every ship at one time both walk contiguous memory.
+class Trajectorypropagator : public Node
+{
+    GODOT_CLASS(Trajectorypropagator, Node);
+
+    vector<real_t> px, py, pz;
+    vector<real_t> vx, vy, vz;
+    // acceleration at the newest sample of every ship, reused by the next verlet step
+    vector<real_t> ax, ay, az;
+    vector<uint8_t> active;
+    vector<int> freeids;
+
+    vector<real_t> attractorx, attractory, attractorz, attractormu;
+
+    int shipcount;
+    int shipcapacity;
+    int samples;
+    int head;
+    double step;
+    double basetime;
+    double currenttime;
+
+    int slot(int index) const { return (head + index) % samples; }
+    void grow(int capacity);
+    void acceleration(real_t x, real_t y, real_t z, real_t &outx, real_t &outy, real_t &outz) const;
+    void integrate(int fromslot, int toslot, int first, int last, real_t h);
+    void seed(int ship, Vector3 position, Vector3 velocity);
+    void repredict();
+    void sample(int ship, double time, Vector3 *position, Vector3 *velocity) const;
+
+public:
+    static const int defaultsamples = 512;
+    static void _register_methods();
+    void _init();
+    void _process(float delta);
+
+    void configure(double steplength, int samplecount);
+    int addattractor(Vector3 position, float mu);
+    void clearattractors();
+    int addship(Vector3 position, Vector3 velocity);
+    void removeship(int id);
+    void setshipstate(int id, Vector3 position, Vector3 velocity);
+    void advance(double delta);
+    double gettime() const;
+    Vector3 getposition(int id, double time) const;
+    Vector3 getvelocity(int id, double time) const;
+    PoolVector3Array getpositions(double time) const;
+};
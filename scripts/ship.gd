@@ -1,24 +1,19 @@
 extends Spatial
 
-var pos
-var timeelapsed = 0
-var futurepositions : Dictionary = {}
-#  example element [t,postion]
-#  					t in ms
-var passedms = 0
+var shipid
+var velocity = Vector3(0.05,0.05,0.05)
+#  positions are predicted natively by the Trajectorypropagator autoload
+#  and looked up by time instead of a per ship Dictionary
 
 func _ready():
-	pos = Vector3(0,0,0)
-	for i in range(10000):
-		futurepositions[i] = pos
-		pos += Vector3(0.01,0.01,0.01)
+	shipid = Trajectorypropagator.addship(Vector3(0,0,0),velocity)
 	pass # Replace with function body.
 
 
 
 func _process(delta):
-	timeelapsed += delta
-	set("translation",futurepositions[int(timeelapsed*5)])
-#	passedms += delta
-#	var newpos = futurepositions.get(passedms)
-#	print(newpos)
+	set("translation",Trajectorypropagator.getposition(shipid,Trajectorypropagator.gettime()))
+
+
+func _exit_tree():
+	Trajectorypropagator.removeship(shipid)